@@ -0,0 +1,299 @@
+/*
+ * Benchmark.cpp is part of Brewtarget, and is Copyright the following
+ * authors 2021
+ * - Mik Firestone <mikfire@gmail.com>
+ *
+ * Brewtarget is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Brewtarget is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <xercesc/util/PlatformUtils.hpp>
+
+#include "Benchmark.h"
+
+#include <QBuffer>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSettings>
+#include <QString>
+#include <QTextStream>
+#include <QtTest/QtTest>
+
+#include "brewtarget.h"
+#include "BtTreeModel.h"
+#include "database.h"
+#include "Log.h"
+#include "model/BrewNote.h"
+#include "model/Equipment.h"
+#include "model/Fermentable.h"
+#include "model/Hop.h"
+#include "model/Mash.h"
+#include "model/MashStep.h"
+#include "model/Misc.h"
+#include "model/Recipe.h"
+#include "model/Yeast.h"
+#include "xml/BeerXml.h"
+
+QTEST_MAIN(Benchmark)
+
+int Benchmark::sizeFromEnv(char const* name, int defaultValue)
+{
+   bool ok = false;
+   int value = qEnvironmentVariableIntValue(name, &ok);
+   return ok && value >= 0 ? value : defaultValue;
+}
+
+void Benchmark::initTestCase()
+{
+   try {
+      xercesc::XMLPlatformUtils::Initialize();
+   } catch (xercesc::XMLException const & xercesInitException) {
+      qCritical() << Q_FUNC_INFO << "Xerces XML Parser Initialisation Failed: " << xercesInitException.getMessage();
+      return;
+   }
+
+   // Keep away from the real options and the real database
+   QCoreApplication::setOrganizationName("brewtarget-bench");
+   QCoreApplication::setOrganizationDomain("brewtarget.org/bench");
+   QCoreApplication::setApplicationName("brewtarget-bench");
+
+   QVERIFY( scratch.isValid() );
+   Brewtarget::setOption("user_data_dir", scratch.path());
+   Brewtarget::setOption("color_formula", "morey");
+   Brewtarget::setOption("ibu_formula", "tinseth");
+
+   Brewtarget::setInteractive(false);
+   QVERIFY( Brewtarget::initialize() );
+
+   // The log would otherwise be timed along with everything else
+   Log::isLoggingToStderr = false;
+   Log::logLevel = Log::LogType_WARNING;
+
+   numRecipes     = sizeFromEnv("BT_BENCH_RECIPES", 100);
+   numIngredients = sizeFromEnv("BT_BENCH_INGREDIENTS", 250);
+   numSnapshots   = sizeFromEnv("BT_BENCH_SNAPSHOTS", 2);
+   numBrewNotes   = sizeFromEnv("BT_BENCH_BREWNOTES", 3);
+
+   QElapsedTimer timer;
+   timer.start();
+   generate();
+   qInfo() << QString("Generated %1 recipes, %2 of each ingredient, %3 snapshots and %4 brew notes per recipe in %5 ms")
+              .arg(numRecipes).arg(numIngredients).arg(numSnapshots).arg(numBrewNotes).arg(timer.elapsed());
+}
+
+void Benchmark::generate()
+{
+   Database& db = Database::instance();
+
+   QList<Fermentable*> ferms;
+   QList<Hop*> hops;
+   QList<Misc*> miscs;
+   QList<Yeast*> yeasts;
+
+   // Everything is picked by index rather than at random, so every run gets
+   // the same database
+   db.beginBulkImport();
+   for ( int i = 0; i < numIngredients; ++i ) {
+      Fermentable* ferm = db.newFermentable();
+      ferm->setName(QString("Bench Malt %1").arg(i));
+      ferm->setType(i % 5 == 0 ? Fermentable::Sugar : Fermentable::Grain);
+      ferm->setYield_pct(60.0 + i % 20);
+      ferm->setColor_srm(2.0 + i % 40);
+      ferm->setIsMashed(i % 5 != 0);
+      ferms.append(ferm);
+
+      Hop* hop = db.newHop();
+      hop->setName(QString("Bench Hop %1").arg(i));
+      hop->setAlpha_pct(3.0 + i % 15);
+      hop->setUse(Hop::Boil);
+      hop->setTime_min(i % 4 * 20);
+      hop->setForm(i % 2 ? Hop::Pellet : Hop::Leaf);
+      hops.append(hop);
+
+      Misc* misc = db.newMisc();
+      misc->setName(QString("Bench Misc %1").arg(i));
+      misc->setUse(Misc::Boil);
+      misc->setTime(15);
+      misc->setAmount(0.01);
+      miscs.append(misc);
+
+      Yeast* yeast = db.newYeast();
+      yeast->setName(QString("Bench Yeast %1").arg(i));
+      yeast->setAttenuation_pct(65.0 + i % 20);
+      yeasts.append(yeast);
+   }
+
+   Equipment* equip = db.newEquipment();
+   equip->setName("Bench 20 L");
+   equip->setBoilSize_l(24.0);
+   equip->setBatchSize_l(20.0);
+   equip->setTunVolume_l(40.0);
+   equip->setEvapRate_lHr(4.0);
+   equip->setBoilTime_min(60);
+   equip->setGrainAbsorption_LKg(1.0);
+   equip->setBoilingPoint_c(100);
+   equip->setHopUtilization_pct(100);
+
+   for ( int i = 0; numIngredients > 0 && i < numRecipes; ++i ) {
+      Recipe* rec = db.newRecipe(QString("Bench Recipe %1").arg(i));
+      rec->setBatchSize_l(20.0);
+      rec->setBoilSize_l(24.0);
+      rec->setEfficiency_pct(70.0);
+
+      db.addToRecipe(rec, equip, false, false);
+      for ( int j = 0; j < 4; ++j ) {
+         Fermentable* ferm = ferms.at((i + j) % ferms.size());
+         ferm->setAmount_kg(j == 0 ? 4.0 : 0.25);
+         db.addToRecipe(rec, ferm, false, false);
+      }
+      for ( int j = 0; j < 3; ++j ) {
+         Hop* hop = hops.at((i + j) % hops.size());
+         hop->setAmount_kg(0.02);
+         db.addToRecipe(rec, hop, false, false);
+      }
+      db.addToRecipe(rec, miscs.at(i % miscs.size()), false, false);
+      db.addToRecipe(rec, yeasts.at(i % yeasts.size()), false, false);
+
+      Mash* mash = db.newMash(rec, false);
+      mash->setName(QString("Bench Mash %1").arg(i));
+      mash->setGrainTemp_c(20.0);
+      mash->setSpargeTemp_c(78.0);
+      MashStep* step = db.newMashStep(mash);
+      step->setName("Conversion");
+      step->setType(MashStep::Infusion);
+      step->setInfuseAmount_l(14.0);
+      step->setStepTemp_c(66.0);
+      step->setStepTime_min(60);
+
+      for ( int j = 0; j < numBrewNotes; ++j ) {
+         BrewNote* note = db.newBrewNote(rec, false);
+         note->setBrewDate(QDateTime::currentDateTime().addDays(-7 * j));
+         note->setOg(1.050);
+         note->setFg(1.010);
+         note->setNotes(QString("Bench brew %1").arg(j));
+      }
+
+      Recipe* latest = rec;
+      for ( int j = 0; j < numSnapshots; ++j )
+         latest = db.newRecipe(latest, true);
+   }
+   QVERIFY( db.endBulkImport(true) );
+}
+
+void Benchmark::databaseLoad()
+{
+   // This times unload() too, but that is small next to the load
+   QBENCHMARK {
+      Database::dropInstance();
+      QVERIFY( Database::instance().loadSuccessful() );
+   }
+}
+
+void Benchmark::recipeRecalcAll()
+{
+   QList<Recipe*> recipes = Database::instance().recipes();
+
+   QBENCHMARK {
+      foreach( Recipe* rec, recipes )
+         rec->recalcAll();
+   }
+}
+
+void Benchmark::treeModelLoad()
+{
+   QBENCHMARK {
+      BtTreeModel model(nullptr, BtTreeModel::RECIPEMASK);
+   }
+}
+
+void Benchmark::databaseUpdateEntry()
+{
+   Database& db = Database::instance();
+   QList<Hop*> hops = db.hops();
+   int pass = 0;
+
+   QBENCHMARK {
+      // A different value every pass, so each write really changes something
+      double alpha = 5.0 + pass++ % 10;
+      foreach( Hop* hop, hops )
+         db.updateEntry(hop, PropertyNames::Hop::alpha_pct, alpha, false);
+      db.flushPendingWrites();
+   }
+}
+
+void Benchmark::beerXmlExport()
+{
+   BeerXML* bxml = Database::instance().getBeerXml();
+   BeerXML::ExportList items;
+   items.recipes = Database::instance().recipes();
+
+   QBENCHMARK {
+      QBuffer buffer;
+      QVERIFY( buffer.open(QIODevice::WriteOnly) );
+      QVERIFY( bxml->exportToXml(items, &buffer) );
+      QVERIFY( ! buffer.data().isEmpty() );
+   }
+}
+
+void Benchmark::beerXmlStreamExport_data()
+{
+   QTest::addColumn<bool>("compress");
+   QTest::newRow("plain") << false;
+   QTest::newRow("gzip") << true;
+}
+
+void Benchmark::beerXmlStreamExport()
+{
+   QFETCH(bool, compress);
+   BeerXML* bxml = Database::instance().getBeerXml();
+   BeerXML::ExportList items = bxml->everything();
+
+   QBENCHMARK {
+      QFile file(scratch.filePath(compress ? "stream.xml.gz" : "stream.xml"));
+      QVERIFY( file.open(QIODevice::WriteOnly | QIODevice::Truncate) );
+      QVERIFY( bxml->exportToXml(items, &file, compress) );
+   }
+}
+
+void Benchmark::beerXmlImport()
+{
+   BeerXML* bxml = Database::instance().getBeerXml();
+
+   QString fileName = scratch.filePath("bench.xml");
+   {
+      BeerXML::ExportList items;
+      foreach( Recipe* rec, Database::instance().recipes() ) {
+         if ( rec->display() )
+            items.recipes.append(rec);
+      }
+
+      QFile file(fileName);
+      QVERIFY( file.open(QIODevice::WriteOnly | QIODevice::Truncate) );
+      QVERIFY( bxml->exportToXml(items, &file) );
+   }
+
+   // Every pass adds another copy of everything, so only the one
+   QString message;
+   QTextStream userMessage(&message);
+   QBENCHMARK_ONCE {
+      QVERIFY2( bxml->importFromXML(fileName, userMessage), qPrintable(message) );
+   }
+}
+
+void Benchmark::cleanupTestCase()
+{
+   Brewtarget::cleanup();
+   QSettings().clear();
+   xercesc::XMLPlatformUtils::Terminate();
+}
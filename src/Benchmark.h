@@ -0,0 +1,84 @@
+/*
+ * Benchmark.h is part of Brewtarget, and is Copyright the following
+ * authors 2021
+ * - Mik Firestone <mikfire@gmail.com>
+ *
+ * Brewtarget is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Brewtarget is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <QObject>
+#include <QString>
+#include <QTemporaryDir>
+#include <QtTest/QtTest>
+
+/*!
+ * \class Benchmark
+ *
+ * \brief Timings for the data layer and the recipe math, run by
+ * brewtarget_bench.
+ *
+ * initTestCase() builds a synthetic database in a scratch directory. How big
+ * it gets comes from the environment:
+ *
+ *  - BT_BENCH_RECIPES      recipes (default 100)
+ *  - BT_BENCH_INGREDIENTS  fermentables, hops, miscs and yeasts of each kind (default 250)
+ *  - BT_BENCH_SNAPSHOTS    snapshots of each recipe (default 2)
+ *  - BT_BENCH_BREWNOTES    brew notes on each recipe (default 3)
+ *
+ * The results are ordinary QTest benchmark results, so any of QTest's
+ * loggers can write them down. "brewtarget_bench -o bench.xml,xml" (or
+ * "make benchmark") gives XML that can be compared between releases.
+ */
+class Benchmark : public QObject
+{
+   Q_OBJECT
+
+private:
+   //! \brief \c name from the environment, or \c defaultValue if it isn't set
+   static int sizeFromEnv(char const* name, int defaultValue);
+
+   //! \brief Fills the database with the synthetic recipes and ingredients
+   void generate();
+
+   QTemporaryDir scratch;
+   int numRecipes;
+   int numIngredients;
+   int numSnapshots;
+   int numBrewNotes;
+
+private slots:
+   void initTestCase();
+   void cleanupTestCase();
+
+   //! \brief Database::load(), by dropping the instance and making a new one
+   void databaseLoad();
+   //! \brief Recipe::recalcAll() over every recipe
+   void recipeRecalcAll();
+   //! \brief BtTreeModel::loadTreeModel(), by building a recipe tree
+   void treeModelLoad();
+   //! \brief Database::updateEntry() on every hop, flushed
+   void databaseUpdateEntry();
+   //! \brief BeerXML::exportToXml() of every recipe, into memory
+   void beerXmlExport();
+   //! \brief BeerXML::exportToXml() of the whole library to a file, plain and gzipped
+   void beerXmlStreamExport();
+   void beerXmlStreamExport_data();
+   //! \brief BeerXML import of every recipe. Last, because it adds to the database
+   void beerXmlImport();
+};
+
+#endif /*BENCHMARK_H*/
@@ -18,6 +18,8 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include <QDebug>
+#include <QDate>
+#include <QDateTime>
 
 #include "brewtarget.h"
 #include "BtTreeFilterProxyModel.h"
@@ -69,7 +71,7 @@ bool BtTreeFilterProxyModel::lessThanRecipe(BtTreeModel* model, const QModelInde
       BrewNote *rightBn = model->brewNote(right);
 
       if ( leftBn && rightBn )
-         return leftBn->brewDate() < rightBn->brewDate();
+         return keyLessThan(sortKey(model, left), sortKey(model, right));
       else
          return false;
    }
@@ -96,32 +98,13 @@ bool BtTreeFilterProxyModel::lessThanRecipe(BtTreeModel* model, const QModelInde
    }
 
 
-   Recipe* leftRecipe  = model->recipe(left);
-   Recipe* rightRecipe = model->recipe(right);
-
    // Yog-Sothoth knows the gate
    // This reads soo much better
    if ( model->showChild(left) && model->showChild(right) ) {
-      return leftRecipe->key() > rightRecipe->key();
+      return model->recipe(left)->key() > model->recipe(right)->key();
    }
 
-   switch(left.column())
-   {
-      case BtTreeItem::RECIPENAMECOL:
-         return leftRecipe->name() < rightRecipe->name();
-      case BtTreeItem::RECIPEBREWDATECOL:
-         return leftRecipe->date() < rightRecipe->date();
-      case BtTreeItem::RECIPESTYLECOL:
-         if ( ! leftRecipe->style() )
-            return true;
-         else if ( ! rightRecipe->style() )
-            return false;
-         else
-            return leftRecipe->style()->name() < rightRecipe->style()->name();
-   }
-   // Default will be to just do a name sort. This doesn't likely make sense,
-   // but it will prevent a lot of warnings.
-   return leftRecipe->name() < rightRecipe->name();
+   return keyLessThan(sortKey(model, left), sortKey(model, right));
 }
 
 bool BtTreeFilterProxyModel::lessThanEquip(BtTreeModel* model, const QModelIndex &left,
@@ -148,18 +131,7 @@ bool BtTreeFilterProxyModel::lessThanEquip(BtTreeModel* model, const QModelIndex
       return leftFolder->fullPath() < rightFolder->fullPath();
    }
 
-   Equipment* leftEquip = model->equipment(left);
-   Equipment* rightEquip = model->equipment(right);
-
-
-   switch(left.column())
-   {
-      case BtTreeItem::EQUIPMENTNAMECOL:
-         return leftEquip->name() < rightEquip->name();
-      case BtTreeItem::EQUIPMENTBOILTIMECOL:
-         return leftEquip->boilTime_min() < rightEquip->boilTime_min();
-   }
-   return leftEquip->name() < rightEquip->name();
+   return keyLessThan(sortKey(model, left), sortKey(model, right));
 }
 
 bool BtTreeFilterProxyModel::lessThanFerment(BtTreeModel* model, const QModelIndex &left,
@@ -186,19 +158,7 @@ bool BtTreeFilterProxyModel::lessThanFerment(BtTreeModel* model, const QModelInd
       return leftFolder->fullPath() < rightFolder->fullPath();
    }
 
-   Fermentable* leftFerment = model->fermentable(left);
-   Fermentable* rightFerment = model->fermentable(right);
-
-   switch(left.column())
-   {
-      case BtTreeItem::FERMENTABLENAMECOL:
-         return leftFerment->name() < rightFerment->name();
-      case BtTreeItem::FERMENTABLETYPECOL:
-         return leftFerment->type() < rightFerment->type();
-      case BtTreeItem::FERMENTABLECOLORCOL:
-         return leftFerment->color_srm() < rightFerment->color_srm();
-   }
-   return leftFerment->name() < rightFerment->name();
+   return keyLessThan(sortKey(model, left), sortKey(model, right));
 }
 
 bool BtTreeFilterProxyModel::lessThanHop(BtTreeModel* model, const QModelIndex &left,
@@ -225,20 +185,7 @@ bool BtTreeFilterProxyModel::lessThanHop(BtTreeModel* model, const QModelIndex &
       return leftFolder->fullPath() < rightFolder->fullPath();
    }
 
-   Hop* leftHop = model->hop(left);
-   Hop* rightHop = model->hop(right);
-
-
-   switch(left.column())
-   {
-      case BtTreeItem::HOPNAMECOL:
-         return leftHop->name() < rightHop->name();
-      case BtTreeItem::HOPFORMCOL:
-         return leftHop->form() < rightHop->form();
-      case BtTreeItem::HOPUSECOL:
-         return leftHop->use() < rightHop->use();
-   }
-   return leftHop->name() < rightHop->name();
+   return keyLessThan(sortKey(model, left), sortKey(model, right));
 }
 
 bool BtTreeFilterProxyModel::lessThanMisc(BtTreeModel* model, const QModelIndex &left,
@@ -265,19 +212,7 @@ bool BtTreeFilterProxyModel::lessThanMisc(BtTreeModel* model, const QModelIndex
       return leftFolder->fullPath() < rightFolder->fullPath();
    }
 
-   Misc* leftMisc = model->misc(left);
-   Misc* rightMisc = model->misc(right);
-
-   switch(left.column())
-   {
-      case BtTreeItem::MISCNAMECOL:
-         return leftMisc->name() < rightMisc->name();
-      case BtTreeItem::MISCTYPECOL:
-         return leftMisc->type() < rightMisc->type();
-      case BtTreeItem::MISCUSECOL:
-         return leftMisc->use() < rightMisc->use();
-   }
-   return leftMisc->name() < rightMisc->name();
+   return keyLessThan(sortKey(model, left), sortKey(model, right));
 }
 
 bool BtTreeFilterProxyModel::lessThanStyle(BtTreeModel* model, const QModelIndex &left,
@@ -304,24 +239,7 @@ bool BtTreeFilterProxyModel::lessThanStyle(BtTreeModel* model, const QModelIndex
       return leftFolder->fullPath() < rightFolder->fullPath();
    }
 
-   Style* leftStyle = model->style(left);
-   Style* rightStyle = model->style(right);
-
-
-   switch(left.column())
-   {
-      case BtTreeItem::STYLENAMECOL:
-         return leftStyle->name() < rightStyle->name();
-      case BtTreeItem::STYLECATEGORYCOL:
-         return leftStyle->category() < rightStyle->category();
-      case BtTreeItem::STYLENUMBERCOL:
-         return leftStyle->categoryNumber() < rightStyle->categoryNumber();
-      case BtTreeItem::STYLELETTERCOL:
-         return leftStyle->styleLetter() < rightStyle->styleLetter();
-      case BtTreeItem::STYLEGUIDECOL:
-         return leftStyle->styleGuide() < rightStyle->styleGuide();
-   }
-   return leftStyle->name() < rightStyle->name();
+   return keyLessThan(sortKey(model, left), sortKey(model, right));
 }
 
 bool BtTreeFilterProxyModel::lessThanYeast(BtTreeModel* model, const QModelIndex &left,
@@ -348,20 +266,7 @@ bool BtTreeFilterProxyModel::lessThanYeast(BtTreeModel* model, const QModelIndex
       return leftFolder->fullPath() < rightFolder->fullPath();
    }
 
-   Yeast* leftYeast = model->yeast(left);
-   Yeast* rightYeast = model->yeast(right);
-
-
-   switch(left.column())
-   {
-      case BtTreeItem::YEASTNAMECOL:
-         return leftYeast->name() < rightYeast->name();
-      case BtTreeItem::YEASTTYPECOL:
-         return leftYeast->type() < rightYeast->type();
-      case BtTreeItem::YEASTFORMCOL:
-         return leftYeast->form() < rightYeast->form();
-   }
-   return leftYeast->name() < rightYeast->name();
+   return keyLessThan(sortKey(model, left), sortKey(model, right));
 }
 
 bool BtTreeFilterProxyModel::lessThanWater(BtTreeModel* model, const QModelIndex &left,
@@ -388,30 +293,183 @@ bool BtTreeFilterProxyModel::lessThanWater(BtTreeModel* model, const QModelIndex
       return leftFolder->fullPath() < rightFolder->fullPath();
    }
 
-   Water*  leftWater = model->water(left);
-   Water* rightWater = model->water(right);
+   return keyLessThan(sortKey(model, left), sortKey(model, right));
+}
+
+QVariant BtTreeFilterProxyModel::sortKey(BtTreeModel* model, const QModelIndex &idx) const
+{
+   NamedEntity* thing = model->thing(idx);
+   if ( ! thing )
+      return QVariant();
+
+   QHash<int,QVariant>& keys = sortKeys[thing];
+   if ( keys.contains(idx.column()) )
+      return keys.value(idx.column());
+
+   // First time we've seen this one, so make sure we hear when it changes or
+   // goes away. UniqueConnection, because we come back here after every
+   // change
+   connect( thing, &NamedEntity::changed, this, &BtTreeFilterProxyModel::dropSortKeys, Qt::UniqueConnection );
+   connect( thing, &QObject::destroyed, this, &BtTreeFilterProxyModel::forgetSortKeys, Qt::UniqueConnection );
+
+   QVariant key = makeSortKey(thing, idx.column());
+   keys.insert(idx.column(), key);
+   return key;
+}
 
+QVariant BtTreeFilterProxyModel::makeSortKey(NamedEntity* thing, int column) const
+{
+   // Enums are stored as ints, so keyLessThan() can compare them
+   if ( BrewNote* note = qobject_cast<BrewNote*>(thing) )
+      return note->brewDate();
 
-   switch(left.column())
+   switch( treeMask )
    {
-      case BtTreeItem::WATERNAMECOL:
-         return leftWater->name() < rightWater->name();
-      case BtTreeItem::WATERpHCOL:
-         return leftWater->ph() < rightWater->ph();
-      case BtTreeItem::WATERHCO3COL:
-         return leftWater->bicarbonate_ppm() < rightWater->bicarbonate_ppm();
-      case BtTreeItem::WATERSO4COL:
-         return leftWater->sulfate_ppm() < rightWater->sulfate_ppm();
-      case BtTreeItem::WATERCLCOL:
-         return leftWater->chloride_ppm() < rightWater->chloride_ppm();
-      case BtTreeItem::WATERNACOL:
-         return leftWater->sodium_ppm() < rightWater->sodium_ppm();
-      case BtTreeItem::WATERMGCOL:
-         return leftWater->magnesium_ppm() < rightWater->magnesium_ppm();
-      case BtTreeItem::WATERCACOL:
-         return leftWater->calcium_ppm() < rightWater->calcium_ppm();
+      case BtTreeModel::RECIPEMASK:
+         if ( Recipe* rec = qobject_cast<Recipe*>(thing) ) {
+            switch(column)
+            {
+               case BtTreeItem::RECIPEBREWDATECOL:
+                  return rec->date();
+               case BtTreeItem::RECIPESTYLECOL:
+                  if ( Style* style = rec->style() ) {
+                     // A renamed style changes the key of every recipe that
+                     // uses it. Styles don't change often, so start over.
+                     connect( style, &NamedEntity::changed, this, &BtTreeFilterProxyModel::dropAllSortKeys, Qt::UniqueConnection );
+                     return style->name();
+                  }
+                  // no style sorts first
+                  return QString();
+            }
+         }
+         break;
+      case BtTreeModel::EQUIPMASK:
+         if ( Equipment* equip = qobject_cast<Equipment*>(thing) ) {
+            if ( column == BtTreeItem::EQUIPMENTBOILTIMECOL )
+               return equip->boilTime_min();
+         }
+         break;
+      case BtTreeModel::FERMENTMASK:
+         if ( Fermentable* ferm = qobject_cast<Fermentable*>(thing) ) {
+            switch(column)
+            {
+               case BtTreeItem::FERMENTABLETYPECOL:
+                  return static_cast<int>(ferm->type());
+               case BtTreeItem::FERMENTABLECOLORCOL:
+                  return ferm->color_srm();
+            }
+         }
+         break;
+      case BtTreeModel::HOPMASK:
+         if ( Hop* hop = qobject_cast<Hop*>(thing) ) {
+            switch(column)
+            {
+               case BtTreeItem::HOPFORMCOL:
+                  return static_cast<int>(hop->form());
+               case BtTreeItem::HOPUSECOL:
+                  return static_cast<int>(hop->use());
+            }
+         }
+         break;
+      case BtTreeModel::MISCMASK:
+         if ( Misc* misc = qobject_cast<Misc*>(thing) ) {
+            switch(column)
+            {
+               case BtTreeItem::MISCTYPECOL:
+                  return static_cast<int>(misc->type());
+               case BtTreeItem::MISCUSECOL:
+                  return static_cast<int>(misc->use());
+            }
+         }
+         break;
+      case BtTreeModel::STYLEMASK:
+         if ( Style* style = qobject_cast<Style*>(thing) ) {
+            switch(column)
+            {
+               case BtTreeItem::STYLECATEGORYCOL:
+                  return style->category();
+               case BtTreeItem::STYLENUMBERCOL:
+                  return style->categoryNumber();
+               case BtTreeItem::STYLELETTERCOL:
+                  return style->styleLetter();
+               case BtTreeItem::STYLEGUIDECOL:
+                  return style->styleGuide();
+            }
+         }
+         break;
+      case BtTreeModel::YEASTMASK:
+         if ( Yeast* yeast = qobject_cast<Yeast*>(thing) ) {
+            switch(column)
+            {
+               case BtTreeItem::YEASTTYPECOL:
+                  return static_cast<int>(yeast->type());
+               case BtTreeItem::YEASTFORMCOL:
+                  return static_cast<int>(yeast->form());
+            }
+         }
+         break;
+      case BtTreeModel::WATERMASK:
+         if ( Water* water = qobject_cast<Water*>(thing) ) {
+            switch(column)
+            {
+               case BtTreeItem::WATERpHCOL:
+                  return water->ph();
+               case BtTreeItem::WATERHCO3COL:
+                  return water->bicarbonate_ppm();
+               case BtTreeItem::WATERSO4COL:
+                  return water->sulfate_ppm();
+               case BtTreeItem::WATERCLCOL:
+                  return water->chloride_ppm();
+               case BtTreeItem::WATERNACOL:
+                  return water->sodium_ppm();
+               case BtTreeItem::WATERMGCOL:
+                  return water->magnesium_ppm();
+               case BtTreeItem::WATERCACOL:
+                  return water->calcium_ppm();
+            }
+         }
+         break;
+      default:
+         break;
+   }
+
+   // Default will be to just do a name sort. This doesn't likely make sense,
+   // but it will prevent a lot of warnings.
+   return thing->name();
+}
+
+bool BtTreeFilterProxyModel::keyLessThan(QVariant const& left, QVariant const& right)
+{
+   switch( left.type() )
+   {
+      case QVariant::Date:
+         return left.toDate() < right.toDate();
+      case QVariant::DateTime:
+         return left.toDateTime() < right.toDateTime();
+      case QVariant::Int:
+      case QVariant::Double:
+         return left.toDouble() < right.toDouble();
+      default:
+         return left.toString() < right.toString();
    }
-   return leftWater->name() < rightWater->name();
+}
+
+void BtTreeFilterProxyModel::dropSortKeys()
+{
+   NamedEntity* thing = qobject_cast<NamedEntity*>(sender());
+   if ( thing )
+      sortKeys.remove(thing);
+}
+
+void BtTreeFilterProxyModel::forgetSortKeys(QObject* gone)
+{
+   // Too late to qobject_cast. We only need the address anyway
+   sortKeys.remove(static_cast<NamedEntity*>(gone));
+}
+
+void BtTreeFilterProxyModel::dropAllSortKeys()
+{
+   sortKeys.clear();
 }
 
 bool BtTreeFilterProxyModel::filterAcceptsRow(int source_row, const QModelIndex &source_parent) const
@@ -23,7 +23,9 @@
 
 class BtTreeFilterProxyModel;
 
+#include <QHash>
 #include <QSortFilterProxyModel>
+#include <QVariant>
 
 #include "BtFolder.h"
 #include "BtTreeModel.h"
@@ -56,9 +58,33 @@ protected:
    bool lessThan(const QModelIndex &left, const QModelIndex &right) const;
    bool filterAcceptsRow( int source_row, const QModelIndex &source_parent) const;
 
+private slots:
+   //! \brief drops the cached sort keys of whatever sent changed()
+   void dropSortKeys();
+   //! \brief drops the cached sort keys of something that is being destroyed
+   void forgetSortKeys(QObject* gone);
+   //! \brief drops every cached sort key
+   void dropAllSortKeys();
+
 private:
    BtTreeModel::TypeMasks treeMask;
 
+   /*!
+    * \brief What each thing sorts on, by column.
+    *
+    * A sort calls lessThan() O(n log n) times, and some of the values go
+    * through a recalc or a db read. So work each one out once and keep it
+    * until the thing changes.
+    */
+   mutable QHash< NamedEntity*, QHash<int,QVariant> > sortKeys;
+
+   //! \brief returns the sort key for \c idx, working it out if we don't have it
+   QVariant sortKey(BtTreeModel* model, const QModelIndex &idx) const;
+   //! \brief works out what \c thing sorts on in \c column
+   QVariant makeSortKey(NamedEntity* thing, int column) const;
+   //! \brief compares two keys from makeSortKey()
+   static bool keyLessThan(QVariant const& left, QVariant const& right);
+
    bool lessThanRecipe(BtTreeModel* model,const QModelIndex &left, const QModelIndex &right) const;
    bool lessThanEquip(BtTreeModel* model,const QModelIndex &left, const QModelIndex &right) const;
    bool lessThanFerment(BtTreeModel* model,const QModelIndex &left, const QModelIndex &right) const;
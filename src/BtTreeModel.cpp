@@ -32,6 +32,7 @@
 #include "BtTreeItem.h"
 #include "BtTreeModel.h"
 #include "BtTreeView.h"
+#include "OptionStore.h"
 #include "RecipeFormatter.h"
 #include "database.h"
 #include "model/Equipment.h"
@@ -54,6 +55,7 @@ BtTreeModel::BtTreeModel(BtTreeView *parent, TypeMasks type)
    // Initialize the tree structure
    int items = 0;
    rootItem = new BtTreeItem();
+   resetting = false;
 
    switch (type)
    {
@@ -264,26 +266,27 @@ QVariant BtTreeModel::data(const QModelIndex &index, int role) const
 
 QVariant BtTreeModel::toolTipData(const QModelIndex &index) const
 {
-   RecipeFormatter* whiskey = new RecipeFormatter();
+   // Cheap to make; the rendered tooltips are cached by RecipeFormatter itself
+   RecipeFormatter whiskey;
 
    switch(treeMask)
    {
       case RECIPEMASK:
-         return whiskey->getToolTip(qobject_cast<Recipe*>(thing(index)));
+         return whiskey.getToolTip(qobject_cast<Recipe*>(thing(index)));
       case STYLEMASK:
-         return whiskey->getToolTip( qobject_cast<Style*>(thing(index)));
+         return whiskey.getToolTip( qobject_cast<Style*>(thing(index)));
       case EQUIPMASK:
-         return whiskey->getToolTip( qobject_cast<Equipment*>(thing(index)));
+         return whiskey.getToolTip( qobject_cast<Equipment*>(thing(index)));
       case FERMENTMASK:
-         return whiskey->getToolTip( qobject_cast<Fermentable*>(thing(index)));
+         return whiskey.getToolTip( qobject_cast<Fermentable*>(thing(index)));
       case HOPMASK:
-         return whiskey->getToolTip( qobject_cast<Hop*>(thing(index)));
+         return whiskey.getToolTip( qobject_cast<Hop*>(thing(index)));
       case MISCMASK:
-         return whiskey->getToolTip( qobject_cast<Misc*>(thing(index)));
+         return whiskey.getToolTip( qobject_cast<Misc*>(thing(index)));
       case YEASTMASK:
-         return whiskey->getToolTip( qobject_cast<Yeast*>(thing(index)));
+         return whiskey.getToolTip( qobject_cast<Yeast*>(thing(index)));
       case WATERMASK:
-         return whiskey->getToolTip( qobject_cast<Water*>(thing(index)));
+         return whiskey.getToolTip( qobject_cast<Water*>(thing(index)));
       default:
          return item(index)->name();
    }
@@ -488,15 +491,20 @@ bool BtTreeModel::insertRow(int row, const QModelIndex &parent, QObject* victim,
 
    bool success = true;
 
-   beginInsertRows(parent,row,row);
+   // loadTreeModel() wraps the whole load in a model reset, so nobody needs
+   // to hear about each row
+   if ( ! resetting )
+      beginInsertRows(parent,row,row);
    success = pItem->insertChildren(row,1,type);
    if ( victim && success )
    {
       type = victimType == -1 ? type : victimType;
       BtTreeItem* added = pItem->child(row);
       added->setData(type, victim);
+      indexItem(added);
    }
-   endInsertRows();
+   if ( ! resetting )
+      endInsertRows();
 
    return success;
 }
@@ -506,6 +514,10 @@ bool BtTreeModel::removeRows(int row, int count, const QModelIndex &parent)
    BtTreeItem *pItem = item(parent);
    bool success = true;
 
+   // The items are deleted by removeChildren(), so forget them first
+   for ( int i = row; i < row + count && i < pItem->childCount(); ++i )
+      unindexSubtree(pItem->child(i));
+
    beginRemoveRows(parent, row, row + count -1 );
    success = pItem->removeChildren(row,count);
    endRemoveRows();
@@ -513,6 +525,37 @@ bool BtTreeModel::removeRows(int row, int count, const QModelIndex &parent)
    return success;
 }
 
+void BtTreeModel::indexItem(BtTreeItem* item)
+{
+   if ( item->type() == BtTreeItem::FOLDER ) {
+      if ( item->folder() )
+         folderIndex.insert(item->folder()->fullPath(), item);
+   }
+   else if ( item->thing() )
+      itemIndex.insert(item->thing(), item);
+}
+
+void BtTreeModel::unindexSubtree(BtTreeItem* item)
+{
+   QList<BtTreeItem*> pending;
+   pending.append(item);
+
+   while ( ! pending.isEmpty() )
+   {
+      BtTreeItem* target = pending.takeLast();
+
+      if ( target->type() == BtTreeItem::FOLDER ) {
+         if ( target->folder() && folderIndex.value(target->folder()->fullPath()) == target )
+            folderIndex.remove(target->folder()->fullPath());
+      }
+      else if ( target->thing() )
+         itemIndex.remove(target->thing(), target);
+
+      for ( int i = 0; i < target->childCount(); ++i )
+         pending.append(target->child(i));
+   }
+}
+
 // =========================================================================
 // ====================== BREWTARGET STUFF =================================
 // =========================================================================
@@ -533,6 +576,39 @@ QModelIndex BtTreeModel::findElement(NamedEntity* thing, BtTreeItem* parent)
    if (! thing )
       return createIndex(0,0,pItem);
 
+   // Searching the whole tree is a lookup. What the search below would find
+   // is the shallowest copy that is only under folders (or, for a brewnote,
+   // folders and recipes), so pick that one out of the index.
+   if ( pItem == rootItem->child(0) )
+   {
+      bool isNote = qobject_cast<BrewNote*>(thing) != nullptr;
+      BtTreeItem* found = nullptr;
+      int foundDepth = -1;
+
+      foreach( BtTreeItem* candidate, itemIndex.values(thing) )
+      {
+         int depth = 0;
+         BtTreeItem* up = candidate->parent();
+
+         while ( up && up != pItem &&
+                 ( up->type() == BtTreeItem::FOLDER || (isNote && up->type() == BtTreeItem::RECIPE) ) )
+         {
+            up = up->parent();
+            ++depth;
+         }
+
+         if ( up == pItem && (found == nullptr || depth < foundDepth) )
+         {
+            found = candidate;
+            foundDepth = depth;
+         }
+      }
+
+      if ( found )
+         return createIndex(found->childNumber(),0,found);
+      return QModelIndex();
+   }
+
    folders.append(pItem);
 
    while ( ! folders.isEmpty() )
@@ -605,6 +681,11 @@ void BtTreeModel::loadTreeModel()
    BtTreeItem* local = nullptr;
    QList<NamedEntity*> elems = elements();
 
+   // One reset for the lot, instead of a begin/endInsertRows() for every
+   // ingredient
+   beginResetModel();
+   resetting = true;
+
    foreach( NamedEntity* elem, elems ) {
 
       if (! elem->folder().isEmpty() ) {
@@ -631,7 +712,7 @@ void BtTreeModel::loadTreeModel()
       // If we have brewnotes, set them up here.
       if ( treeMask & RECIPEMASK ) {
          Recipe *holdmebeer = qobject_cast<Recipe*>(elem);
-         if ( Brewtarget::option("showsnapshots", false).toBool() && holdmebeer->hasAncestors() ) {
+         if ( OptionStore::instance().boolValue("showsnapshots", false) && holdmebeer->hasAncestors() ) {
             setShowChild(ndxLocal,true);
             addAncestoralTree(holdmebeer, i, local);
             addBrewNoteSubTree(holdmebeer,i,local,false);
@@ -642,6 +723,9 @@ void BtTreeModel::loadTreeModel()
       }
       observeElement(elem);
    }
+
+   resetting = false;
+   endResetModel();
 }
 
 void BtTreeModel::addAncestoralTree(Recipe* rec, int i, BtTreeItem* parent)
@@ -1183,7 +1267,8 @@ QModelIndex BtTreeModel::createFolderTree( QStringList dirs, BtTreeItem* parent,
    // Need to call this because we are adding different things with different
    // column counts. Just using the rowsAboutToBeAdded throws ugly errors and
    // then a sigsegv
-   emit layoutAboutToBeChanged();
+   if ( ! resetting )
+      emit layoutAboutToBeChanged();
    foreach ( QString cur, dirs )
    {
       QString fPath;
@@ -1204,6 +1289,7 @@ QModelIndex BtTreeModel::createFolderTree( QStringList dirs, BtTreeItem* parent,
 
       pItem->insertChildren(i, 1, BtTreeItem::FOLDER);
       pItem->child(i)->setData(BtTreeItem::FOLDER, temp);
+      indexItem(pItem->child(i));
 
       // Set the parent item to point to the newly created tree
       pItem = pItem->child(i);
@@ -1211,7 +1297,8 @@ QModelIndex BtTreeModel::createFolderTree( QStringList dirs, BtTreeItem* parent,
       // And this for the return
       ndx = createIndex(pItem->childCount(), 0, pItem);
    }
-   emit layoutChanged();
+   if ( ! resetting )
+      emit layoutChanged();
 
    // May K&R have mercy on my soul
    return ndx;
@@ -1245,6 +1332,30 @@ QModelIndex BtTreeModel::findFolder( QString name, BtTreeItem* parent, bool crea
    if ( dirs.isEmpty() )
       return QModelIndex();
 
+   // Folders only ever hang off the top of the tree or other folders, so
+   // from the top a folder is just its full path
+   if ( pItem == rootItem->child(0) ) {
+      targetPath = "/" % dirs.join("/");
+      BtTreeItem* kid = folderIndex.value(targetPath, nullptr);
+      if ( kid )
+         return createIndex(kid->childNumber(),0,kid);
+
+      if ( ! create )
+         return QModelIndex();
+
+      // Find the deepest folder we do have, and make the rest under it
+      QStringList missing;
+      while ( ! dirs.isEmpty() ) {
+         missing.prepend(dirs.takeLast());
+         if ( dirs.isEmpty() )
+            break;
+         kid = folderIndex.value("/" % dirs.join("/"), nullptr);
+         if ( kid )
+            return createFolderTree( missing, kid, kid->folder()->fullPath() );
+      }
+      return createFolderTree( missing, pItem, "/" );
+   }
+
    current = dirs.takeFirst();
    fullPath = "/";
    targetPath = fullPath % current;
@@ -25,6 +25,7 @@ class BtTreeModel;
 #include <QModelIndex>
 #include <QVariant>
 #include <QList>
+#include <QHash>
 #include <QAbstractItemModel>
 #include <QMetaProperty>
 #include <QVariant>
@@ -293,7 +294,18 @@ private:
    void makeAncestors(NamedEntity* ancestor, NamedEntity* descendant);
    void addAncestoralTree(Recipe* rec, int i, BtTreeItem* parent);
 
+   //! \brief adds \c item to itemIndex or folderIndex, as appropriate
+   void indexItem(BtTreeItem* item);
+   //! \brief takes \c item and everything under it out of the indexes. Call it before the items are deleted
+   void unindexSubtree(BtTreeItem* item);
+
    BtTreeItem* rootItem;
+   //! \brief every item in the tree, by what it shows. The same thing can be in the tree more than once (eg, ancestors and their brewnotes)
+   QMultiHash<NamedEntity*, BtTreeItem*> itemIndex;
+   //! \brief every folder in the tree, by full path
+   QHash<QString, BtTreeItem*> folderIndex;
+   //! \brief true while loadTreeModel() is filling the tree inside a model reset
+   bool resetting;
    BtTreeView *parentTree;
    TypeMasks treeMask;
    int _type, m_maxColumns;
@@ -0,0 +1,418 @@
+/*
+ * DatabaseBackup.cpp is part of Brewtarget, and is Copyright the following
+ * authors 2021
+ * - Mik Firestone <mikfire@gmail.com>
+ *
+ * Brewtarget is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Brewtarget is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "DatabaseBackup.h"
+
+#include <functional>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QEvent>
+#include <QFile>
+#include <QProcessEnvironment>
+#include <QRunnable>
+#include <QSqlDatabase>
+#include <QSqlDriver>
+#include <QSqlQuery>
+#include <QStringList>
+#include <QTimer>
+#include <QVariant>
+
+#include <sqlite3.h>
+#include <zlib.h>
+
+#include "brewtarget.h"
+#include "database.h"
+
+namespace {
+   // Small enough that a step never holds up the event loop noticeably
+   int const pagesPerStep = 128;
+   int const stepIntervalMs = 10;
+
+   //! \brief gzips \c from into \c to. Safe on any thread
+   bool gzipFile(QString const& from, QString const& to)
+   {
+      QFile in(from);
+      if ( ! in.open(QIODevice::ReadOnly) ) {
+         qCritical() << QString("%1 could not open %2: %3").arg(Q_FUNC_INFO).arg(from).arg(in.errorString());
+         return false;
+      }
+
+      gzFile out = gzopen( QFile::encodeName(to).constData(), "wb6" );
+      if ( ! out ) {
+         qCritical() << QString("%1 could not open %2").arg(Q_FUNC_INFO).arg(to);
+         return false;
+      }
+
+      bool success = true;
+      while ( success && ! in.atEnd() ) {
+         QByteArray chunk = in.read(1 << 16);
+         if ( gzwrite(out, chunk.constData(), static_cast<unsigned>(chunk.size())) != chunk.size() ) {
+            qCritical() << QString("%1 could not write %2").arg(Q_FUNC_INFO).arg(to);
+            success = false;
+         }
+      }
+
+      if ( gzclose(out) != Z_OK )
+         success = false;
+
+      return success;
+   }
+
+   class CompressRunnable : public QRunnable
+   {
+   public:
+      CompressRunnable(std::function<void()> work) : work(work) {}
+      void run() { work(); }
+
+   private:
+      std::function<void()> work;
+   };
+}
+
+DatabaseBackup::DatabaseBackup(QString const& target, bool compress, QObject* parent)
+   : QObject(parent),
+     m_target(target),
+     m_compress(compress),
+     m_running(false),
+     m_dest(nullptr),
+     m_backup(nullptr),
+     m_timer(nullptr),
+     m_dump(nullptr),
+     m_tablesDumped(0),
+     m_tableCount(0)
+{
+   if ( m_compress && ! m_target.endsWith(".gz") )
+      m_target.append(".gz");
+   m_partFile = m_target + ".part";
+   m_pool.setMaxThreadCount(1);
+}
+
+DatabaseBackup::~DatabaseBackup()
+{
+   if ( m_running )
+      cancel();
+   m_pool.waitForDone();
+}
+
+QString DatabaseBackup::target() const
+{
+   return m_target;
+}
+
+bool DatabaseBackup::isRunning() const
+{
+   return m_running;
+}
+
+bool DatabaseBackup::start()
+{
+   if ( m_running )
+      return true;
+
+   QFile::remove(m_partFile);
+
+   // Anything queued needs to be in the db before we copy it
+   try {
+      Database::instance().flushPendingWrites();
+   }
+   catch (QString e) {
+      qCritical() << QString("%1 %2").arg(Q_FUNC_INFO).arg(e);
+      return false;
+   }
+
+   m_running = Brewtarget::dbType() == Brewtarget::PGSQL ? startPgSQL() : startSQLite();
+   return m_running;
+}
+
+bool DatabaseBackup::sameSQLite(QSqlDatabase const& db)
+{
+   // Qt's driver is often built against its own copy of SQLite. Its handle
+   // means nothing to the library we link, and the type name of the handle
+   // is the same either way. So ask the driver which SQLite it is running
+   // and compare that with ours
+   QSqlQuery q(db);
+   if ( ! q.exec("SELECT sqlite_version(), sqlite_source_id()") || ! q.next() ) {
+      qWarning() << QString("%1 could not ask the driver for its SQLite version").arg(Q_FUNC_INFO);
+      return false;
+   }
+
+   bool const same = q.value(0).toString() == QString::fromLatin1(sqlite3_libversion()) &&
+                     q.value(1).toString() == QString::fromLatin1(sqlite3_sourceid());
+   if ( ! same ) {
+      qInfo() << QString("%1 Qt uses SQLite %2, we link %3. Backing up with a file copy")
+                 .arg(Q_FUNC_INFO).arg(q.value(0).toString()).arg(sqlite3_libversion());
+   }
+   q.finish();
+   return same;
+}
+
+bool DatabaseBackup::startSQLite()
+{
+   // The backup runs on the app's own connection, so what we write in the
+   // meantime goes into the copy without restarting it
+   QSqlDatabase db = Database::sqlDatabase();
+
+   // Uncompressed, the copy goes straight to the part file. Otherwise it
+   // goes to a scratch file we gzip from
+   QString copyFile = m_compress ? m_partFile + ".raw" : m_partFile;
+   QFile::remove(copyFile);
+
+   QVariant handle = db.driver()->handle();
+   if ( ! handle.isValid() || qstrcmp(handle.typeName(), "sqlite3*") != 0 || ! sameSQLite(db) ) {
+      return copySQLiteFile(db.databaseName(), copyFile);
+   }
+   sqlite3* source = *static_cast<sqlite3**>(handle.data());
+
+   if ( sqlite3_open( QFile::encodeName(copyFile).constData(), &m_dest ) != SQLITE_OK ) {
+      qCritical() << QString("%1 could not open %2: %3").arg(Q_FUNC_INFO).arg(copyFile).arg(sqlite3_errmsg(m_dest));
+      closeSQLite();
+      return false;
+   }
+
+   m_backup = sqlite3_backup_init(m_dest, "main", source, "main");
+   if ( ! m_backup ) {
+      qCritical() << QString("%1 could not start the backup: %2").arg(Q_FUNC_INFO).arg(sqlite3_errmsg(m_dest));
+      closeSQLite();
+      return false;
+   }
+
+   m_timer = new QTimer(this);
+   m_timer->setInterval(stepIntervalMs);
+   connect( m_timer, &QTimer::timeout, this, &DatabaseBackup::step );
+   m_timer->start();
+
+   return true;
+}
+
+bool DatabaseBackup::copySQLiteFile(QString const& from, QString const& to)
+{
+   // The pending writes are flushed and nothing is written until we return,
+   // so the file is whole while we copy it
+   if ( ! QFile::copy(from, to) ) {
+      qCritical() << QString("%1 could not copy %2 to %3").arg(Q_FUNC_INFO).arg(from).arg(to);
+      return false;
+   }
+
+   // All in one go, so there's only the one step to report
+   emit progress(1, 1);
+
+   // start() hasn't said we're running yet, so finish up from the event loop
+   QMetaObject::invokeMethod(this, "copied", Qt::QueuedConnection);
+   return true;
+}
+
+bool DatabaseBackup::copyPages(int pages)
+{
+   int rc = sqlite3_backup_step(m_backup, pages);
+
+   int total = sqlite3_backup_pagecount(m_backup);
+   emit progress( total - sqlite3_backup_remaining(m_backup), total );
+
+   switch( rc ) {
+      case SQLITE_OK:
+      case SQLITE_BUSY:
+      case SQLITE_LOCKED:
+         // More to do, or somebody is in the way. Either way, next time
+         return true;
+      case SQLITE_DONE:
+         closeSQLite();
+         copied();
+         return true;
+      default:
+         qCritical() << QString("%1 backup failed: %2").arg(Q_FUNC_INFO).arg(sqlite3_errstr(rc));
+         closeSQLite();
+         done(false);
+         return false;
+   }
+}
+
+void DatabaseBackup::step()
+{
+   if ( m_backup )
+      copyPages(pagesPerStep);
+}
+
+void DatabaseBackup::closeSQLite()
+{
+   if ( m_timer ) {
+      m_timer->stop();
+      m_timer->deleteLater();
+      m_timer = nullptr;
+   }
+   if ( m_backup ) {
+      sqlite3_backup_finish(m_backup);
+      m_backup = nullptr;
+   }
+   if ( m_dest ) {
+      sqlite3_close(m_dest);
+      m_dest = nullptr;
+   }
+}
+
+bool DatabaseBackup::startPgSQL()
+{
+   QSqlDatabase db = Database::sqlDatabase();
+   m_tableCount = db.tables().size();
+   m_tablesDumped = 0;
+
+   QStringList args;
+   args << "--host" << Database::dbHostname
+        << "--port" << QString::number(Database::dbPortnum)
+        << "--username" << Database::dbUsername
+        << "--dbname" << Database::dbName
+        << "--schema" << Database::dbSchema
+        << "--no-password"
+        << "--verbose"
+        << "--file" << m_partFile;
+   // pg_dump gzips plain dumps itself
+   if ( m_compress )
+      args << "--compress=6";
+
+   QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+   env.insert("PGPASSWORD", Database::dbPassword);
+
+   m_dump = new QProcess(this);
+   m_dump->setProcessEnvironment(env);
+   connect( m_dump, &QProcess::readyReadStandardError, this, &DatabaseBackup::dumpOutput );
+   connect( m_dump, qOverload<int, QProcess::ExitStatus>(&QProcess::finished), this, &DatabaseBackup::dumpFinished );
+
+   m_dump->start("pg_dump", args);
+   if ( ! m_dump->waitForStarted() ) {
+      qCritical() << QString("%1 could not run pg_dump: %2").arg(Q_FUNC_INFO).arg(m_dump->errorString());
+      m_dump->deleteLater();
+      m_dump = nullptr;
+      return false;
+   }
+
+   return true;
+}
+
+void DatabaseBackup::dumpOutput()
+{
+   // --verbose says when it starts on each table's rows, which is as close
+   // to progress as pg_dump gets
+   QString output = QString::fromLocal8Bit( m_dump->readAllStandardError() );
+   m_tablesDumped += output.count("dumping contents of table");
+   emit progress( qMin(m_tablesDumped, m_tableCount), m_tableCount );
+}
+
+void DatabaseBackup::dumpFinished(int exitCode, QProcess::ExitStatus status)
+{
+   m_dump->deleteLater();
+   m_dump = nullptr;
+
+   if ( status != QProcess::NormalExit || exitCode != 0 ) {
+      qCritical() << QString("%1 pg_dump failed with %2").arg(Q_FUNC_INFO).arg(exitCode);
+      done(false);
+      return;
+   }
+
+   emit progress(m_tableCount, m_tableCount);
+   // Already compressed if we asked for it
+   compressed(true);
+}
+
+void DatabaseBackup::copied()
+{
+   if ( ! m_running )
+      return;
+
+   if ( ! m_compress ) {
+      compressed(true);
+      return;
+   }
+
+   // gzip is slow enough to want its own thread
+   QString raw = m_partFile + ".raw";
+   QString part = m_partFile;
+   m_pool.start( new CompressRunnable( [this, raw, part]() {
+      bool success = gzipFile(raw, part);
+      QFile::remove(raw);
+      QMetaObject::invokeMethod(this, "compressed", Qt::QueuedConnection, Q_ARG(bool, success));
+   }));
+}
+
+void DatabaseBackup::compressed(bool success)
+{
+   if ( ! m_running )
+      return;
+
+   if ( success ) {
+      QFile::remove(m_target);
+      success = QFile::rename(m_partFile, m_target);
+   }
+   done(success);
+}
+
+void DatabaseBackup::done(bool success)
+{
+   m_running = false;
+   if ( ! success )
+      QFile::remove(m_partFile);
+
+   qDebug() << QString("Database backup to \"%1\" %2").arg(m_target, success ? "succeeded" : "failed");
+   emit finished(success);
+}
+
+bool DatabaseBackup::finish()
+{
+   if ( ! m_running )
+      return true;
+
+   bool success = true;
+   bool gotResult = false;
+   QMetaObject::Connection conn = connect( this, &DatabaseBackup::finished, [&](bool ok) { success = ok; gotResult = true; } );
+
+   if ( m_backup )
+      copyPages(-1);
+   if ( m_dump )
+      m_dump->waitForFinished(-1);
+
+   // A file copy and the gzip, if any, both report back through the event
+   // loop. The first can start the second
+   m_pool.waitForDone();
+   QCoreApplication::sendPostedEvents(this, QEvent::MetaCall);
+   m_pool.waitForDone();
+   if ( ! gotResult )
+      QCoreApplication::sendPostedEvents(this, QEvent::MetaCall);
+
+   disconnect(conn);
+   return gotResult && success;
+}
+
+void DatabaseBackup::cancel()
+{
+   if ( ! m_running )
+      return;
+
+   closeSQLite();
+   if ( m_dump ) {
+      m_dump->disconnect(this);
+      m_dump->kill();
+      m_dump->waitForFinished();
+      m_dump->deleteLater();
+      m_dump = nullptr;
+   }
+   m_pool.waitForDone();
+
+   m_running = false;
+   QFile::remove(m_partFile);
+   QFile::remove(m_partFile + ".raw");
+   qDebug() << QString("Database backup to \"%1\" cancelled").arg(m_target);
+}
@@ -0,0 +1,115 @@
+/*
+ * DatabaseBackup.h is part of Brewtarget, and is Copyright the following
+ * authors 2021
+ * - Mik Firestone <mikfire@gmail.com>
+ *
+ * Brewtarget is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Brewtarget is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DATABASE_BACKUP_H
+#define DATABASE_BACKUP_H
+
+#include <QObject>
+#include <QProcess>
+#include <QString>
+#include <QThreadPool>
+
+class QSqlDatabase;
+class QTimer;
+struct sqlite3;
+struct sqlite3_backup;
+
+/*!
+ * \class DatabaseBackup
+ *
+ * \brief Backs up the open database without stopping the app.
+ *
+ * For SQLite, this uses SQLite's online backup API on the app's own
+ * connection. The pages are copied a few at a time from a timer, so the
+ * event loop keeps running between steps. Anything written in the
+ * meantime goes into the copy too, so the result is consistent. That only
+ * works if Qt's driver uses the same SQLite library we link; if it brings
+ * its own, the database file is copied instead.
+ *
+ * For PostgreSQL, this runs pg_dump in the background and writes a plain
+ * SQL dump.
+ *
+ * Either way, the output can be gzipped. A backup writes to a ".part" file
+ * and only moves it into place once it is complete.
+ */
+class DatabaseBackup : public QObject
+{
+   Q_OBJECT
+public:
+   /*!
+    * \param target where the backup goes
+    * \param compress gzip the backup. ".gz" is added to \c target if it
+    *        isn't there already
+    */
+   DatabaseBackup(QString const& target, bool compress, QObject* parent = nullptr);
+   virtual ~DatabaseBackup();
+
+   //! \brief Starts the backup. Returns false if it could not be started
+   bool start();
+   //! \brief Does whatever is left right now, waiting for it. For when the event loop is going away
+   bool finish();
+   //! \brief Stops the backup and throws away what was written
+   void cancel();
+
+   bool isRunning() const;
+   //! \brief The file the backup ends up in
+   QString target() const;
+
+signals:
+   //! \brief \c done out of \c total. Pages for SQLite, tables for PostgreSQL
+   void progress(int done, int total);
+   void finished(bool success);
+
+private slots:
+   void step();
+   void dumpOutput();
+   void dumpFinished(int exitCode, QProcess::ExitStatus status);
+   void compressed(bool success);
+   //! \brief The copy is done; compress it or move it into place
+   void copied();
+
+private:
+   //! \brief True if the driver behind \c db runs the same SQLite we link against
+   static bool sameSQLite(QSqlDatabase const& db);
+   bool startSQLite();
+   //! \brief The fallback when the online backup can't be used
+   bool copySQLiteFile(QString const& from, QString const& to);
+   bool startPgSQL();
+   //! \brief Copies up to \c pages pages. -1 copies the rest. Returns false on error
+   bool copyPages(int pages);
+   void done(bool success);
+   void closeSQLite();
+
+   QString m_target;
+   QString m_partFile;
+   bool m_compress;
+   bool m_running;
+
+   sqlite3* m_dest;
+   sqlite3_backup* m_backup;
+   QTimer* m_timer;
+
+   QProcess* m_dump;
+   int m_tablesDumped;
+   int m_tableCount;
+
+   QThreadPool m_pool;
+};
+
+#endif
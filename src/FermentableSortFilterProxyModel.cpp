@@ -20,6 +20,7 @@
 
 #include "Unit.h"
 #include "FermentableSortFilterProxyModel.h"
+#include "SearchIndex.h"
 #include "FermentableTableModel.h"
 #include "model/Fermentable.h"
 #include "brewtarget.h"
@@ -30,6 +31,8 @@ FermentableSortFilterProxyModel::FermentableSortFilterProxyModel(QObject *parent
 : QSortFilterProxyModel(parent)
 {
    filter = filt;
+   if ( filter )
+      SearchIndex::instance().refilterWhenReady(this);
 }
 
 bool FermentableSortFilterProxyModel::lessThan(const QModelIndex &left,
@@ -102,9 +105,10 @@ bool FermentableSortFilterProxyModel::filterAcceptsRow( int source_row, const QM
    FermentableTableModel* model = qobject_cast<FermentableTableModel*>(sourceModel());
    QModelIndex index = sourceModel()->index(source_row, 0, source_parent);
 
-   return !filter
-          ||
-          (  sourceModel()->data(index).toString().contains(filterRegExp())
-             && model->getFermentable(source_row)->display()
-          );
+   if ( !filter )
+      return true;
+
+   return SearchIndex::instance().filterAccepts( model->getFermentable(source_row),
+                                                 sourceModel()->data(index).toString(),
+                                                 filterRegExp() );
 }
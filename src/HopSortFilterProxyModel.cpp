@@ -20,6 +20,7 @@
 
 #include "brewtarget.h"
 #include "HopSortFilterProxyModel.h"
+#include "SearchIndex.h"
 #include "HopTableModel.h"
 #include "model/Hop.h"
 #include "Unit.h"
@@ -29,6 +30,8 @@ HopSortFilterProxyModel::HopSortFilterProxyModel(QObject *parent, bool filt)
 : QSortFilterProxyModel(parent)
 {
    filter = filt;
+   if ( filter )
+      SearchIndex::instance().refilterWhenReady(this);
 }
 
 bool HopSortFilterProxyModel::lessThan(const QModelIndex &left,
@@ -88,9 +91,10 @@ bool HopSortFilterProxyModel::filterAcceptsRow( int source_row, const QModelInde
    HopTableModel* model = qobject_cast<HopTableModel*>(sourceModel());
    QModelIndex index = sourceModel()->index(source_row, 0, source_parent);
 
-   return !filter
-          ||
-           ( sourceModel()->data(index).toString().contains(filterRegExp())
-             && model->getHop(source_row)->display()
-           );
+   if ( !filter )
+      return true;
+
+   return SearchIndex::instance().filterAccepts( model->getHop(source_row),
+                                                 sourceModel()->data(index).toString(),
+                                                 filterRegExp() );
 }
@@ -19,14 +19,28 @@
 #include "Html.h"
 
 #include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
 #include <QString>
 #include <QTextStream>
 
+namespace
+{
+   // The style sheets are compiled-in resources, so they can't change under us
+   QHash<QString,QString> loadedCss;
+   QMutex loadedCssMutex;
+}
+
 namespace Html
 {
 
 QString getCss(const QString& resourceName)
 {
+   QMutexLocker locker(&loadedCssMutex);
+   if ( loadedCss.contains(resourceName) )
+      return loadedCss.value(resourceName);
+
    QFile cssInput(resourceName);
    QString result;
 
@@ -37,6 +51,7 @@ QString getCss(const QString& resourceName)
       {
          result += inStream.readLine();
       }
+      loadedCss.insert(resourceName, result);
    }
    return result;
 }
@@ -22,7 +22,7 @@ namespace Html
 {
 
 /*!
- * \return The contents of the CSS resource.
+ * \return The contents of the CSS resource. Each resource is only read once.
  * \param recourceName The name of the CSS resource to retreive.
  */
 QString getCss(const QString& recourceName);
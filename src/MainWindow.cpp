@@ -34,6 +34,7 @@
 #include <QtGui>
 #include <QString>
 #include <QFileDialog>
+#include <QRegExp>
 #include <QIcon>
 #include <QPixmap>
 #include <QList>
@@ -56,6 +57,7 @@
 #include <QBrush>
 #include <QPen>
 #include <QDesktopWidget>
+#include <QProgressDialog>
 
 #include "Algorithms.h"
 #include "BtTabWidget.h"
@@ -75,6 +77,7 @@
 #include "MainWindow.h"
 #include "AboutDialog.h"
 #include "database.h"
+#include "DatabaseBackup.h"
 #include "YeastDialog.h"
 #include "config.h"
 #include "Unit.h"
@@ -735,6 +738,7 @@ void MainWindow::setupTriggers()
    connect( actionNewRecipe, &QAction::triggered, this, &MainWindow::newRecipe );                                       // > File > New Recipe
    connect( actionImportFromXml, &QAction::triggered, this, &MainWindow::importFiles );                                // > File > Import Recipes
    connect( actionExportToXml, &QAction::triggered, this, &MainWindow::exportRecipe );                                 // > File > Export Recipes
+   connect( actionExportLibraryToXml, &QAction::triggered, this, &MainWindow::exportLibrary );                         // > File > Export Library
    connect( actionUndo, &QAction::triggered, this, &MainWindow::editUndo );                                             // > Edit > Undo
    connect( actionRedo, &QAction::triggered, this, &MainWindow::editRedo );                                             // > Edit > Redo
    setUndoRedoEnable();
@@ -1753,40 +1757,35 @@ void MainWindow::addMashStepToMash(MashStep * mashStep)
    //         even by pulling out some of the common/similar code into a base class or template...
 }
 
-/**
- * .:TODO:. (MY 2020-12-30) See also MainWindow::exportSelected().  I wonder if we could share more code between that
- *                          function and this one.
- */
 void MainWindow::exportRecipe()
 {
-   QFile* outFile;
-   QDomDocument doc;
-   BeerXML* bxml = Database::instance().getBeerXml();
+   BeerXML::ExportList items;
 
    if( recipeObs == nullptr )
       return;
 
-   outFile = openForWrite();
-   if ( ! outFile )
-      return;
-
-   QTextStream out(outFile);
-
-   QString xmlHead = QString("version=\"1.0\" encoding=\"ISO-8859-1\"");
+   items.recipes.append(recipeObs);
+   exportToXml(items);
+}
 
-   // Create the headers to make other BeerXML parsers happy
-   QDomProcessingInstruction inst = doc.createProcessingInstruction("xml", xmlHead);
-   QDomComment beerxml = doc.createComment(QString(" BeerXML generated by Brewtarget %1 ").arg(VERSIONSTRING));
+void MainWindow::exportLibrary()
+{
+   exportToXml( Database::instance().getBeerXml()->everything() );
+}
 
-   doc.appendChild(inst);
-   doc.appendChild(beerxml);
+void MainWindow::exportToXml(BeerXML::ExportList const& items)
+{
+   QFile* outFile;
+   BeerXML* bxml = Database::instance().getBeerXml();
 
-   QDomElement recipes = doc.createElement("RECIPES"); // The root element.
-   doc.appendChild(recipes);
-   bxml->toXml( recipeObs, doc, recipes );
+   outFile = openForWrite(tr("BeerXML files (*.xml);;Compressed BeerXML files (*.xml.gz)"));
+   if ( ! outFile )
+      return;
 
-   // QString::toLatin1 returns an ISO 8859-1 stream.
-   out << doc.toString().toLatin1();
+   // Written as it goes, so even the whole library never has to be in memory
+   bool compress = fileSaver->selectedNameFilter().contains("*.xml.gz") || outFile->fileName().endsWith(".gz");
+   if ( ! bxml->exportToXml(items, outFile, compress) )
+      QMessageBox::warning( this, tr("Export failed"), tr("Could not write %1: %2").arg(outFile->fileName()).arg(outFile->errorString()) );
 
    outFile->close();
    delete outFile;
@@ -2497,10 +2496,34 @@ void MainWindow::backup()
    // If the filename returned from the dialog is empty, it means the user clicked cancel, so we should stop trying to do the backup
    if (!backupFileName.isEmpty())
    {
-      bool success = Database::backupToFile(backupFileName);
-
-      if( ! success )
+      // The backup runs in the background. A name ending in .gz gets it
+      // compressed
+      DatabaseBackup* backup = Database::instance().startBackup(backupFileName, backupFileName.endsWith(".gz"));
+      if ( ! backup ) {
          QMessageBox::warning( this, tr("Oops!"), tr("Could not copy the files for some reason."));
+         return;
+      }
+
+      QProgressDialog* progress = new QProgressDialog(tr("Backing up the database..."), tr("Cancel"), 0, 0, this);
+      progress->setWindowModality(Qt::NonModal);
+      progress->setAutoClose(false);
+      progress->setAutoReset(false);
+      progress->setMinimumDuration(500);
+
+      connect( backup, &DatabaseBackup::progress, progress, [progress](int done, int total) {
+         progress->setMaximum(total);
+         progress->setValue(done);
+      });
+      connect( progress, &QProgressDialog::canceled, backup, [backup, progress]() {
+         backup->cancel();
+         backup->deleteLater();
+         progress->deleteLater();
+      });
+      connect( backup, &DatabaseBackup::finished, this, [this, progress](bool success) {
+         progress->deleteLater();
+         if( ! success )
+            QMessageBox::warning( this, tr("Oops!"), tr("Could not copy the files for some reason."));
+      });
    }
 }
 
@@ -2883,10 +2906,24 @@ QFile* MainWindow::openForWrite( QString filterStr, QString defaultSuff)
 {
    QFile* outFile = new QFile();
 
+   // The default suffix follows the filter, so picking "(*.xml.gz)" and
+   // typing a bare name gives name.xml.gz and not name.xml
+   auto suffixFor = [defaultSuff](QString const& filter) {
+      QRegExp pattern("\\*\\.([^ )]+)");
+      return pattern.indexIn(filter) >= 0 ? pattern.cap(1) : defaultSuff;
+   };
+
    fileSaver->setNameFilter( filterStr );
-   fileSaver->setDefaultSuffix( defaultSuff );
+   fileSaver->setDefaultSuffix( suffixFor(fileSaver->selectedNameFilter()) );
+   QMetaObject::Connection followFilter = connect( fileSaver, &QFileDialog::filterSelected, this,
+                                                   [this, suffixFor](QString const& filter) {
+                                                      fileSaver->setDefaultSuffix( suffixFor(filter) );
+                                                   });
 
-   if( fileSaver->exec() )
+   bool const accepted = fileSaver->exec();
+   disconnect(followFilter);
+
+   if( accepted )
    {
       QString filename = fileSaver->selectedFiles()[0];
       outFile->setFileName(filename);
@@ -2930,9 +2967,10 @@ void MainWindow::exportSelectedHtml() {
    foreach( QModelIndex ndx, selected)
       targets.append( treeView_recipe->recipe(ndx) );
 
-   // and write it all
+   // and write it all, a recipe at a time
    QTextStream out(outFile);
-   out << recipeFormatter->getHTMLFormat(targets);
+   recipeFormatter->writeHTMLFormat(targets, out);
+   out.flush();
    outFile->close();
 }
 
@@ -2941,12 +2979,7 @@ void MainWindow::exportSelected()
    BtTreeView* active = qobject_cast<BtTreeView*>(tabWidget_Trees->currentWidget()->focusWidget());
    QModelIndexList selected;
    QList<QModelIndex>::const_iterator at,end;
-   QDomDocument doc;
-   QFile* outFile;
-   QDomElement root,dbase,recipe;
-   bool didRecipe = false;
-   BeerXML* bxml = Database::instance().getBeerXml();
-
+   BeerXML::ExportList items;
 
    if ( active == nullptr )
       return;
@@ -2955,27 +2988,7 @@ void MainWindow::exportSelected()
    if( selected.count() == 0 )
       return;
 
-   outFile = openForWrite();
-   if ( !outFile )
-      return;
-
-   QTextStream out(outFile);
-
-   QString xmlHead = QString("version=\"1.0\" encoding=\"%1\"").arg(QTextCodec::codecForLocale()->name().data());
-
-   // Create the headers to make other BeerXML parsers happy
-   QDomProcessingInstruction inst = doc.createProcessingInstruction("xml", xmlHead);
-   QDomComment beerxml = doc.createComment(QString(" BeerXML generated by Brewtarget %1 ").arg(VERSIONSTRING));
-
-   doc.appendChild(inst);
-   doc.appendChild(beerxml);
-
-   // We need to handle the recipes separate from the normal database
-   // elements.  All recipes live under the RECIPES tag, whereas the
-   // equipment, hops, etc. go under DATABASE.
-   dbase = doc.createElement("DATABASE");
-   recipe = doc.createElement("RECIPES");
-
+   // Each kind of thing gets its own group in the document
    for(at = selected.begin(),end = selected.end(); at < end; ++at)
    {
       QModelIndex selection = *at;
@@ -2984,39 +2997,30 @@ void MainWindow::exportSelected()
       switch(type)
       {
          case BtTreeItem::RECIPE:
-            bxml->toXml( treeView_recipe->recipe(selection), doc, recipe);
-            didRecipe = true;
+            items.recipes.append( treeView_recipe->recipe(selection) );
             break;
          case BtTreeItem::EQUIPMENT:
-            bxml->toXml( treeView_equip->equipment(selection), doc, dbase);
+            items.equipments.append( treeView_equip->equipment(selection) );
             break;
          case BtTreeItem::FERMENTABLE:
-            bxml->toXml( treeView_ferm->fermentable(selection), doc, dbase);
+            items.fermentables.append( treeView_ferm->fermentable(selection) );
             break;
          case BtTreeItem::HOP:
-            bxml->toXml( treeView_hops->hop(selection), doc, dbase);
+            items.hops.append( treeView_hops->hop(selection) );
             break;
          case BtTreeItem::MISC:
-            bxml->toXml( treeView_misc->misc(selection), doc, dbase);
+            items.miscs.append( treeView_misc->misc(selection) );
             break;
          case BtTreeItem::STYLE:
-            bxml->toXml( treeView_style->style(selection), doc, dbase);
+            items.styles.append( treeView_style->style(selection) );
             break;
          case BtTreeItem::YEAST:
-            bxml->toXml( treeView_yeast->yeast(selection), doc, dbase);
+            items.yeasts.append( treeView_yeast->yeast(selection) );
             break;
       }
    }
 
-   if ( didRecipe )
-      doc.appendChild(recipe);
-   else
-      doc.appendChild(dbase);
-
-   out << doc.toString();
-
-   outFile->close();
-   delete outFile;
+   exportToXml(items);
 }
 
 void MainWindow::updateDatabase()
@@ -44,6 +44,7 @@ class MainWindow;
 #include <QUndoStack>
 #include "ui_mainWindow.h"
 #include "SimpleUndoableUpdate.h"
+#include "xml/BeerXml.h"
 
 #include <functional>
 
@@ -225,6 +226,8 @@ public slots:
    void newRecipe();
    //! \brief Export current recipe to BeerXML.
    void exportRecipe();
+   //! \brief Export every recipe and ingredient to BeerXML.
+   void exportLibrary();
    //! \brief Display file selection dialog and import BeerXML files.
    void importFiles();
    //! \brief Create a duplicate of the current recipe.
@@ -349,6 +352,8 @@ private:
    void removeMisc(Misc * itemToRemove);
    void removeYeast(Yeast * itemToRemove);
    void removeMashStep(MashStep * itemToRemove);
+   //! \brief Asks for a file and streams \c items to it as BeerXML, gzipped if the name ends in .gz
+   void exportToXml(BeerXML::ExportList const& items);
 //   void removeWater(Water * itemToRemove);
 //   void removeSalt(Salt * itemToRemove);
 
@@ -20,6 +20,7 @@
 
 #include <QAbstractItemModel>
 #include "MiscSortFilterProxyModel.h"
+#include "SearchIndex.h"
 #include "MiscTableModel.h"
 #include "model/Misc.h"
 #include "brewtarget.h"
@@ -29,6 +30,8 @@ MiscSortFilterProxyModel::MiscSortFilterProxyModel(QObject *parent, bool filt)
 : QSortFilterProxyModel(parent)
 {
    filter = filt;
+   if ( filter )
+      SearchIndex::instance().refilterWhenReady(this);
 }
 
 bool MiscSortFilterProxyModel::lessThan(const QModelIndex &left,
@@ -64,9 +67,10 @@ bool MiscSortFilterProxyModel::filterAcceptsRow( int source_row, const QModelInd
    MiscTableModel* model = qobject_cast<MiscTableModel*>(sourceModel());
    QModelIndex index = sourceModel()->index(source_row, 0, source_parent);
 
-   return !filter
-          ||
-          (  sourceModel()->data(index).toString().contains(filterRegExp())
-             && model->getMisc(source_row)->display()
-          );
+   if ( !filter )
+      return true;
+
+   return SearchIndex::instance().filterAccepts( model->getMisc(source_row),
+                                                 sourceModel()->data(index).toString(),
+                                                 filterRegExp() );
 }
@@ -0,0 +1,196 @@
+/*
+ * OptionStore.cpp is part of Brewtarget, and is Copyright the following
+ * authors 2021
+ * - Mik Firestone <mikfire@gmail.com>
+ *
+ * Brewtarget is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Brewtarget is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "OptionStore.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QMutexLocker>
+#include <QReadLocker>
+#include <QSettings>
+#include <QStringList>
+#include <QThread>
+#include <QWriteLocker>
+
+namespace {
+   // Long enough to gather up everything an options dialog changes
+   int const writeBackDelayMs = 1000;
+
+   QMutex instanceMutex;
+}
+
+OptionStore* OptionStore::storeInstance = nullptr;
+
+OptionStore::OptionStore()
+   : QObject(),
+     writeTimer(new QTimer(this))
+{
+   QSettings settings;
+   foreach( QString const& key, settings.allKeys() )
+      values.insert(key, settings.value(key));
+
+   writeTimer->setSingleShot(true);
+   writeTimer->setInterval(writeBackDelayMs);
+   connect( writeTimer, &QTimer::timeout, this, &OptionStore::sync );
+
+   // The write back is timed on the GUI thread, no matter who asked first
+   if ( QCoreApplication::instance() )
+      moveToThread( QCoreApplication::instance()->thread() );
+}
+
+OptionStore::~OptionStore()
+{
+   sync();
+}
+
+OptionStore& OptionStore::instance()
+{
+   QMutexLocker locker(&instanceMutex);
+
+   if ( ! storeInstance )
+      storeInstance = new OptionStore();
+
+   return *storeInstance;
+}
+
+void OptionStore::dropInstance()
+{
+   QMutexLocker locker(&instanceMutex);
+
+   delete storeInstance;
+   storeInstance = nullptr;
+}
+
+bool OptionStore::contains(QString const& name) const
+{
+   QReadLocker locker(&lock);
+   return values.contains(name);
+}
+
+QVariant OptionStore::value(QString const& name, QVariant const& defaultValue) const
+{
+   QReadLocker locker(&lock);
+   return values.value(name, defaultValue);
+}
+
+bool OptionStore::boolValue(QString const& name, bool defaultValue) const
+{
+   QReadLocker locker(&lock);
+   QHash<QString, QVariant>::const_iterator found = values.constFind(name);
+   return found == values.constEnd() ? defaultValue : found.value().toBool();
+}
+
+int OptionStore::intValue(QString const& name, int defaultValue) const
+{
+   QReadLocker locker(&lock);
+   QHash<QString, QVariant>::const_iterator found = values.constFind(name);
+   return found == values.constEnd() ? defaultValue : found.value().toInt();
+}
+
+double OptionStore::doubleValue(QString const& name, double defaultValue) const
+{
+   QReadLocker locker(&lock);
+   QHash<QString, QVariant>::const_iterator found = values.constFind(name);
+   return found == values.constEnd() ? defaultValue : found.value().toDouble();
+}
+
+QString OptionStore::stringValue(QString const& name, QString const& defaultValue) const
+{
+   QReadLocker locker(&lock);
+   QHash<QString, QVariant>::const_iterator found = values.constFind(name);
+   return found == values.constEnd() ? defaultValue : found.value().toString();
+}
+
+void OptionStore::setValue(QString const& name, QVariant const& value)
+{
+   PendingWrite write;
+   write.name = name;
+   write.value = value;
+   write.remove = false;
+
+   {
+      QWriteLocker locker(&lock);
+      values.insert(name, value);
+      pending.append(write);
+   }
+
+   scheduleWriteBack();
+   emit changed(name, value);
+}
+
+void OptionStore::remove(QString const& name)
+{
+   PendingWrite write;
+   write.name = name;
+   write.remove = true;
+
+   {
+      QWriteLocker locker(&lock);
+      // An empty name takes everything, the same as it does for QSettings
+      QString group = name + "/";
+      QMutableHashIterator<QString, QVariant> i(values);
+      while ( i.hasNext() ) {
+         QString const& key = i.next().key();
+         if ( name.isEmpty() || key == name || key.startsWith(group) )
+            i.remove();
+      }
+      pending.append(write);
+   }
+
+   scheduleWriteBack();
+   emit changed(name, QVariant());
+}
+
+void OptionStore::scheduleWriteBack()
+{
+   // The timer belongs to the GUI thread, so anybody else asks it to start
+   if ( QThread::currentThread() != thread() ) {
+      QMetaObject::invokeMethod(this, "scheduleWriteBack", Qt::QueuedConnection);
+      return;
+   }
+
+   if ( ! writeTimer->isActive() )
+      writeTimer->start();
+}
+
+void OptionStore::sync()
+{
+   QMutexLocker syncLocker(&syncMutex);
+   QVector<PendingWrite> writes;
+
+   {
+      QWriteLocker locker(&lock);
+      writes.swap(pending);
+   }
+
+   if ( writes.isEmpty() )
+      return;
+
+   QSettings settings;
+   foreach( PendingWrite const& write, writes ) {
+      if ( write.remove )
+         settings.remove(write.name);
+      else
+         settings.setValue(write.name, write.value);
+   }
+   settings.sync();
+
+   if ( settings.status() != QSettings::NoError )
+      qWarning() << QString("%1 could not write the options back: %2").arg(Q_FUNC_INFO).arg(settings.status());
+}
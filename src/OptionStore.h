@@ -0,0 +1,103 @@
+/*
+ * OptionStore.h is part of Brewtarget, and is Copyright the following
+ * authors 2021
+ * - Mik Firestone <mikfire@gmail.com>
+ *
+ * Brewtarget is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Brewtarget is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPTION_STORE_H
+#define OPTION_STORE_H
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QReadWriteLock>
+#include <QString>
+#include <QTimer>
+#include <QVariant>
+#include <QVector>
+
+/*!
+ * \class OptionStore
+ *
+ * \brief The options, kept in memory in front of QSettings.
+ *
+ * Everything in QSettings is read once, the first time the store is used.
+ * After that, reading an option is a hash lookup. Changes go into memory
+ * at once and are written back to QSettings a little later, in one go. They
+ * are also written when the store is dropped, which Brewtarget::cleanup()
+ * does.
+ *
+ * Reads and writes are safe from any thread. The write back happens on the
+ * GUI thread.
+ *
+ * Brewtarget::option() and friends are the usual way in. Hot paths can use
+ * the typed accessors directly and skip the QVariant.
+ */
+class OptionStore : public QObject
+{
+   Q_OBJECT
+public:
+   static OptionStore& instance();
+   //! \brief Writes anything pending and deletes the instance
+   static void dropInstance();
+
+   bool contains(QString const& name) const;
+   QVariant value(QString const& name, QVariant const& defaultValue = QVariant()) const;
+   bool boolValue(QString const& name, bool defaultValue = false) const;
+   int intValue(QString const& name, int defaultValue = 0) const;
+   double doubleValue(QString const& name, double defaultValue = 0.0) const;
+   QString stringValue(QString const& name, QString const& defaultValue = QString()) const;
+
+   void setValue(QString const& name, QVariant const& value);
+   //! \brief Removes \c name and everything under it, like QSettings::remove()
+   void remove(QString const& name);
+
+   //! \brief Writes everything pending to QSettings now
+   void sync();
+
+signals:
+   //! \brief \c name was set or removed. \c value is invalid if it was removed
+   void changed(QString const& name, QVariant const& value);
+
+private slots:
+   void scheduleWriteBack();
+
+private:
+   //! \brief A set or a remove waiting to go to QSettings
+   struct PendingWrite {
+      QString name;
+      QVariant value;
+      bool remove;
+   };
+
+   OptionStore();
+   ~OptionStore();
+   OptionStore(OptionStore const&) = delete;
+   OptionStore& operator=(OptionStore const&) = delete;
+
+   static OptionStore* storeInstance;
+
+   mutable QReadWriteLock lock;
+   QHash<QString, QVariant> values;
+   //! In order, so a remove and a later set of the same name come out right
+   QVector<PendingWrite> pending;
+   //! Keeps one batch of writes from passing another on its way to QSettings
+   QMutex syncMutex;
+
+   QTimer* writeTimer;
+};
+
+#endif
@@ -32,9 +32,21 @@
 #include "model/MashStep.h"
 #include "Unit.h"
 #include "brewtarget.h"
+#include "database.h"
 #include "MainWindow.h"
+#include "OptionStore.h"
+#include <functional>
 #include <QClipboard>
+#include <QHash>
+#include <QMutex>
 #include <QObject>
+#include <QPair>
+#include <QPointer>
+#include <QRunnable>
+#include <QSet>
+#include <QThreadPool>
+#include <QVector>
+#include <QWaitCondition>
 #include <QPrinter>
 #include <QPrintDialog>
 #include <QTextDocument>
@@ -42,11 +54,162 @@
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 
+namespace {
+   enum FragmentKind { ToolTip, RecipeBody };
+
+   /*
+    * Rendered HTML, shared by every RecipeFormatter. A fragment remembers
+    * the things it was built from and goes as soon as any of them changes
+    * or is deleted. Everything goes when an option changes, because the
+    * units and formats come from the options. Only the most recently used
+    * fragments are kept.
+    */
+   class FragmentCache
+   {
+   public:
+      bool find(QObject const* thing, FragmentKind kind, QString& html)
+      {
+         watchOptions();
+
+         Key key(thing, kind);
+         if ( ! fragments.contains(key) )
+            return false;
+         html = fragments.value(key);
+         if ( lru.first() != key ) {
+            lru.removeOne(key);
+            lru.prepend(key);
+         }
+         return true;
+      }
+
+      QString store(QObject const* thing, FragmentKind kind, QString const& html, QList<NamedEntity*> const& sources)
+      {
+         watchOptions();
+
+         Key key(thing, kind);
+         remove(key);
+         fragments.insert(key, html);
+         lru.prepend(key);
+
+         foreach( NamedEntity* source, sources ) {
+            if ( source == nullptr )
+               continue;
+            usedBy[source].insert(key);
+            sourcesOf[key].append(source);
+            if ( ! watched.contains(source) ) {
+               watched.insert(source, QList<QMetaObject::Connection>()
+                  << QObject::connect( source, &NamedEntity::changed, &context, [this, source]() { drop(source); } )
+                  << QObject::connect( source, &QObject::destroyed, &context, [this, source]() { drop(source); } ));
+            }
+         }
+
+         // New and removed brew notes, instructions and the like are only
+         // announced by the Database, and not per recipe
+         if ( kind == RecipeBody && watchedDb != &Database::instance() ) {
+            watchedDb = &Database::instance();
+            QObject::connect( watchedDb, &Database::changed, &context, [this]() { dropAll(RecipeBody); } );
+         }
+
+         while ( lru.size() > maxFragments )
+            remove(lru.last());
+         return html;
+      }
+
+   private:
+      typedef QPair<QObject const*, int> Key;
+      static int const maxFragments = 200;
+
+      void watchOptions()
+      {
+         if ( watchedOptions != &OptionStore::instance() ) {
+            watchedOptions = &OptionStore::instance();
+            QObject::connect( watchedOptions, &OptionStore::changed, &context, [this]() { clear(); } );
+         }
+      }
+
+      //! Forgets \c key, and stops watching anything only it was built from
+      void remove(Key const& key)
+      {
+         if ( ! fragments.remove(key) )
+            return;
+         lru.removeOne(key);
+
+         foreach( QObject const* source, sourcesOf.take(key) ) {
+            QSet<Key>& users = usedBy[source];
+            users.remove(key);
+            if ( users.isEmpty() ) {
+               usedBy.remove(source);
+               foreach( QMetaObject::Connection c, watched.take(source) )
+                  QObject::disconnect(c);
+            }
+         }
+      }
+
+      void drop(QObject const* source)
+      {
+         foreach( Key key, usedBy.value(source) )
+            remove(key);
+      }
+
+      void dropAll(FragmentKind kind)
+      {
+         foreach( Key key, lru ) {
+            if ( key.second == kind )
+               remove(key);
+         }
+      }
+
+      void clear()
+      {
+         foreach( Key key, lru )
+            remove(key);
+      }
+
+      QObject context;
+      QHash<Key, QString> fragments;
+      //! Most recently used first
+      QList<Key> lru;
+      //! thing -> fragments built from it
+      QHash< QObject const*, QSet<Key> > usedBy;
+      //! fragment -> things it was built from
+      QHash< Key, QList<QObject const*> > sourcesOf;
+      //! thing -> our connections to it
+      QHash< QObject const*, QList<QMetaObject::Connection> > watched;
+      QPointer<Database> watchedDb;
+      QPointer<OptionStore> watchedOptions;
+   };
+
+   FragmentCache& fragmentCache()
+   {
+      static FragmentCache cache;
+      return cache;
+   }
+
+   class RenderRunnable : public QRunnable
+   {
+   public:
+      RenderRunnable(std::function<void()> work) : work(work) {}
+      void run() { work(); }
+
+   private:
+      std::function<void()> work;
+   };
+}
+
 RecipeFormatter::RecipeFormatter(QObject* parent)
-   : QObject(parent)
+   : QObject(parent),
+     printer(nullptr),
+     doc(nullptr),
+     docDialog(nullptr)
 {
    textSeparator = nullptr;
    rec = nullptr;
+}
+
+void RecipeFormatter::createPreviewDialog()
+{
+   if ( docDialog )
+      return;
 
    //===Construct a print-preview dialog.===
    docDialog = new QDialog(Brewtarget::mainWindow());
@@ -161,36 +324,81 @@ QString RecipeFormatter::buildHTMLFooter() {
 }
 
 QString RecipeFormatter::getHTMLFormat( QList<Recipe*> recipes ) {
-   Recipe *current = rec;
    QString hDoc;
+   QTextStream out(&hDoc);
 
-   hDoc = buildHTMLHeader();
+   writeHTMLFormat(recipes, out);
+   out.flush();
+   return hDoc;
+}
+
+void RecipeFormatter::writeHTMLFormat( QList<Recipe*> recipes, QTextStream& out )
+{
+   int const count = recipes.size();
+   QVector<QString> bodies(count);
+   QVector<bool> ready(count, false);
+   QVector< QList<NamedEntity*> > sources(count);
+   QMutex lock;
+   QWaitCondition finished;
+   QThreadPool pool;
+   // How far ahead of the writer the snapshots and renders are allowed to get
+   int const window = qMax(2, 2 * pool.maxThreadCount());
+   int next = 0;
+
+   out << buildHTMLHeader();
 
    // build a toc -- why do I do this to myself?
-   hDoc += "<ul>";
+   out << "<ul>";
    foreach ( Recipe* foo, recipes ) {
-       hDoc += QString("<li><a href=\"#%1\">%1</a></li>").arg(foo->name());
+       out << QString("<li><a href=\"#%1\">%1</a></li>").arg(foo->name());
    }
-   hDoc += "</ul>";
-
-   foreach (Recipe* foo, recipes) {
-      rec = foo;
-      hDoc += QString("<a name=\"%1\"></a>").arg(foo->name());
-      hDoc += buildStatTableHtml();
-      hDoc += buildFermentableTableHtml();
-      hDoc += buildHopsTableHtml();
-      hDoc += buildMiscTableHtml();
-      hDoc += buildYeastTableHtml();
-      hDoc += buildMashTableHtml();
-      hDoc += buildNotesHtml();
-      hDoc += buildInstructionTableHtml();
-      hDoc += buildBrewNotesHtml();
-      hDoc += "<p></p>";
+   out << "</ul>";
+
+   // Write each one as soon as it and everything before it is done
+   for ( int i = 0; i < count; ++i ) {
+      // Anything that has to touch the database happens here, on this
+      // thread. Bodies already in the cache need no work at all
+      for ( ; next < count && next < i + window; ++next ) {
+         QString html;
+         if ( fragmentCache().find(recipes.at(next), RecipeBody, html) ) {
+            QMutexLocker locker(&lock);
+            bodies[next] = html;
+            ready[next] = true;
+            continue;
+         }
+
+         int const j = next;
+         Snapshot snap = takeSnapshot(recipes.at(j), sources[j]);
+         pool.start( new RenderRunnable( [snap, &bodies, &ready, &lock, &finished, j]() {
+            QString html = renderRecipeHtml(snap);
+            QMutexLocker locker(&lock);
+            bodies[j] = html;
+            ready[j] = true;
+            finished.wakeAll();
+         }));
+      }
+
+      QString html;
+      {
+         QMutexLocker locker(&lock);
+         while ( ! ready.at(i) )
+            finished.wait(&lock);
+         html = bodies.at(i);
+         bodies[i].clear();
+      }
+
+      if ( ! sources.at(i).isEmpty() ) {
+         fragmentCache().store(recipes.at(i), RecipeBody, html, sources.at(i));
+         sources[i].clear();
+      }
+
+      out << QString("<a name=\"%1\"></a>").arg(recipes.at(i)->name());
+      out << html;
+      out << "<p></p>";
    }
-   hDoc += buildHTMLFooter();
+   pool.waitForDone();
 
-   rec = current;
-   return hDoc;
+   out << buildHTMLFooter();
 }
 
 QString RecipeFormatter::getHTMLFormat()
@@ -198,21 +406,172 @@ QString RecipeFormatter::getHTMLFormat()
    QString pDoc;
 
    pDoc = buildHTMLHeader();
-   pDoc += buildStatTableHtml();
-   pDoc += buildFermentableTableHtml();
-   pDoc += buildHopsTableHtml();
-   pDoc += buildMiscTableHtml();
-   pDoc += buildYeastTableHtml();
-   pDoc += buildMashTableHtml();
-   pDoc += buildNotesHtml();
-   pDoc += buildInstructionTableHtml();
-   pDoc += buildBrewNotesHtml();
-
+   pDoc += buildRecipeHtml();
    pDoc += buildHTMLFooter();
 
    return pDoc;
 }
 
+QString RecipeFormatter::buildRecipeHtml()
+{
+   QString html;
+
+   if ( rec == nullptr )
+      return html;
+
+   if ( fragmentCache().find(rec, RecipeBody, html) )
+      return html;
+
+   QList<NamedEntity*> sources;
+   Snapshot snap = takeSnapshot(rec, sources);
+   return fragmentCache().store(rec, RecipeBody, renderRecipeHtml(snap), sources);
+}
+
+RecipeFormatter::Snapshot RecipeFormatter::takeSnapshot(Recipe* recipe, QList<NamedEntity*>& sources)
+{
+   Snapshot snap;
+   Style* style = recipe->style();
+   Equipment* kit = recipe->equipment();
+   Mash* mash = recipe->mash();
+
+   sources << recipe << style << kit << mash;
+
+   snap.name                = recipe->name();
+   snap.brewer              = recipe->brewer();
+   snap.date                = recipe->date();
+   snap.notes               = recipe->notes();
+   snap.styleName           = style ? style->name() : tr("unknown style");
+   snap.styleCategoryNumber = style ? style->categoryNumber() : tr("N/A");
+   snap.styleLetter         = style ? style->styleLetter() : "";
+   snap.efficiency_pct      = recipe->efficiency_pct();
+   snap.finalVolume_l       = recipe->finalVolume_l();
+   snap.boilVolume_l        = recipe->boilVolume_l();
+   snap.boilTime_min        = kit ? kit->boilTime_min() : 0.0;
+   snap.og                  = recipe->og();
+   snap.fg                  = recipe->fg();
+   snap.ABV_pct             = recipe->ABV_pct();
+   snap.IBU                 = recipe->IBU();
+   snap.color_srm           = recipe->color_srm();
+   snap.calories12oz        = recipe->calories12oz();
+   snap.calories33cl        = recipe->calories33cl();
+   snap.grains_kg           = recipe->grains_kg();
+
+   snap.hasMash = mash != nullptr;
+   if ( mash ) {
+      foreach( MashStep* step, mash->mashSteps() ) {
+         MashStepRow row;
+         row.name              = step->name();
+         row.type              = step->typeStringTr();
+         row.isInfusion        = step->isInfusion();
+         row.isDecoction       = step->isDecoction();
+         row.infuseAmount_l    = step->infuseAmount_l();
+         row.infuseTemp_c      = step->infuseTemp_c();
+         row.decoctionAmount_l = step->decoctionAmount_l();
+         row.stepTemp_c        = step->stepTemp_c();
+         row.stepTime_min      = step->stepTime_min();
+         snap.mashSteps.append(row);
+         sources << step;
+      }
+   }
+
+   foreach( Fermentable* ferm, sortFermentablesByWeight(recipe) ) {
+      FermentableRow row;
+      row.name         = ferm->name();
+      row.type         = ferm->typeStringTr();
+      row.amount_kg    = ferm->amount_kg();
+      row.isMashed     = ferm->isMashed();
+      row.addAfterBoil = ferm->addAfterBoil();
+      row.yield_pct    = ferm->yield_pct();
+      row.color_srm    = ferm->color_srm();
+      snap.fermentables.append(row);
+      sources << ferm;
+   }
+
+   foreach( Hop* hop, sortHopsByTime(recipe) ) {
+      HopRow row;
+      row.name      = hop->name();
+      row.alpha_pct = hop->alpha_pct();
+      row.amount_kg = hop->amount_kg();
+      row.use       = hop->useStringTr();
+      row.time_min  = hop->time_min();
+      row.form      = hop->formStringTr();
+      row.ibu       = recipe->ibuFromHop(hop);
+      snap.hops.append(row);
+      sources << hop;
+   }
+
+   foreach( Misc* misc, recipe->miscs() ) {
+      MiscRow row;
+      row.name           = misc->name();
+      row.type           = misc->typeStringTr();
+      row.use            = misc->useStringTr();
+      row.amountIsWeight = misc->amountIsWeight();
+      row.amount         = misc->amount();
+      row.time           = misc->time();
+      snap.miscs.append(row);
+      sources << misc;
+   }
+
+   foreach( Yeast* yeast, recipe->yeasts() ) {
+      YeastRow row;
+      row.name           = yeast->name();
+      row.type           = yeast->typeStringTr();
+      row.form           = yeast->formStringTr();
+      row.amountIsWeight = yeast->amountIsWeight();
+      row.amount         = yeast->amount();
+      row.addToSecondary = yeast->addToSecondary();
+      snap.yeasts.append(row);
+      sources << yeast;
+   }
+
+   foreach( Instruction* ins, recipe->instructions() ) {
+      snap.instructions.append(ins->directions());
+      sources << ins;
+   }
+
+   // The calculators store what they work out, so they stay on this thread
+   foreach( BrewNote* note, recipe->brewNotes() ) {
+      BrewNoteRow row;
+      row.brewDate         = note->brewDate_short();
+      row.fermentDate      = note->fermentDate_short();
+      row.sg               = note->sg();
+      row.volumeIntoBK_l   = note->volumeIntoBK_l();
+      row.strikeTemp_c     = note->strikeTemp_c();
+      row.mashFinTemp_c    = note->mashFinTemp_c();
+      row.og               = note->og();
+      row.postBoilVolume_l = note->postBoilVolume_l();
+      row.volumeIntoFerm_l = note->volumeIntoFerm_l();
+      row.fg               = note->fg();
+      row.finalVolume_l    = note->finalVolume_l();
+      row.effIntoBK_pct    = note->calculateEffIntoBK_pct();
+      row.projOg           = note->calculateOg();
+      row.brewhouseEff_pct = note->calculateBrewHouseEff_pct();
+      row.projABV_pct      = note->calculateABV_pct();
+      row.abv_pct          = note->calculateActualABV_pct();
+      snap.brewNotes.append(row);
+      sources << note;
+   }
+
+   return snap;
+}
+
+QString RecipeFormatter::renderRecipeHtml(Snapshot const& snap)
+{
+   QString html;
+
+   html += buildStatTableHtml(snap);
+   html += buildFermentableTableHtml(snap);
+   html += buildHopsTableHtml(snap);
+   html += buildMiscTableHtml(snap);
+   html += buildYeastTableHtml(snap);
+   html += buildMashTableHtml(snap);
+   html += buildNotesHtml(snap);
+   html += buildInstructionTableHtml(snap);
+   html += buildBrewNotesHtml(snap);
+
+   return html;
+}
+
 QString RecipeFormatter::getBBCodeFormat()
 {
    QString ret = "";
@@ -285,6 +644,10 @@ QString RecipeFormatter::getToolTip(Recipe* rec)
    if ( rec == nullptr )
       return "";
 
+   QString cached;
+   if ( fragmentCache().find(rec, ToolTip, cached) )
+      return cached;
+
    style = rec->style();
 
    // Do the style sheet first
@@ -321,7 +684,7 @@ QString RecipeFormatter::getToolTip(Recipe* rec)
 
    body += "</table></body></html>";
 
-   return header + body;
+   return fragmentCache().store(rec, ToolTip, header + body, QList<NamedEntity*>() << rec << style);
 
 }
 
@@ -333,6 +696,10 @@ QString RecipeFormatter::getToolTip(Style* style)
    if ( style == nullptr )
       return "";
 
+   QString cached;
+   if ( fragmentCache().find(style, ToolTip, cached) )
+      return cached;
+
    // Do the style sheet first
    header = "<html><head><style type=\"text/css\">";
    header += Html::getCss(":/css/tooltip.css");
@@ -364,7 +731,7 @@ QString RecipeFormatter::getToolTip(Style* style)
 
    body += "</table></body></html>";
 
-   return header + body;
+   return fragmentCache().store(style, ToolTip, header + body, QList<NamedEntity*>() << style);
 
 }
 
@@ -376,6 +743,10 @@ QString RecipeFormatter::getToolTip(Equipment* kit)
    if ( kit == nullptr )
       return "";
 
+   QString cached;
+   if ( fragmentCache().find(kit, ToolTip, cached) )
+      return cached;
+
    // Do the style sheet first
    header = "<html><head><style type=\"text/css\">";
    header += Html::getCss(":/css/tooltip.css");
@@ -398,7 +769,7 @@ QString RecipeFormatter::getToolTip(Equipment* kit)
 
    body += "</table></body></html>";
 
-   return header + body;
+   return fragmentCache().store(kit, ToolTip, header + body, QList<NamedEntity*>() << kit);
 
 }
 
@@ -411,6 +782,10 @@ QString RecipeFormatter::getToolTip(Fermentable* ferm)
    if ( ferm == nullptr )
       return "";
 
+   QString cached;
+   if ( fragmentCache().find(ferm, ToolTip, cached) )
+      return cached;
+
    // Do the style sheet first
    header = "<html><head><style type=\"text/css\">";
    header += Html::getCss(":/css/tooltip.css");
@@ -440,7 +815,7 @@ QString RecipeFormatter::getToolTip(Fermentable* ferm)
 
    body += "</table></body></html>";
 
-   return header + body;
+   return fragmentCache().store(ferm, ToolTip, header + body, QList<NamedEntity*>() << ferm);
 
 }
 
@@ -452,6 +827,10 @@ QString RecipeFormatter::getToolTip(Hop* hop)
    if ( hop == nullptr )
       return "";
 
+   QString cached;
+   if ( fragmentCache().find(hop, ToolTip, cached) )
+      return cached;
+
    // Do the style sheet first
    header = "<html><head><style type=\"text/css\">";
    header += Html::getCss(":/css/tooltip.css");
@@ -482,7 +861,7 @@ QString RecipeFormatter::getToolTip(Hop* hop)
 
    body += "</table></body></html>";
 
-   return header + body;
+   return fragmentCache().store(hop, ToolTip, header + body, QList<NamedEntity*>() << hop);
 
 }
 
@@ -494,6 +873,10 @@ QString RecipeFormatter::getToolTip(Misc* misc)
    if ( misc == nullptr )
       return "";
 
+   QString cached;
+   if ( fragmentCache().find(misc, ToolTip, cached) )
+      return cached;
+
    // Do the style sheet first
    header = "<html><head><style type=\"text/css\">";
    header += Html::getCss(":/css/tooltip.css");
@@ -516,7 +899,7 @@ QString RecipeFormatter::getToolTip(Misc* misc)
 
    body += "</table></body></html>";
 
-   return header + body;
+   return fragmentCache().store(misc, ToolTip, header + body, QList<NamedEntity*>() << misc);
 
 }
 
@@ -528,6 +911,10 @@ QString RecipeFormatter::getToolTip(Yeast* yeast)
    if ( yeast == nullptr )
       return "";
 
+   QString cached;
+   if ( fragmentCache().find(yeast, ToolTip, cached) )
+      return cached;
+
    // Do the style sheet first
    header = "<html><head><style type=\"text/css\">";
    header += Html::getCss(":/css/tooltip.css");
@@ -566,7 +953,7 @@ QString RecipeFormatter::getToolTip(Yeast* yeast)
 
    body += "</table></body></html>";
 
-   return header + body;
+   return fragmentCache().store(yeast, ToolTip, header + body, QList<NamedEntity*>() << yeast);
 
 }
 
@@ -578,6 +965,10 @@ QString RecipeFormatter::getToolTip(Water* water)
    if ( water == nullptr )
       return "";
 
+   QString cached;
+   if ( fragmentCache().find(water, ToolTip, cached) )
+      return cached;
+
    // Do the style sheet first
    header = "<html><head><style type=\"text/css\">";
    header += Html::getCss(":/css/tooltip.css");
@@ -615,7 +1006,7 @@ QString RecipeFormatter::getToolTip(Water* water)
 
    body += "</table></body></html>";
 
-   return header + body;
+   return fragmentCache().store(water, ToolTip, header + body, QList<NamedEntity*>() << water);
 
 }
 void RecipeFormatter::toTextClipboard()
@@ -694,24 +1085,18 @@ QString RecipeFormatter::wrapText( const QString &text, int wrapLength )
    return wrappedText;
 }
 
-QString RecipeFormatter::buildStatTableHtml()
+QString RecipeFormatter::buildStatTableHtml(Snapshot const& snap)
 {
    QString header;
    QString body;
-   Style* style = nullptr;
-
-   if ( rec == nullptr )
-      return "";
-
-   style = rec->style();
 
    body += QString("<div id=\"headerdiv\">");
    // NOTE: QTextBrowser does not support the caption tag
    body += QString("<h1>%1 - %2 (%3%4)</h1>")
-         .arg( rec->name())
-         .arg( style ? style->name() : tr("unknown style"))
-         .arg( style ? style->categoryNumber() : tr("N/A") )
-         .arg( style ? style->styleLetter() : "" );
+         .arg( snap.name)
+         .arg( snap.styleName )
+         .arg( snap.styleCategoryNumber )
+         .arg( snap.styleLetter );
 
    body += QString("<table id=\"header\">");
    body += QString("<tr>"
@@ -719,13 +1104,13 @@ QString RecipeFormatter::buildStatTableHtml()
                    "<td class=\"value\">%2</td>"
                    "</tr>")
            .arg(tr("Brewer"))
-           .arg(rec->brewer());
+           .arg(snap.brewer);
    body += QString("<tr>"
                    "<td class=\"label\">%1</td>"
                    "<td class=\"value \">%2</td>"
                    "</tr>")
            .arg(tr("Date"))
-           .arg(Brewtarget::displayDate(rec->date()));
+           .arg(Brewtarget::displayDate(snap.date));
    body += "</table>";
 
    // Build the top table
@@ -739,46 +1124,44 @@ QString RecipeFormatter::buildStatTableHtml()
                    "<td align=\"left\" class=\"left\">%1</td>"
                    "<td width=\"20%\" class=\"value\">%2</td>")
            .arg(tr("Batch Size"))
-           .arg(Brewtarget::displayAmount(rec->finalVolume_l(), "tab_recipe", "finalVolume_l", &Units::liters));
+           .arg(Brewtarget::displayAmount(snap.finalVolume_l, "tab_recipe", "finalVolume_l", &Units::liters));
    body += QString("<td width=\"40%\" align=\"right\" class=\"right\">%1</td>"
                    "<td class=\"value\">%2</td>"
                    "</tr>")
            .arg(tr("Boil Size"))
-           .arg(Brewtarget::displayAmount(rec->boilVolume_l(), "tab_recipe", "boilVolume_l", &Units::liters));
+           .arg(Brewtarget::displayAmount(snap.boilVolume_l, "tab_recipe", "boilVolume_l", &Units::liters));
    // Second row: Boil Time and Efficiency
    body += QString("<tr>"
                    "<td align=\"left\" class=\"left\">%1</td>"
                    "<td class=\"value\">%2</td>")
            .arg(tr("Boil Time"))
-           .arg( (rec->equipment() == nullptr)?
-                   Brewtarget::displayAmount(0, "tab_recipe", "boilTime_min", &Units::minutes)
-                 : Brewtarget::displayAmount( (rec->equipment())->boilTime_min(), "tab_recipe", "boilTime_min", &Units::minutes));
+           .arg(Brewtarget::displayAmount(snap.boilTime_min, "tab_recipe", "boilTime_min", &Units::minutes));
    body += QString("<td align=\"right\" class=\"right\">%1</td>"
                    "<td class=\"value\">%2</td></tr>")
            .arg(tr("Efficiency"))
-           .arg(rec->efficiency_pct(), 0, 'f', 0);
+           .arg(snap.efficiency_pct, 0, 'f', 0);
 
    // Third row: OG and FG
    body += QString("<tr>"
                    "<td align=\"left\" class=\"left\">%1</td>"
                    "<td class=\"value\">%2</td>")
            .arg(tr("OG"))
-           .arg(Brewtarget::displayAmount(rec->og(), "tab_recipe", "og", &Units::sp_grav, 3));
+           .arg(Brewtarget::displayAmount(snap.og, "tab_recipe", "og", &Units::sp_grav, 3));
    body += QString("<td align=\"right\" class=\"right\">%1</td>"
                    "<td class=\"value\">%2</td></tr>")
            .arg(tr("FG"))
-           .arg(Brewtarget::displayAmount(rec->fg(), "tab_recipe", "fg", &Units::sp_grav, 3));
+           .arg(Brewtarget::displayAmount(snap.fg, "tab_recipe", "fg", &Units::sp_grav, 3));
 
    // Fourth row: ABV and Bitterness.  We need to set the bitterness string up first
    body += QString("<tr>"
                    "<td align=\"left\" class=\"left\">%1</td>"
                    "<td class=\"value\">%2%</td>")
            .arg(tr("ABV"))
-           .arg(Brewtarget::displayAmount(rec->ABV_pct(), nullptr, 1));
+           .arg(Brewtarget::displayAmount(snap.ABV_pct, nullptr, 1));
    body += QString("<td align=\"right\" class=\"right\">%1</td>"
                    "<td class=\"value\">%2 (%3)</td></tr>")
            .arg(tr("IBU"))
-           .arg(Brewtarget::displayAmount(rec->IBU(), nullptr, 1))
+           .arg(Brewtarget::displayAmount(snap.IBU, nullptr, 1))
            .arg(Brewtarget::ibuFormulaName() );
 
    // Fifth row: Color and calories.  Set up the color string first
@@ -786,13 +1169,13 @@ QString RecipeFormatter::buildStatTableHtml()
                    "<td align=\"left\" class=\"left\">%1</td>"
                    "<td class=\"value\">%2 (%3)</td>")
            .arg(tr("Color"))
-           .arg(Brewtarget::displayAmount(rec->color_srm(),"tab_recipe", "color_srm", &Units::srm, 1))
+           .arg(Brewtarget::displayAmount(snap.color_srm,"tab_recipe", "color_srm", &Units::srm, 1))
            .arg(Brewtarget::colorFormulaName());
 
    body += QString("<td align=\"right\" class=\"right\">%1</td>"
                    "<td class=\"value\">%2</td></tr>")
            .arg( Brewtarget::getVolumeUnitSystem() == SI ? tr("Estimated calories (per 33 cl)") : tr("Estimated calories (per 12 oz)"))
-           .arg( Brewtarget::displayAmount(Brewtarget::getVolumeUnitSystem() == SI ? rec->calories33cl() : rec->calories12oz(),nullptr,0) );
+           .arg( Brewtarget::displayAmount(Brewtarget::getVolumeUnitSystem() == SI ? snap.calories33cl : snap.calories12oz,nullptr,0) );
 
    body += "</table>";
 
@@ -844,13 +1227,10 @@ QString RecipeFormatter::buildStatTableTxt()
    return ret;
 }
 
-QString RecipeFormatter::buildFermentableTableHtml()
+QString RecipeFormatter::buildFermentableTableHtml(Snapshot const& snap)
 {
-   if( rec == nullptr )
-      return "";
-
    QString ftable;
-   QList<Fermentable*> ferms = sortFermentablesByWeight(rec);
+   QList<FermentableRow> const& ferms = snap.fermentables;
    int i, size;
 
    size = ferms.size();
@@ -879,21 +1259,21 @@ QString RecipeFormatter::buildFermentableTableHtml()
    // Now add a row for each fermentable
    for(i=0; i < size; ++i)
    {
-      Fermentable* ferm = ferms[i];
+      FermentableRow const& ferm = ferms.at(i);
       ftable += QString("<tr><td>%1</td><td>%2</td><td>%3</td><td>%4</td><td>%5</td><td>%6%</td><td>%7</td></tr>")
-            .arg( ferm->name())
-            .arg( ferm->typeStringTr())
-            .arg( Brewtarget::displayAmount(ferm->amount_kg(), "fermentableTable", "amount_kg", &Units::kilograms))
-            .arg( ferm->isMashed() ? tr("Yes") : tr("No") )
-            .arg( ferm->addAfterBoil() ? tr("Yes") : tr("No"))
-            .arg( Brewtarget::displayAmount(ferm->yield_pct(), nullptr, 0) )
-            .arg( Brewtarget::displayAmount(ferm->color_srm(), "fermentableTable", "color_srm", &Units::srm, 1));
+            .arg( ferm.name)
+            .arg( ferm.type)
+            .arg( Brewtarget::displayAmount(ferm.amount_kg, "fermentableTable", "amount_kg", &Units::kilograms))
+            .arg( ferm.isMashed ? tr("Yes") : tr("No") )
+            .arg( ferm.addAfterBoil ? tr("Yes") : tr("No"))
+            .arg( Brewtarget::displayAmount(ferm.yield_pct, nullptr, 0) )
+            .arg( Brewtarget::displayAmount(ferm.color_srm, "fermentableTable", "color_srm", &Units::srm, 1));
    }
    // One row for the total grain (QTextBrowser does not know the caption tag)
    ftable += QString("<tr><td><b>%1</b></td><td>%2</td><td>%3</td><td>%4</td><td>%5</td><td>%6</td><td>%7</td></tr>")
             .arg(tr("Total"))
             .arg("&mdash;" )
-            .arg(Brewtarget::displayAmount(rec->grains_kg(), "fermentableTable", "amount_kg", &Units::kilograms))
+            .arg(Brewtarget::displayAmount(snap.grains_kg, "fermentableTable", "amount_kg", &Units::kilograms))
             .arg("&mdash;")
             .arg("&mdash;")
             .arg("&mdash;")
@@ -952,13 +1332,10 @@ QString RecipeFormatter::buildFermentableTableTxt()
    return ret;
 }
 
-QString RecipeFormatter::buildHopsTableHtml()
+QString RecipeFormatter::buildHopsTableHtml(Snapshot const& snap)
 {
-   if( rec == nullptr )
-      return "";
-
    QString hTable;
-   QList<Hop*> hops = sortHopsByTime(rec);
+   QList<HopRow> const& hops = snap.hops;
    int i, size;
 
    size = hops.size();
@@ -987,15 +1364,15 @@ QString RecipeFormatter::buildHopsTableHtml()
 
    for( i = 0; i < size; ++i)
    {
-      Hop *hop = hops[i];
+      HopRow const& hop = hops.at(i);
       hTable += QString("<tr><td>%1</td><td>%2%</td><td>%3</td><td>%4</td><td>%5</td><td>%6</td><td>%7</td></tr>")
-            .arg( hop->name())
-            .arg( Brewtarget::displayAmount(hop->alpha_pct(),nullptr,1) )
-            .arg( Brewtarget::displayAmount(hop->amount_kg(), "hopTable", "amount_kg", &Units::kilograms))
-            .arg( hop->useStringTr())
-            .arg( Brewtarget::displayAmount(hop->time_min(), "hopTable", PropertyNames::Hop::time_min, &Units::minutes))
-            .arg( hop->formStringTr())
-            .arg( Brewtarget::displayAmount(rec->ibuFromHop(hop), nullptr, 1) );
+            .arg( hop.name)
+            .arg( Brewtarget::displayAmount(hop.alpha_pct,nullptr,1) )
+            .arg( Brewtarget::displayAmount(hop.amount_kg, "hopTable", "amount_kg", &Units::kilograms))
+            .arg( hop.use)
+            .arg( Brewtarget::displayAmount(hop.time_min, "hopTable", PropertyNames::Hop::time_min, &Units::minutes))
+            .arg( hop.form)
+            .arg( Brewtarget::displayAmount(hop.ibu, nullptr, 1) );
    }
    hTable += "</table>";
    return hTable;
@@ -1050,14 +1427,11 @@ QString RecipeFormatter::buildHopsTableTxt()
    return ret;
 }
 
-QString RecipeFormatter::buildMiscTableHtml()
+QString RecipeFormatter::buildMiscTableHtml(Snapshot const& snap)
 {
-   if( rec == nullptr )
-      return "";
-
    QString mtable;
    int i, size;
-   QList<Misc*> miscs = rec->miscs();
+   QList<MiscRow> const& miscs = snap.miscs;
    size = miscs.size();
    Unit const * kindOf;
 
@@ -1081,15 +1455,15 @@ QString RecipeFormatter::buildMiscTableHtml()
          .arg(tr("Time"));
    for( i = 0; i < size; ++i)
    {
-      Misc *misc = miscs[i];
-      kindOf = misc->amountIsWeight() ? static_cast<Unit const *>(&Units::kilograms) : static_cast<Unit const *>(&Units::liters);
+      MiscRow const& misc = miscs.at(i);
+      kindOf = misc.amountIsWeight ? static_cast<Unit const *>(&Units::kilograms) : static_cast<Unit const *>(&Units::liters);
 
       mtable += QString("<tr><td>%1</td><td>%2</td><td>%3</td><td>%4</td><td>%5</td></tr>")
-            .arg( misc->name())
-            .arg( misc->typeStringTr())
-            .arg( misc->useStringTr())
-            .arg( Brewtarget::displayAmount(misc->amount(), "miscTableModel", "amount_kg", kindOf, 3))
-            .arg( Brewtarget::displayAmount(misc->time(), "miscTableModel", PropertyNames::Misc::time, &Units::minutes));
+            .arg( misc.name)
+            .arg( misc.type)
+            .arg( misc.use)
+            .arg( Brewtarget::displayAmount(misc.amount, "miscTableModel", "amount_kg", kindOf, 3))
+            .arg( Brewtarget::displayAmount(misc.time, "miscTableModel", PropertyNames::Misc::time, &Units::minutes));
    }
    mtable += "</table>";
    return mtable;
@@ -1140,14 +1514,11 @@ QString RecipeFormatter::buildMiscTableTxt()
    return ret;
 }
 
-QString RecipeFormatter::buildYeastTableHtml()
+QString RecipeFormatter::buildYeastTableHtml(Snapshot const& snap)
 {
-   if( rec == nullptr )
-      return "";
-
    QString ytable;
    int i, size;
-   QList<Yeast*> yeasts = rec->yeasts();
+   QList<YeastRow> const& yeasts = snap.yeasts;
    Unit const * kindOf;
    size = yeasts.size();
 
@@ -1170,15 +1541,15 @@ QString RecipeFormatter::buildYeastTableHtml()
          .arg(tr("Stage"));
    for( i = 0; i < size; ++i)
    {
-      Yeast* y = yeasts[i];
-      kindOf = y->amountIsWeight() ? static_cast<Unit const *>(&Units::kilograms) : static_cast<Unit const *>(&Units::liters);
+      YeastRow const& y = yeasts.at(i);
+      kindOf = y.amountIsWeight ? static_cast<Unit const *>(&Units::kilograms) : static_cast<Unit const *>(&Units::liters);
 
       ytable += QString("<tr><td>%1</td><td>%2</td><td>%3</td><td>%4</td><td>%5</td></tr>")
-            .arg( y->name())
-            .arg( y->typeStringTr())
-            .arg( y->formStringTr())
-            .arg( Brewtarget::displayAmount( y->amount(), "yeastTableModel", "amount_kg", kindOf, 2) )
-            .arg( y->addToSecondary() ? tr("Secondary") : tr("Primary"));
+            .arg( y.name)
+            .arg( y.type)
+            .arg( y.form)
+            .arg( Brewtarget::displayAmount( y.amount, "yeastTableModel", "amount_kg", kindOf, 2) )
+            .arg( y.addToSecondary ? tr("Secondary") : tr("Primary"));
    }
    ytable += "</table>";
    return ytable;
@@ -1228,17 +1599,15 @@ QString RecipeFormatter::buildYeastTableTxt()
    return ret;
 }
 
-QString RecipeFormatter::buildMashTableHtml()
+QString RecipeFormatter::buildMashTableHtml(Snapshot const& snap)
 {
-   if( rec == nullptr || rec->mash() == nullptr )
+   if( ! snap.hasMash )
       return "";
 
    QString mtable;
 
-   MashStep* ms;
    int i, size;
-   Mash* m = rec->mash();
-   QList<MashStep*> mashSteps = m->mashSteps();
+   QList<MashStepRow> const& mashSteps = snap.mashSteps;
    size = mashSteps.size();
 
    if( size <= 0 )
@@ -1265,26 +1634,26 @@ QString RecipeFormatter::buildMashTableHtml()
    for( i = 0; i < size; ++i )
    {
       QString tmp = "<tr>";
-      ms = mashSteps[i];
+      MashStepRow const& ms = mashSteps.at(i);
       tmp += QString("<td>%1</td><td>%2</td><td>%3</td><td>%4</td><td>%5</td><td>%6</td>")
-             .arg(ms->name())
-             .arg(ms->typeStringTr());
+             .arg(ms.name)
+             .arg(ms.type);
 
-      if( ms->isInfusion() )
+      if( ms.isInfusion )
       {
-         tmp = tmp.arg(Brewtarget::displayAmount(ms->infuseAmount_l(), "mashStepTableModel", "amount", &Units::liters))
-                  .arg(Brewtarget::displayAmount(ms->infuseTemp_c(),   "mashStepTableModel", PropertyNames::MashStep::infuseTemp_c, &Units::celsius));
+         tmp = tmp.arg(Brewtarget::displayAmount(ms.infuseAmount_l, "mashStepTableModel", "amount", &Units::liters))
+                  .arg(Brewtarget::displayAmount(ms.infuseTemp_c,   "mashStepTableModel", PropertyNames::MashStep::infuseTemp_c, &Units::celsius));
       }
-      else if( ms->isDecoction() )
+      else if( ms.isDecoction )
       {
-         tmp = tmp.arg( Brewtarget::displayAmount( ms->decoctionAmount_l(), "mashStepTableModel", "amount", &Units::liters ) )
+         tmp = tmp.arg( Brewtarget::displayAmount( ms.decoctionAmount_l, "mashStepTableModel", "amount", &Units::liters ) )
                .arg("---");
       }
       else
          tmp = tmp.arg( "---" ).arg("---");
 
-      tmp = tmp.arg( Brewtarget::displayAmount(ms->stepTemp_c(), "mashStepTableModel", PropertyNames::MashStep::stepTemp_c, &Units::celsius) );
-      tmp = tmp.arg( Brewtarget::displayAmount(ms->stepTime_min(), "mashStepTableModel", PropertyNames::Misc::time, &Units::minutes, 0) );
+      tmp = tmp.arg( Brewtarget::displayAmount(ms.stepTemp_c, "mashStepTableModel", PropertyNames::MashStep::stepTemp_c, &Units::celsius) );
+      tmp = tmp.arg( Brewtarget::displayAmount(ms.stepTime_min, "mashStepTableModel", PropertyNames::Misc::time, &Units::minutes, 0) );
 
       mtable += tmp + "</tr>";
    }
@@ -1356,29 +1725,26 @@ QString RecipeFormatter::buildMashTableTxt()
    return ret;
 }
 
-QString RecipeFormatter::buildNotesHtml()
+QString RecipeFormatter::buildNotesHtml(Snapshot const& snap)
 {
    QString notes;
 
-   if ( rec == nullptr || rec->notes() == "" )
+   if ( snap.notes == "" )
       return "";
 
    notes = QString("<h3>%1</h3>").arg(tr("Notes"));
    // NOTE: (heh) Using the QTextDocument.toHtml() method doesn't really work
    // here. So we cheat and use some newer functionality
-   notes += rec->notes().toHtmlEscaped();
+   notes += snap.notes.toHtmlEscaped();
 
    return notes;
 }
 
-QString RecipeFormatter::buildInstructionTableHtml()
+QString RecipeFormatter::buildInstructionTableHtml(Snapshot const& snap)
 {
-   if( rec == nullptr )
-      return "";
-
    QString itable;
    int i, size;
-   QList<Instruction*> instructions = rec->instructions();
+   QStringList const& instructions = snap.instructions;
    size = instructions.size();
 
    if ( size < 1 )
@@ -1389,8 +1755,7 @@ QString RecipeFormatter::buildInstructionTableHtml()
 
    for( i = 0; i < size; ++i )
    {
-      Instruction* ins = instructions[i];
-      itable += QString("<li>%1</li>").arg( ins->directions());
+      itable += QString("<li>%1</li>").arg( instructions.at(i));
    }
 
    itable += "</ol>";
@@ -1433,14 +1798,11 @@ QString RecipeFormatter::buildInstructionTableTxt()
    return ret;
 }
 
-QString RecipeFormatter::buildBrewNotesHtml()
+QString RecipeFormatter::buildBrewNotesHtml(Snapshot const& snap)
 {
-   if( rec == nullptr )
-      return "";
-
    QString bnTable = "";
    int i, size;
-   QList<BrewNote*> brewNotes = rec->brewNotes();
+   QList<BrewNoteRow> const& brewNotes = snap.brewNotes;
    size = brewNotes.size();
 
    if ( size < 1 )
@@ -1448,10 +1810,10 @@ QString RecipeFormatter::buildBrewNotesHtml()
 
    for( i = 0; i < size; ++i )
    {
-      BrewNote* note = brewNotes[i];
+      BrewNoteRow const& note = brewNotes.at(i);
       QString section;
 
-      bnTable += QString("<h2>%1 %2</h2>").arg(tr("Brew Date")).arg(note->brewDate_short());
+      bnTable += QString("<h2>%1 %2</h2>").arg(tr("Brew Date")).arg(note.brewDate);
 
       // PREBOIL, done two-by-two
       section = "page_preboil";
@@ -1459,21 +1821,21 @@ QString RecipeFormatter::buildBrewNotesHtml()
       bnTable += QString("<caption>%1</caption>").arg(tr("Preboil"));
       bnTable += QString("<tr><td class=\"left\">%1</td><td class=\"value\">%2</td><td class=\"right\">%3</td><td class=\"value\">%4</td></tr>")
                  .arg(tr("SG"))
-                 .arg(Brewtarget::displayAmount(note->sg(), section, PropertyNames::BrewNote::sg, &Units::sp_grav, 3))
+                 .arg(Brewtarget::displayAmount(note.sg, section, PropertyNames::BrewNote::sg, &Units::sp_grav, 3))
                  .arg(tr("Volume into BK"))
-                 .arg(Brewtarget::displayAmount(note->volumeIntoBK_l(), section, PropertyNames::BrewNote::volumeIntoBK_l, &Units::liters));
+                 .arg(Brewtarget::displayAmount(note.volumeIntoBK_l, section, PropertyNames::BrewNote::volumeIntoBK_l, &Units::liters));
 
       bnTable += QString("<tr><td class=\"left\">%1</td><td class=\"value\">%2</td><td class=\"right\">%3</td><td class=\"value\">%4</td></tr>")
                  .arg(tr("Strike Temp"))
-                 .arg(Brewtarget::displayAmount(note->strikeTemp_c(), section, PropertyNames::BrewNote::strikeTemp_c, &Units::celsius))
+                 .arg(Brewtarget::displayAmount(note.strikeTemp_c, section, PropertyNames::BrewNote::strikeTemp_c, &Units::celsius))
                  .arg(tr("Final Temp"))
-                 .arg(Brewtarget::displayAmount(note->mashFinTemp_c(), section, PropertyNames::BrewNote::mashFinTemp_c, &Units::celsius));
+                 .arg(Brewtarget::displayAmount(note.mashFinTemp_c, section, PropertyNames::BrewNote::mashFinTemp_c, &Units::celsius));
 
       bnTable += QString("<tr><td class=\"left\">%1</td><td class=\"value\">%2%</td><td class=\"right\">%3</td><td class=\"value\">%4</td></tr>")
                  .arg(tr("Eff into BK"))
-                 .arg(Brewtarget::displayAmount(note->calculateEffIntoBK_pct(), nullptr, 2))
+                 .arg(Brewtarget::displayAmount(note.effIntoBK_pct, nullptr, 2))
                  .arg(tr("Projected OG"))
-                 .arg(Brewtarget::displayAmount(note->calculateOg(), section, PropertyNames::BrewNote::projOg, &Units::sp_grav, 3));
+                 .arg(Brewtarget::displayAmount(note.projOg, section, PropertyNames::BrewNote::projOg, &Units::sp_grav, 3));
       bnTable += "</table>";
 
       // POSTBOIL
@@ -1482,17 +1844,17 @@ QString RecipeFormatter::buildBrewNotesHtml()
       bnTable += QString("<caption>%1</caption>").arg(tr("Postboil"));
       bnTable += QString("<tr><td class=\"left\">%1</td><td class=\"value\">%2</td><td class=\"right\">%3</td><td class=\"value\">%4</td></tr>")
                  .arg(tr("OG"))
-                 .arg(Brewtarget::displayAmount(note->og(),section, "og", &Units::sp_grav, 3))
+                 .arg(Brewtarget::displayAmount(note.og,section, "og", &Units::sp_grav, 3))
                  .arg(tr("Postboil Volume"))
-                 .arg(Brewtarget::displayAmount(note->postBoilVolume_l(), section, "postBoilVolume_l", &Units::liters));
+                 .arg(Brewtarget::displayAmount(note.postBoilVolume_l, section, "postBoilVolume_l", &Units::liters));
       bnTable += QString("<tr><td class=\"left\">%1</td><td class=\"value\">%2</td><td class=\"right\">%3</td><td class=\"value\">%4</td></tr>")
                  .arg(tr("Volume Into Fermenter"))
-                 .arg(Brewtarget::displayAmount(note->volumeIntoFerm_l(), section, PropertyNames::BrewNote::volumeIntoFerm_l, &Units::liters))
+                 .arg(Brewtarget::displayAmount(note.volumeIntoFerm_l, section, PropertyNames::BrewNote::volumeIntoFerm_l, &Units::liters))
                  .arg(tr("Brewhouse Eff"))
-                 .arg(Brewtarget::displayAmount(note->calculateBrewHouseEff_pct(), nullptr, 2));
+                 .arg(Brewtarget::displayAmount(note.brewhouseEff_pct, nullptr, 2));
       bnTable += QString("<tr><td class=\"left\">%1</td><td class=\"value\">%2%</td></tr>")
                  .arg(tr("Projected ABV"))
-                 .arg(Brewtarget::displayAmount(note->calculateABV_pct(), nullptr, 2));
+                 .arg(Brewtarget::displayAmount(note.projABV_pct, nullptr, 2));
       bnTable += "</table>";
 
 
@@ -1502,15 +1864,15 @@ QString RecipeFormatter::buildBrewNotesHtml()
       bnTable += QString("<caption>%1</caption>").arg(tr("Postferment"));
       bnTable += QString("<tr><td class=\"left\">%1</td><td class=\"value\">%2</td><td class=\"right\">%3</td><td class=\"value\">%4</td></tr>")
                  .arg(tr("FG"))
-                 .arg(Brewtarget::displayAmount(note->fg(),section,"fg",&Units::sp_grav, 3))
+                 .arg(Brewtarget::displayAmount(note.fg,section,"fg",&Units::sp_grav, 3))
                  .arg(tr("Volume"))
-                 .arg(Brewtarget::displayAmount(note->finalVolume_l(), section, "finalVolume_l", &Units::liters));
+                 .arg(Brewtarget::displayAmount(note.finalVolume_l, section, "finalVolume_l", &Units::liters));
 
       bnTable += QString("<tr><td class=\"left\">%1</td><td class=\"value\">%2</td><td class=\"right\">%3</td><td class=\"value\">%4</td></tr>")
                  .arg(tr("Date"))
-                 .arg(note->fermentDate_short())
+                 .arg(note.fermentDate)
                  .arg(tr("ABV"))
-                 .arg(Brewtarget::displayAmount(note->calculateActualABV_pct(), nullptr, 2));
+                 .arg(Brewtarget::displayAmount(note.abv_pct, nullptr, 2));
       bnTable += "</table>";
 
    }
@@ -1594,6 +1956,8 @@ void RecipeFormatter::print(QPrinter* mainPrinter,
       outFile->close();
       return;
    }
+   createPreviewDialog();
+
    // We are printing hard copy
    if ( action == PRINT )
    {
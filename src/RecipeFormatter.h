@@ -31,6 +31,8 @@ class RecipeFormatter;
 #include <QTextBrowser>
 #include <QDialog>
 #include <QFile>
+#include <QDate>
+#include <QTextStream>
 #include "model/Recipe.h"
 
 /*!
@@ -56,6 +58,13 @@ public:
    QString getHTMLFormat();
    //! Get a whole mess of html views
    QString getHTMLFormat( QList<Recipe*> recipes );
+   /*!
+    * \brief The same as getHTMLFormat(QList<Recipe*>), but written to \c out
+    * a recipe at a time instead of built up in one string. The recipes are
+    * rendered in parallel and written in order, with only a few of them
+    * copied out and waiting at any one time.
+    */
+   void writeHTMLFormat( QList<Recipe*> recipes, QTextStream& out );
    //! Get a BBCode view. Why is this here?
    QString getBBCodeFormat();
    //! Generate a tooltip for a recipe
@@ -87,21 +96,156 @@ public slots:
 private:
    QString getTextSeparator();
 
+   //! \brief One row of the fermentables table
+   struct FermentableRow
+   {
+      QString name;
+      QString type;
+      double amount_kg;
+      bool isMashed;
+      bool addAfterBoil;
+      double yield_pct;
+      double color_srm;
+   };
+
+   //! \brief One row of the hops table
+   struct HopRow
+   {
+      QString name;
+      double alpha_pct;
+      double amount_kg;
+      QString use;
+      double time_min;
+      QString form;
+      double ibu;
+   };
+
+   //! \brief One row of the misc table
+   struct MiscRow
+   {
+      QString name;
+      QString type;
+      QString use;
+      bool amountIsWeight;
+      double amount;
+      double time;
+   };
+
+   //! \brief One row of the yeast table
+   struct YeastRow
+   {
+      QString name;
+      QString type;
+      QString form;
+      bool amountIsWeight;
+      double amount;
+      bool addToSecondary;
+   };
+
+   //! \brief One row of the mash table
+   struct MashStepRow
+   {
+      QString name;
+      QString type;
+      bool isInfusion;
+      bool isDecoction;
+      double infuseAmount_l;
+      double infuseTemp_c;
+      double decoctionAmount_l;
+      double stepTemp_c;
+      double stepTime_min;
+   };
+
+   //! \brief One brew note, with what the calculators gave when it was copied
+   struct BrewNoteRow
+   {
+      QString brewDate;
+      QString fermentDate;
+      double sg;
+      double volumeIntoBK_l;
+      double strikeTemp_c;
+      double mashFinTemp_c;
+      double og;
+      double postBoilVolume_l;
+      double volumeIntoFerm_l;
+      double fg;
+      double finalVolume_l;
+      double effIntoBK_pct;
+      double projOg;
+      double brewhouseEff_pct;
+      double projABV_pct;
+      double abv_pct;
+   };
+
+   /*!
+    * \brief Everything the HTML tables need from one recipe, copied out.
+    *
+    * A snapshot is taken on the GUI thread, which is where anything that
+    * goes to the database or recalculates has to happen. It holds no
+    * pointers into the recipe, so the tables can be built from it on any
+    * thread, even if the recipe changes or goes away in the meantime.
+    */
+   struct Snapshot
+   {
+      QString name;
+      QString brewer;
+      QDate date;
+      QString notes;
+      QString styleName;
+      QString styleCategoryNumber;
+      QString styleLetter;
+      double efficiency_pct;
+      double finalVolume_l;
+      double boilVolume_l;
+      //! 0 without an equipment
+      double boilTime_min;
+      double og;
+      double fg;
+      double ABV_pct;
+      double IBU;
+      double color_srm;
+      double calories12oz;
+      double calories33cl;
+      double grains_kg;
+
+      bool hasMash;
+      QList<MashStepRow> mashSteps;
+      //! Sorted by weight
+      QList<FermentableRow> fermentables;
+      //! Sorted by time
+      QList<HopRow> hops;
+      QList<MiscRow> miscs;
+      QList<YeastRow> yeasts;
+      QStringList instructions;
+      QList<BrewNoteRow> brewNotes;
+   };
+
+   /*!
+    * \brief Must be called on the GUI thread
+    * \param sources gets everything the snapshot was copied from, for the
+    *        fragment cache
+    */
+   static Snapshot takeSnapshot(Recipe* recipe, QList<NamedEntity*>& sources);
+   //! \brief The tables for \c snap. Safe on any thread
+   static QString renderRecipeHtml(Snapshot const& snap);
+
    QString buildHTMLHeader();
-   QString buildStatTableHtml();
+   //! \brief Everything but the header and footer for \c rec. Cached until something in it changes
+   QString buildRecipeHtml();
+   static QString buildStatTableHtml(Snapshot const& snap);
    QString buildStatTableTxt();
-   QString buildFermentableTableHtml();
+   static QString buildFermentableTableHtml(Snapshot const& snap);
    QString buildFermentableTableTxt();
-   QString buildHopsTableHtml();
+   static QString buildHopsTableHtml(Snapshot const& snap);
    QString buildHopsTableTxt();
-   QString buildYeastTableHtml();
+   static QString buildYeastTableHtml(Snapshot const& snap);
    QString buildYeastTableTxt();
-   QString buildMashTableHtml();
+   static QString buildMashTableHtml(Snapshot const& snap);
    QString buildMashTableTxt();
-   QString buildMiscTableHtml();
+   static QString buildMiscTableHtml(Snapshot const& snap);
    QString buildMiscTableTxt();
-   QString buildNotesHtml();
-   QString buildInstructionTableHtml();
+   static QString buildNotesHtml(Snapshot const& snap);
+   static QString buildInstructionTableHtml(Snapshot const& snap);
    QString buildInstructionTableTxt();
    /* I am not sure how I want to implement these yet.
     * I might just include the salts in the instructions table. Until I decide
@@ -111,12 +255,15 @@ private:
    QString buildSaltTableHtml();
    QString buildSaltTableTxt();
    */
-   QString buildBrewNotesHtml();
+   static QString buildBrewNotesHtml(Snapshot const& snap);
    QString buildBrewNotesTxt();
    QString buildHTMLFooter();
 
-   QList<Hop*> sortHopsByTime(Recipe* rec);
-   QList<Fermentable*> sortFermentablesByWeight(Recipe* rec);
+   //! \brief The print preview is only made the first time it is wanted
+   void createPreviewDialog();
+
+   static QList<Hop*> sortHopsByTime(Recipe* rec);
+   static QList<Fermentable*> sortFermentablesByWeight(Recipe* rec);
 
    QString* textSeparator;
    Recipe* rec;
@@ -0,0 +1,224 @@
+/*
+ * RecipeMath.cpp is part of Brewtarget, and is Copyright the following
+ * authors 2021
+ * - Mik Firestone <mikfire@gmail.com>
+ *
+ * Brewtarget is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Brewtarget is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "RecipeMath.h"
+
+#include "Algorithms.h"
+#include "ColorMethods.h"
+#include "IbuMethods.h"
+#include "model/Recipe.h"
+
+RecipeMath::FermentableSnapshot RecipeMath::snapshot(Fermentable* ferm)
+{
+   FermentableSnapshot fs;
+   fs.type               = ferm->type();
+   fs.amount_kg          = ferm->amount_kg();
+   fs.color_srm          = ferm->color_srm();
+   fs.equivSucrose_kg    = ferm->equivSucrose_kg();
+   fs.ibuGalPerLb        = ferm->ibuGalPerLb();
+   fs.isMashed           = ferm->isMashed();
+   fs.addAfterBoil       = ferm->addAfterBoil();
+   fs.isFermentableSugar = Recipe::isFermentableSugar(ferm);
+   return fs;
+}
+
+RecipeMath::HopSnapshot RecipeMath::snapshot(Hop const* hop)
+{
+   HopSnapshot hs;
+   hs.use       = hop->use();
+   hs.form      = hop->form();
+   hs.alpha_pct = hop->alpha_pct();
+   hs.amount_kg = hop->amount_kg();
+   hs.time_min  = hop->time_min();
+   return hs;
+}
+
+double RecipeMath::grainsInMash_kg(QVector<FermentableSnapshot> const& ferms)
+{
+   double ret = 0.0;
+
+   foreach( FermentableSnapshot const& f, ferms ) {
+      if ( f.type == Fermentable::Grain && f.isMashed ) {
+         ret += f.amount_kg;
+      }
+   }
+   return ret;
+}
+
+double RecipeMath::color_srm(QVector<FermentableSnapshot> const& ferms, double finalVolumeNoLosses_l)
+{
+   double mcu = 0.0;
+
+   foreach( FermentableSnapshot const& f, ferms ) {
+      // Conversion factor for lb/gal to kg/l = 8.34538.
+      mcu += f.color_srm * 8.34538 * f.amount_kg / finalVolumeNoLosses_l;
+   }
+   return ColorMethods::mcuToSrm(mcu);
+}
+
+RecipeMath::Sugars RecipeMath::totalPoints(QVector<FermentableSnapshot> const& ferms)
+{
+   Sugars ret = { 0.0, 0.0, 0.0, 0.0, 0.0 };
+
+   foreach( FermentableSnapshot const& f, ferms ) {
+      // If we have some sort of non-grain, we have to ignore efficiency.
+      if ( f.type == Fermentable::Sugar || f.type == Fermentable::Extract || f.type == Fermentable::Dry_Extract ) {
+         ret.sugar_kg_ignoreEfficiency += f.equivSucrose_kg;
+
+         if ( f.addAfterBoil )
+            ret.lateAddition_kg_ignoreEff += f.equivSucrose_kg;
+
+         if ( ! f.isFermentableSugar )
+            ret.nonFermentableSugars_kg += f.equivSucrose_kg;
+      }
+      else {
+         ret.sugar_kg += f.equivSucrose_kg;
+
+         if ( f.addAfterBoil )
+            ret.lateAddition_kg += f.equivSucrose_kg;
+      }
+   }
+   return ret;
+}
+
+double RecipeMath::lossRatio(double postBoilWort_l, double trubChillerLoss_l)
+{
+   double ratio = (postBoilWort_l - trubChillerLoss_l) / postBoilWort_l;
+
+   if ( ratio > 1.0 ) // Usually happens when we don't have a mash yet.
+      ratio = 1.0;
+   else if ( ratio < 0.0 )
+      ratio = 0.0;
+   else if ( Algorithms::isNan(ratio) )
+      ratio = 1.0;
+   return ratio;
+}
+
+double RecipeMath::attenuation_pct(QVector<double> const& attenuations_pct)
+{
+   double ret = 0.0;
+
+   // Get the yeast with the greatest attenuation.
+   foreach( double att, attenuations_pct ) {
+      if ( att > ret )
+         ret = att;
+   }
+   // This means we have yeast, but they neglected to provide attenuation percentages.
+   if ( attenuations_pct.size() > 0 && ret <= 0.0 ) {
+      ret = 75.0; // 75% is an average attenuation.
+   }
+   return ret;
+}
+
+RecipeMath::Gravities RecipeMath::ogFg(Sugars sugars,
+                                       double efficiency_pct,
+                                       double lossRatio,
+                                       double finalVolumeNoLosses_l,
+                                       double attenuation_pct)
+{
+   Gravities ret;
+   double plato;
+   double pnts, fermPnts, nonFermPnts;
+
+   // We might lose some sugar in the form of Trub/Chiller loss and lauter
+   // deadspace. What is subject to efficiency already allows for that.
+   sugars.sugar_kg_ignoreEfficiency *= lossRatio;
+   sugars.nonFermentableSugars_kg *= lossRatio;
+
+   // Total sugars after accounting for efficiency and mash losses. Implicitly includes non-fermentable sugars
+   double sugar_kg = sugars.sugar_kg * efficiency_pct/100.0 + sugars.sugar_kg_ignoreEfficiency;
+   plato = Algorithms::getPlato( sugar_kg, finalVolumeNoLosses_l );
+
+   ret.og = Algorithms::PlatoToSG_20C20C( plato );  // og from all sugars
+   pnts = (ret.og-1)*1000.0;  // points from all sugars
+   if ( sugars.nonFermentableSugars_kg != 0.0 ) {
+      plato = Algorithms::getPlato( sugar_kg - sugars.nonFermentableSugars_kg, finalVolumeNoLosses_l );
+      ret.og_fermentable = Algorithms::PlatoToSG_20C20C( plato );  // og from only fermentable sugars
+      plato = Algorithms::getPlato( sugars.nonFermentableSugars_kg, finalVolumeNoLosses_l );
+      nonFermPnts = (Algorithms::PlatoToSG_20C20C( plato )-1)*1000.0;  // og points from non-fermentable sugars
+
+      fermPnts = (pnts-nonFermPnts) * (1.0 - attenuation_pct/100.0);  // fg points from fermentable sugars
+      ret.fg = 1 + (fermPnts + nonFermPnts)/1000.0;
+      ret.fg_fermentable = 1 + fermPnts/1000.0;  // FG from fermentables only
+   }
+   else {
+      ret.og_fermentable = ret.og;
+      ret.fg = 1 + pnts * (1.0 - attenuation_pct/100.0)/1000.0;
+      ret.fg_fermentable = ret.fg;
+   }
+   return ret;
+}
+
+double RecipeMath::ibuFromHop(HopSnapshot const& hop,
+                              double finalVolumeNoLosses_l,
+                              double og,
+                              double hopUtilization_pct,
+                              int boilTime_min,
+                              double fwhAdjust,
+                              double mashHopAdjust)
+{
+   double ibus = 0.0;
+   double AArating = hop.alpha_pct/100.0;
+   double grams = hop.amount_kg*1000.0;
+   double hopUtilization = hopUtilization_pct/100.0;
+
+   // NOTE: we used to carefully calculate the average boil gravity and use it in the
+   // IBU calculations. However, due to John Palmer
+   // (http://homebrew.stackexchange.com/questions/7343/does-wort-gravity-affect-hop-utilization),
+   // it seems more appropriate to just use the OG directly, since it is the total
+   // amount of break material that truly affects the IBUs.
+   if( hop.use == Hop::Boil)
+      ibus = IbuMethods::getIbus( AArating, grams, finalVolumeNoLosses_l, og, hop.time_min );
+   else if( hop.use == Hop::First_Wort )
+      ibus = fwhAdjust * IbuMethods::getIbus( AArating, grams, finalVolumeNoLosses_l, og, boilTime_min );
+   else if( hop.use == Hop::Mash && mashHopAdjust > 0.0 )
+      ibus = mashHopAdjust * IbuMethods::getIbus( AArating, grams, finalVolumeNoLosses_l, og, boilTime_min );
+
+   // Adjust for hop form. Tinseth's table was created from whole cone data,
+   // and it seems other formulae are optimized that way as well. So, the
+   // utilization is considered unadjusted for whole cones, and adjusted
+   // up for plugs and pellets.
+   //
+   // - http://www.realbeer.com/hops/FAQ.html
+   // - https://groups.google.com/forum/#!topic/brewtarget-help/mv2qvWBC4sU
+   switch( hop.form ) {
+      case Hop::Plug:
+         hopUtilization *= 1.02;
+         break;
+      case Hop::Pellet:
+         hopUtilization *= 1.10;
+         break;
+      default:
+         break;
+   }
+
+   // Adjust for hop utilization.
+   return ibus * hopUtilization;
+}
+
+double RecipeMath::ibuFromFermentables(QVector<FermentableSnapshot> const& ferms, double batchSize_l)
+{
+   double ibus = 0.0;
+
+   foreach( FermentableSnapshot const& f, ferms ) {
+      // Conversion factor for lb/gal to kg/l = 8.34538.
+      ibus += f.ibuGalPerLb * (f.amount_kg / batchSize_l) / 8.34538;
+   }
+   return ibus;
+}
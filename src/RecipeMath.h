@@ -0,0 +1,125 @@
+/*
+ * RecipeMath.h is part of Brewtarget, and is Copyright the following
+ * authors 2021
+ * - Mik Firestone <mikfire@gmail.com>
+ *
+ * Brewtarget is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Brewtarget is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _RECIPEMATH_H
+#define _RECIPEMATH_H
+
+#include <QVector>
+
+#include "model/Fermentable.h"
+#include "model/Hop.h"
+
+/*!
+ * \class RecipeMath
+ *
+ * \brief The arithmetic behind Recipe's calculated properties.
+ *
+ * Everything here works on plain values, so Recipe can use it on its own
+ * ingredients and RecipeReport can use it on snapshots in a worker thread.
+ */
+class RecipeMath
+{
+public:
+   //! \brief What the calculations need from a fermentable
+   struct FermentableSnapshot {
+      Fermentable::Type type;
+      double amount_kg;
+      double color_srm;
+      double equivSucrose_kg;
+      double ibuGalPerLb;
+      bool isMashed;
+      bool addAfterBoil;
+      bool isFermentableSugar;
+   };
+
+   //! \brief What the calculations need from a hop
+   struct HopSnapshot {
+      Hop::Use use;
+      Hop::Form form;
+      double alpha_pct;
+      double amount_kg;
+      double time_min;
+   };
+
+   //! \brief Sugar masses, split the way the gravity calculations need them
+   struct Sugars {
+      //! affected by mash efficiency
+      double sugar_kg;
+      //! not affected by mash efficiency
+      double sugar_kg_ignoreEfficiency;
+      //! not fermentable. Also counted in sugar_kg_ignoreEfficiency
+      double nonFermentableSugars_kg;
+      double lateAddition_kg;
+      double lateAddition_kg_ignoreEff;
+   };
+
+   //! \brief Gravities, with and without the non-fermentable sugars
+   struct Gravities {
+      double og;
+      double fg;
+      double og_fermentable;
+      double fg_fermentable;
+   };
+
+   //! \brief Copies what the calculations need out of \c ferm
+   static FermentableSnapshot snapshot(Fermentable* ferm);
+   //! \brief Copies what the calculations need out of \c hop
+   static HopSnapshot snapshot(Hop const* hop);
+
+   static double grainsInMash_kg(QVector<FermentableSnapshot> const& ferms);
+   static double color_srm(QVector<FermentableSnapshot> const& ferms, double finalVolumeNoLosses_l);
+   static Sugars totalPoints(QVector<FermentableSnapshot> const& ferms);
+
+   /*!
+    * \return the fraction of sugar that survives trub/chiller loss, in [0,1]
+    * \param postBoilWort_l wort at the end of the boil
+    * \param trubChillerLoss_l what gets left behind
+    */
+   static double lossRatio(double postBoilWort_l, double trubChillerLoss_l);
+   //! \return the highest attenuation, or 75% if there are yeasts but none say
+   static double attenuation_pct(QVector<double> const& attenuations_pct);
+
+   /*!
+    * \brief OG and FG from the sugars in the fermenter
+    * \param lossRatio from lossRatio(), or 1.0 without an equipment
+    */
+   static Gravities ogFg(Sugars sugars,
+                         double efficiency_pct,
+                         double lossRatio,
+                         double finalVolumeNoLosses_l,
+                         double attenuation_pct);
+
+   /*!
+    * \return the IBUs from one hop addition
+    * \param hopUtilization_pct from the equipment, 100 without one
+    * \param boilTime_min from the equipment, 60 without one. Used for first
+    *        wort and mash hops
+    */
+   static double ibuFromHop(HopSnapshot const& hop,
+                            double finalVolumeNoLosses_l,
+                            double og,
+                            double hopUtilization_pct,
+                            int boilTime_min,
+                            double fwhAdjust,
+                            double mashHopAdjust);
+   //! \return the IBUs from hopped extracts
+   static double ibuFromFermentables(QVector<FermentableSnapshot> const& ferms, double batchSize_l);
+};
+
+#endif
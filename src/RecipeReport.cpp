@@ -0,0 +1,262 @@
+/*
+ * RecipeReport.cpp is part of Brewtarget, and is Copyright the following
+ * authors 2021
+ * - Mik Firestone <mikfire@gmail.com>
+ *
+ * Brewtarget is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Brewtarget is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "RecipeReport.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+
+#include "Algorithms.h"
+#include "brewtarget.h"
+#include "database.h"
+#include "model/Equipment.h"
+#include "model/Mash.h"
+#include "model/Recipe.h"
+#include "model/Yeast.h"
+#include "PhysicalConstants.h"
+
+namespace {
+   // One recipe's worth of work. Each one writes to its own slot in the
+   // results, so they don't need to lock anything
+   class EvaluateRunnable : public QRunnable
+   {
+   public:
+      EvaluateRunnable(RecipeReport::Snapshot const& snap, RecipeReport::Result* result)
+         : m_snap(snap), m_result(result) {}
+
+      void run() { *m_result = RecipeReport::evaluate(m_snap); }
+
+   private:
+      RecipeReport::Snapshot const& m_snap;
+      RecipeReport::Result* m_result;
+   };
+
+   // CSV quoting: double any embedded quotes and wrap the whole thing
+   QString csvQuote(QString const& field)
+   {
+      QString tmp = field;
+      return QString("\"%1\"").arg(tmp.replace("\"","\"\""));
+   }
+}
+
+RecipeReport::Snapshot RecipeReport::snapshot(Recipe* rec)
+{
+   Snapshot snap;
+
+   snap.key            = rec->key();
+   snap.name           = rec->name();
+   snap.batchSize_l    = rec->batchSize_l();
+   snap.boilSize_l     = rec->boilSize_l();
+   snap.efficiency_pct = rec->efficiency_pct();
+
+   Mash* mash = rec->mash();
+   snap.hasMash = mash != nullptr;
+   snap.totalMashWater_l = mash ? mash->totalMashWater_l() : 0.0;
+
+   Equipment* equip = rec->equipment();
+   snap.hasEquipment = equip != nullptr;
+   if ( equip ) {
+      snap.grainAbsorption_LKg = equip->grainAbsorption_LKg();
+      snap.lauterDeadspace_l   = equip->lauterDeadspace_l();
+      snap.topUpKettle_l       = equip->topUpKettle_l();
+      snap.topUpWater_l        = equip->topUpWater_l();
+      snap.trubChillerLoss_l   = equip->trubChillerLoss_l();
+      snap.boilTime_min        = equip->boilTime_min();
+      snap.evapRate_lHr        = equip->evapRate_lHr();
+      snap.hopUtilization_pct  = equip->hopUtilization_pct();
+   }
+   else {
+      snap.grainAbsorption_LKg = PhysicalConstants::grainAbsorption_Lkg;
+      snap.lauterDeadspace_l   = 0.0;
+      snap.topUpKettle_l       = 0.0;
+      snap.topUpWater_l        = 0.0;
+      snap.trubChillerLoss_l   = 0.0;
+      snap.boilTime_min        = 60.0;
+      snap.evapRate_lHr        = 0.0;
+      snap.hopUtilization_pct  = 100.0;
+   }
+
+   snap.fwhAdjust = Brewtarget::toDouble(Brewtarget::option("firstWortHopAdjustment", 1.1).toString(), "RecipeReport::snapshot()");
+   snap.mashHopAdjust = Brewtarget::toDouble(Brewtarget::option("mashHopAdjustment", 0).toString(), "RecipeReport::snapshot()");
+
+   foreach( Fermentable* f, rec->fermentables() ) {
+      snap.fermentables.append( RecipeMath::snapshot(f) );
+   }
+
+   foreach( Hop* h, rec->hops() ) {
+      snap.hops.append( RecipeMath::snapshot(h) );
+   }
+
+   foreach( Yeast* y, rec->yeasts() ) {
+      snap.yeastAttenuations_pct.append(y->attenuation_pct());
+   }
+
+   return snap;
+}
+
+RecipeReport::Result RecipeReport::evaluate(Snapshot const& snap)
+{
+   Result ret;
+   ret.key = snap.key;
+   ret.name = snap.name;
+
+   // The same steps Recipe::recalcAll() takes, in the same order
+   double grainsInMash_kg = RecipeMath::grainsInMash_kg(snap.fermentables);
+   double wortFromMash_l = 0.0;
+   if ( snap.hasMash ) {
+      wortFromMash_l = snap.totalMashWater_l - snap.grainAbsorption_LKg * grainsInMash_kg;
+   }
+
+   // NOTE: like the recipe, og/fg/ibu/color are figured as if the collected
+   // wort is correct, so the boil volume estimate doesn't feed any of them
+   double finalVolumeNoLosses_l = snap.batchSize_l + snap.trubChillerLoss_l;
+
+   ret.color_srm = RecipeMath::color_srm(snap.fermentables, finalVolumeNoLosses_l);
+
+   double ratio = 1.0;
+   if ( snap.hasEquipment ) {
+      // See Equipment::wortEndOfBoil_l()
+      double kettleWort_l = (wortFromMash_l - snap.lauterDeadspace_l) + snap.topUpKettle_l;
+      double postBoilWort_l = kettleWort_l - (snap.boilTime_min/60.0) * snap.evapRate_lHr;
+      ratio = RecipeMath::lossRatio(postBoilWort_l, snap.trubChillerLoss_l);
+   }
+
+   RecipeMath::Gravities grav = RecipeMath::ogFg( RecipeMath::totalPoints(snap.fermentables),
+                                                  snap.efficiency_pct,
+                                                  ratio,
+                                                  finalVolumeNoLosses_l,
+                                                  RecipeMath::attenuation_pct(snap.yeastAttenuations_pct) );
+   ret.og = grav.og;
+   ret.fg = grav.fg;
+   ret.ABV_pct = Algorithms::abvFromOgAndFg(grav.og_fermentable, grav.fg_fermentable);
+
+   double ibus = 0.0;
+   int boilTime = snap.hasEquipment ? static_cast<int>(snap.boilTime_min) : 60;
+   foreach( RecipeMath::HopSnapshot const& h, snap.hops ) {
+      ibus += RecipeMath::ibuFromHop(h, finalVolumeNoLosses_l, grav.og, snap.hopUtilization_pct,
+                                     boilTime, snap.fwhAdjust, snap.mashHopAdjust);
+   }
+   ibus += RecipeMath::ibuFromFermentables(snap.fermentables, snap.batchSize_l);
+   ret.IBU = ibus;
+
+   return ret;
+}
+
+QVector<RecipeReport::Result> RecipeReport::evaluateAll(QVector<Snapshot> const& snaps)
+{
+   QVector<Result> results(snaps.size());
+   // Detach now, so the workers all write into the same buffer
+   Result* slots = results.data();
+
+   // A private pool, so waitForDone() doesn't wait on anybody else's work
+   QThreadPool pool;
+   pool.setMaxThreadCount(QThread::idealThreadCount());
+
+   for( int i = 0; i < snaps.size(); ++i ) {
+      pool.start(new EvaluateRunnable(snaps.at(i), slots + i));
+   }
+   pool.waitForDone();
+
+   return results;
+}
+
+void RecipeReport::write(QVector<Result> const& results, QTextStream& out, Format format)
+{
+   if ( format == JSON ) {
+      QJsonArray all;
+      foreach( Result const& r, results ) {
+         QJsonObject obj;
+         obj.insert("id", r.key);
+         obj.insert("name", r.name);
+         obj.insert("og", r.og);
+         obj.insert("fg", r.fg);
+         obj.insert("ibu", r.IBU);
+         obj.insert("srm", r.color_srm);
+         obj.insert("abv", r.ABV_pct);
+         all.append(obj);
+      }
+      out << QJsonDocument(all).toJson();
+      return;
+   }
+
+   out << "id,name,og,fg,ibu,srm,abv\n";
+   foreach( Result const& r, results ) {
+      out << QString("%1,%2,%3,%4,%5,%6,%7\n")
+               .arg(r.key)
+               .arg(csvQuote(r.name))
+               .arg(r.og, 0, 'f', 3)
+               .arg(r.fg, 0, 'f', 3)
+               .arg(r.IBU, 0, 'f', 1)
+               .arg(r.color_srm, 0, 'f', 1)
+               .arg(r.ABV_pct, 0, 'f', 2);
+   }
+}
+
+int RecipeReport::run(QString const& fileName)
+{
+   QElapsedTimer timer;
+   QVector<Snapshot> snaps;
+
+   timer.start();
+   // The snapshots have to be taken here. The recipes are QObjects living on
+   // this thread, and their getters may go to the db
+   foreach( Recipe* rec, Database::instance().recipes() ) {
+      snaps.append(snapshot(rec));
+   }
+   qint64 snapped = timer.restart();
+
+   QVector<Result> results = evaluateAll(snaps);
+   qint64 evaluated = timer.elapsed();
+
+   qInfo() << QString("%1 snapshot %2 recipes in %3 ms, evaluated in %4 ms on %5 threads")
+                 .arg(Q_FUNC_INFO)
+                 .arg(snaps.size())
+                 .arg(snapped)
+                 .arg(evaluated)
+                 .arg(QThread::idealThreadCount());
+
+   Format format = QFileInfo(fileName).suffix().toLower() == "json" ? JSON : CSV;
+
+   if ( fileName.isEmpty() ) {
+      QTextStream out(stdout);
+      write(results, out, format);
+      return 0;
+   }
+
+   QFile outFile(fileName);
+   if ( ! outFile.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text) ) {
+      qCritical() << QString("%1 Could not open %2 for writing: %3")
+                        .arg(Q_FUNC_INFO)
+                        .arg(fileName)
+                        .arg(outFile.errorString());
+      return 1;
+   }
+
+   QTextStream out(&outFile);
+   write(results, out, format);
+   return 0;
+}
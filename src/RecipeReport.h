@@ -0,0 +1,111 @@
+/*
+ * RecipeReport.h is part of Brewtarget, and is Copyright the following
+ * authors 2021
+ * - Mik Firestone <mikfire@gmail.com>
+ *
+ * Brewtarget is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Brewtarget is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RECIPE_REPORT_H
+#define RECIPE_REPORT_H
+
+#include <QList>
+#include <QString>
+#include <QTextStream>
+#include <QVector>
+
+#include "RecipeMath.h"
+
+class Recipe;
+
+/*!
+ * \class RecipeReport
+ *
+ * \brief Batch calculation of the headline numbers (OG, FG, IBU, SRM, ABV)
+ * for every recipe in the database, without a MainWindow.
+ *
+ * The recipes are copied into plain value snapshots on the calling thread.
+ * The math then runs on those snapshots in a thread pool, so it never goes
+ * near the QObject signals or the per-thread database connections. The math
+ * itself is RecipeMath, same as Recipe::recalcAll().
+ */
+class RecipeReport
+{
+public:
+   //! \brief Everything Recipe::recalcAll() reads, by value
+   struct Snapshot {
+      int key;
+      QString name;
+      double batchSize_l;
+      double boilSize_l;
+      double efficiency_pct;
+
+      bool hasMash;
+      double totalMashWater_l;
+
+      bool hasEquipment;
+      double grainAbsorption_LKg;
+      double lauterDeadspace_l;
+      double topUpKettle_l;
+      double topUpWater_l;
+      double trubChillerLoss_l;
+      double boilTime_min;
+      double evapRate_lHr;
+      double hopUtilization_pct;
+
+      // These are options, but reading QSettings from the workers is asking
+      // for trouble
+      double fwhAdjust;
+      double mashHopAdjust;
+
+      QVector<RecipeMath::FermentableSnapshot> fermentables;
+      QVector<RecipeMath::HopSnapshot> hops;
+      QVector<double> yeastAttenuations_pct;
+   };
+
+   //! \brief The calculated numbers for one recipe
+   struct Result {
+      int key;
+      QString name;
+      double og;
+      double fg;
+      double IBU;
+      double color_srm;
+      double ABV_pct;
+   };
+
+   enum Format { CSV, JSON };
+
+   //! \brief Copies what the calculations need out of \c rec. Call this on the GUI thread.
+   static Snapshot snapshot(Recipe* rec);
+   //! \brief Does the math. Touches nothing but \c snap, so it is safe on any thread.
+   static Result evaluate(Snapshot const& snap);
+   //! \brief Evaluates every snapshot using all the cores, keeping the order of \c snaps
+   static QVector<Result> evaluateAll(QVector<Snapshot> const& snaps);
+
+   //! \brief Writes \c results to \c out, one row or object per recipe
+   static void write(QVector<Result> const& results, QTextStream& out, Format format);
+
+   /*!
+    * \brief Snapshots every recipe in the database, evaluates them and writes
+    * the report.
+    *
+    * \param fileName where to write. Empty means stdout. A .json suffix
+    *        gets JSON, anything else gets CSV.
+    * \returns 0 on success, non-zero otherwise. Suitable for main().
+    */
+   static int run(QString const& fileName);
+};
+
+#endif
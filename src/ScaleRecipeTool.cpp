@@ -52,6 +52,14 @@ void ScaleRecipeTool::accept() {
    double newEff = field("effLineEdit").toString().toDouble();
    scale(selectedEquip, newEff);
 
+   // scale() only queued its writes; send them out as one commit
+   try {
+      Database::instance().flushPendingWrites();
+   }
+   catch (QString e) {
+      qCritical() << Q_FUNC_INFO << e;
+   }
+
    QWizard::accept();
 }
 
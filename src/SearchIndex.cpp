@@ -0,0 +1,483 @@
+/*
+ * SearchIndex.cpp is part of Brewtarget, and is Copyright the following
+ * authors 2021
+ * - Mik Firestone <mikfire@gmail.com>
+ *
+ * Brewtarget is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Brewtarget is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SearchIndex.h"
+
+#include <cstring>
+#include <functional>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QPair>
+#include <QRegExp>
+#include <QRunnable>
+#include <QSharedPointer>
+#include <QSortFilterProxyModel>
+#include <QVector>
+
+#include "database.h"
+#include "model/Equipment.h"
+#include "model/Fermentable.h"
+#include "model/Hop.h"
+#include "model/Misc.h"
+#include "model/NamedEntity.h"
+#include "model/Recipe.h"
+#include "model/Style.h"
+#include "model/Water.h"
+#include "model/Yeast.h"
+
+SearchIndex* SearchIndex::searchInstance = nullptr;
+
+namespace {
+   // What gets indexed. Every class that has notes calls the property
+   // "notes", so one entry does for all of them. Things without a property
+   // just return an invalid QVariant
+   char const * const indexedFields[] = {
+      PropertyNames::NamedEntity::name,
+      PropertyNames::Hop::notes,
+      PropertyNames::Hop::origin,
+      PropertyNames::Hop::substitutes,
+      PropertyNames::Fermentable::supplier,
+      PropertyNames::Misc::useFor,
+      PropertyNames::Yeast::bestFor,
+      PropertyNames::Yeast::laboratory,
+      PropertyNames::Yeast::productID,
+      PropertyNames::Style::examples,
+      PropertyNames::Style::profile,
+      PropertyNames::Style::ingredients,
+      PropertyNames::Recipe::tasteNotes
+   };
+
+   // Fuzzy matching on short words finds too much to be useful
+   int const minFuzzyLength = 4;
+
+   bool isIndexedField(char const* name)
+   {
+      for( char const* field : indexedFields ) {
+         if ( std::strcmp(field, name) == 0 )
+            return true;
+      }
+      return false;
+   }
+
+   //! \brief Splits \c text into unique words, lower case and without accents
+   QStringList tokenize(QString const& text)
+   {
+      QSet<QString> words;
+      QString word;
+
+      // Decomposing splits "ü" into "u" and a combining mark we can drop
+      for( QChar c : text.normalized(QString::NormalizationForm_D).toLower() ) {
+         if ( c.category() == QChar::Mark_NonSpacing )
+            continue;
+         if ( c.isLetterOrNumber() ) {
+            word.append(c);
+         }
+         else if ( ! word.isEmpty() ) {
+            words.insert(word);
+            word.clear();
+         }
+      }
+      if ( ! word.isEmpty() )
+         words.insert(word);
+
+      return words.toList();
+   }
+
+   //! \brief \c word with each letter dropped in turn
+   QStringList deletions(QString const& word)
+   {
+      QStringList ret;
+      for( int i = 0; i < word.length(); ++i )
+         ret.append( QString(word).remove(i,1) );
+      return ret;
+   }
+
+   //! \brief true if one insertion, deletion, substitution or swap turns \c a into \c b
+   bool withinOneEdit(QString const& a, QString const& b)
+   {
+      int const la = a.length();
+      int const lb = b.length();
+      if ( qAbs(la - lb) > 1 )
+         return false;
+
+      int i = 0;
+      while ( i < la && i < lb && a.at(i) == b.at(i) )
+         ++i;
+
+      if ( la == lb ) {
+         if ( i == la )
+            return true;
+         // substitution
+         if ( a.midRef(i+1) == b.midRef(i+1) )
+            return true;
+         // adjacent swap
+         return i + 1 < la &&
+                a.at(i) == b.at(i+1) && a.at(i+1) == b.at(i) &&
+                a.midRef(i+2) == b.midRef(i+2);
+      }
+
+      // insertion or deletion
+      return la < lb ? a.midRef(i) == b.midRef(i+1) : a.midRef(i+1) == b.midRef(i);
+   }
+
+   //! \brief Runs the build for SearchIndex::rebuild() on a pool thread
+   class BuildRunnable : public QRunnable
+   {
+   public:
+      BuildRunnable(std::function<void()> work) : work(work) {}
+      void run() { work(); }
+
+   private:
+      std::function<void()> work;
+   };
+}
+
+void SearchIndex::Terms::add(NamedEntity* thing, QString const& text)
+{
+   QStringList words = tokenize(text);
+
+   foreach( QString const& word, words ) {
+      QSet<NamedEntity*>& users = postings[word];
+      // First time we've seen this word, so remember how to find it from a typo
+      if ( users.isEmpty() && word.length() >= minFuzzyLength ) {
+         foreach( QString const& variant, deletions(word) )
+            variants[variant].insert(word);
+      }
+      users.insert(thing);
+   }
+
+   termsOf.insert(thing, words);
+}
+
+void SearchIndex::Terms::remove(NamedEntity* thing)
+{
+   foreach( QString const& word, termsOf.take(thing) ) {
+      auto it = postings.find(word);
+      if ( it == postings.end() )
+         continue;
+
+      it.value().remove(thing);
+      if ( ! it.value().isEmpty() )
+         continue;
+
+      // Nobody uses the word anymore
+      postings.erase(it);
+      if ( word.length() >= minFuzzyLength ) {
+         foreach( QString const& variant, deletions(word) ) {
+            auto vit = variants.find(variant);
+            if ( vit == variants.end() )
+               continue;
+            vit.value().remove(word);
+            if ( vit.value().isEmpty() )
+               variants.erase(vit);
+         }
+      }
+   }
+}
+
+SearchIndex::SearchIndex()
+   : QObject(),
+     ready(false),
+     building(false),
+     builtGeneration(0),
+     generation(0)
+{
+   // One build at a time is plenty
+   pool.setMaxThreadCount(1);
+
+   connect( this, &SearchIndex::buildFinished, this, &SearchIndex::installBuild, Qt::QueuedConnection );
+
+   Database& db = Database::instance();
+   connect( &db, qOverload<Equipment*>(&Database::createdSignal),   this, [this](Equipment* e)   { add(e); } );
+   connect( &db, qOverload<Fermentable*>(&Database::createdSignal), this, [this](Fermentable* f) { add(f); } );
+   connect( &db, qOverload<Hop*>(&Database::createdSignal),         this, [this](Hop* h)         { add(h); } );
+   connect( &db, qOverload<Misc*>(&Database::createdSignal),        this, [this](Misc* m)        { add(m); } );
+   connect( &db, qOverload<Recipe*>(&Database::createdSignal),      this, [this](Recipe* r)      { add(r); } );
+   connect( &db, qOverload<Style*>(&Database::createdSignal),       this, [this](Style* s)       { add(s); } );
+   connect( &db, qOverload<Water*>(&Database::createdSignal),       this, [this](Water* w)       { add(w); } );
+   connect( &db, qOverload<Yeast*>(&Database::createdSignal),       this, [this](Yeast* y)       { add(y); } );
+
+   connect( &db, qOverload<Equipment*>(&Database::deletedSignal),   this, [this](Equipment* e)   { remove(e); } );
+   connect( &db, qOverload<Fermentable*>(&Database::deletedSignal), this, [this](Fermentable* f) { remove(f); } );
+   connect( &db, qOverload<Hop*>(&Database::deletedSignal),         this, [this](Hop* h)         { remove(h); } );
+   connect( &db, qOverload<Misc*>(&Database::deletedSignal),        this, [this](Misc* m)        { remove(m); } );
+   connect( &db, qOverload<Recipe*>(&Database::deletedSignal),      this, [this](Recipe* r)      { remove(r); } );
+   connect( &db, qOverload<Style*>(&Database::deletedSignal),       this, [this](Style* s)       { remove(s); } );
+   connect( &db, qOverload<Water*>(&Database::deletedSignal),       this, [this](Water* w)       { remove(w); } );
+   connect( &db, qOverload<Yeast*>(&Database::deletedSignal),       this, [this](Yeast* y)       { remove(y); } );
+}
+
+SearchIndex::~SearchIndex()
+{
+   pool.waitForDone();
+}
+
+SearchIndex& SearchIndex::instance()
+{
+   // Only ever touched from the GUI thread, so no locking
+   if ( ! searchInstance )
+      searchInstance = new SearchIndex();
+
+   return *searchInstance;
+}
+
+void SearchIndex::dropInstance()
+{
+   delete searchInstance;
+   searchInstance = nullptr;
+}
+
+void SearchIndex::rebuild()
+{
+   Database& db = Database::instance();
+   QElapsedTimer timer;
+   timer.start();
+
+   // Reading the properties has to happen here. Everything after that is
+   // just strings, and can go to the pool
+   QList<NamedEntity*> things;
+   foreach( Equipment* e, db.equipments() )     things.append(e);
+   foreach( Fermentable* f, db.fermentables() ) things.append(f);
+   foreach( Hop* h, db.hops() )                 things.append(h);
+   foreach( Misc* m, db.miscs() )               things.append(m);
+   foreach( Recipe* r, db.recipes() )           things.append(r);
+   foreach( Style* s, db.styles() )             things.append(s);
+   foreach( Water* w, db.waters() )             things.append(w);
+   foreach( Yeast* y, db.yeasts() )             things.append(y);
+
+   auto docs = QSharedPointer< QVector< QPair<NamedEntity*,QString> > >::create();
+   docs->reserve(things.size());
+   foreach( NamedEntity* thing, things ) {
+      docs->append( qMakePair(thing, textOf(thing)) );
+      watch(thing);
+   }
+
+   building = true;
+   dirtyWhileBuilding.clear();
+   goneWhileBuilding.clear();
+   int const thisGeneration = ++generation;
+
+   qInfo() << QString("%1 read %2 things in %3 ms").arg(Q_FUNC_INFO).arg(docs->size()).arg(timer.elapsed());
+
+   pool.start( new BuildRunnable( [this, docs, thisGeneration]() {
+      QElapsedTimer buildTimer;
+      buildTimer.start();
+
+      Terms local;
+      for( auto const& doc : *docs )
+         local.add(doc.first, doc.second);
+
+      qInfo() << QString("SearchIndex::rebuild() indexed %1 words in %2 ms")
+                 .arg(local.postings.size()).arg(buildTimer.elapsed());
+
+      builtMutex.lock();
+      built = std::move(local);
+      builtGeneration = thisGeneration;
+      builtMutex.unlock();
+
+      emit buildFinished();
+   }));
+}
+
+void SearchIndex::installBuild()
+{
+   builtMutex.lock();
+   // A newer rebuild() is on its way; this one is already stale
+   if ( builtGeneration != generation ) {
+      builtMutex.unlock();
+      return;
+   }
+   terms = std::move(built);
+   built = Terms();
+   builtMutex.unlock();
+
+   building = false;
+
+   // Catch up on whatever happened while we were building
+   foreach( NamedEntity* thing, goneWhileBuilding )
+      terms.remove(thing);
+   foreach( NamedEntity* thing, dirtyWhileBuilding ) {
+      terms.remove(thing);
+      terms.add(thing, textOf(thing));
+   }
+   dirtyWhileBuilding.clear();
+   goneWhileBuilding.clear();
+
+   invalidateLastQuery();
+   ready = true;
+   emit indexReady();
+}
+
+bool SearchIndex::isReady() const
+{
+   return ready;
+}
+
+QString SearchIndex::textOf(NamedEntity const* thing)
+{
+   QStringList text;
+   for( char const* field : indexedFields ) {
+      QVariant value = thing->property(field);
+      if ( value.isValid() )
+         text.append(value.toString());
+   }
+   return text.join(' ');
+}
+
+void SearchIndex::watch(NamedEntity* thing)
+{
+   // UniqueConnection, since rebuild() walks everything again
+   connect( thing, &NamedEntity::changed, this, &SearchIndex::reindexChanged, Qt::UniqueConnection );
+   connect( thing, &QObject::destroyed, this, &SearchIndex::forget, Qt::UniqueConnection );
+}
+
+void SearchIndex::add(NamedEntity* thing)
+{
+   if ( ! thing )
+      return;
+
+   watch(thing);
+
+   if ( building ) {
+      goneWhileBuilding.remove(thing);
+      dirtyWhileBuilding.insert(thing);
+   }
+   terms.remove(thing);
+   terms.add(thing, textOf(thing));
+   invalidateLastQuery();
+}
+
+void SearchIndex::remove(NamedEntity* thing)
+{
+   if ( building ) {
+      dirtyWhileBuilding.remove(thing);
+      goneWhileBuilding.insert(thing);
+   }
+   terms.remove(thing);
+   invalidateLastQuery();
+}
+
+void SearchIndex::reindexChanged(QMetaProperty prop, QVariant /*value*/)
+{
+   if ( ! isIndexedField(prop.name()) )
+      return;
+
+   NamedEntity* thing = qobject_cast<NamedEntity*>(sender());
+   // Soft deleted things stay out until they are undeleted
+   if ( thing && ! thing->deleted() )
+      add(thing);
+}
+
+void SearchIndex::forget(QObject* gone)
+{
+   // Too late to qobject_cast. We only need the address anyway
+   remove(static_cast<NamedEntity*>(gone));
+}
+
+void SearchIndex::invalidateLastQuery()
+{
+   lastQuery.clear();
+   lastResult.clear();
+}
+
+QSet<NamedEntity*> SearchIndex::lookup(QString const& word, bool fuzzy) const
+{
+   QSet<NamedEntity*> hits;
+
+   // Prefixes. The map is sorted, so everything starting with word follows
+   // lowerBound(word)
+   for( auto it = terms.postings.lowerBound(word);
+        it != terms.postings.constEnd() && it.key().startsWith(word);
+        ++it ) {
+      hits.unite(it.value());
+   }
+
+   if ( ! fuzzy || word.length() < minFuzzyLength )
+      return hits;
+
+   // Words one letter longer than ours have us as a variant. Words one
+   // letter shorter are one of our variants. Substitutions and swaps share
+   // a variant with us. That finds candidates; withinOneEdit() sorts out
+   // the ones that are really two edits away.
+   QSet<QString> candidates = terms.variants.value(word);
+   foreach( QString const& variant, deletions(word) ) {
+      if ( terms.postings.contains(variant) )
+         candidates.insert(variant);
+      candidates.unite( terms.variants.value(variant) );
+   }
+
+   foreach( QString const& candidate, candidates ) {
+      if ( withinOneEdit(word, candidate) )
+         hits.unite( terms.postings.value(candidate) );
+   }
+
+   return hits;
+}
+
+QSet<NamedEntity*> SearchIndex::search(QString const& query, bool fuzzy) const
+{
+   QSet<NamedEntity*> result;
+   bool first = true;
+
+   foreach( QString const& word, tokenize(query) ) {
+      if ( first ) {
+         result = lookup(word, fuzzy);
+         first = false;
+      }
+      else {
+         result.intersect( lookup(word, fuzzy) );
+      }
+
+      if ( result.isEmpty() )
+         break;
+   }
+
+   return result;
+}
+
+bool SearchIndex::matches(NamedEntity const* thing, QString const& query) const
+{
+   if ( query.trimmed().isEmpty() )
+      return true;
+
+   if ( query != lastQuery ) {
+      lastResult = search(query);
+      lastQuery = query;
+   }
+
+   return lastResult.contains( const_cast<NamedEntity*>(thing) );
+}
+
+bool SearchIndex::filterAccepts(NamedEntity const* thing, QString const& name, QRegExp const& filter) const
+{
+   if ( ! thing->display() )
+      return false;
+
+   // The index only matches words from the front, so keep the substring
+   // match on the name the filters always had
+   if ( name.contains(filter) )
+      return true;
+
+   return ready && matches(thing, filter.pattern());
+}
+
+void SearchIndex::refilterWhenReady(QSortFilterProxyModel* proxy)
+{
+   connect( this, &SearchIndex::indexReady, proxy, &QSortFilterProxyModel::invalidate );
+}
@@ -0,0 +1,149 @@
+/*
+ * SearchIndex.h is part of Brewtarget, and is Copyright the following
+ * authors 2021
+ * - Mik Firestone <mikfire@gmail.com>
+ *
+ * Brewtarget is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Brewtarget is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SEARCH_INDEX_H
+#define SEARCH_INDEX_H
+
+#include <QHash>
+#include <QMap>
+#include <QMetaProperty>
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QVariant>
+
+class NamedEntity;
+class QRegExp;
+class QSortFilterProxyModel;
+
+/*!
+ * \class SearchIndex
+ *
+ * \brief Inverted index over the text fields (name, notes, origin,
+ * substitutes, style examples and the like) of the ingredients, recipes,
+ * styles, equipment and waters in the database.
+ *
+ * Words are folded to lower case without accents. Every word in a query has
+ * to match; a query word matches any indexed word it is a prefix of and, if
+ * it is long enough, any indexed word one typo away.
+ *
+ * The first build runs on a pool thread after the database loads. Until it
+ * is done, isReady() is false and callers should fall back to whatever they
+ * did before. After that, the index follows Database::createdSignal,
+ * Database::deletedSignal and each thing's changed() signal. Everything but
+ * the build happens on the GUI thread.
+ */
+class SearchIndex : public QObject
+{
+   Q_OBJECT
+public:
+   static SearchIndex& instance();
+   //! \brief Waits for any build in flight and deletes the instance
+   static void dropInstance();
+
+   //! \brief Starts building the index from the database in the background
+   void rebuild();
+   //! \brief true once a build has finished
+   bool isReady() const;
+
+   //! \brief Everything matching every word of \c query
+   QSet<NamedEntity*> search(QString const& query, bool fuzzy = true) const;
+   /*!
+    * \brief true if \c thing matches \c query. An empty query matches
+    * everything.
+    *
+    * Filters ask this once per row with the same query, so the last result
+    * is kept until the query or the index changes.
+    */
+   bool matches(NamedEntity const* thing, QString const& query) const;
+
+   /*!
+    * \brief What the ingredient filters accept: anything displayed whose
+    * \c name contains \c filter, or that the index matches once it is ready
+    */
+   bool filterAccepts(NamedEntity const* thing, QString const& name, QRegExp const& filter) const;
+   //! \brief Makes \c proxy filter again each time a build is installed
+   void refilterWhenReady(QSortFilterProxyModel* proxy);
+
+signals:
+   //! \brief emitted when a build has been installed
+   void indexReady();
+   //! \brief emitted from the pool thread when a build is done
+   void buildFinished();
+
+private slots:
+   void installBuild();
+   void reindexChanged(QMetaProperty prop, QVariant value);
+   void forget(QObject* gone);
+
+private:
+   //! \brief The index proper. Plain values, so it can be built off the GUI thread
+   struct Terms {
+      //! word -> things using it. A QMap, so a prefix is a range
+      QMap< QString, QSet<NamedEntity*> > postings;
+      //! word with one letter dropped -> the words it came from
+      QHash< QString, QSet<QString> > variants;
+      //! thing -> its words, so it can be taken back out
+      QHash< NamedEntity*, QStringList > termsOf;
+
+      void add(NamedEntity* thing, QString const& text);
+      void remove(NamedEntity* thing);
+   };
+
+   SearchIndex();
+   ~SearchIndex();
+   SearchIndex(SearchIndex const&) = delete;
+   SearchIndex& operator=(SearchIndex const&) = delete;
+
+   //! \brief What the index reads from \c thing. Call on the GUI thread.
+   static QString textOf(NamedEntity const* thing);
+   QSet<NamedEntity*> lookup(QString const& word, bool fuzzy) const;
+
+   //! \brief Connects to \c thing's signals so we hear about edits
+   void watch(NamedEntity* thing);
+   void add(NamedEntity* thing);
+   void remove(NamedEntity* thing);
+   void invalidateLastQuery();
+
+   static SearchIndex* searchInstance;
+
+   Terms terms;
+   bool ready;
+
+   // Edits that land while a build is running, replayed when it is installed
+   bool building;
+   QSet<NamedEntity*> dirtyWhileBuilding;
+   QSet<NamedEntity*> goneWhileBuilding;
+
+   // Handed from the build thread to installBuild()
+   QMutex builtMutex;
+   Terms built;
+   int builtGeneration;
+   int generation;
+
+   QThreadPool pool;
+
+   mutable QString lastQuery;
+   mutable QSet<NamedEntity*> lastResult;
+};
+
+#endif
@@ -58,7 +58,8 @@ TableSchema::TableSchema(Brewtarget::DBTable table)
       m_invTable(Brewtarget::NOTABLE),
       m_btTable(Brewtarget::NOTABLE),
       m_trigger(QString()),
-      m_defType(Brewtarget::dbType())
+      m_defType(Brewtarget::dbType()),
+      m_resolvedCount(-1)
 {
     // for this bit of ugly, I gain a lot of utility.
     defineTable();
@@ -198,6 +199,49 @@ const QString TableSchema::foreignKeyToColumn(Brewtarget::DBTypes type) const
    return retval;
 }
 
+void TableSchema::resolveColumns(QSqlRecord const& rec) const
+{
+   m_propertyIndex.clear();
+   m_foreignKeyIndex.clear();
+
+   QMapIterator<QString,PropertySchema*> i(m_properties);
+   while ( i.hasNext() ) {
+      i.next();
+      m_propertyIndex.insert( i.key(), rec.indexOf(i.value()->colName(m_defType)) );
+   }
+
+   QMapIterator<QString,PropertySchema*> j(m_foreignKeys);
+   while ( j.hasNext() ) {
+      j.next();
+      m_foreignKeyIndex.insert( j.key(), rec.indexOf(j.value()->colName(m_defType)) );
+   }
+
+   m_resolvedCount = rec.count();
+}
+
+QVariant TableSchema::value(QSqlRecord const& rec, QString const& prop) const
+{
+   // Anything but SELECT * gets looked up the slow way
+   if ( rec.count() != m_resolvedCount ) {
+      if ( m_resolvedCount != -1 ) {
+         return rec.value( propertyToColumn(prop) );
+      }
+      resolveColumns(rec);
+   }
+   return rec.value( m_propertyIndex.value(prop, -1) );
+}
+
+QVariant TableSchema::foreignKeyValue(QSqlRecord const& rec, QString const& fkey) const
+{
+   if ( rec.count() != m_resolvedCount ) {
+      if ( m_resolvedCount != -1 ) {
+         return rec.value( foreignKeyToColumn(fkey) );
+      }
+      resolveColumns(rec);
+   }
+   return rec.value( m_foreignKeyIndex.value(fkey, -1) );
+}
+
 const QString TableSchema::propertyToXml(QString prop, Brewtarget::DBTypes type) const
 {
    Brewtarget::DBTypes selected = type == Brewtarget::ALLDB ? m_defType : type;
@@ -449,6 +493,32 @@ const QString TableSchema::generateInsertRow(Brewtarget::DBTypes type)
    return QString("INSERT INTO %1 (%2) VALUES(%3)").arg(m_tableName).arg(columns).arg(binding);
 }
 
+const QStringList TableSchema::insertColumnNames(Brewtarget::DBTypes type) const
+{
+   Brewtarget::DBTypes selected = type == Brewtarget::ALLDB ? m_defType : type;
+
+   return QStringList() << keyName(selected)
+                        << allColumnNames(selected)
+                        << allForeignKeyColumnNames(selected);
+}
+
+const QString TableSchema::generateInsertRows(int rows, Brewtarget::DBTypes type)
+{
+   QStringList columns = insertColumnNames(type);
+
+   QStringList marks;
+   for( int i = 0; i < columns.size(); ++i ) {
+      marks.append(QString("?"));
+   }
+   QString row = QString("(%1)").arg(marks.join(","));
+
+   QStringList values;
+   for( int i = 0; i < rows; ++i ) {
+      values.append(row);
+   }
+   return QString("INSERT INTO %1 (%2) VALUES %3").arg(m_tableName).arg(columns.join(",")).arg(values.join(","));
+}
+
 // NOTE: This does NOT deal with foreign keys nor the primary key for the table. It assumes
 // any calling method will handle those relationships. In my rough design ideas, a table knows
 // of itself and foreign key *values* are part of the database.
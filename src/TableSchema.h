@@ -21,6 +21,8 @@
 
 #include "PropertySchema.h"
 #include "brewtarget.h"
+#include <QHash>
+#include <QSqlRecord>
 #include <QString>
 
 class TableSchema : QObject
@@ -132,6 +134,10 @@ public:
    const QString generateUpdateRow(Brewtarget::DBTypes type = Brewtarget::ALLDB);
    //!brief generate an INSERT into a table, including all foreign keys
    const QString generateInsertRow(Brewtarget::DBTypes type = Brewtarget::ALLDB);
+   //!brief generate an INSERT of \c rows rows with positional bindings, columns in insertColumnNames() order
+   const QString generateInsertRows(int rows, Brewtarget::DBTypes type = Brewtarget::ALLDB);
+   //!brief the key, the properties and then the foreign keys -- the column order generateInsertRow() uses
+   const QStringList insertColumnNames(Brewtarget::DBTypes type = Brewtarget::ALLDB) const;
    //!brief generate an INSERT into a table, ignoring all of the foreign keys
    const QString generateInsertProperties(Brewtarget::DBTypes type = Brewtarget::ALLDB);
    //!brief generate a CREATE temp table, needed when dropping columns in SQLite
@@ -158,6 +164,18 @@ public:
    // convenience for the name of the key (eg, id) field in the db
    const QString keyName(Brewtarget::DBTypes type = Brewtarget::ALLDB) const;
 
+   // Reading records. The entity constructors read every column of every
+   // row, and QSqlRecord::value(name) searches the fields each time. These
+   // work out where each column is once, from the first record, and reuse
+   // that for every record of the same shape. GUI thread only.
+
+   //!brief where every property and foreign key is in records shaped like \c rec
+   void resolveColumns(QSqlRecord const& rec) const;
+   //!brief the value of property \c prop in \c rec
+   QVariant value(QSqlRecord const& rec, QString const& prop) const;
+   //!brief the value of foreign key \c fkey in \c rec
+   QVariant foreignKeyValue(QSqlRecord const& rec, QString const& fkey) const;
+
 private:
 
    // I only allow table schema to be made with a DBTable constant
@@ -188,6 +206,12 @@ private:
    // metaphor.
    Brewtarget::DBTypes m_defType;
 
+   // See resolveColumns(). m_resolvedCount is the field count of the record
+   // they came from, or -1 if nothing is resolved yet
+   mutable QHash<QString,int> m_propertyIndex;
+   mutable QHash<QString,int> m_foreignKeyIndex;
+   mutable int m_resolvedCount;
+
    // getter only. But this is private because only my dearest,
    // closest friends can do this
    Brewtarget::DBTypes defType() const;
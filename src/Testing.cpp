@@ -27,13 +27,18 @@
 #include "database.h"
 #include "model/Hop.h"
 #include "model/Fermentable.h"
+#include "model/Instruction.h"
 #include "model/Mash.h"
 #include "model/MashStep.h"
 #include "Log.h"
 
 #include <QDebug>
 #include <QDir>
+#include <QPointer>
+#include <QSqlDatabase>
+#include <QSqlQuery>
 #include <QString>
+#include <QTemporaryDir>
 #include <QtTest/QtTest>
 
 QTEST_MAIN(Testing)
@@ -262,6 +267,204 @@ void Testing::postBoilLossOgTest()
    QVERIFY2( fuzzyComp(recLoss->og(), recNoLoss->og(), 0.002), "OG of recipe with post-boil loss is different from no-loss recipe" );
 }
 
+void Testing::sharedIngredientCopyOnWrite()
+{
+   Database& db = Database::instance();
+   Recipe* older = db.newRecipe(QString("TestRecipe_shareOlder"));
+
+   twoRow->setAmount_kg(4.0);
+   Fermentable* ferm = older->add<Fermentable>(twoRow);
+   QVERIFY( ferm );
+
+   // A new version links to what it didn't change instead of copying it
+   Recipe* newer = db.copyRecipeExcept(older, nullptr);
+   QVERIFY2( newer->fermentables().contains(ferm), "New version does not share the fermentable" );
+
+   // Edit: the newest version gets its own copy, the old one is untouched
+   ferm->setAmount_kg(5.0);
+   QCOMPARE( older->fermentables(), QList<Fermentable*>() << ferm );
+   QVERIFY2( fuzzyComp(ferm->amount_kg(), 4.0, 0.001), "Editing a shared fermentable changed the old version" );
+   QCOMPARE( newer->fermentables().size(), 1 );
+   Fermentable* edited = newer->fermentables().first();
+   QVERIFY2( edited != ferm, "Editing a shared fermentable did not copy it" );
+   QVERIFY2( fuzzyComp(edited->amount_kg(), 5.0, 0.001), "The copy did not get the edit" );
+
+   // Delete: only the link goes, the old version keeps the fermentable
+   Recipe* another = db.copyRecipeExcept(older, nullptr);
+   QVERIFY2( another->fermentables().contains(ferm), "New version does not share the fermentable" );
+   another->remove<Fermentable>(ferm);
+   QVERIFY2( another->fermentables().isEmpty(), "Removed fermentable is still in the recipe" );
+   QCOMPARE( older->fermentables(), QList<Fermentable*>() << ferm );
+
+   // Undo: the link comes back, not a copy
+   Fermentable* restored = another->add<Fermentable>(ferm);
+   QVERIFY2( restored == ferm, "Undoing the removal made a copy" );
+   QCOMPARE( another->fermentables(), QList<Fermentable*>() << ferm );
+   QCOMPARE( older->fermentables(), QList<Fermentable*>() << ferm );
+
+   // Detach: unlocking the old version gives it its own copy, so editing it
+   // can't reach the newer one
+   older->setLocked(false);
+   QCOMPARE( older->fermentables().size(), 1 );
+   Fermentable* detached = older->fermentables().first();
+   QVERIFY2( detached != ferm, "Unlocked version still shares the fermentable" );
+   detached->setAmount_kg(6.0);
+   QVERIFY2( fuzzyComp(ferm->amount_kg(), 4.0, 0.001), "Editing the detached copy changed the newer version" );
+   QCOMPARE( another->fermentables(), QList<Fermentable*>() << ferm );
+}
+
+//! Cache-only instructions, as Recipe::generateInstructions() makes them
+static QList<Instruction*> steps(QStringList const& names)
+{
+   QList<Instruction*> ret;
+   foreach( QString name, names ) {
+      Instruction* ins = new Instruction(name);
+      ins->setDirections(QString("Do %1.").arg(name));
+      ret.append(ins);
+   }
+   return ret;
+}
+
+static QList<int> keysOf(QList<Instruction*> const& list)
+{
+   QList<int> ret;
+   foreach( Instruction* ins, list ) {
+      ret.append(ins->key());
+   }
+   return ret;
+}
+
+void Testing::replaceInstructionsDiff()
+{
+   Database& db = Database::instance();
+   Recipe* rec = db.newRecipe(QString("TestRecipe_instructions"));
+
+   db.replaceInstructions(rec, steps(QStringList() << "Mash" << "Boil" << "Ferment"));
+   QList<Instruction*> first = rec->instructions();
+   QCOMPARE( first.size(), 3 );
+   first.at(1)->setCompleted(true);
+
+   // A step in the middle: the ones after it keep their rows and flags
+   db.replaceInstructions(rec, steps(QStringList() << "Mash" << "Sparge" << "Boil" << "Ferment"));
+   QList<Instruction*> second = rec->instructions();
+   QCOMPARE( second.size(), 4 );
+   QCOMPARE( second.at(0)->key(), first.at(0)->key() );
+   QCOMPARE( second.at(2)->key(), first.at(1)->key() );
+   QCOMPARE( second.at(3)->key(), first.at(2)->key() );
+   QVERIFY2( ! keysOf(first).contains(second.at(1)->key()), "The new step reused an old row" );
+   QVERIFY2( second.at(2)->completed(), "Inserting a step cleared a later step's completed flag" );
+   for ( int i = 0; i < second.size(); ++i ) {
+      QCOMPARE( second.at(i)->instructionNumber(), i + 1 );
+   }
+
+   // Taking a step out of the middle only drops that one
+   db.replaceInstructions(rec, steps(QStringList() << "Mash" << "Sparge" << "Ferment"));
+   QList<Instruction*> third = rec->instructions();
+   QCOMPARE( keysOf(third), QList<int>() << second.at(0)->key() << second.at(1)->key() << second.at(3)->key() );
+   for ( int i = 0; i < third.size(); ++i ) {
+      QCOMPARE( third.at(i)->instructionNumber(), i + 1 );
+   }
+
+   // A step that says something else is rewritten where it is, and starts over
+   third.at(1)->setCompleted(true);
+   QList<Instruction*> reworded = steps(QStringList() << "Mash" << "Sparge" << "Ferment");
+   reworded.at(1)->setDirections("Do it twice.");
+   db.replaceInstructions(rec, reworded);
+   QList<Instruction*> fourth = rec->instructions();
+   QCOMPARE( keysOf(fourth), keysOf(third) );
+   QCOMPARE( fourth.at(1)->directions(), QString("Do it twice.") );
+   QVERIFY2( ! fourth.at(1)->completed(), "A reworded step is still completed" );
+}
+
+void Testing::bulkImportRollback()
+{
+   Database& db = Database::instance();
+   int numRecipes = db.recipes().size();
+   int numHops = db.hops().size();
+
+   db.beginBulkImport();
+   Recipe* rec = db.newRecipe(QString("TestRecipe_bulkRollback"));
+   Hop* hop = rec->add<Hop>(cascade_4pct);
+   QVERIFY( hop );
+   int recKey = rec->key();
+   int hopKey = hop->key();
+   QPointer<Recipe> recAlive(rec);
+   QPointer<Hop> hopAlive(hop);
+   QVERIFY2( ! db.endBulkImport(false), "A failed import was committed" );
+
+   // The rows are gone
+   QVERIFY2( db.get(Brewtarget::RECTABLE, recKey, "name").isNull(), "The recipe row survived the rollback" );
+   QVERIFY2( db.get(Brewtarget::HOPTABLE, hopKey, "name").isNull(), "The hop row survived the rollback" );
+
+   // and so are the objects that were made for them
+   QCOMPARE( db.recipes().size(), numRecipes );
+   QCOMPARE( db.hops().size(), numHops );
+   QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+   QVERIFY2( recAlive.isNull(), "The rolled back recipe was not deleted" );
+   QVERIFY2( hopAlive.isNull(), "The rolled back hop was not deleted" );
+
+   // What was there before the import is untouched
+   QVERIFY( ! db.get(Brewtarget::HOPTABLE, cascade_4pct->key(), "name").isNull() );
+
+   // The next import starts clean, and keeps what it made
+   db.beginBulkImport();
+   Recipe* kept = db.newRecipe(QString("TestRecipe_bulkCommit"));
+   QVERIFY2( db.endBulkImport(true), "A good import was rolled back" );
+   QCOMPARE( db.recipes().size(), numRecipes + 1 );
+   QCOMPARE( db.get(Brewtarget::RECTABLE, kept->key(), "name").toString(), QString("TestRecipe_bulkCommit") );
+}
+
+void Testing::mergeDefaultDataIds()
+{
+   Database& db = Database::instance();
+   QTemporaryDir scratch;
+   QString dataDb = scratch.filePath("default_db.sqlite");
+   int maxBt, hopA, hopB;
+
+   // Start from a copy of the user's db, so the only new rows are the ones
+   // added here
+   db.flushPendingWrites();
+   QVERIFY( QFile::copy(Database::getDbFileName(), dataDb) );
+   {
+      QSqlDatabase data = QSqlDatabase::addDatabase("QSQLITE", "mergeDefaultDataIds");
+      data.setDatabaseName(dataDb);
+      QVERIFY( data.open() );
+      QSqlQuery q(data);
+
+      QVERIFY( q.exec("SELECT MAX(id) FROM bt_hop") && q.next() );
+      maxBt = q.value(0).toInt();
+      QVERIFY( q.exec("SELECT MAX(id) FROM hop") && q.next() );
+      // Ids the user's db won't hand out, so a merge that kept them would show
+      hopA = q.value(0).toInt() + 1000;
+      hopB = hopA + 1;
+
+      QVERIFY( q.exec(QString("INSERT INTO hop (id,name) VALUES (%1,'TestHop_mergeA')").arg(hopA)) );
+      QVERIFY( q.exec(QString("INSERT INTO hop (id,name) VALUES (%1,'TestHop_mergeB')").arg(hopB)) );
+      // Out of order, and with a bt row whose hop isn't there
+      QVERIFY( q.exec(QString("INSERT INTO bt_hop (id,hop_id) VALUES (%1,%2)").arg(maxBt + 1).arg(hopB)) );
+      QVERIFY( q.exec(QString("INSERT INTO bt_hop (id,hop_id) VALUES (%1,%2)").arg(maxBt + 2).arg(hopB + 1)) );
+      QVERIFY( q.exec(QString("INSERT INTO bt_hop (id,hop_id) VALUES (%1,%2)").arg(maxBt + 3).arg(hopA)) );
+      q.finish();
+      data.close();
+   }
+   QSqlDatabase::removeDatabase("mergeDefaultDataIds");
+
+   db.updateDatabase(dataDb);
+
+   int newB = db.get(Brewtarget::BT_HOPTABLE, maxBt + 1, "hop_id").toInt();
+   int newA = db.get(Brewtarget::BT_HOPTABLE, maxBt + 3, "hop_id").toInt();
+   QCOMPARE( db.get(Brewtarget::HOPTABLE, newB, "name").toString(), QString("TestHop_mergeB") );
+   QCOMPARE( db.get(Brewtarget::HOPTABLE, newA, "name").toString(), QString("TestHop_mergeA") );
+   QVERIFY2( newA != hopA && newB != hopB, "The merged hops kept the data db's ids" );
+   QVERIFY2( db.get(Brewtarget::BT_HOPTABLE, maxBt + 2, "hop_id").isNull(), "A bt row without a hop was merged" );
+
+   // Merging again adds nothing
+   db.updateDatabase(dataDb);
+   QCOMPARE( db.get(Brewtarget::BT_HOPTABLE, maxBt + 1, "hop_id").toInt(), newB );
+   QCOMPARE( db.get(Brewtarget::BT_HOPTABLE, maxBt + 3, "hop_id").toInt(), newA );
+   QVERIFY2( db.get(Brewtarget::HOPTABLE, qMax(newA, newB) + 1, "name").isNull(), "Merging again copied the hops again" );
+}
+
 void Testing::testLogRotation()
 {
    QCOMPARE(Log::loggingEnabled, true);
@@ -130,6 +130,18 @@ private slots:
    //! \brief Verify post-boil losses do not affect OG
    void postBoilLossOgTest();
 
+   //! \brief Verify versions share ingredients until one of them changes
+   void sharedIngredientCopyOnWrite();
+
+   //! \brief Verify regenerated instructions keep the steps that didn't change
+   void replaceInstructionsDiff();
+
+   //! \brief Verify a rolled back bulk import leaves nothing behind
+   void bulkImportRollback();
+
+   //! \brief Verify merging the default data links each bt_ row to the right new row
+   void mergeDefaultDataIds();
+
    //! \brief Verify Log rotation is working
    void testLogRotation();
 };
@@ -19,6 +19,7 @@
  */
 
 #include "YeastSortFilterProxyModel.h"
+#include "SearchIndex.h"
 #include "YeastTableModel.h"
 #include "model/Yeast.h"
 #include "brewtarget.h"
@@ -28,6 +29,8 @@ YeastSortFilterProxyModel::YeastSortFilterProxyModel(QObject *parent, bool filt)
 : QSortFilterProxyModel(parent)
 {
    filter = filt;
+   if ( filter )
+      SearchIndex::instance().refilterWhenReady(this);
 }
 
 bool YeastSortFilterProxyModel::lessThan(const QModelIndex &left,
@@ -64,9 +67,10 @@ bool YeastSortFilterProxyModel::filterAcceptsRow( int source_row, const QModelIn
    YeastTableModel* model = qobject_cast<YeastTableModel*>(sourceModel());
    QModelIndex index = sourceModel()->index(source_row, 0, source_parent);
 
-   return !filter
-          ||
-           ( sourceModel()->data(index).toString().contains(filterRegExp())
-             && model->getYeast(source_row)->display()
-           );
+   if ( !filter )
+      return true;
+
+   return SearchIndex::instance().filterAccepts( model->getYeast(source_row),
+                                                 sourceModel()->data(index).toString(),
+                                                 filterRegExp() );
 }
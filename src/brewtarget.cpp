@@ -49,6 +49,7 @@
 #include <QPixmap>
 #include <QSplashScreen>
 #include <QSettings>
+#include <QStringBuilder>
 #include <QDebug>
 
 #include "brewtarget.h"
@@ -61,6 +62,9 @@
 
 #include "BtSplashScreen.h"
 #include "MainWindow.h"
+#include "OptionStore.h"
+#include "RecipeReport.h"
+#include "SearchIndex.h"
 #include "model/Mash.h"
 #include "model/Instruction.h"
 #include "model/Water.h"
@@ -507,7 +511,7 @@ bool Brewtarget::initialize(const QString &userDirectory)
    qDebug() << "Loading Database...";
    if (Database::instance().loadSuccessful())
    {
-      if ( ! QSettings().contains("converted") )
+      if ( ! hasOption("converted") )
          Database::instance().convertFromXml();
 
       return true;
@@ -594,8 +598,10 @@ void Brewtarget::cleanup()
    delete btTrans;
    delete _mainWindow;
 
+   SearchIndex::dropInstance();
    Database::dropInstance();
-
+   // Last, so anything set on the way down gets written too
+   OptionStore::dropInstance();
 }
 
 bool Brewtarget::isInteractive()
@@ -621,6 +627,8 @@ int Brewtarget::run(const QString &userDirectory)
       return 1;
    }
    qDebug() << QString("Starting Brewtarget v%1 on %2.").arg(VERSIONSTRING).arg(QSysInfo::prettyProductName());
+   // Builds in the background. The dialogs use plain matching until it is done
+   SearchIndex::instance().rebuild();
    _mainWindow = new MainWindow();
    _mainWindow->init();
    _mainWindow->setVisible(true);
@@ -636,6 +644,26 @@ int Brewtarget::run(const QString &userDirectory)
    return ret;
 }
 
+int Brewtarget::runReport(const QString &userDirectory, const QString &reportFile)
+{
+   int ret = 0;
+
+   // There is no MainWindow, so there is nobody to answer a dialog
+   setInteractive(false);
+   if( !initialize(userDirectory) )
+   {
+      cleanup();
+      return 1;
+   }
+   qDebug() << QString("Starting Brewtarget v%1 report on %2.").arg(VERSIONSTRING).arg(QSysInfo::prettyProductName());
+
+   ret = RecipeReport::run(reportFile);
+
+   cleanup();
+
+   return ret;
+}
+
 // Read the old options.xml file one more time, then move it out of the way.
 void Brewtarget::convertPersistentOptions()
 {
@@ -850,7 +878,7 @@ void Brewtarget::convertPersistentOptions()
 
 #endif
    // And remove the flag
-   QSettings().remove("hadOldConfig");
+   removeOption("hadOldConfig");
 }
 
 QString Brewtarget::getOptionValue(const QDomDocument& optionsDoc, const QString& option, bool* hasOption)
@@ -1527,7 +1555,7 @@ bool Brewtarget::hasOption(QString attribute, const QString section, iUnitOps op
    else
       name = generateName(attribute,section,ops);
 
-   return QSettings().contains(name);
+   return OptionStore::instance().contains(name);
 }
 
 void Brewtarget::setOption(QString attribute, QVariant value, const QString section, iUnitOps ops)
@@ -1539,7 +1567,7 @@ void Brewtarget::setOption(QString attribute, QVariant value, const QString sect
    else
       name = generateName(attribute,section,ops);
 
-   QSettings().setValue(name,value);
+   OptionStore::instance().setValue(name,value);
 }
 
 QVariant Brewtarget::option(QString attribute, QVariant default_value, QString section, iUnitOps ops)
@@ -1551,7 +1579,7 @@ QVariant Brewtarget::option(QString attribute, QVariant default_value, QString s
    else
       name = generateName(attribute,section,ops);
 
-   return QSettings().value(name,default_value);
+   return OptionStore::instance().value(name,default_value);
 }
 
 void Brewtarget::removeOption(QString attribute, QString section)
@@ -1564,17 +1592,16 @@ void Brewtarget::removeOption(QString attribute, QString section)
       name = generateName(attribute,section,NOOP);
 
    if ( hasOption(name) )
-        QSettings().remove(name);
+        OptionStore::instance().remove(name);
 }
 
 QString Brewtarget::generateName(QString attribute, const QString section, iUnitOps ops)
 {
-   QString ret = QString("%1/%2").arg(section).arg(attribute);
+   // Every displayed amount asks for two of these, so no QString::arg()
+   if ( ops == NOOP )
+      return section % QLatin1Char('/') % attribute;
 
-   if ( ops != NOOP )
-      ret += ops == UNIT ? "_unit" : "_scale";
-
-   return ret;
+   return section % QLatin1Char('/') % attribute % QLatin1String(ops == UNIT ? "_unit" : "_scale");
 }
 
 // These are used in at least two places. I hate cut'n'paste coding so I am
@@ -188,6 +188,14 @@ public:
     * \return Exit code from the application.
     */
    static int run(const QString &userDirectory = QString());
+   /*!
+    * \brief Blocking call that loads the database without a MainWindow,
+    *        recalculates every recipe and writes a report.
+    * \param userDirectory If !isEmpty, overwrites the current settings.
+    * \param reportFile Where to write the report. Empty means stdout.
+    * \return Exit code for the application.
+    */
+   static int runReport(const QString &userDirectory, const QString &reportFile);
 
    static double toDouble(QString text, bool* ok = nullptr);
    static double toDouble(const NamedEntity* element, QString attribute, QString caller);
@@ -312,6 +320,7 @@ public:
     */
    static const QString& getSystemLanguage();
 
+   //! \brief The options live in OptionStore, which writes them back to QSettings a little later
    static bool  hasOption(QString attribute, const QString section = QString(), iUnitOps ops = NOOP);
    static void  setOption(QString attribute, QVariant value, const QString section = QString(), iUnitOps ops = NOOP);
    static QVariant option(QString attribute, QVariant default_value = QVariant(), QString section = QString(), iUnitOps = NOOP);
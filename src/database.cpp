@@ -47,9 +47,17 @@
 #include <QSqlError>
 #include <QSqlField>
 #include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QElapsedTimer>
+#include <QVector>
+#include <QTimer>
 #include <QDebug>
 #include <QMutex>
 #include <QMutexLocker>
+#include <QQueue>
+#include <QSharedPointer>
+#include <QWaitCondition>
 #include <QPushButton>
 #include <QInputDialog>
 #include <QCryptographicHash>
@@ -72,6 +80,8 @@
 
 #include "config.h"
 #include "xml/BeerXml.h"
+#include "DatabaseBackup.h"
+#include "OptionStore.h"
 #include "brewtarget.h"
 #include "QueuedMethod.h"
 #include "DatabaseSchemaHelper.h"
@@ -102,15 +112,123 @@ QFile Database::dataDbFile;
 QString Database::dataDbFileName;
 QString Database::dbConName;
 
-QHash< QThread*, QString > Database::_threadToConnection;
-QMutex Database::_threadToConnectionMutex;
+QThread* Database::guiThread = nullptr;
+QSqlDatabase Database::guiConnection;
+QThreadStorage<Database::WorkerConnection*> Database::workerConnections;
+QSemaphore Database::workerConnectionSlots;
+QAtomicInt Database::workerConnectionSerial;
+QAtomicInt Database::workerPoolGeneration;
+QSet<QString> Database::openWorkerConnections;
+QMutex Database::openWorkerConnectionsMutex;
+
+namespace {
+   //! \brief Runs one table fetch for populateAllElements() on a pool thread
+   class FetchRunnable : public QRunnable
+   {
+   public:
+      FetchRunnable(std::function<void()> work, QString* error)
+         : work(work), error(error)
+      {
+      }
+
+      void run() override
+      {
+         // Exceptions can't cross the thread boundary, so hand the message back
+         try {
+            work();
+         }
+         catch (QString e) {
+            *error = e;
+         }
+      }
+
+   private:
+      std::function<void()> work;
+      QString* error;
+   };
+}
+
+/*!
+ * Batches of rows on their way from the copyDatabase() reader to one
+ * writer. It holds a few batches at most, so the reader waits for the
+ * writer instead of reading a whole table into memory.
+ */
+class Database::CopyQueue
+{
+public:
+   explicit CopyQueue(int maxBatches)
+      : maxBatches(maxBatches), closed(false), abandoned(false)
+   {
+   }
+
+   //! Waits for room. False if the writer has given up
+   bool put(QVector<QVariantList> const& batch)
+   {
+      QMutexLocker locker(&mutex);
+      while ( batches.size() >= maxBatches && ! abandoned )
+         notFull.wait(&mutex);
+      if ( abandoned )
+         return false;
+      batches.enqueue(batch);
+      notEmpty.wakeOne();
+      return true;
+   }
+
+   //! Waits for a batch. False once the reader is done and everything is taken
+   bool take(QVector<QVariantList>& batch)
+   {
+      QMutexLocker locker(&mutex);
+      while ( batches.isEmpty() && ! closed )
+         notEmpty.wait(&mutex);
+      if ( batches.isEmpty() )
+         return false;
+      batch = batches.dequeue();
+      notFull.wakeOne();
+      return true;
+   }
+
+   //! The reader has nothing more to put
+   void close()
+   {
+      QMutexLocker locker(&mutex);
+      closed = true;
+      notEmpty.wakeAll();
+   }
+
+   //! The writer failed. Stops the reader waiting on it
+   void abandon()
+   {
+      QMutexLocker locker(&mutex);
+      abandoned = true;
+      batches.clear();
+      notFull.wakeAll();
+   }
+
+private:
+   QMutex mutex;
+   QWaitCondition notEmpty;
+   QWaitCondition notFull;
+   QQueue< QVector<QVariantList> > batches;
+   int const maxBatches;
+   bool closed;
+   bool abandoned;
+};
 
 Database::Database()
 {
    //.setUndoLimit(100);
-   // Lock this here until we actually construct the first database connection.
-   _threadToConnectionMutex.lock();
    converted = false;
+   bulkImport = false;
+   bulkImportFailed = false;
+   transactionDepth = 0;
+   flushingWrites = false;
+   lazyLoad = false;
+   evictionScheduled = false;
+
+   flushTimer = new QTimer(this);
+   flushTimer->setSingleShot(true);
+   flushTimer->setInterval(flushIntervalMs);
+   connect( flushTimer, &QTimer::timeout, this, &Database::flushOnTimer );
    dbDefn = new DatabaseSchema();
    m_beerxml = new BeerXML(dbDefn);
 
@@ -208,8 +326,6 @@ bool Database::loadSQLite()
             throw QString("could not disable synchronous writes");
          if ( ! pragma.exec( "PRAGMA foreign_keys = on"))
             throw QString("could not enable foreign keys");
-         if ( ! pragma.exec( "PRAGMA locking_mode = EXCLUSIVE"))
-            throw QString("could not enable exclusive locks");
          if ( ! pragma.exec("PRAGMA temp_store = MEMORY") )
             throw QString("could not enable temporary memory");
 
@@ -217,8 +333,9 @@ bool Database::loadSQLite()
          // just check to see if anything is in there.
          createFromScratch = sqldb.tables().size() == 0;
 
-         // Associate this db with the current thread.
-         _threadToConnection.insert(QThread::currentThread(), dbConName);
+         // This is the GUI thread's connection
+         guiThread = QThread::currentThread();
+         guiConnection = sqldb;
       }
       catch(QString e) {
          qCritical() << QString("%1: %2 (%3)").arg(Q_FUNC_INFO).arg(e).arg(pragma.lastError().text());
@@ -280,8 +397,9 @@ bool Database::loadPgSQL()
    else {
       // by the time we had pgsql support, there is a settings table
       createFromScratch = ! sqldb.tables().contains("settings");
-      // Associate this db with the current thread.
-      _threadToConnection.insert(QThread::currentThread(), sqldb.connectionName());
+      // This is the GUI thread's connection
+      guiThread = QThread::currentThread();
+      guiConnection = sqldb;
    }
 
    return dbIsOpen;
@@ -307,10 +425,12 @@ bool Database::load()
       dbIsOpen = loadSQLite();
    }
 
-   _threadToConnectionMutex.unlock();
    if ( ! dbIsOpen )
       return false;
 
+   // Open up the worker pool
+   workerConnectionSlots.release( maxWorkerConnections() );
+
    sqldb = sqlDatabase();
 
    // This should work regardless of the db being used.
@@ -367,70 +487,11 @@ bool Database::load()
       Brewtarget::lastDbMergeRequest = QDateTime::currentDateTime();
    }
 
-   // Create and store all pointers.
-   populateElements( allBrewNotes, Brewtarget::BREWNOTETABLE );
-   populateElements( allEquipments, Brewtarget::EQUIPTABLE );
-   populateElements( allFermentables, Brewtarget::FERMTABLE );
-   populateElements( allHops, Brewtarget::HOPTABLE );
-   populateElements( allInstructions, Brewtarget::INSTRUCTIONTABLE );
-   populateElements( allMashs, Brewtarget::MASHTABLE );
-   populateElements( allMashSteps, Brewtarget::MASHSTEPTABLE );
-   populateElements( allMiscs, Brewtarget::MISCTABLE );
-   populateElements( allStyles, Brewtarget::STYLETABLE );
-   populateElements( allWaters, Brewtarget::WATERTABLE );
-   populateElements( allSalts, Brewtarget::SALTTABLE );
-   populateElements( allYeasts, Brewtarget::YEASTTABLE );
-
-   populateElements( allRecipes, Brewtarget::RECTABLE );
-
-   // Connect fermentable,hop changed signals to their parent recipe.
-   QHash<int,Recipe*>::iterator i;
-   QList<Fermentable*>::iterator j;
-   QList<Hop*>::iterator k;
-   QList<Yeast*>::iterator l;
-   QList<Mash*>::iterator m;
-   QList<MashStep*>::iterator n;
-
-
-   for( i = allRecipes.begin(); i != allRecipes.end(); i++ )
-   {
-      Equipment* e = equipment(*i);
-      if( e )
-      {
-         connect( e, &NamedEntity::changed, *i, &Recipe::acceptEquipChange );
-         connect( e, &Equipment::changedBoilSize_l, *i, &Recipe::setBoilSize_l);
-         connect( e, &Equipment::changedBoilTime_min, *i, &Recipe::setBoilTime_min);
-      }
-
-      QList<Fermentable*> tmpF = fermentables(*i);
-      for( j = tmpF.begin(); j != tmpF.end(); ++j ) {
-         connect( *j, SIGNAL(changed(QMetaProperty,QVariant)), *i, SLOT(acceptFermChange(QMetaProperty,QVariant)) );
-      }
-
-      QList<Hop*> tmpH = hops(*i);
-      for( k = tmpH.begin(); k != tmpH.end(); ++k ) {
-         connect( *k, SIGNAL(changed(QMetaProperty,QVariant)), *i, SLOT(acceptHopChange(QMetaProperty,QVariant)) );
-      }
-
-      QList<Yeast*> tmpY = yeasts(*i);
-      for( l = tmpY.begin(); l != tmpY.end(); ++l ) {
-         connect( *l, SIGNAL(changed(QMetaProperty,QVariant)), *i, SLOT(acceptYeastChange(QMetaProperty,QVariant)) );
-      }
-
-      // a recipe may not have a mash. Can't connect what doesn't exist
-      if ( mash(*i) != nullptr ) {
-         connect( mash(*i), SIGNAL(changed(QMetaProperty,QVariant)), *i, SLOT(acceptMashChange(QMetaProperty,QVariant)) );
-      }
-   }
-
-   QList<Mash*> tmpM = mashs();
-   for( m = tmpM.begin(); m != tmpM.end(); ++m )
-   {
-      QList<MashStep*> tmpMS = mashSteps(*m);
-      for( n=tmpMS.begin(); n != tmpMS.end(); ++n) {
-         connect( *n, SIGNAL(changed(QMetaProperty,QVariant)), *m, SLOT(acceptMashStepChange(QMetaProperty,QVariant)) );
-      }
-   }
+   // Create and store all pointers, and wire the children to their parents.
+   // Deleted rows are left in the db until they are needed, unless somebody
+   // has asked us not to
+   lazyLoad = Brewtarget::option("lazyLoad", true).toBool();
+   populateAllElements();
 
    loadWasSuccessful = true;
    return loadWasSuccessful;
@@ -523,93 +584,695 @@ QSqlDatabase Database::sqlDatabase()
    // Need a unique database connection for each thread.
    //http://www.linuxjournal.com/article/9602
 
-   QThread* t = QThread::currentThread();
+   if ( QThread::currentThread() == guiThread ) {
+      // Everything this thread reads or writes comes through here, so this
+      // is where the queued writes catch up. Inside a transaction there is
+      // nothing queued: beginTransaction() came through here too
+      if ( ! flushingWrites && transactionDepth == 0 && ! bulkImport ) {
+         pendingWritesMutex.lock();
+         bool pending = ! pendingWrites.isEmpty();
+         pendingWritesMutex.unlock();
+         if ( pending ) {
+            flushPendingWrites();
+         }
+      }
+      return guiConnection;
+   }
+
+   // Before load() or after unload() there is no pool to wait on either.
+   // Say so now rather than after workerConnectionWaitMs
+   if ( guiThread == nullptr ) {
+      QString e = QString("the database is not open");
+      qCritical() << QString("%1 %2").arg(Q_FUNC_INFO).arg(e);
+      throw e;
+   }
+
+   return workerConnection()->db;
+}
+
+QSqlDatabase Database::openConnection(QString const& conName)
+{
    QSqlDatabase sqldb;
 
-   _threadToConnectionMutex.lock();
-   // If this thread already has a connection, return it.
-   if( _threadToConnection.contains(t) )
-   {
-      QSqlDatabase ret = QSqlDatabase::database(_threadToConnection[t]);
-      _threadToConnectionMutex.unlock();
-      return ret;
+   if ( Brewtarget::dbType() == Brewtarget::PGSQL ) {
+      sqldb = QSqlDatabase::addDatabase("QPSQL",conName);
+
+      sqldb.setHostName( dbHostname );
+      sqldb.setDatabaseName( dbName );
+      sqldb.setUserName( dbUsername );
+      sqldb.setPort( dbPortnum );
+      sqldb.setPassword( dbPassword );
+
+      if( ! sqldb.open() )
+         throw QString("Could not open %1 for reading.\n%2")
+         .arg(dbHostname).arg(sqldb.lastError().text());
+   }
+   else {
+      sqldb = QSqlDatabase::addDatabase("QSQLITE",conName);
+      sqldb.setDatabaseName(dbFileName);
+      if( ! sqldb.open() )
+         throw QString("Could not open %1 for reading.\n%2")
+         .arg(dbFileName).arg(sqldb.lastError().text());
+   }
+
+   return sqldb;
+}
+
+int Database::maxWorkerConnections()
+{
+   return Brewtarget::option("maxDbConnections", qMax(2, QThread::idealThreadCount())).toInt();
+}
+
+Database::WorkerConnection* Database::workerConnection()
+{
+   // No locks here: each thread only ever sees its own
+   if ( workerConnections.hasLocalData() )
+      return workerConnections.localData();
+
+   if ( ! workerConnectionSlots.tryAcquire(1, workerConnectionWaitMs) ) {
+      QString e = QString("no database connection came free in %1 s").arg(workerConnectionWaitMs/1000);
+      qCritical() << QString("%1 %2").arg(Q_FUNC_INFO).arg(e);
+      throw e;
+   }
+
+   // Thread addresses get reused, so number them instead
+   QString conName = QString("worker%1").arg(workerConnectionSerial.fetchAndAddRelaxed(1));
+
+   WorkerConnection* worker = new WorkerConnection();
+   worker->name = conName;
+   worker->leases = 0;
+   worker->poolGeneration = workerPoolGeneration.load();
+
+   try {
+      worker->db = openConnection(conName);
+   }
+   catch (QString e) {
+      qCritical() << QString("%1 %2").arg(Q_FUNC_INFO).arg(e);
+      worker->db = QSqlDatabase();
+      QSqlDatabase::removeDatabase(conName);
+      // So the destructor doesn't try to close it or give the slot back twice
+      worker->name.clear();
+      delete worker;
+      workerConnectionSlots.release();
+      throw;
    }
-   // Create a unique connection name, just containing the addy of the thread.
-   QString conName = QString("0x%1").arg(reinterpret_cast<uintptr_t>(t), 0, 16);
 
-   // Create the new connection.
+   openWorkerConnectionsMutex.lock();
+   openWorkerConnections.insert(conName);
+   openWorkerConnectionsMutex.unlock();
+
+   workerConnections.setLocalData(worker);
+   return worker;
+}
+
+void Database::closeConnection(QString const& conName)
+{
+   // The cached queries hold the connection open
+   if ( dbInstance ) {
+      dbInstance->preparedQueriesMutex.lock();
+      dbInstance->preparedQueries.remove(conName);
+      dbInstance->preparedQueriesMutex.unlock();
+   }
+
+   QSqlDatabase::database( conName, false ).close();
+   QSqlDatabase::removeDatabase( conName );
+}
+
+Database::WorkerConnection::~WorkerConnection()
+{
+   if ( name.isEmpty() )
+      return;
+
+   openWorkerConnectionsMutex.lock();
+   // unload() got to it first
+   bool const stillOpen = openWorkerConnections.remove(name);
+   openWorkerConnectionsMutex.unlock();
+
+   db = QSqlDatabase();
+   if ( stillOpen )
+      closeConnection(name);
+
+   if ( poolGeneration == workerPoolGeneration.load() )
+      workerConnectionSlots.release();
+}
+
+Database::ConnectionLease::ConnectionLease()
+{
+   if ( QThread::currentThread() != guiThread )
+      ++workerConnection()->leases;
+}
+
+Database::ConnectionLease::~ConnectionLease()
+{
+   if ( QThread::currentThread() == guiThread || ! workerConnections.hasLocalData() )
+      return;
+
+   WorkerConnection* worker = workerConnections.localData();
+   // The last one out closes the connection and frees the slot for somebody else
+   if ( --worker->leases <= 0 )
+      workerConnections.setLocalData(nullptr);
+}
+
+QSqlDatabase Database::ConnectionLease::database() const
+{
+   return sqlDatabase();
+}
+
+template <class T> void Database::populateElements( QHash<int,T*>& hash, Brewtarget::DBTable table )
+{
+   QVector<QSqlRecord> records;
+   fetchRecords(table, records);
+   buildElements(hash, table, records);
+}
+
+void Database::fetchRecords( Brewtarget::DBTable table, QVector<QSqlRecord>& records )
+{
+   QSqlQuery q(sqlDatabase());
+   TableSchema* tbl = dbDefn->table(table);
+   q.setForwardOnly(true);
+   QString queryString = QString("SELECT * FROM %1").arg(tbl->tableName());
+   q.prepare( queryString );
+
    try {
-      if ( Brewtarget::dbType() == Brewtarget::PGSQL ) {
-         sqldb = QSqlDatabase::addDatabase("QPSQL",conName);
+      if ( ! q.exec() )
+         throw QString("%1 %2").arg(q.lastQuery()).arg(q.lastError().text());
+   }
+   catch (QString e) {
+      qCritical() << QString("%1 %2").arg(Q_FUNC_INFO).arg(e);
+      q.finish();
+      throw;
+   }
 
-         sqldb.setHostName( dbHostname );
-         sqldb.setDatabaseName( dbName );
-         sqldb.setUserName( dbUsername );
-         sqldb.setPort( dbPortnum );
-         sqldb.setPassword( dbPassword );
+   while( q.next() ) {
+      records.append( q.record() );
+   }
 
-         if( ! sqldb.open() )
-            throw QString("Could not open %1 for reading.\n%2")
-            .arg(dbHostname).arg(sqldb.lastError().text());
+   q.finish();
+}
+
+template <class T> void Database::buildElements( QHash<int,T*>& hash,
+                                                 Brewtarget::DBTable table,
+                                                 QVector<QSqlRecord> const& records )
+{
+   if ( records.isEmpty() ) {
+      return;
+   }
+
+   TableSchema* tbl = dbDefn->table(table);
+   // Every row has the same shape, so find the columns once instead of
+   // looking each one up by name for each row
+   tbl->resolveColumns(records.first());
+   int const keyIdx = records.first().indexOf(tbl->keyName(Brewtarget::dbType()));
+   int const deletedIdx = lazyLoad ? records.first().indexOf(tbl->propertyToColumn(PropertyNames::NamedEntity::deleted)) : -1;
+   // Hidden recipes are old versions, and the tree wants those at startup
+   int const displayIdx = lazyLoad && table != Brewtarget::RECTABLE ?
+                             records.first().indexOf(tbl->propertyToColumn(PropertyNames::NamedEntity::display)) : -1;
+
+   hash.reserve( hash.size() + records.size() );
+   foreach( QSqlRecord const& rec, records ) {
+      int key = rec.value(keyIdx).toInt();
+
+      // Deleted and hidden rows wait until somebody asks for them
+      if ( ( deletedIdx >= 0 && rec.value(deletedIdx).toBool() ) ||
+           ( displayIdx >= 0 && ! rec.value(displayIdx).toBool() ) ) {
+         lazyKeys[table].insert(key);
+         continue;
       }
-      else {
-         sqldb = QSqlDatabase::addDatabase("QSQLITE",conName);
-         sqldb.setDatabaseName(dbFileName);
-         if( ! sqldb.open() )
-            throw QString("Could not open %1 for reading.\n%2")
-            .arg(dbFileName).arg(sqldb.lastError().text());
+
+      // if the thing is already in the hash, there's no point making a new
+      // one
+      if( ! hash.contains(key) ) {
+         T* e = new T(tbl, rec, key);
+         hash.insert(key, e);
       }
    }
+}
+
+template <class T> T* Database::materialize( QHash<int,T*>& hash, int key )
+{
+   T* ret = hash.value(key, nullptr);
+
+   if ( ret != nullptr ) {
+      // Only lazy entities are in the list, so this is cheap for everybody else
+      NamedEntity* ne = ret;
+      if ( ! lazyLru.isEmpty() && lazyLru.first().data() != ne && lazyLru.removeOne(ne) ) {
+         lazyLru.prepend(ne);
+      }
+      return ret;
+   }
+
+   Brewtarget::DBTable table = dbDefn->classNameToTable( T::classNameStr() );
+   if ( ! lazyKeys.value(table).contains(key) ) {
+      return nullptr;
+   }
+
+   TableSchema* tbl = dbDefn->table(table);
+   QSqlQuery q = preparedQuery( QString("SELECT * FROM %1 WHERE %2 = :id")
+                                   .arg(tbl->tableName())
+                                   .arg(tbl->keyName()) );
+   q.bindValue(":id", key);
+
+   try {
+      if ( ! q.exec() )
+         throw QString("%1 %2").arg(q.lastQuery()).arg(q.lastError().text());
+      if ( ! q.next() )
+         throw QString("no row %1 in %2").arg(key).arg(tbl->tableName());
+   }
    catch (QString e) {
       qCritical() << QString("%1 %2").arg(Q_FUNC_INFO).arg(e);
-      _threadToConnectionMutex.unlock();
+      q.finish();
       throw;
    }
 
-   // Put new connection in the hash.
-   _threadToConnection.insert(t,conName);
-   _threadToConnectionMutex.unlock();
-   return sqldb;
+   QSqlRecord row = q.record();
+   ret = new T(tbl, row, key);
+   q.finish();
+
+   lazyKeys[table].remove(key);
+   hash.insert(key, ret);
+   // Wired up the same as if load() had made it
+   connectToOwners(ret, row);
+   lazyLru.prepend(ret);
+   scheduleEviction();
+
+   return ret;
+}
+
+template <class T> void Database::materializeAll( QHash<int,T*>& hash, QList<int> const& keys )
+{
+   Brewtarget::DBTable table = dbDefn->classNameToTable( T::classNameStr() );
+   QSet<int> const lazy = lazyKeys.value(table);
+   QStringList missing;
+
+   if ( lazy.isEmpty() ) {
+      return;
+   }
+
+   foreach( int key, keys ) {
+      if ( lazy.contains(key) && ! hash.contains(key) ) {
+         missing.append( QString::number(key) );
+      }
+   }
+
+   // One is no better done here than by materialize()
+   if ( missing.size() < 2 ) {
+      return;
+   }
+
+   TableSchema* tbl = dbDefn->table(table);
+   QSqlQuery q(sqlDatabase());
+   q.setForwardOnly(true);
+
+   for ( int i = 0; i < missing.size(); i += materializeBatchSize ) {
+      QString select = QString("SELECT * FROM %1 WHERE %2 IN (%3)")
+                          .arg(tbl->tableName())
+                          .arg(tbl->keyName())
+                          .arg(missing.mid(i, materializeBatchSize).join(","));
+
+      if ( ! q.exec(select) ) {
+         QString e = QString("%1 %2").arg(select).arg(q.lastError().text());
+         qCritical() << QString("%1 %2").arg(Q_FUNC_INFO).arg(e);
+         q.finish();
+         throw e;
+      }
+
+      int keyIdx = -1;
+      while ( q.next() ) {
+         QSqlRecord row = q.record();
+         if ( keyIdx < 0 ) {
+            keyIdx = row.indexOf(tbl->keyName());
+         }
+         int key = row.value(keyIdx).toInt();
+
+         T* e = new T(tbl, row, key);
+         lazyKeys[table].remove(key);
+         hash.insert(key, e);
+         connectToOwners(e, row);
+         lazyLru.prepend(e);
+      }
+   }
+   q.finish();
+
+   scheduleEviction();
 }
 
+void Database::scheduleEviction()
+{
+   // Not now. Whoever asked is still holding raw pointers and hasn't had a
+   // chance to connect to anything yet. Back in the event loop, anything they
+   // kept is connected to and anything they didn't is fair game
+   if ( ! evictionScheduled && lazyLru.size() > lazyCacheSize ) {
+      evictionScheduled = true;
+      QTimer::singleShot( 0, this, &Database::evictLazy );
+   }
+}
+
+void Database::evictLazy()
+{
+   evictionScheduled = false;
+
+   // Oldest first. Anything somebody is still listening to -- a recipe, a
+   // table model, an editor -- has a pointer to it somewhere, so it is in use
+   // and gets pinned instead
+   for ( int i = lazyLru.size() - 1; i >= 0 && lazyLru.size() > lazyCacheSize; --i ) {
+      NamedEntity* ing = lazyLru.at(i).data();
+      lazyLru.removeAt(i);
+
+      // Somebody else deleted it already
+      if ( ing == nullptr ) {
+         continue;
+      }
+
+      if ( ing->receivers(SIGNAL(changed(QMetaProperty,QVariant))) > 0 ) {
+         continue;
+      }
+
+      int key = ing->key();
+      bool removed = false;
+
+      switch( ing->table() ) {
+         case Brewtarget::BREWNOTETABLE:    removed = allBrewNotes.remove(key) > 0;    break;
+         case Brewtarget::EQUIPTABLE:       removed = allEquipments.remove(key) > 0;   break;
+         case Brewtarget::FERMTABLE:        removed = allFermentables.remove(key) > 0; break;
+         case Brewtarget::HOPTABLE:         removed = allHops.remove(key) > 0;         break;
+         case Brewtarget::INSTRUCTIONTABLE: removed = allInstructions.remove(key) > 0; break;
+         case Brewtarget::MASHTABLE:        removed = allMashs.remove(key) > 0;        break;
+         case Brewtarget::MASHSTEPTABLE:    removed = allMashSteps.remove(key) > 0;    break;
+         case Brewtarget::MISCTABLE:        removed = allMiscs.remove(key) > 0;        break;
+         case Brewtarget::RECTABLE:         removed = allRecipes.remove(key) > 0;      break;
+         case Brewtarget::STYLETABLE:       removed = allStyles.remove(key) > 0;       break;
+         case Brewtarget::WATERTABLE:       removed = allWaters.remove(key) > 0;       break;
+         case Brewtarget::SALTTABLE:        removed = allSalts.remove(key) > 0;        break;
+         case Brewtarget::YEASTTABLE:       removed = allYeasts.remove(key) > 0;       break;
+         default:
+            break;
+      }
+
+      if ( removed ) {
+         lazyKeys[ing->table()].insert(key);
+         // Whoever asked for it may still be holding the pointer for the rest
+         // of this event, so don't pull it out from under them
+         ing->deleteLater();
+      }
+   }
+}
+
+void Database::pinLazy( NamedEntity const* ing )
+{
+   if ( ! lazyLru.isEmpty() ) {
+      lazyLru.removeOne( const_cast<NamedEntity*>(ing) );
+   }
+}
+
+void Database::connectIngredient( NamedEntity* ing, Recipe* rec )
+{
+   if ( qobject_cast<Fermentable*>(ing) != nullptr ) {
+      connect( ing, SIGNAL(changed(QMetaProperty,QVariant)), rec, SLOT(acceptFermChange(QMetaProperty,QVariant)), Qt::UniqueConnection );
+   }
+   else if ( qobject_cast<Hop*>(ing) != nullptr ) {
+      connect( ing, SIGNAL(changed(QMetaProperty,QVariant)), rec, SLOT(acceptHopChange(QMetaProperty,QVariant)), Qt::UniqueConnection );
+   }
+   else if ( qobject_cast<Yeast*>(ing) != nullptr ) {
+      connect( ing, SIGNAL(changed(QMetaProperty,QVariant)), rec, SLOT(acceptYeastChange(QMetaProperty,QVariant)), Qt::UniqueConnection );
+   }
+}
+
+void Database::connectRecipe( Recipe* rec, QSqlRecord const& row )
+{
+   TableSchema* tbl = dbDefn->table(Brewtarget::RECTABLE);
+
+   Equipment* e = allEquipments.value( tbl->foreignKeyValue(row, kpropEquipmentId).toInt() );
+   if( e )
+   {
+      connect( e, &NamedEntity::changed, rec, &Recipe::acceptEquipChange, Qt::UniqueConnection );
+      connect( e, &Equipment::changedBoilSize_l, rec, &Recipe::setBoilSize_l, Qt::UniqueConnection );
+      connect( e, &Equipment::changedBoilTime_min, rec, &Recipe::setBoilTime_min, Qt::UniqueConnection );
+   }
+
+   // Only what is already in memory. The rest connect themselves when they
+   // are materialized
+   QList<Brewtarget::DBTable> const inRecTables = { Brewtarget::FERMINRECTABLE, Brewtarget::HOPINRECTABLE, Brewtarget::YEASTINRECTABLE };
+   foreach( Brewtarget::DBTable inRecTable, inRecTables ) {
+      foreach( int key, inRecipeIndex.value(inRecTable).value(rec->key()) ) {
+         NamedEntity* ing = nullptr;
+         switch( inRecTable ) {
+            case Brewtarget::FERMINRECTABLE:  ing = allFermentables.value(key); break;
+            case Brewtarget::HOPINRECTABLE:   ing = allHops.value(key);         break;
+            default:                          ing = allYeasts.value(key);       break;
+         }
+         if ( ing != nullptr ) {
+            connectIngredient(ing, rec);
+         }
+      }
+   }
+
+   // a recipe may not have a mash. Can't connect what doesn't exist
+   Mash* m = allMashs.value( tbl->foreignKeyValue(row, kpropMashId).toInt() );
+   if ( m != nullptr ) {
+      connect( m, SIGNAL(changed(QMetaProperty,QVariant)), rec, SLOT(acceptMashChange(QMetaProperty,QVariant)), Qt::UniqueConnection );
+   }
+}
+
+void Database::connectMashStep( MashStep* step, QSqlRecord const& row )
+{
+   TableSchema* tbl = dbDefn->table(Brewtarget::MASHSTEPTABLE);
+
+   if ( tbl->value(row, PropertyNames::NamedEntity::deleted).toBool() ) {
+      return;
+   }
+
+   Mash* m = allMashs.value( tbl->foreignKeyValue(row, kpropMashId).toInt() );
+   if ( m != nullptr ) {
+      connect( step, SIGNAL(changed(QMetaProperty,QVariant)), m, SLOT(acceptMashStepChange(QMetaProperty,QVariant)), Qt::UniqueConnection );
+   }
+}
+
+QList<int> Database::keysWhere( Brewtarget::DBTable table, QString const& column, int value )
+{
+   QList<int> ret;
+   TableSchema* tbl = dbDefn->table(table);
+   QSqlQuery q = preparedQuery( QString("SELECT %1 FROM %2 WHERE %3 = :value")
+                                   .arg(tbl->keyName())
+                                   .arg(tbl->tableName())
+                                   .arg(column) );
+   q.bindValue(":value", value);
+
+   if ( ! q.exec() ) {
+      QString e = QString("%1 %2").arg(q.lastQuery()).arg(q.lastError().text());
+      qCritical() << QString("%1 %2").arg(Q_FUNC_INFO).arg(e);
+      q.finish();
+      throw e;
+   }
+
+   while ( q.next() ) {
+      ret.append( q.value(0).toInt() );
+   }
+   q.finish();
+
+   return ret;
+}
+
+void Database::connectToOwners( NamedEntity* ing, QSqlRecord const& row )
+{
+   TableSchema* recTbl = dbDefn->table(Brewtarget::RECTABLE);
+
+   switch( ing->table() ) {
+      case Brewtarget::RECTABLE:
+         connectRecipe( qobject_cast<Recipe*>(ing), row );
+         break;
+      case Brewtarget::MASHSTEPTABLE:
+         connectMashStep( qobject_cast<MashStep*>(ing), row );
+         break;
+      case Brewtarget::FERMTABLE:
+      case Brewtarget::HOPTABLE:
+      case Brewtarget::YEASTTABLE:
+      {
+         Brewtarget::DBTable inRecTable = dbDefn->table(ing->table())->inRecTable();
+         QHashIterator< int, QList<int> > i( inRecipeIndex.value(inRecTable) );
+         while ( i.hasNext() ) {
+            i.next();
+            Recipe* rec = allRecipes.value(i.key());
+            if ( rec != nullptr && i.value().contains(ing->key()) ) {
+               connectIngredient(ing, rec);
+            }
+         }
+         break;
+      }
+      case Brewtarget::EQUIPTABLE:
+      {
+         Equipment* e = qobject_cast<Equipment*>(ing);
+         foreach( int key, keysWhere(Brewtarget::RECTABLE, recTbl->foreignKeyToColumn(kpropEquipmentId), ing->key()) ) {
+            Recipe* rec = allRecipes.value(key);
+            if ( rec != nullptr ) {
+               connect( e, &NamedEntity::changed, rec, &Recipe::acceptEquipChange, Qt::UniqueConnection );
+               connect( e, &Equipment::changedBoilSize_l, rec, &Recipe::setBoilSize_l, Qt::UniqueConnection );
+               connect( e, &Equipment::changedBoilTime_min, rec, &Recipe::setBoilTime_min, Qt::UniqueConnection );
+            }
+         }
+         break;
+      }
+      case Brewtarget::MASHTABLE:
+      {
+         foreach( int key, keysWhere(Brewtarget::RECTABLE, recTbl->foreignKeyToColumn(kpropMashId), ing->key()) ) {
+            Recipe* rec = allRecipes.value(key);
+            if ( rec != nullptr ) {
+               connect( ing, SIGNAL(changed(QMetaProperty,QVariant)), rec, SLOT(acceptMashChange(QMetaProperty,QVariant)), Qt::UniqueConnection );
+            }
+         }
+         TableSchema* stepTbl = dbDefn->table(Brewtarget::MASHSTEPTABLE);
+         foreach( int key, keysWhere(Brewtarget::MASHSTEPTABLE, stepTbl->foreignKeyToColumn(kpropMashId), ing->key()) ) {
+            MashStep* step = allMashSteps.value(key);
+            if ( step != nullptr && ! step->deleted() ) {
+               connect( step, SIGNAL(changed(QMetaProperty,QVariant)), ing, SLOT(acceptMashStepChange(QMetaProperty,QVariant)), Qt::UniqueConnection );
+            }
+         }
+         break;
+      }
+      default:
+         // Nothing else is connected to anything at load either
+         break;
+   }
+}
+
+void Database::populateAllElements()
+{
+   QList<Brewtarget::DBTable> const tables = {
+      Brewtarget::BREWNOTETABLE,
+      Brewtarget::EQUIPTABLE,
+      Brewtarget::FERMTABLE,
+      Brewtarget::HOPTABLE,
+      Brewtarget::INSTRUCTIONTABLE,
+      Brewtarget::MASHTABLE,
+      Brewtarget::MASHSTEPTABLE,
+      Brewtarget::MISCTABLE,
+      Brewtarget::STYLETABLE,
+      Brewtarget::WATERTABLE,
+      Brewtarget::SALTTABLE,
+      Brewtarget::YEASTTABLE,
+      Brewtarget::RECTABLE
+   };
+
+   QElapsedTimer timer;
+   timer.start();
+
+   // The tables don't depend on each other, so read them all at once. Each
+   // pool thread leases its own connection for as long as its fetch runs.
+   //
+   // Only the rows are fetched on the pool threads. The entities are QObjects
+   // and have to be made on this thread.
+   QVector< QVector<QSqlRecord> > records(tables.size());
+   QVector<QString> errors(tables.size());
+
+   {
+      QThreadPool pool;
+      pool.setMaxThreadCount(qMin(tables.size(), qMax(2, QThread::idealThreadCount())));
+
+      for( int i = 0; i < tables.size(); ++i ) {
+         Brewtarget::DBTable table = tables.at(i);
+         QVector<QSqlRecord>* rows = &records[i];
+         pool.start(new FetchRunnable([this, table, rows]() {
+                                         ConnectionLease lease;
+                                         fetchRecords(table, *rows);
+                                      },
+                                      &errors[i]));
+      }
+      pool.waitForDone();
+   }
+
+   for( int i = 0; i < tables.size(); ++i ) {
+      if ( ! errors.at(i).isEmpty() ) {
+         qCritical() << QString("%1 could not read %2: %3")
+                        .arg(Q_FUNC_INFO)
+                        .arg(dbDefn->table(tables.at(i))->tableName())
+                        .arg(errors.at(i));
+         throw errors.at(i);
+      }
+   }
+   qint64 fetched = timer.elapsed();
+
+   QVector<QSqlRecord> const& recipeRows = records.at(tables.indexOf(Brewtarget::RECTABLE));
+   QVector<QSqlRecord> const& mashStepRows = records.at(tables.indexOf(Brewtarget::MASHSTEPTABLE));
+
+   buildElements( allBrewNotes, Brewtarget::BREWNOTETABLE, records.at(tables.indexOf(Brewtarget::BREWNOTETABLE)) );
+   buildElements( allEquipments, Brewtarget::EQUIPTABLE, records.at(tables.indexOf(Brewtarget::EQUIPTABLE)) );
+   buildElements( allFermentables, Brewtarget::FERMTABLE, records.at(tables.indexOf(Brewtarget::FERMTABLE)) );
+   buildElements( allHops, Brewtarget::HOPTABLE, records.at(tables.indexOf(Brewtarget::HOPTABLE)) );
+   buildElements( allInstructions, Brewtarget::INSTRUCTIONTABLE, records.at(tables.indexOf(Brewtarget::INSTRUCTIONTABLE)) );
+   buildElements( allMashs, Brewtarget::MASHTABLE, records.at(tables.indexOf(Brewtarget::MASHTABLE)) );
+   buildElements( allMashSteps, Brewtarget::MASHSTEPTABLE, mashStepRows );
+   buildElements( allMiscs, Brewtarget::MISCTABLE, records.at(tables.indexOf(Brewtarget::MISCTABLE)) );
+   buildElements( allStyles, Brewtarget::STYLETABLE, records.at(tables.indexOf(Brewtarget::STYLETABLE)) );
+   buildElements( allWaters, Brewtarget::WATERTABLE, records.at(tables.indexOf(Brewtarget::WATERTABLE)) );
+   buildElements( allSalts, Brewtarget::SALTTABLE, records.at(tables.indexOf(Brewtarget::SALTTABLE)) );
+   buildElements( allYeasts, Brewtarget::YEASTTABLE, records.at(tables.indexOf(Brewtarget::YEASTTABLE)) );
+
+   buildElements( allRecipes, Brewtarget::RECTABLE, recipeRows );
+
+   // Read the recipe/ingredient links once, so Recipe::fermentables() and
+   // friends don't need to go to the db every time they are called
+   populateInRecipeIndex();
+
+   // Connect fermentable,hop changed signals to their parent recipe. All of
+   // the links are already in memory -- the equipment and mash ids are in the
+   // recipe rows, the mash ids in the mash step rows and the rest in
+   // inRecipeIndex -- so there is no need to ask the db once per recipe.
+   TableSchema* recTbl = dbDefn->table(Brewtarget::RECTABLE);
+   if ( ! recipeRows.isEmpty() ) {
+      int const keyIdx   = recipeRows.first().indexOf(recTbl->keyName());
+      int const ancIdx   = recipeRows.first().indexOf(recTbl->foreignKeyToColumn(kpropAncestorId));
+
+      foreach( QSqlRecord const& row, recipeRows ) {
+         // Every row, deleted or not, since a chain of versions can run
+         // through a deleted one
+         ancestorOf.insert( row.value(keyIdx).toInt(), row.value(ancIdx).toInt() );
+
+         Recipe* rec = allRecipes.value( row.value(keyIdx).toInt() );
+         if ( rec != nullptr ) {
+            connectRecipe(rec, row);
+         }
+      }
+   }
 
-template <class T> void Database::populateElements( QHash<int,T*>& hash, Brewtarget::DBTable table )
-{
-   QSqlQuery q(sqlDatabase());
-   TableSchema* tbl = dbDefn->table(table);
-   q.setForwardOnly(true);
-   QString queryString = QString("SELECT * FROM %1").arg(tbl->tableName());
-   q.prepare( queryString );
+   // Same for the brewnotes of each recipe. Deleted ones are never shown
+   QVector<QSqlRecord> const& noteRows = records.at(tables.indexOf(Brewtarget::BREWNOTETABLE));
+   TableSchema* noteTbl = dbDefn->table(Brewtarget::BREWNOTETABLE);
+   brewNotesOf.clear();
+   if ( ! noteRows.isEmpty() ) {
+      int const keyIdx     = noteRows.first().indexOf(noteTbl->keyName());
+      int const recIdx     = noteRows.first().indexOf(noteTbl->recipeIndexName());
+      int const deletedIdx = noteRows.first().indexOf(noteTbl->propertyToColumn(PropertyNames::NamedEntity::deleted));
 
-   try {
-      if ( ! q.exec() )
-         throw QString("%1 %2").arg(q.lastQuery()).arg(q.lastError().text());
-   }
-   catch (QString e) {
-      qCritical() << QString("%1 %2").arg(Q_FUNC_INFO).arg(e);
-      q.finish();
-      throw;
+      foreach( QSqlRecord const& row, noteRows ) {
+         if ( ! row.value(deletedIdx).toBool() ) {
+            brewNotesOf[ row.value(recIdx).toInt() ].append( row.value(keyIdx).toInt() );
+         }
+      }
    }
 
-   while( q.next() ) {
-      int key = q.record().value(tbl->keyName(Brewtarget::dbType())).toInt();
+   TableSchema* stepTbl = dbDefn->table(Brewtarget::MASHSTEPTABLE);
+   if ( ! mashStepRows.isEmpty() ) {
+      int const keyIdx = mashStepRows.first().indexOf(stepTbl->keyName());
 
-      // if the thing is already in the hash, there's no point making a new
-      // one
-      if( ! hash.contains(key) ) {
-         T* e = new T(tbl, q.record());
-         hash.insert(key, e);
+      foreach( QSqlRecord const& row, mashStepRows ) {
+         MashStep* step = allMashSteps.value( row.value(keyIdx).toInt() );
+         if ( step != nullptr ) {
+            connectMashStep(step, row);
+         }
       }
    }
 
-   q.finish();
+   qInfo() << QString("%1 read %2 tables in %3 ms, built and connected in %4 ms")
+              .arg(Q_FUNC_INFO)
+              .arg(tables.size())
+              .arg(fetched)
+              .arg(timer.elapsed() - fetched);
 }
 
 
 template <class T> bool Database::getElements(QList<T*>& list,
                                               QString filter,
                                               Brewtarget::DBTable table,
-                                              QHash<int,T*> allElements,
+                                              QHash<int,T*>& allElements,
                                               QString id)
 {
    QSqlQuery q(sqlDatabase());
@@ -640,35 +1303,175 @@ template <class T> bool Database::getElements(QList<T*>& list,
       throw;
    }
 
-   while( q.next() )
-   {
-      int key = q.record().value("id").toInt();
-      if( allElements.contains(key) )
-         list.append( allElements[key] );
+   QList<int> keys;
+   while( q.next() ) {
+      keys.append( q.record().value("id").toInt() );
    }
-
    q.finish();
+
+   // Anything lazy gets read in a few queries, not one per row
+   materializeAll(allElements, keys);
+
+   foreach( int key, keys ) {
+      T* e = materialize(allElements, key);
+      if( e != nullptr )
+         list.append( e );
+   }
+
    return true;
 }
 
+void Database::populateInRecipeIndex()
+{
+   QList<Brewtarget::DBTable> const indexed = {
+      Brewtarget::FERMINRECTABLE,
+      Brewtarget::HOPINRECTABLE,
+      Brewtarget::MISCINRECTABLE,
+      Brewtarget::WATERINRECTABLE,
+      Brewtarget::SALTINRECTABLE,
+      Brewtarget::YEASTINRECTABLE
+   };
+
+   inRecipeIndex.clear();
+
+   foreach( Brewtarget::DBTable table, indexed ) {
+      TableSchema* inrec = dbDefn->table(table);
+      QHash< int, QList<int> > byRecipe;
+      QSqlQuery q(sqlDatabase());
+      q.setForwardOnly(true);
+
+      // SELECT recipe_id, fermentable_id FROM fermentable_in_recipe ORDER BY id
+      QString queryString = QString("SELECT %1, %2 FROM %3 ORDER BY %4")
+                              .arg(inrec->recipeIndexName())
+                              .arg(inrec->inRecIndexName())
+                              .arg(inrec->tableName())
+                              .arg(inrec->keyName());
+
+      try {
+         if ( ! q.exec(queryString) )
+            throw QString("%1 %2").arg(q.lastQuery()).arg(q.lastError().text());
+      }
+      catch (QString e) {
+         qCritical() << QString("%1 %2").arg(Q_FUNC_INFO).arg(e);
+         q.finish();
+         throw;
+      }
+
+      while( q.next() ) {
+         byRecipe[ q.value(0).toInt() ].append( q.value(1).toInt() );
+      }
+
+      q.finish();
+      inRecipeIndex.insert(table, byRecipe);
+   }
+}
+
+void Database::indexLink( Brewtarget::DBTable inRecTable, int recKey, int ingKey )
+{
+   if ( ! inRecipeIndex.contains(inRecTable) ) {
+      return;
+   }
+
+   inRecipeIndex[inRecTable][recKey].append(ingKey);
+   onRollback( [this, inRecTable, recKey, ingKey]() {
+      inRecipeIndex[inRecTable][recKey].removeAll(ingKey);
+   });
+}
+
+void Database::indexUnlink( Brewtarget::DBTable inRecTable, int recKey, int ingKey )
+{
+   if ( ! inRecipeIndex.contains(inRecTable) ) {
+      return;
+   }
+
+   QList<int>& links = inRecipeIndex[inRecTable][recKey];
+   int at = links.indexOf(ingKey);
+   if ( at < 0 ) {
+      return;
+   }
+
+   links.removeAt(at);
+   // Back where it was, so the recipe lists things in the same order
+   onRollback( [this, inRecTable, recKey, ingKey, at]() {
+      QList<int>& undone = inRecipeIndex[inRecTable][recKey];
+      if ( ! undone.contains(ingKey) ) {
+         undone.insert( qMin(at, undone.size()), ingKey );
+      }
+   });
+}
+
+template <class T> QList<T*> Database::getIndexedElements( Brewtarget::DBTable inRecTable,
+                                                           Recipe const* parent,
+                                                           QHash<int,T*>& allElements )
+{
+   QList<T*> ret;
+   QList<int> const keys = inRecipeIndex.value(inRecTable).value(parent->key());
+
+   // A recipe's ingredients are hidden, so likely lazy. Read them together
+   materializeAll(allElements, keys);
+   foreach( int key, keys ) {
+      T* e = materialize(allElements, key);
+      if ( e != nullptr )
+         ret.append( e );
+   }
+
+   return ret;
+}
+
 
 void Database::unload()
 {
+   // Anything still queued has to be written before the connections go
+   try {
+      flushPendingWrites();
+   }
+   catch (QString e) {
+      qCritical() << QString("%1 %2").arg(Q_FUNC_INFO).arg(e);
+   }
+
+   // A backup still going needs the connection to finish
+   if ( runningBackup ) {
+      runningBackup->finish();
+   }
+
+   // The automatic backup is of what the user is leaving with, so it is
+   // taken last, while we still have the connection to take it through
+   if (loadWasSuccessful && Brewtarget::dbType() == Brewtarget::SQLITE ) {
+      automaticBackup();
+   }
+
    // selectSome saves context. If we close the database before we tear that
    // context down, core gets dumped
    selectSome.clear();
 
-   // so far, it seems we only create one connection to the db. This is
-   // likely overkill
-   foreach( QString conName, _threadToConnection.values() ) {
-      QSqlDatabase::database( conName, false ).close();
-      QSqlDatabase::removeDatabase( conName );
-   }
+   qInfo() << QString("Prepared statement cache: %1 hits, %2 misses")
+              .arg(preparedQueryHits())
+              .arg(preparedQueryMisses());
+   preparedQueriesMutex.lock();
+   preparedQueries.clear();
+   preparedQueriesMutex.unlock();
+
+   // Close the pool. Any worker connection still open belongs to a thread
+   // that didn't give it back; close it from here and let the thread's
+   // WorkerConnection find it gone
+   workerPoolGeneration.ref();
+   workerConnectionSlots.acquire( workerConnectionSlots.available() );
+   openWorkerConnectionsMutex.lock();
+   QSet<QString> leftOpen = openWorkerConnections;
+   openWorkerConnections.clear();
+   openWorkerConnectionsMutex.unlock();
+   foreach( QString conName, leftOpen ) {
+      qWarning() << QString("%1 closing %2, which was never given back").arg(Q_FUNC_INFO).arg(conName);
+      closeConnection(conName);
+   }
+
+   guiConnection = QSqlDatabase();
+   guiThread = nullptr;
+   closeConnection(dbConName);
 
    if (loadWasSuccessful && Brewtarget::dbType() == Brewtarget::SQLITE )
    {
       dbFile.close();
-      automaticBackup();
    }
 }
 
@@ -714,8 +1517,16 @@ void Database::automaticBackup()
          newName = halfName;
       }
    }
-   // backup the file first
-   backupToDir(backupDir,newName);
+   // backup the file first. We are on our way out, so wait for it. If the
+   // online backup won't start or doesn't finish, do it the old way
+   bool compress = Brewtarget::option("compress", false, "backups").toBool();
+   DatabaseBackup* backup = startBackup( backupDir + "/" + newName, compress );
+   if ( backup && backup->finish() ) {
+      newName = QFileInfo(backup->target()).fileName();
+   }
+   else {
+      backupToDir(backupDir,newName);
+   }
 
    // If we have maxBackups == -1, it means never clean. It also means we
    // don't track the filenames.
@@ -802,7 +1613,14 @@ char const * Database::getDefaultBackupFileName()
 bool Database::backupToFile(QString newDbFileName)
 {
    // Make sure the singleton exists - otherwise there's nothing to backup.
-   instance();
+   // Anything it has queued needs to be in the file before we copy it.
+   try {
+      instance().flushPendingWrites();
+   }
+   catch (QString e) {
+      qCritical() << QString("%1 %2").arg(Q_FUNC_INFO).arg(e);
+      return false;
+   }
 
    bool success = true;
 
@@ -817,6 +1635,19 @@ bool Database::backupToFile(QString newDbFileName)
    return success;
 }
 
+DatabaseBackup* Database::startBackup(QString const& target, bool compress)
+{
+   DatabaseBackup* backup = new DatabaseBackup(target, compress, this);
+   connect( backup, &DatabaseBackup::finished, backup, &QObject::deleteLater );
+
+   if ( ! backup->start() ) {
+      delete backup;
+      return nullptr;
+   }
+   runningBackup = backup;
+   return backup;
+}
+
 bool Database::backupToDir(QString dir,QString filename)
 {
    bool success = true;
@@ -942,7 +1773,11 @@ NamedEntity * Database::removeNamedEntityFromRecipe( Recipe* rec, NamedEntity* i
       return ing;
    }
 
-   sqlDatabase().transaction();
+   // An older version of the recipe may still be using this. If so, all we
+   // can take away is the link
+   bool shared = isShared(ing);
+
+   beginTransaction();
    QSqlQuery q(sqlDatabase());
 
    qDebug() << QString("%1 Deleting NamedEntity %2 #%3").arg(Q_FUNC_INFO).arg(meta->className()).arg(ing->key());
@@ -962,45 +1797,55 @@ NamedEntity * Database::removeNamedEntityFromRecipe( Recipe* rec, NamedEntity* i
       // remove the entry from *_children
       // and DELETE THE COPY
       // delete from misc_in_recipe where misc_id = [misc key] and recipe_id = [rec key]
-      QString deleteFromInRecipe = QString("DELETE FROM %1 WHERE %2=%3 AND %4=%5")
+      QString deleteFromInRecipe = QString("DELETE FROM %1 WHERE %2=:ingredient AND %3=:recipe")
                                  .arg(inrec->tableName() )
                                  .arg(inrec->inRecIndexName())
-                                 .arg(ing->key())
-                                 .arg(inrec->recipeIndexName())
-                                 .arg(rec->key());
+                                 .arg(inrec->recipeIndexName());
       qDebug() << QString("Delete From In Recipe SQL: %1").arg(deleteFromInRecipe);
 
       // delete from misc where id = [misc key]
-      QString deleteNamedEntity = QString("DELETE FROM %1 where %2=%3")
+      QString deleteNamedEntity = QString("DELETE FROM %1 where %2=:ingredient")
                                  .arg(table->tableName())
-                                 .arg(table->keyName())
-                                 .arg(ing->key());
+                                 .arg(table->keyName());
       qDebug() << QString("Delete NamedEntity SQL: %1").arg(deleteNamedEntity);
 
       q.setForwardOnly(true);
 
-      if (parentNamedEntity) {
+      if (parentNamedEntity && ! shared) {
 
          // delete from misc_child where child_id = [misc key]
-         QString deleteFromChildren = QString("DELETE FROM %1 WHERE %2=%3")
+         QString deleteFromChildren = QString("DELETE FROM %1 WHERE %2=:ingredient")
                                     .arg(child->tableName())
-                                    .arg( child->childIndexName() )
-                                    .arg(ing->key());
+                                    .arg( child->childIndexName() );
          qDebug() << QString("Delete From Children SQL: %1").arg(deleteFromChildren);
-         if ( ! q.exec( deleteFromChildren ) ) {
+         q = preparedQuery( deleteFromChildren );
+         q.bindValue(":ingredient", ing->key());
+         if ( ! q.exec() ) {
             qInfo() << Q_FUNC_INFO << q.lastQuery() << q.lastError().text();
             throw QString("failed to delete children.");
          }
+         q.finish();
       }
 
-      if ( ! q.exec(deleteFromInRecipe) ) {
+      q = preparedQuery( deleteFromInRecipe );
+      q.bindValue(":ingredient", ing->key());
+      q.bindValue(":recipe", rec->key());
+      if ( ! q.exec() ) {
          qInfo() << Q_FUNC_INFO << q.lastQuery() << q.lastError().text();
          throw QString("failed to delete in_recipe.");
       }
+      q.finish();
 
-      if ( ! q.exec( deleteNamedEntity ) ) {
-         qInfo() << Q_FUNC_INFO << q.lastQuery() << q.lastError().text();
-         throw QString("failed to delete ingredient.");
+      if ( ! shared ) {
+         q = preparedQuery( deleteNamedEntity );
+         q.bindValue(":ingredient", ing->key());
+         if ( ! q.exec() ) {
+            qInfo() << Q_FUNC_INFO << q.lastQuery() << q.lastError().text();
+            throw QString("failed to delete ingredient.");
+         }
+      }
+      else {
+         disconnect( ing, nullptr, rec, nullptr );
       }
 
    }
@@ -1010,13 +1855,17 @@ NamedEntity * Database::removeNamedEntityFromRecipe( Recipe* rec, NamedEntity* i
                            .arg(e)
                            .arg(q.lastQuery())
                            .arg(q.lastError().text());
-      sqlDatabase().rollback();
+      rollbackTransaction();
       q.finish();
       abort();
    }
 
+   // The link is gone from the db, so take it out of the index before
+   // recalcAll() asks for the ingredients again
+   indexUnlink( inrec->dbTable(), rec->key(), ing->key() );
+
    rec->recalcAll();
-   sqlDatabase().commit();
+   commitTransaction();
 
    q.finish();
    emit rec->changed( rec->metaProperty(propName), QVariant() );
@@ -1096,7 +1945,7 @@ Recipe* Database::getRecipeFromForeignKey(QString keyName, int key)
    }
    if ( q.next() ) {
       int pKey = q.record().value(recTable->keyName()).toInt();
-      parent = this->allRecipes[pKey];
+      parent = materialize(allRecipes, pKey);
    }
    return parent;
 }
@@ -1113,8 +1962,10 @@ Recipe* Database::getParentRecipe(NamedEntity const * ing) {
    if ( inrec == nullptr ) {
       return parent;
    }
-   
-   QString select = QString("SELECT %4 from %1 WHERE %2=%3")
+
+   // Versions share the ingredients they didn't change, so this can find
+   // more than one recipe. The newest is the only one that can be edited.
+   QString select = QString("SELECT %4 from %1 WHERE %2=%3 ORDER BY %4 DESC")
                         .arg(inrec->tableName())
                         .arg(inrec->inRecIndexName())
                         .arg(ing->key())
@@ -1126,7 +1977,7 @@ Recipe* Database::getParentRecipe(NamedEntity const * ing) {
    }
    if ( q.next() ) {
       int key = q.record().value(inrec->recipeIndexName()).toInt();
-      parent = this->allRecipes[key];
+      parent = materialize(allRecipes, key);
    }
 
    return parent;
@@ -1164,7 +2015,7 @@ Recipe* Database::getParentRecipe( BrewNote const* note )
    key = q.record().value(tbl->recipeIndexName()).toInt();
    q.finish();
 
-   return allRecipes[key];
+   return materialize(allRecipes, key);
 }
 
 // Mashsteps need some special handling. Oddly, we don't need to invoke the
@@ -1205,18 +2056,18 @@ Recipe* Database::getParentRecipe( MashStep const* step )
    key = q.record().value("id").toInt();
    q.finish();
 
-   return allRecipes[key];
+   return materialize(allRecipes, key);
 }
 
-Recipe*      Database::recipe(int key)      { return allRecipes[key]; }
-Equipment*   Database::equipment(int key)   { return allEquipments[key]; }
-Fermentable* Database::fermentable(int key) { return allFermentables[key]; }
-Hop*         Database::hop(int key)         { return allHops[key]; }
-Misc*        Database::misc(int key)        { return allMiscs[key]; }
-Style*       Database::style(int key)       { return allStyles[key]; }
-Yeast*       Database::yeast(int key)       { return allYeasts[key]; }
-Salt*        Database::salt(int key)        { return allSalts[key]; }
-Water*       Database::water(int key)       { return allWaters[key]; }
+Recipe*      Database::recipe(int key)      { return materialize(allRecipes, key); }
+Equipment*   Database::equipment(int key)   { return materialize(allEquipments, key); }
+Fermentable* Database::fermentable(int key) { return materialize(allFermentables, key); }
+Hop*         Database::hop(int key)         { return materialize(allHops, key); }
+Misc*        Database::misc(int key)        { return materialize(allMiscs, key); }
+Style*       Database::style(int key)       { return materialize(allStyles, key); }
+Yeast*       Database::yeast(int key)       { return materialize(allYeasts, key); }
+Salt*        Database::salt(int key)        { return materialize(allSalts, key); }
+Water*       Database::water(int key)       { return materialize(allWaters, key); }
 
 void Database::swapMashStepOrder(MashStep* m1, MashStep* m2)
 {
@@ -1319,7 +2170,7 @@ void Database::insertInstruction(Instruction* in, int pos)
                    .arg(in->key());
    QString update;
 
-   sqlDatabase().transaction();
+   beginTransaction();
 
    QSqlQuery q(sqlDatabase());
 
@@ -1390,11 +2241,11 @@ void Database::insertInstruction(Instruction* in, int pos)
                            .arg(q.lastQuery())
                            .arg(q.lastError().text());
       q.finish();
-      sqlDatabase().rollback();
+      rollbackTransaction();
       throw;
    }
 
-   sqlDatabase().commit();
+   commitTransaction();
    q.finish();
 
    emit in->changed( in->metaProperty("instructionNumber"), pos );
@@ -1403,39 +2254,48 @@ void Database::insertInstruction(Instruction* in, int pos)
 QList<int> Database::ancestoralIds(Recipe const* descendant)
 {
    QList<int> ret;
-   TableSchema* tbl = dbDefn->table(Brewtarget::RECTABLE);
+   int key = descendant->key();
 
    // Ph'nglui mglw'nafh Cthulhu R'lyeh wgah'nagl fhtagn
-   // The first select initializes the chain, so we get the id and ancestor_id
-   // of the current recipe. The UNION ALL does the recursive trick, where
-   // find all the ancestors. The query stops when recipe.id = ancestor_id.
-   //
-   // WITH RECURSIVE ancestor(id,ancestor_id) AS
-   //  (SELECT id,ancestor_id FROM recipe r WHERE r.id = [key]
-   //   UNION ALL
-   //   SELECT r.id, r.ancestor_id FROM ancestor a, recipe r
-   //     WHERE r.id = a.ancestor_id AND r.ancestor_id != a.id )
-   // SELECT id FROM ancestor
-   QString recursiveQuery =
-      QString("WITH RECURSIVE ancestor(%1,%2) AS "
-               "(SELECT %1,%2 FROM %3 r WHERE r.%1 = %4 "
-                "UNION ALL "
-                "SELECT r.%1, r.%2 FROM ancestor a, recipe r "
-                "WHERE r.%1 = a.%2 AND r.%2 != a.%1 ) "
-              "SELECT %1 from ancestor")
-      .arg( tbl->keyName() )
-      .arg( tbl->foreignKeyToColumn(PropertyNames::Recipe::ancestorId) )
-      .arg( tbl->tableName() )
-      .arg( descendant->key() );
-
-   QSqlQuery q( sqlDatabase() );
+   // This used to be a recursive query, run for every recipe in the tree.
+   // Walking ancestorOf gives the same answer: the chain starts with the
+   // recipe itself and stops at the recipe that is its own ancestor (or has
+   // none). Checking ret guards against a loop in the db.
+   while ( key > 0 && ! ret.contains(key) ) {
+      ret.append(key);
+
+      int ancestor = ancestorIdOf(key);
+      if ( ancestor == key ) {
+         break;
+      }
+      key = ancestor;
+   }
+
+   return ret;
+}
+
+int Database::ancestorIdOf(int key)
+{
+   if ( ancestorOf.contains(key) ) {
+      return ancestorOf.value(key);
+   }
+
+   TableSchema* tbl = dbDefn->table(Brewtarget::RECTABLE);
+   int ret = 0;
+
+   // SELECT ancestor_id FROM recipe WHERE id = :id
+   QSqlQuery q = preparedQuery( QString("SELECT %1 FROM %2 WHERE %3 = :id")
+                                   .arg( tbl->foreignKeyToColumn(PropertyNames::Recipe::ancestorId) )
+                                   .arg( tbl->tableName() )
+                                   .arg( tbl->keyName() ) );
+   q.bindValue(":id", key);
 
    try {
-      if ( ! q.exec(recursiveQuery) ) {
-         throw QString("Could not find ancestoral recipes");
+      if ( ! q.exec() ) {
+         throw QString("Could not find ancestoral recipe");
       }
-      while ( q.next() ) {
-         ret.append( q.record().value( tbl->keyName() ).toInt() );
+      if ( q.next() ) {
+         ret = q.value(0).toInt();
       }
    }
    catch( QString e ) {
@@ -1443,74 +2303,60 @@ QList<int> Database::ancestoralIds(Recipe const* descendant)
       abort();
    }
 
+   q.finish();
+   ancestorOf.insert(key, ret);
    return ret;
 }
 
 QList<BrewNote*> Database::brewNotes(Recipe const* parent, bool recurse)
 {
-   QList<int> ancestors;
-   QString inList;
-
    QList<BrewNote*> ret;
-   TableSchema* tbl = dbDefn->table(Brewtarget::BREWNOTETABLE);
+   QList<int> recipes;
 
+   // Everything needed is already in memory: ancestoralIds() walks
+   // ancestorOf, and brewNotesOf has the notes of each recipe
    if ( recurse ) {
-      ancestors = ancestoralIds(parent);
-      inList = QString("%1").arg(ancestors.takeFirst());
-      foreach(int key, ancestors) {
-         inList.append(QString(",%1").arg(key));
-      }
+      recipes = ancestoralIds(parent);
    }
    else {
-      inList = QString("%1").arg(parent->key());
+      recipes.append(parent->key());
    }
 
-   // this may not be the most efficient way to query. It compresses the code
-   // nicely, but maybe that's the wrong optimization
-   //  deleted = false and recipe_id in (LIST)
-   QString filterString = QString("%1 = %2 AND %3 in (%4)")
-         .arg(tbl->propertyToColumn(PropertyNames::NamedEntity::deleted))
-         .arg(Brewtarget::dbFalse())
-         .arg(tbl->recipeIndexName())
-         .arg(inList);
+   foreach( int recKey, recipes ) {
+      QList<int> const keys = brewNotesOf.value(recKey);
 
-   getElements(ret, filterString, Brewtarget::BREWNOTETABLE, allBrewNotes);
+      materializeAll(allBrewNotes, keys);
+      foreach( int key, keys ) {
+         BrewNote* note = materialize(allBrewNotes, key);
+         if ( note != nullptr && ! note->deleted() )
+            ret.append(note);
+      }
+   }
 
    return ret;
 }
 
-QList<Fermentable*> Database::fermentables(Recipe const* parent)
+void Database::indexBrewNote( int recKey, int noteKey )
 {
-   QList<Fermentable*> ret;
-   TableSchema* inrec = dbDefn->table(Brewtarget::FERMINRECTABLE);
-   // recipe_id = [parent->key]
-   QString filter = QString("%1 = %2").arg(inrec->recipeIndexName()).arg(parent->key());
-
-   getElements(ret,filter, Brewtarget::FERMINRECTABLE, allFermentables, inrec->inRecIndexName());
+   brewNotesOf[recKey].append(noteKey);
+   onRollback( [this, recKey, noteKey]() {
+      brewNotesOf[recKey].removeAll(noteKey);
+   });
+}
 
-   return ret;
+QList<Fermentable*> Database::fermentables(Recipe const* parent)
+{
+   return getIndexedElements(Brewtarget::FERMINRECTABLE, parent, allFermentables);
 }
 
 QList<Hop*> Database::hops(Recipe const* parent)
 {
-   QList<Hop*> ret;
-   TableSchema* inrec = dbDefn->table(Brewtarget::HOPINRECTABLE);
-   QString filter = QString("%1 = %2").arg(inrec->recipeIndexName()).arg(parent->key());
-
-   getElements(ret,filter, Brewtarget::HOPINRECTABLE, allHops, inrec->inRecIndexName());
-
-   return ret;
+   return getIndexedElements(Brewtarget::HOPINRECTABLE, parent, allHops);
 }
 
 QList<Misc*> Database::miscs(Recipe const* parent)
 {
-   QList<Misc*> ret;
-   TableSchema* inrec = dbDefn->table(Brewtarget::MISCINRECTABLE);
-   QString filter = QString("%1 = %2").arg(inrec->recipeIndexName()).arg(parent->key());
-
-   getElements(ret,filter, Brewtarget::MISCINRECTABLE, allMiscs, inrec->inRecIndexName());
-
-   return ret;
+   return getIndexedElements(Brewtarget::MISCINRECTABLE, parent, allMiscs);
 }
 
 Equipment* Database::equipment(Recipe const* parent)
@@ -1518,10 +2364,7 @@ Equipment* Database::equipment(Recipe const* parent)
    TableSchema* tbl = dbDefn->table(Brewtarget::RECTABLE);
    int id = get( tbl, parent->key(), tbl->foreignKeyToColumn(kpropEquipmentId)).toInt();
 
-   if( allEquipments.contains(id) )
-      return allEquipments[id];
-   else
-      return nullptr;
+   return materialize(allEquipments, id);
 }
 
 Style* Database::style(Recipe const* parent)
@@ -1529,18 +2372,12 @@ Style* Database::style(Recipe const* parent)
    TableSchema* tbl = dbDefn->table(Brewtarget::RECTABLE);
    int id = get( tbl, parent->key(), tbl->foreignKeyToColumn(kpropStyleId)).toInt();
 
-   if( allStyles.contains(id) )
-      return allStyles[id];
-   else
-      return nullptr;
+   return materialize(allStyles, id);
 }
 
 Style* Database::styleById(int styleId )
 {
-   if( allStyles.contains(styleId) )
-      return allStyles[styleId];
-   else
-      return nullptr;
+   return materialize(allStyles, styleId);
 }
 
 Mash* Database::mash( Recipe const* parent )
@@ -1548,10 +2385,7 @@ Mash* Database::mash( Recipe const* parent )
    TableSchema* tbl = dbDefn->table(Brewtarget::RECTABLE);
    int mashId = get( tbl, parent->key(), tbl->foreignKeyToColumn(kpropMashId)).toInt();
 
-   if( allMashs.contains(mashId) )
-      return allMashs[mashId];
-   else
-      return nullptr;
+   return materialize(allMashs, mashId);
 }
 
 QList<MashStep*> Database::mashSteps(Mash const* parent)
@@ -1589,35 +2423,17 @@ QList<Instruction*> Database::instructions( Recipe const* parent )
 
 QList<Water*> Database::waters(Recipe const* parent)
 {
-   QList<Water*> ret;
-   TableSchema* inrec = dbDefn->table(Brewtarget::WATERINRECTABLE);
-   QString filter = QString("%1 = %2").arg(inrec->recipeIndexName()).arg(parent->key());
-
-   getElements(ret,filter,Brewtarget::WATERINRECTABLE,allWaters,inrec->inRecIndexName());
-
-   return ret;
+   return getIndexedElements(Brewtarget::WATERINRECTABLE, parent, allWaters);
 }
 
 QList<Salt*> Database::salts(Recipe const* parent)
 {
-   QList<Salt*> ret;
-   TableSchema* inrec = dbDefn->table(Brewtarget::SALTINRECTABLE);
-   QString filter = QString("%1 = %2").arg(inrec->recipeIndexName()).arg(parent->key());
-
-   getElements(ret,filter,Brewtarget::SALTINRECTABLE,allSalts,inrec->inRecIndexName());
-
-   return ret;
+   return getIndexedElements(Brewtarget::SALTINRECTABLE, parent, allSalts);
 }
 
 QList<Yeast*> Database::yeasts(Recipe const* parent)
 {
-   QList<Yeast*> ret;
-   TableSchema* inrec = dbDefn->table(Brewtarget::YEASTINRECTABLE);
-   QString filter = QString("%1 = %2").arg(inrec->recipeIndexName()).arg(parent->key());
-
-   getElements(ret,filter,Brewtarget::YEASTINRECTABLE,allYeasts,inrec->inRecIndexName());
-
-   return ret;
+   return getIndexedElements(Brewtarget::YEASTINRECTABLE, parent, allYeasts);
 }
 
 // Named constructors =========================================================
@@ -1638,7 +2454,7 @@ BrewNote* Database::newBrewNote(Recipe* parent, bool signal)
 {
    BrewNote* tmp;
 
-   sqlDatabase().transaction();
+   beginTransaction();
 
    try {
       tmp = newNamedEntity(&allBrewNotes);
@@ -1647,15 +2463,16 @@ BrewNote* Database::newBrewNote(Recipe* parent, bool signal)
       sqlUpdate( Brewtarget::BREWNOTETABLE,
                QString("%1=%2").arg(tbl->recipeIndexName()).arg(parent->key()),
                QString("%1=%2").arg(tbl->keyName()).arg(tmp->key()) );
+      indexBrewNote( parent->key(), tmp->key() );
 
    }
    catch (QString e) {
       qCritical() << QString("%1 %2").arg(Q_FUNC_INFO).arg(e);
-      sqlDatabase().rollback();
+      rollbackTransaction();
       throw;
    }
 
-   sqlDatabase().commit();
+   commitTransaction();
    tmp->setDisplay(true);
    if ( signal )
    {
@@ -1694,7 +2511,7 @@ Fermentable* Database::newFermentable(Fermentable* other, bool add_inventory)
    Fermentable* tmp;
    add_inventory = add_inventory || other == nullptr;
 
-   sqlDatabase().transaction();
+   beginTransaction();
    try {
       if (other != nullptr) {
          tmp = copy(other, &allFermentables);
@@ -1710,11 +2527,11 @@ Fermentable* Database::newFermentable(Fermentable* other, bool add_inventory)
    }
    catch (QString e) {
       qCritical() << QString("%1 %2").arg(Q_FUNC_INFO).arg(e);
-      sqlDatabase().rollback();
+      rollbackTransaction();
       abort();
    }
 
-   sqlDatabase().commit();
+   commitTransaction();
 
    if ( tmp ) {
       emit changed( metaProperty("fermentables"), QVariant() );
@@ -1732,7 +2549,7 @@ Hop* Database::newHop(Hop* other, bool add_inventory )
    Hop* tmp;
    add_inventory = add_inventory || other == nullptr;
 
-   sqlDatabase().transaction();
+   beginTransaction();
    try {
       if ( other != nullptr )
          tmp = copy(other, &allHops);
@@ -1746,11 +2563,11 @@ Hop* Database::newHop(Hop* other, bool add_inventory )
    }
    catch (QString e) {
       qCritical() << QString("%1 %2").arg(Q_FUNC_INFO).arg(e);
-      sqlDatabase().rollback();
+      rollbackTransaction();
       abort();
    }
 
-   sqlDatabase().commit();
+   commitTransaction();
 
    if ( tmp ) {
       emit changed( metaProperty("hops"), QVariant() );
@@ -1769,27 +2586,318 @@ Instruction* Database::newInstruction(Recipe* rec)
 {
    Instruction* tmp;
 
-   sqlDatabase().transaction();
+   beginTransaction();
+
+   try {
+      tmp = newNamedEntity(&allInstructions);
+      tmp->setRecipe(rec);
+
+      // Add without copying to "instruction_in_recipe". We already have a
+      // transaction open, so tell addIng to not worry about it
+      tmp = addNamedEntityToRecipe<Instruction>(rec,tmp,true,nullptr,false,false);
+   }
+   catch ( QString e ) {
+      qCritical() << QString("%1 %2").arg( Q_FUNC_INFO ).arg(e);
+      rollbackTransaction();
+      throw;
+   }
+
+   // Database's instructions have changed.
+   commitTransaction();
+   emit changed( metaProperty("instructions"), QVariant() );
+
+   return tmp;
+}
+
+QVector<int> Database::alignInstructions(QList<Instruction*> const& existing, QList<Instruction*> const& generated)
+{
+   int const n = existing.size();
+   int const m = generated.size();
+   auto same = [&existing, &generated](int i, int j) {
+      return existing.at(i)->name() == generated.at(j)->name() &&
+             existing.at(i)->directions() == generated.at(j)->directions();
+   };
+
+   // lcs[i][j] is how many steps existing[i..] and generated[j..] have in
+   // common, in order
+   QVector< QVector<int> > lcs(n + 1, QVector<int>(m + 1, 0));
+   for ( int i = n - 1; i >= 0; --i ) {
+      for ( int j = m - 1; j >= 0; --j ) {
+         lcs[i][j] = same(i, j) ? lcs[i+1][j+1] + 1 : qMax(lcs[i+1][j], lcs[i][j+1]);
+      }
+   }
+
+   QVector<int> ret(m, -1);
+   int gapI = 0, gapJ = 0;
+   // Whatever is between two matches gets paired up by position
+   auto pairGap = [&ret, &gapI, &gapJ](int endI, int endJ) {
+      for ( int k = 0; gapI + k < endI && gapJ + k < endJ; ++k )
+         ret[gapJ + k] = gapI + k;
+   };
+
+   int i = 0, j = 0;
+   while ( i < n && j < m ) {
+      if ( same(i, j) ) {
+         pairGap(i, j);
+         ret[j] = i;
+         gapI = ++i;
+         gapJ = ++j;
+      }
+      else if ( lcs[i+1][j] >= lcs[i][j+1] ) {
+         ++i;
+      }
+      else {
+         ++j;
+      }
+   }
+   pairGap(n, m);
+
+   return ret;
+}
+
+void Database::replaceInstructions(Recipe* rec, QList<Instruction*> generated)
+{
+   if ( rec == nullptr || rec->locked() ) {
+      qDeleteAll(generated);
+      return;
+   }
+
+   TableSchema* tbl = dbDefn->table(Brewtarget::INSTRUCTIONTABLE);
+   TableSchema* inrec = dbDefn->table(Brewtarget::INSTINRECTABLE);
+   QStringList props = tbl->allProperties();
+
+   // Line the steps up by what they say, so one step added or dropped in the
+   // middle doesn't push every step after it onto its neighbour's row
+   QList<Instruction*> existing = instructions(rec);
+   QVector<int> source = alignInstructions(existing, generated);
+
+   QVector<bool> survives(existing.size(), false);
+   QList<Instruction*> added;
+   for ( int j = 0; j < generated.size(); ++j ) {
+      if ( source.at(j) >= 0 )
+         survives[source.at(j)] = true;
+      else
+         added.append(generated.at(j));
+   }
+   QList<Instruction*> removed;
+   for ( int i = 0; i < existing.size(); ++i ) {
+      if ( ! survives.at(i) )
+         removed.append(existing.at(i));
+   }
+
+   QList<int> changedAt;
+   QList<int> addedKeys;
+   int renumbered = 0;
+
+   beginTransaction();
+   QSqlQuery q(sqlDatabase());
+
+   try {
+      // Rewrite, in place, the instructions that say something different now.
+      // A step that only moved or changed its time is still the same step, so
+      // it stays completed if it was
+      QString update = QString("UPDATE %1 SET %2=:name, %3=:directions, %4=:interval, %5=:completed WHERE %6=:id")
+                          .arg(tbl->tableName())
+                          .arg(tbl->propertyToColumn(PropertyNames::NamedEntity::name))
+                          .arg(tbl->propertyToColumn(PropertyNames::Instruction::directions))
+                          .arg(tbl->propertyToColumn(PropertyNames::Instruction::interval))
+                          .arg(tbl->propertyToColumn(PropertyNames::Instruction::completed))
+                          .arg(tbl->keyName());
+      for ( int j = 0; j < generated.size(); ++j ) {
+         if ( source.at(j) < 0 )
+            continue;
+
+         Instruction* was = existing.at(source.at(j));
+         Instruction* now = generated.at(j);
+         bool const sameStep = was->name() == now->name() && was->directions() == now->directions();
+         if ( sameStep && was->interval() == now->interval() )
+            continue;
+
+         // Its own query: the prepared one is shared with the cache
+         QSqlQuery u = preparedQuery(update);
+         u.bindValue(":name", now->name());
+         u.bindValue(":directions", now->directions());
+         u.bindValue(":interval", now->interval());
+         u.bindValue(":completed", sameStep && was->completed());
+         u.bindValue(":id", was->key());
+         if ( ! u.exec() )
+            throw QString("%1 : %2").arg(u.lastQuery()).arg(u.lastError().text());
+         u.finish();
+         changedAt.append(j);
+      }
+
+      if ( ! removed.isEmpty() ) {
+         // One at a time and from the bottom up, so dec_ins_num always sees
+         // the numbers as they are
+         // DELETE FROM instruction_in_recipe WHERE recipe_id=:recipe AND instruction_id=:ingredient
+         QString unlink = QString("DELETE FROM %1 WHERE %2=:recipe AND %3=:ingredient")
+                             .arg(inrec->tableName())
+                             .arg(inrec->recipeIndexName())
+                             .arg(inrec->inRecIndexName());
+         QStringList keys;
+         for ( int i = removed.size() - 1; i >= 0; --i ) {
+            QSqlQuery d = preparedQuery(unlink);
+            d.bindValue(":recipe", rec->key());
+            d.bindValue(":ingredient", removed.at(i)->key());
+            if ( ! d.exec() )
+               throw QString("%1 : %2").arg(d.lastQuery()).arg(d.lastError().text());
+            d.finish();
+            keys.append(QString::number(removed.at(i)->key()));
+         }
+
+         // and the instructions themselves, unless an older version of the
+         // recipe still has them
+         QString drop = QString("DELETE FROM %1 WHERE %2 IN (%3) AND %2 NOT IN (SELECT %4 FROM %5)")
+                           .arg(tbl->tableName())
+                           .arg(tbl->keyName())
+                           .arg(keys.join(","))
+                           .arg(inrec->inRecIndexName())
+                           .arg(inrec->tableName());
+         if ( ! q.exec(drop) )
+            throw QString("%1 : %2").arg(drop).arg(q.lastError().text());
+      }
+
+      if ( ! added.isEmpty() ) {
+         QStringList columns, marks;
+         foreach( QString prop, props ) {
+            columns.append(tbl->propertyToColumn(prop));
+            marks.append("?");
+         }
+         QString row = QString("(%1)").arg(marks.join(","));
+
+         // Well under SQLite's limit on bound values per statement
+         int const rowsPerInsert = 100;
+         for ( int first = 0; first < added.size(); first += rowsPerInsert ) {
+            QList<Instruction*> batch = added.mid(first, rowsPerInsert);
+            QStringList rows;
+            for ( int i = 0; i < batch.size(); ++i )
+               rows.append(row);
+
+            QString insert = QString("INSERT INTO %1 (%2) VALUES %3")
+                                .arg(tbl->tableName())
+                                .arg(columns.join(","))
+                                .arg(rows.join(","));
+            if ( Brewtarget::dbType() == Brewtarget::PGSQL )
+               insert += QString(" RETURNING %1").arg(tbl->keyName());
+
+            if ( ! q.prepare(insert) )
+               throw QString("%1 : %2").arg(insert).arg(q.lastError().text());
+            foreach( Instruction* ins, batch ) {
+               foreach( QString prop, props )
+                  q.addBindValue( ins->property(tbl->propertyName(prop).toUtf8().data()) );
+            }
+            if ( ! q.exec() )
+               throw QString("%1 : %2").arg(insert).arg(q.lastError().text());
+
+            if ( Brewtarget::dbType() == Brewtarget::PGSQL ) {
+               while ( q.next() )
+                  addedKeys.append(q.value(0).toInt());
+            }
+            else {
+               // AUTOINCREMENT gives the rows of one INSERT consecutive keys,
+               // and nobody else can write in the middle of our transaction
+               int last = q.lastInsertId().toInt();
+               for ( int key = last - batch.size() + 1; key <= last; ++key )
+                  addedKeys.append(key);
+            }
+         }
+         if ( addedKeys.size() != added.size() )
+            throw QString("got %1 keys for %2 new instructions").arg(addedKeys.size()).arg(added.size());
+
+         // The links go in in order, so inc_ins_num numbers them in order
+         QStringList links;
+         foreach( int key, addedKeys )
+            links.append(QString("(%1,%2)").arg(key).arg(rec->key()));
+         QString link = QString("INSERT INTO %1 (%2,%3) VALUES %4")
+                           .arg(inrec->tableName())
+                           .arg(inrec->inRecIndexName())
+                           .arg(inrec->recipeIndexName())
+                           .arg(links.join(","));
+         if ( ! q.exec(link) )
+            throw QString("%1 : %2").arg(link).arg(q.lastError().text());
+      }
 
-   try {
-      tmp = newNamedEntity(&allInstructions);
-      tmp->setRecipe(rec);
+      // The triggers have numbered the steps we kept in their old order, and
+      // put the new ones after them. Move the ones that belong elsewhere
+      QHash<int,int> numberOf;
+      int number = 0;
+      for ( int i = 0; i < existing.size(); ++i ) {
+         if ( survives.at(i) )
+            numberOf.insert(existing.at(i)->key(), ++number);
+      }
+      foreach( int key, addedKeys )
+         numberOf.insert(key, ++number);
+
+      // UPDATE instruction_in_recipe SET instruction_number=:number WHERE recipe_id=:recipe AND instruction_id=:ingredient
+      QString renumber = QString("UPDATE %1 SET %2=:number WHERE %3=:recipe AND %4=:ingredient")
+                            .arg(inrec->tableName())
+                            .arg(inrec->propertyToColumn(kpropInstructionNumber))
+                            .arg(inrec->recipeIndexName())
+                            .arg(inrec->inRecIndexName());
+      int nextAdded = 0;
+      for ( int j = 0; j < generated.size(); ++j ) {
+         int key = source.at(j) >= 0 ? existing.at(source.at(j))->key() : addedKeys.at(nextAdded++);
+         if ( numberOf.value(key) == j + 1 )
+            continue;
 
-      // Add without copying to "instruction_in_recipe". We already have a
-      // transaction open, so tell addIng to not worry about it
-      tmp = addNamedEntityToRecipe<Instruction>(rec,tmp,true,nullptr,false,false);
+         QSqlQuery r = preparedQuery(renumber);
+         r.bindValue(":number", j + 1);
+         r.bindValue(":recipe", rec->key());
+         r.bindValue(":ingredient", key);
+         if ( ! r.exec() )
+            throw QString("%1 : %2").arg(r.lastQuery()).arg(r.lastError().text());
+         r.finish();
+         ++renumbered;
+      }
    }
-   catch ( QString e ) {
-      qCritical() << QString("%1 %2").arg( Q_FUNC_INFO ).arg(e);
-      sqlDatabase().rollback();
+   catch (QString e) {
+      qCritical() << QString("%1 %2").arg(Q_FUNC_INFO).arg(e);
+      q.finish();
+      rollbackTransaction();
+      qDeleteAll(generated);
       throw;
    }
 
-   // Database's instructions have changed.
-   sqlDatabase().commit();
-   emit changed( metaProperty("instructions"), QVariant() );
+   q.finish();
+   commitTransaction();
+
+   // The db has it all, so now the objects can follow
+   bool indexed = inRecipeIndex.contains(inrec->dbTable());
+   foreach( int j, changedAt ) {
+      Instruction* was = existing.at(source.at(j));
+      Instruction* now = generated.at(j);
+      if ( was->name() != now->name() || was->directions() != now->directions() )
+         was->m_completed = false;
+      was->setName(now->name(), true);
+      was->m_directions = now->directions();
+      was->m_interval = now->interval();
+      was->m_reagents = now->reagents();
+   }
+   foreach( Instruction* ins, removed ) {
+      allInstructions.remove(ins->key());
+      if ( indexed )
+         inRecipeIndex[inrec->dbTable()][rec->key()].removeAll(ins->key());
+   }
+   for ( int i = 0; i < added.size(); ++i ) {
+      Instruction* ins = added.at(i);
+      ins->m_key = addedKeys.at(i);
+      ins->setCacheOnly(false);
+      ins->setRecipe(rec);
+      allInstructions.insert(ins->key(), ins);
+      if ( indexed )
+         inRecipeIndex[inrec->dbTable()][rec->key()].append(ins->key());
+   }
+   for ( int j = 0; j < generated.size(); ++j ) {
+      if ( source.at(j) >= 0 )
+         delete generated.at(j);
+   }
 
-   return tmp;
+   qDebug() << QString("%1 recipe #%2: %3 kept, %4 rewritten, %5 removed, %6 added, %7 renumbered")
+                  .arg(Q_FUNC_INFO).arg(rec->key())
+                  .arg(generated.size() - added.size() - changedAt.size())
+                  .arg(changedAt.size()).arg(removed.size()).arg(added.size()).arg(renumbered);
+
+   emit changed( metaProperty("instructions"), QVariant() );
 }
 
 // needs fixed
@@ -1818,7 +2926,7 @@ Mash* Database::newMash(Mash* other, bool displace)
 
    try {
       if ( other ) {
-         sqlDatabase().transaction();
+         beginTransaction();
          tmp = copy<Mash>(other, &allMashs);
       }
       else {
@@ -1842,12 +2950,12 @@ Mash* Database::newMash(Mash* other, bool displace)
    }
    catch (QString e) {
       if ( other )
-         sqlDatabase().rollback();
+         rollbackTransaction();
       throw;
    }
 
    if ( other ) {
-      sqlDatabase().commit();
+      commitTransaction();
    }
 
    emit changed( metaProperty("mashs"), QVariant() );
@@ -1861,7 +2969,7 @@ Mash* Database::newMash(Recipe* parent, bool transact)
    Mash* tmp;
 
    if ( transact ) {
-      sqlDatabase().transaction();
+      beginTransaction();
    }
 
    try {
@@ -1876,12 +2984,12 @@ Mash* Database::newMash(Recipe* parent, bool transact)
    catch (QString e) {
       qCritical() << QString("%1 %2").arg(Q_FUNC_INFO).arg(e);
       if ( transact )
-         sqlDatabase().rollback();
+         rollbackTransaction();
       throw;
    }
 
    if ( transact ) {
-      sqlDatabase().commit();
+      commitTransaction();
    }
 
    emit changed( metaProperty("mashs"), QVariant() );
@@ -1910,7 +3018,7 @@ MashStep* Database::newMashStep(Mash* mash, bool connected)
                         .arg(tbl->foreignKeyToColumn())
                         .arg(mash->key());
 
-   sqlDatabase().transaction();
+   beginTransaction();
 
    QSqlQuery q(sqlDatabase());
    q.setForwardOnly(true);
@@ -1935,11 +3043,11 @@ MashStep* Database::newMashStep(Mash* mash, bool connected)
    }
    catch (QString e) {
       qCritical() << QString("%1 %2").arg(Q_FUNC_INFO).arg(e);
-      sqlDatabase().rollback();
+      rollbackTransaction();
       throw;
    }
 
-   sqlDatabase().commit();
+   commitTransaction();
 
    if ( connected )
       connect( tmp, SIGNAL(changed(QMetaProperty,QVariant)), mash, SLOT(acceptMashStepChange(QMetaProperty,QVariant)) );
@@ -1954,7 +3062,7 @@ Misc* Database::newMisc(Misc* other, bool add_inventory)
    Misc* tmp;
    add_inventory = add_inventory || other == nullptr;
 
-   sqlDatabase().transaction();
+   beginTransaction();
    try {
       if ( other != nullptr ) {
         tmp = copy(other, &allMiscs);
@@ -1970,11 +3078,11 @@ Misc* Database::newMisc(Misc* other, bool add_inventory)
    }
    catch (QString e) {
       qCritical() << QString("%1 %2").arg(Q_FUNC_INFO).arg(e);
-      sqlDatabase().rollback();
+      rollbackTransaction();
       abort();
    }
 
-   sqlDatabase().commit();
+   commitTransaction();
 
    if ( tmp ) {
       emit changed( metaProperty("miscs"), QVariant() );
@@ -1993,7 +3101,7 @@ Recipe* Database::newRecipe(QString name)
 {
    Recipe* tmp;
 
-   sqlDatabase().transaction();
+   beginTransaction();
 
    try {
       tmp = newNamedEntity(&allRecipes);
@@ -2002,7 +3110,7 @@ Recipe* Database::newRecipe(QString name)
    }
    catch (QString e ) {
       qCritical() << QString("%1 %2").arg(Q_FUNC_INFO).arg(e);
-      sqlDatabase().rollback();
+      rollbackTransaction();
       throw;
    }
 
@@ -2018,7 +3126,7 @@ Recipe* Database::newRecipe(QString name)
       throw;
    }
 
-   sqlDatabase().commit();
+   commitTransaction();
    emit changed( metaProperty("recipes"), QVariant() );
    emit createdSignal(tmp);
 
@@ -2028,18 +3136,36 @@ Recipe* Database::newRecipe(QString name)
 Recipe* Database::copyRecipeExcept(Recipe *other, NamedEntity *except)
 {
    Recipe *tmp;
-   sqlDatabase().transaction();
+   beginTransaction();
 
    try {
       tmp = copy<Recipe>(other, &allRecipes, true);
 
-      // the cast will return nullptr if the NamedEntity cannot be cast. The
-      // addToRecipe will do the right thing and simply copy it all.
-      addToRecipe( tmp, other->fermentables(), qobject_cast<Fermentable*>(except), false);
-      addToRecipe( tmp, other->hops(),         qobject_cast<Hop*>(except),         false);
-      addToRecipe( tmp, other->miscs(),        qobject_cast<Misc*>(except),        false);
-      addToRecipe( tmp, other->yeasts(),       qobject_cast<Yeast*>(except),       false);
+      // The new version shares the ingredients with the old one instead of
+      // copying them. Old versions are locked, so the only way a shared
+      // ingredient changes is through modifyEntry(), which gives the newest
+      // version its own copy first. That way a version only costs the rows
+      // that actually changed.
+      foreach( Fermentable* f, other->fermentables() ) {
+         if ( f != except )
+            linkToRecipe(tmp, f);
+      }
+      foreach( Hop* h, other->hops() ) {
+         if ( h != except )
+            linkToRecipe(tmp, h);
+      }
+      foreach( Misc* m, other->miscs() ) {
+         if ( m != except )
+            linkToRecipe(tmp, m);
+      }
+      foreach( Yeast* y, other->yeasts() ) {
+         if ( y != except )
+            linkToRecipe(tmp, y);
+      }
 
+      // Equipment, mash and style hang off the recipe row, and changes to
+      // them don't go through modifyEntry(). They stay copies, or editing the
+      // new version would rewrite the old one.
       // if the exception cannot be cast to a equipment/mash/style, then copy
       // the equipment/mash/style to the clone
       if ( qobject_cast<Equipment*>(except) == nullptr ) {
@@ -2056,20 +3182,170 @@ Recipe* Database::copyRecipeExcept(Recipe *other, NamedEntity *except)
    }
    catch (QString e) {
       qCritical() << Q_FUNC_INFO << e;
-      sqlDatabase().rollback();
+      rollbackTransaction();
       abort();
    }
 
-   sqlDatabase().commit();
+   commitTransaction();
    return tmp;
 }
 
+void Database::linkToRecipe( Recipe* rec, NamedEntity* ing )
+{
+   TableSchema* table = dbDefn->table( dbDefn->classNameToTable(ing->metaObject()->className()) );
+   TableSchema* inrec = dbDefn->table( table->inRecTable() );
+
+   if ( inrec == nullptr ) {
+      throw QString("%1 has no in recipe table").arg(ing->metaObject()->className());
+   }
+
+   // INSERT INTO fermentable_in_recipe (fermentable_id, recipe_id) VALUES (:ingredient, :recipe)
+   QSqlQuery q = preparedQuery( QString("INSERT INTO %1 (%2, %3) VALUES (:ingredient, :recipe)")
+                                   .arg(inrec->tableName())
+                                   .arg(inrec->inRecIndexName(Brewtarget::dbType()))
+                                   .arg(inrec->recipeIndexName()) );
+   q.bindValue(":ingredient", ing->key());
+   q.bindValue(":recipe", rec->key());
+
+   if ( ! q.exec() ) {
+      throw QString("%1 : %2").arg(q.lastQuery()).arg(q.lastError().text());
+   }
+   q.finish();
+
+   indexLink( inrec->dbTable(), rec->key(), ing->key() );
+   connectIngredient( ing, rec );
+}
+
+NamedEntity* Database::relinkToRecipe( Recipe* rec, NamedEntity* ing )
+{
+   const QMetaObject* meta = ing->metaObject();
+   int ndx = meta->indexOfClassInfo("signal");
+
+   beginTransaction();
+   try {
+      linkToRecipe(rec, ing);
+   }
+   catch (QString e) {
+      qCritical() << QString("%1 %2").arg(Q_FUNC_INFO).arg(e);
+      rollbackTransaction();
+      throw;
+   }
+
+   rec->recalcAll();
+   commitTransaction();
+
+   if ( ndx != -1 ) {
+      emit rec->changed( rec->metaProperty(meta->classInfo(ndx).value()), QVariant() );
+   }
+   return ing;
+}
+
+void Database::unlinkFromRecipe( Recipe* rec, NamedEntity* ing )
+{
+   TableSchema* table = dbDefn->table( dbDefn->classNameToTable(ing->metaObject()->className()) );
+   TableSchema* inrec = dbDefn->table( table->inRecTable() );
+
+   if ( inrec == nullptr ) {
+      return;
+   }
+
+   // DELETE FROM fermentable_in_recipe WHERE fermentable_id=:ingredient AND recipe_id=:recipe
+   QSqlQuery q = preparedQuery( QString("DELETE FROM %1 WHERE %2=:ingredient AND %3=:recipe")
+                                   .arg(inrec->tableName())
+                                   .arg(inrec->inRecIndexName())
+                                   .arg(inrec->recipeIndexName()) );
+   q.bindValue(":ingredient", ing->key());
+   q.bindValue(":recipe", rec->key());
+
+   if ( ! q.exec() ) {
+      throw QString("%1 : %2").arg(q.lastQuery()).arg(q.lastError().text());
+   }
+   q.finish();
+
+   indexUnlink( inrec->dbTable(), rec->key(), ing->key() );
+
+   disconnect( ing, nullptr, rec, nullptr );
+}
+
+void Database::unshareIngredients( Recipe* rec )
+{
+   // The newest version that uses an ingredient is the one edits go to, so
+   // that one can keep sharing. Everybody else needs a copy.
+   QList<NamedEntity*> shared;
+   foreach( Fermentable* ing, rec->fermentables() ) { if ( getParentRecipe(ing) != rec ) shared.append(ing); }
+   foreach( Hop* ing, rec->hops() )                 { if ( getParentRecipe(ing) != rec ) shared.append(ing); }
+   foreach( Misc* ing, rec->miscs() )               { if ( getParentRecipe(ing) != rec ) shared.append(ing); }
+   foreach( Yeast* ing, rec->yeasts() )             { if ( getParentRecipe(ing) != rec ) shared.append(ing); }
+
+   if ( shared.isEmpty() ) {
+      return;
+   }
+
+   beginTransaction();
+   try {
+      foreach( NamedEntity* ing, shared ) {
+         unlinkFromRecipe(rec, ing);
+         clone(rec, ing, QString(), QVariant());
+      }
+   }
+   catch (QString e) {
+      qCritical() << QString("%1 %2").arg(Q_FUNC_INFO).arg(e);
+      rollbackTransaction();
+      throw;
+   }
+   commitTransaction();
+}
+
+bool Database::isShared( NamedEntity const* ing )
+{
+   TableSchema* table = dbDefn->table( dbDefn->classNameToTable(ing->metaObject()->className()) );
+   TableSchema* inrec = dbDefn->table( table->inRecTable() );
+   bool ret = false;
+
+   if ( inrec == nullptr ) {
+      return ret;
+   }
+
+   // Every link of the indexed tables is in inRecipeIndex already
+   auto byRecipe = inRecipeIndex.constFind(inrec->dbTable());
+   if ( byRecipe != inRecipeIndex.constEnd() ) {
+      int users = 0;
+      foreach( QList<int> const& keys, byRecipe.value() ) {
+         if ( keys.contains(ing->key()) && ++users > 1 ) {
+            return true;
+         }
+      }
+      return ret;
+   }
+
+   // SELECT COUNT(*) FROM hop_in_recipe WHERE hop_id = :ingredient
+   QSqlQuery q = preparedQuery( QString("SELECT COUNT(*) FROM %1 WHERE %2=:ingredient")
+                                   .arg(inrec->tableName())
+                                   .arg(inrec->inRecIndexName()) );
+   q.bindValue(":ingredient", ing->key());
+
+   try {
+      if ( ! q.exec() )
+         throw QString("%1 : %2").arg(q.lastQuery()).arg(q.lastError().text());
+      if ( q.next() )
+         ret = q.value(0).toInt() > 1;
+   }
+   catch (QString e) {
+      qCritical() << QString("%1 %2").arg(Q_FUNC_INFO).arg(e);
+      q.finish();
+      throw;
+   }
+
+   q.finish();
+   return ret;
+}
+
 bool Database::wantsVersion(Recipe* rec)
 {
    bool ret = false;
 
    // if the user has said they don't want versioning, just return false
-   if ( ! Brewtarget::option("versioning", false).toBool() ) {
+   if ( ! OptionStore::instance().boolValue("versioning", false) ) {
       return ret;
    }
 
@@ -2104,7 +3380,7 @@ void Database::setAncestor(Recipe* descendant, Recipe* ancestor, bool transact)
    TableSchema* tbl = dbDefn->table(Brewtarget::RECTABLE);
 
    if ( transact ) {
-      sqlDatabase().transaction();
+      beginTransaction();
    }
 
    try {
@@ -2152,13 +3428,24 @@ void Database::setAncestor(Recipe* descendant, Recipe* ancestor, bool transact)
    }
    catch( QString e ) {
       if ( transact ) 
-         sqlDatabase().rollback();
+         rollbackTransaction();
       qCritical() << Q_FUNC_INFO << e;
       abort();
    }
-   sqlDatabase().commit();
 
-   // some housekeeping to keep my caches synced
+   // some housekeeping to keep my caches synced. ancestorOf has to wait for
+   // whoever owns the transaction, or a rollback would leave it pointing at a
+   // chain the db doesn't have
+   int const descendantKey = descendant->key();
+   int const ancestorKey = ancestor->key();
+   afterCommit( [this, descendantKey, ancestorKey]() {
+      ancestorOf.insert( descendantKey, ancestorKey );
+   });
+
+   if ( transact ) {
+      commitTransaction();
+   }
+
    ancestor->setCacheOnly(true);
    ancestor->setDisplay( ancestor == descendant );
    ancestor->setLocked( ancestor != descendant );
@@ -2169,7 +3456,7 @@ Recipe* Database::newRecipe(Recipe* other, bool ancestor)
 {
    Recipe* tmp;
 
-   sqlDatabase().transaction();
+   beginTransaction();
    try {
       tmp = copy<Recipe>(other, &allRecipes, true);
 
@@ -2195,11 +3482,11 @@ Recipe* Database::newRecipe(Recipe* other, bool ancestor)
    }
    catch (QString e) {
       qCritical() << QString("%1 %2").arg(Q_FUNC_INFO).arg(e);
-      sqlDatabase().rollback();
+      rollbackTransaction();
       throw;
    }
 
-   sqlDatabase().commit();
+   commitTransaction();
    emit changed( metaProperty("recipes"), QVariant() );
    emit createdSignal(tmp);
 
@@ -2215,7 +3502,7 @@ Style* Database::newStyle(Style* other)
    }
    catch (QString e) {
       qCritical() << QString("%1 %2").arg(Q_FUNC_INFO).arg(e);
-      sqlDatabase().rollback();
+      rollbackTransaction();
       throw;
    }
 
@@ -2234,7 +3521,7 @@ Style* Database::newStyle(QString name)
    }
    catch (QString e) {
       qCritical() << QString("%1 %2").arg(Q_FUNC_INFO).arg(e);
-      sqlDatabase().rollback();
+      rollbackTransaction();
       throw;
    }
 
@@ -2269,7 +3556,7 @@ Water* Database::newWater(Water* other)
    }
    catch (QString e) {
       qCritical() << QString("%1 %2").arg(Q_FUNC_INFO).arg(e);
-      sqlDatabase().rollback();
+      rollbackTransaction();
       throw;
    }
 
@@ -2291,7 +3578,7 @@ Salt* Database::newSalt(Salt* other)
    }
    catch (QString e) {
       qCritical() << QString("%1 %2").arg(Q_FUNC_INFO).arg(e);
-      sqlDatabase().rollback();
+      rollbackTransaction();
       throw;
    }
 
@@ -2306,7 +3593,7 @@ Yeast* Database::newYeast(Yeast* other, bool add_inventory)
    Yeast* tmp;
    add_inventory = add_inventory || other == nullptr;
 
-   sqlDatabase().transaction();
+   beginTransaction();
    try {
       if (other != nullptr) {
          tmp = copy(other, &allYeasts);
@@ -2322,11 +3609,11 @@ Yeast* Database::newYeast(Yeast* other, bool add_inventory)
    }
    catch (QString e) {
       qCritical() << QString("%1 %2").arg(Q_FUNC_INFO).arg(e);
-      sqlDatabase().rollback();
+      rollbackTransaction();
       throw;
    }
 
-   sqlDatabase().commit();
+   commitTransaction();
 
    if ( tmp ) {
       emit changed( metaProperty("yeasts"), QVariant() );
@@ -2426,49 +3713,290 @@ int Database::insertElement(NamedEntity * ins)
    }
 
    int key;
-   QSqlQuery q( sqlDatabase() );
-
    TableSchema* schema = dbDefn->table(ins->table());
    QString insertQ = schema->generateInsertProperties(Brewtarget::dbType());
    QStringList allProps = schema->allProperties();
 
-   qDebug() << Q_FUNC_INFO << "SQL:" << insertQ;
-   q.prepare(insertQ);
+   // The insert is the same for every row of the table, so prepare it once
+   // and just rebind the values
+   QSqlQuery q = preparedQuery(insertQ);
+
+   QString sqlParameters;
+   QTextStream sqlParametersConcat(&sqlParameters);
+   foreach (QString prop, allProps) {
+      QString pname = schema->propertyName(prop);
+      QVariant val_to_ins = ins->property(pname.toUtf8().data());
+
+      if ( ins->table() == Brewtarget::BREWNOTETABLE && prop == PropertyNames::BrewNote::brewDate ) {
+         val_to_ins = val_to_ins.toString();
+      }
+      // I've arranged it such that the bindings are on the property names. It simplifies a lot
+      q.bindValue( QString(":%1").arg(prop), val_to_ins);
+      sqlParametersConcat << QString(":%1").arg(prop) << " = " << val_to_ins.toString() << "\n\t";
+   }
+   qDebug() << Q_FUNC_INFO << "SQL Parameters: " << *sqlParametersConcat.string();
+
+   try {
+      if ( ! q.exec() ) {
+         throw QString("could not insert a record into %1: %2")
+               .arg(schema->tableName())
+               .arg(insertQ);
+      }
+
+      qDebug() << Q_FUNC_INFO << "Query succeeded";
+      key = q.lastInsertId().toInt();
+      q.finish();
+   }
+   catch (QString e) {
+      rollbackTransaction();
+      qCritical() << QString("%1 %2 %3").arg(Q_FUNC_INFO).arg(e).arg( q.lastError().text());
+      abort();
+   }
+   ins->m_key = key;
+   noteInserted(ins);
+
+   return key;
+}
+
+QSqlQuery Database::preparedQuery(QString const& sql)
+{
+   QSqlDatabase db = sqlDatabase();
+   QMutexLocker locker(&preparedQueriesMutex);
+   QHash<QString,QSqlQuery>& cache = preparedQueries[db.connectionName()];
+
+   if ( cache.contains(sql) ) {
+      preparedQueryHitCount.ref();
+      return cache.value(sql);
+   }
+
+   preparedQueryMissCount.ref();
+   qDebug() << Q_FUNC_INFO << "Preparing:" << sql;
+   QSqlQuery q(db);
+   if ( ! q.prepare(sql) ) {
+      // Don't cache it. The exec() will fail and the caller will report it
+      qCritical() << QString("%1 could not prepare %2: %3").arg(Q_FUNC_INFO).arg(sql).arg(q.lastError().text());
+      return q;
+   }
+   cache.insert(sql, q);
+   return q;
+}
+
+int Database::preparedQueryHits() const
+{
+   return preparedQueryHitCount.load();
+}
+
+int Database::preparedQueryMisses() const
+{
+   return preparedQueryMissCount.load();
+}
+
+void Database::beginTransaction()
+{
+   if ( ! bulkImport ) {
+      // sqlDatabase() writes anything queued before the transaction starts
+      sqlDatabase().transaction();
+      ++transactionDepth;
+   }
+}
+
+void Database::commitTransaction()
+{
+   if ( ! bulkImport ) {
+      sqlDatabase().commit();
+      if ( transactionDepth > 0 ) {
+         --transactionDepth;
+      }
+      if ( transactionDepth == 0 ) {
+         finishTransactionHooks(true);
+      }
+   }
+}
+
+void Database::rollbackTransaction()
+{
+   // We can't roll back part of the bulk transaction, so remember to roll back
+   // all of it when it ends
+   if ( bulkImport ) {
+      bulkImportFailed = true;
+   }
+   else {
+      sqlDatabase().rollback();
+      if ( transactionDepth > 0 ) {
+         --transactionDepth;
+      }
+      // A rollback takes the whole transaction with it, however deep we are
+      finishTransactionHooks(false);
+   }
+}
+
+void Database::afterCommit(std::function<void()> f)
+{
+   if ( bulkImport || transactionDepth > 0 ) {
+      commitHooks.append(f);
+   }
+   else {
+      f();
+   }
+}
+
+void Database::onRollback(std::function<void()> undo)
+{
+   // Outside a transaction the write is already permanent
+   if ( bulkImport || transactionDepth > 0 ) {
+      rollbackHooks.append(undo);
+   }
+}
+
+void Database::finishTransactionHooks(bool committed)
+{
+   // Take them first, since a hook may start a transaction of its own
+   QList< std::function<void()> > hooks = committed ? commitHooks : rollbackHooks;
+   commitHooks.clear();
+   rollbackHooks.clear();
+
+   if ( committed ) {
+      foreach( std::function<void()> const& f, hooks ) {
+         f();
+      }
+   }
+   else {
+      // Undo in the reverse order things were done
+      for ( int i = hooks.size() - 1; i >= 0; --i ) {
+         hooks.at(i)();
+      }
+   }
+}
+
+void Database::beginBulkImport()
+{
+   // It's a coding error to nest these
+   Q_ASSERT( ! bulkImport );
+
+   sqlDatabase().transaction();
+   bulkImport = true;
+   bulkImportFailed = false;
+   bulkInserted.clear();
+}
+
+bool Database::endBulkImport(bool success)
+{
+   Q_ASSERT( bulkImport );
+
+   bool committed = false;
+
+   bulkImport = false;
+
+   if ( success && ! bulkImportFailed ) {
+      committed = sqlDatabase().commit();
+      if ( ! committed ) {
+         qCritical() << QString("%1 could not commit: %2").arg(Q_FUNC_INFO).arg(sqlDatabase().lastError().text());
+      }
+   }
+
+   if ( ! committed ) {
+      sqlDatabase().rollback();
+   }
+   finishTransactionHooks(committed);
+
+   if ( ! committed ) {
+      // The rows are gone, so the objects we made for them have to go too.
+      // Newest first, so children go before their parents
+      for( int i = bulkInserted.size() - 1; i >= 0; --i ) {
+         forgetInserted(bulkInserted.at(i));
+      }
+   }
+
+   bulkInserted.clear();
+   bulkImportFailed = false;
+   return committed;
+}
 
-   QString sqlParameters;
-   QTextStream sqlParametersConcat(&sqlParameters);
-   foreach (QString prop, allProps) {
-      QString pname = schema->propertyName(prop);
-      QVariant val_to_ins = ins->property(pname.toUtf8().data());
+bool Database::isBulkImport() const
+{
+   return bulkImport;
+}
 
-      if ( ins->table() == Brewtarget::BREWNOTETABLE && prop == PropertyNames::BrewNote::brewDate ) {
-         val_to_ins = val_to_ins.toString();
-      }
-      // I've arranged it such that the bindings are on the property names. It simplifies a lot
-      q.bindValue( QString(":%1").arg(prop), val_to_ins);
-      sqlParametersConcat << QString(":%1").arg(prop) << " = " << val_to_ins.toString() << "\n\t";
+void Database::noteInserted(NamedEntity* ing)
+{
+   if ( bulkImport ) {
+      bulkInserted.append( BulkInsert{ ing, ing->table(), ing->key() } );
    }
-   qDebug() << Q_FUNC_INFO << "SQL Parameters: " << *sqlParametersConcat.string();
+}
 
-   try {
-      if ( ! q.exec() ) {
-         throw QString("could not insert a record into %1: %2")
-               .arg(schema->tableName())
-               .arg(insertQ);
-      }
+void Database::forgetInserted(BulkInsert const& ins)
+{
+   // Null if whoever made it has already deleted it. The hash entry still
+   // has to go, but there is nobody left to tell
+   NamedEntity* ing = ins.entity.data();
+   int key = ins.key;
 
-      qDebug() << Q_FUNC_INFO << "Query succeeded";
-      key = q.lastInsertId().toInt();
-      q.finish();
+   switch( ins.table ) {
+      case Brewtarget::BREWNOTETABLE:
+         allBrewNotes.remove(key);
+         if ( ing ) emit deletedSignal(qobject_cast<BrewNote*>(ing));
+         break;
+      case Brewtarget::EQUIPTABLE:
+         allEquipments.remove(key);
+         if ( ing ) emit deletedSignal(qobject_cast<Equipment*>(ing));
+         break;
+      case Brewtarget::FERMTABLE:
+         allFermentables.remove(key);
+         if ( ing ) emit deletedSignal(qobject_cast<Fermentable*>(ing));
+         break;
+      case Brewtarget::HOPTABLE:
+         allHops.remove(key);
+         if ( ing ) emit deletedSignal(qobject_cast<Hop*>(ing));
+         break;
+      case Brewtarget::INSTRUCTIONTABLE:
+         allInstructions.remove(key);
+         if ( ing ) emit deletedSignal(qobject_cast<Instruction*>(ing));
+         break;
+      case Brewtarget::MASHTABLE:
+         allMashs.remove(key);
+         if ( ing ) emit deletedSignal(qobject_cast<Mash*>(ing));
+         break;
+      case Brewtarget::MASHSTEPTABLE:
+         allMashSteps.remove(key);
+         if ( ing ) emit deletedSignal(qobject_cast<MashStep*>(ing));
+         break;
+      case Brewtarget::MISCTABLE:
+         allMiscs.remove(key);
+         if ( ing ) emit deletedSignal(qobject_cast<Misc*>(ing));
+         break;
+      case Brewtarget::RECTABLE:
+         allRecipes.remove(key);
+         // the key may well be handed out again
+         ancestorOf.remove(key);
+         if ( ing ) emit deletedSignal(qobject_cast<Recipe*>(ing));
+         break;
+      case Brewtarget::STYLETABLE:
+         allStyles.remove(key);
+         if ( ing ) emit deletedSignal(qobject_cast<Style*>(ing));
+         break;
+      case Brewtarget::WATERTABLE:
+         allWaters.remove(key);
+         if ( ing ) emit deletedSignal(qobject_cast<Water*>(ing));
+         break;
+      case Brewtarget::SALTTABLE:
+         allSalts.remove(key);
+         if ( ing ) emit deletedSignal(qobject_cast<Salt*>(ing));
+         break;
+      case Brewtarget::YEASTTABLE:
+         allYeasts.remove(key);
+         if ( ing ) emit deletedSignal(qobject_cast<Yeast*>(ing));
+         break;
+      default:
+         break;
    }
-   catch (QString e) {
-      sqlDatabase().rollback();
-      qCritical() << QString("%1 %2 %3").arg(Q_FUNC_INFO).arg(e).arg( q.lastError().text());
-      abort();
+
+   if ( ! ing ) {
+      return;
    }
-   ins->m_key = key;
 
-   return key;
+   // The key no longer means anything, and nothing else will delete it
+   ing->m_key = -1;
+   ing->deleteLater();
 }
 
 
@@ -2503,7 +4031,7 @@ int Database::insertEquipment(Equipment* ins)
 int Database::insertFermentable(Fermentable* ins)
 {
    int key;
-   sqlDatabase().transaction();
+   beginTransaction();
 
    try {
       key = insertElement(ins);
@@ -2518,7 +4046,7 @@ int Database::insertFermentable(Fermentable* ins)
       throw;
    }
 
-   sqlDatabase().commit();
+   commitTransaction();
    allFermentables.insert(key,ins);
    emit changed( metaProperty("fermentables"), QVariant() );
    emit createdSignal(ins);
@@ -2528,7 +4056,7 @@ int Database::insertFermentable(Fermentable* ins)
 int Database::insertHop(Hop* ins)
 {
    int key;
-   sqlDatabase().transaction();
+   beginTransaction();
 
    try {
       key = insertElement(ins);
@@ -2541,7 +4069,7 @@ int Database::insertHop(Hop* ins)
       throw;
    }
 
-   sqlDatabase().commit();
+   commitTransaction();
    allHops.insert(key,ins);
    emit changed( metaProperty("hops"), QVariant() );
    emit createdSignal(ins);
@@ -2552,7 +4080,7 @@ int Database::insertHop(Hop* ins)
 int Database::insertInstruction(Instruction* ins, Recipe* parent)
 {
    int key;
-   sqlDatabase().transaction();
+   beginTransaction();
 
    try {
       key = insertElement(ins);
@@ -2563,11 +4091,11 @@ int Database::insertInstruction(Instruction* ins, Recipe* parent)
    }
    catch (QString e) {
       qCritical() << QString("%1 %2").arg(Q_FUNC_INFO).arg(e);
-      sqlDatabase().rollback();
+      rollbackTransaction();
       throw;
    }
 
-   sqlDatabase().commit();
+   commitTransaction();
 
    allInstructions.insert(key,ins);
    emit changed( metaProperty("instructions"), QVariant() );
@@ -2602,7 +4130,7 @@ int Database::insertMashStep(MashStep* ins, Mash* parent)
                         .arg(parent->key());
    int key;
 
-   sqlDatabase().transaction();
+   beginTransaction();
    try {
       // we need to insert the mashstep into the db first to get the key
       key = insertElement(ins);
@@ -2622,11 +4150,11 @@ int Database::insertMashStep(MashStep* ins, Mash* parent)
    }
    catch (QString e) {
       qCritical() << QString("%1 %2").arg(Q_FUNC_INFO).arg(e);
-      sqlDatabase().rollback();
+      rollbackTransaction();
       throw;
    }
 
-   sqlDatabase().commit();
+   commitTransaction();
 
    allMashSteps.insert(key,ins);
    connect( ins, SIGNAL(changed(QMetaProperty,QVariant)), parent,
@@ -2641,7 +4169,7 @@ int Database::insertMashStep(MashStep* ins, Mash* parent)
 int Database::insertMisc(Misc* ins)
 {
    int key;
-   sqlDatabase().transaction();
+   beginTransaction();
 
    try {
       key = insertElement(ins);
@@ -2655,7 +4183,7 @@ int Database::insertMisc(Misc* ins)
       throw;
    }
 
-   sqlDatabase().commit();
+   commitTransaction();
    allMiscs.insert(key,ins);
    emit changed( metaProperty("miscs"), QVariant() );
    emit createdSignal(ins);
@@ -2678,7 +4206,7 @@ int Database::insertRecipe(Recipe* ins)
 int Database::insertYeast(Yeast* ins)
 {
    int key;
-   sqlDatabase().transaction();
+   beginTransaction();
 
    try {
       key = insertElement(ins);
@@ -2691,7 +4219,7 @@ int Database::insertYeast(Yeast* ins)
       throw;
    }
 
-   sqlDatabase().commit();
+   commitTransaction();
    allYeasts.insert(key,ins);
    emit changed( metaProperty("yeasts"), QVariant() );
    emit createdSignal(ins);
@@ -2733,7 +4261,7 @@ int Database::insertBrewNote(BrewNote* ins, Recipe* parent) {
 
    int key;
    TableSchema* tbl = dbDefn->table(Brewtarget::BREWNOTETABLE);
-   sqlDatabase().transaction();
+   beginTransaction();
 
    try {
       key = insertElement(ins);
@@ -2743,16 +4271,17 @@ int Database::insertBrewNote(BrewNote* ins, Recipe* parent) {
       QString const whereClause = QString("%1=%2").arg(tbl->keyName()).arg(key);
 
       sqlUpdate(Brewtarget::BREWNOTETABLE, setClause, whereClause);
+      indexBrewNote( parent->key(), key );
 
    }
    catch (QString e) {
       qCritical() << QString("%1 %2").arg(Q_FUNC_INFO).arg(e);
-      sqlDatabase().rollback();
+      rollbackTransaction();
       throw;
    }
 
    qDebug() << Q_FUNC_INFO << "DB update succeeded; key =" << key;
-   sqlDatabase().commit();
+   commitTransaction();
 
    this->allBrewNotes.insert(key,ins);
    emit changed( metaProperty("brewNotes"), QVariant() );
@@ -2812,7 +4341,7 @@ template<class T> T* Database::addNamedEntityToRecipe(
 
    // TRANSACTION BEGIN, but only if requested. Yeah. Had to go there.
    if ( transact ) {
-      sqlDatabase().transaction();
+      beginTransaction();
    }
 
    // Queries have to be created inside transactional boundaries
@@ -2828,25 +4357,33 @@ template<class T> T* Database::addNamedEntityToRecipe(
       table = dbDefn->table( dbDefn->classNameToTable(meta->className()) );
       child = dbDefn->table( table->childTable() );
       inrec = dbDefn->table( table->inRecTable() );
-      // Ensure this ingredient is not already in the recipe.
-      QString select = QString("SELECT %5 from %1 WHERE %2=%3 AND %5=%4")
-                           .arg(inrec->tableName())
-                           .arg(inrec->inRecIndexName())
-                           .arg(ing->key())
-                           .arg(reinterpret_cast<NamedEntity*>(rec)->key())
-                           .arg(inrec->recipeIndexName());
-      qDebug() << Q_FUNC_INFO << "NamedEntity in recipe search:" << select;
-      if (! q.exec(select) ) {
-         throw QString("Couldn't execute ingredient in recipe search: Query: %1 error: %2")
-            .arg(q.lastQuery()).arg(q.lastError().text());
+      // Ensure this ingredient is not already in the recipe. If we have the
+      // links in memory, there's no need to ask the db
+      if ( inRecipeIndex.contains(inrec->dbTable()) ) {
+         if ( inRecipeIndex.value(inrec->dbTable()).value(rec->key()).contains(ing->key()) ) {
+            throw QString("NamedEntity already exists in recipe." );
+         }
       }
+      else {
+         QString select = QString("SELECT %5 from %1 WHERE %2=%3 AND %5=%4")
+                              .arg(inrec->tableName())
+                              .arg(inrec->inRecIndexName())
+                              .arg(ing->key())
+                              .arg(reinterpret_cast<NamedEntity*>(rec)->key())
+                              .arg(inrec->recipeIndexName());
+         qDebug() << Q_FUNC_INFO << "NamedEntity in recipe search:" << select;
+         if (! q.exec(select) ) {
+            throw QString("Couldn't execute ingredient in recipe search: Query: %1 error: %2")
+               .arg(q.lastQuery()).arg(q.lastError().text());
+         }
 
-      // this probably should just be a warning, not a throw?
-      if ( q.next() ) {
-         throw QString("NamedEntity already exists in recipe." );
-      }
+         // this probably should just be a warning, not a throw?
+         if ( q.next() ) {
+            throw QString("NamedEntity already exists in recipe." );
+         }
 
-      q.finish();
+         q.finish();
+      }
 
       if ( noCopy ) {
          newIng = qobject_cast<T*>(ing);
@@ -2878,7 +4415,7 @@ template<class T> T* Database::addNamedEntityToRecipe(
                .arg(inrec->inRecIndexName(Brewtarget::dbType()))
                .arg(inrec->recipeIndexName());
 
-      q.prepare(insert);
+      q = preparedQuery(insert);
       q.bindValue(":ingredient", newIng->key());
       q.bindValue(":recipe", rec->key());
 
@@ -2888,6 +4425,11 @@ template<class T> T* Database::addNamedEntityToRecipe(
          throw QString("%2 : %1.").arg(q.lastQuery()).arg(q.lastError().text());
       }
 
+      // Keep the in-memory links in step with the db before anybody hears
+      // about the change. If whoever owns the transaction rolls it back, the
+      // entry goes too
+      indexLink( inrec->dbTable(), rec->key(), newIng->key() );
+
       emit rec->changed( rec->metaProperty(propName), QVariant() );
 
       q.finish();
@@ -2905,13 +4447,13 @@ template<class T> T* Database::addNamedEntityToRecipe(
           *   Else if fails due to a foreign key constrain.
           */
          int key = ing->key();
-         QString parentChildSql = QString("SELECT %1 FROM %2 WHERE %3=%4")
+         QString parentChildSql = QString("SELECT %1 FROM %2 WHERE %3=:child")
                .arg(child->parentIndexName())
                .arg(child->tableName())
-               .arg(child->childIndexName())
-               .arg(key);
-         q.prepare(parentChildSql);
-         qDebug() << QString("%1 Parent-Child find: %2").arg(Q_FUNC_INFO).arg(parentChildSql);
+               .arg(child->childIndexName());
+         q = preparedQuery(parentChildSql);
+         q.bindValue(":child", key);
+         qDebug() << QString("%1 Parent-Child find: %2 with %3").arg(Q_FUNC_INFO).arg(parentChildSql).arg(key);
          if (q.exec() && q.next()) {
             key = q.record().value(child->parentIndexName()).toInt();
          }
@@ -2922,7 +4464,7 @@ template<class T> T* Database::addNamedEntityToRecipe(
                .arg(child->parentIndexName())
                .arg(child->childIndexName());
 
-         q.prepare(insert);
+         q = preparedQuery(insert);
          q.bindValue(":parent", key);
          q.bindValue(":child", newIng->key());
 
@@ -2940,12 +4482,12 @@ template<class T> T* Database::addNamedEntityToRecipe(
       qCritical() << QString("%1 %2").arg(QString("Q_FUNC_INFO")).arg(e);
       q.finish();
       if ( transact )
-         sqlDatabase().rollback();
+         rollbackTransaction();
       throw;
    }
    q.finish();
    if ( transact )
-      sqlDatabase().commit();
+      commitTransaction();
 
    return newIng;
 }
@@ -3094,6 +4636,22 @@ bool Database::modifyEntry(NamedEntity* object, QString propName, QVariant value
       emit createdSignal(spawn);
       emit spawned(owner,spawn);
    }
+   else if ( owner && isShared(object) ) {
+      // An older version of the recipe still uses this, so it can't be
+      // changed in place. Give the owner its own copy and change that.
+      beginTransaction();
+      try {
+         unlinkFromRecipe(owner, object);
+         neClone = clone(owner, object, propName, value);
+      }
+      catch (QString e) {
+         qCritical() << QString("%1 %2").arg(Q_FUNC_INFO).arg(e);
+         rollbackTransaction();
+         throw;
+      }
+      commitTransaction();
+      noclone = false;
+   }
    else {
       // we don't want a version, or the ingredient isn't in a recipe
       neClone = object;
@@ -3119,49 +4677,140 @@ void Database::updateEntry( NamedEntity* object, QString propName, QVariant valu
       qCritical() << Q_FUNC_INFO << "Could not translate " << propName << " to a column name";
       throw  QString("Could not translate %1 to a column name").arg(propName);
    }
-   if ( transact )
-      sqlDatabase().transaction();
 
-   try {
-      QSqlQuery update( sqlDatabase() );
-      QString command = QString("UPDATE %1 set %2=:value where id=%3")
-                           .arg(schema->tableName())
-                           .arg(colName)
-                           .arg(object->key());
+   // Once it has been changed, it isn't ours to evict any more
+   pinLazy(object);
 
-      update.prepare( command );
-      update.bindValue(":value", value);
+   // Outside of a transaction, queue the write. Typing in a field or
+   // dragging a slider can update the same column many times a second, and
+   // there is no point in a commit for each one. Writes from other threads,
+   // or that are part of somebody's transaction, go straight through.
+   if ( transactionDepth == 0 && ! bulkImport && QThread::currentThread() == thread() ) {
+      QMutexLocker locker(&pendingWritesMutex);
+      PendingWrite write = { object->table(), object->key(), colName, value };
+      pendingWrites.insert( pendingWriteKey(object->table(), object->key(), colName), write );
+      if ( ! flushTimer->isActive() ) {
+         flushTimer->start();
+      }
+   }
+   else {
+      if ( transact )
+         beginTransaction();
 
-      if ( ! update.exec() )
-         throw QString("Could not update %1.%2 to %3: %4 %5")
-                  .arg( schema->tableName() )
-                  .arg( colName )
-                  .arg( value.toString() )
-                  .arg( update.lastQuery() )
-                  .arg( update.lastError().text() );
+      try {
+         writeEntry( schema, object->key(), colName, value );
+      }
+      catch (QString e) {
+         qCritical() << QString("%1 %2").arg(Q_FUNC_INFO).arg(e);
+         if ( transact )
+            rollbackTransaction();
+         abort();
+      }
 
-   }
-   catch (QString e) {
-      qCritical() << QString("%1 %2").arg(Q_FUNC_INFO).arg(e);
       if ( transact )
-         sqlDatabase().rollback();
-      abort();
+         commitTransaction();
    }
 
-   if ( transact )
-      sqlDatabase().commit();
-
    if ( notify )
       emit object->changed(mProp,value);
 
 }
 
+void Database::writeEntry( TableSchema* schema, int key, QString const& colName, QVariant const& value )
+{
+   // The key is bound, so there is one statement per column no matter how
+   // many objects (or keystrokes) we update
+   QString command = QString("UPDATE %1 set %2=:value where %3=:id")
+                        .arg(schema->tableName())
+                        .arg(colName)
+                        .arg(schema->keyName());
+
+   QSqlQuery update = preparedQuery( command );
+   update.bindValue(":value", value);
+   update.bindValue(":id", key);
+
+   if ( ! update.exec() )
+      throw QString("Could not update %1.%2 to %3: %4 %5")
+               .arg( schema->tableName() )
+               .arg( colName )
+               .arg( value.toString() )
+               .arg( update.lastQuery() )
+               .arg( update.lastError().text() );
+
+   update.finish();
+}
+
+QString Database::pendingWriteKey( Brewtarget::DBTable table, int key, QString const& colName )
+{
+   return QString("%1/%2/%3").arg(static_cast<int>(table)).arg(key).arg(colName);
+}
+
+void Database::flushPendingWrites()
+{
+   QHash<QString,PendingWrite> writes;
+
+   pendingWritesMutex.lock();
+   writes.swap(pendingWrites);
+   pendingWritesMutex.unlock();
+
+   if ( QThread::currentThread() == thread() ) {
+      flushTimer->stop();
+   }
+
+   if ( writes.isEmpty() ) {
+      return;
+   }
+
+   // sqlDatabase() would try to flush them again
+   flushingWrites = true;
+
+   // One transaction for the lot. If we are already in one, this just nests
+   try {
+      beginTransaction();
+      foreach( PendingWrite const& write, writes ) {
+         writeEntry( dbDefn->table(write.table), write.key, write.column, write.value );
+      }
+   }
+   catch (QString e) {
+      qCritical() << QString("%1 %2").arg(Q_FUNC_INFO).arg(e);
+      rollbackTransaction();
+      flushingWrites = false;
+      throw QString("could not write %1 queued updates: %2").arg(writes.size()).arg(e);
+   }
+
+   commitTransaction();
+   flushingWrites = false;
+   qDebug() << Q_FUNC_INFO << "Wrote" << writes.size() << "queued updates";
+}
+
+void Database::flushOnTimer()
+{
+   // Nobody to throw to from here. The objects still have the values, so
+   // say so and carry on
+   try {
+      flushPendingWrites();
+   }
+   catch (QString e) {
+      qCritical() << QString("%1 %2").arg(Q_FUNC_INFO).arg(e);
+   }
+}
+
 
 QVariant Database::get( Brewtarget::DBTable table, int key, QString col_name )
 {
    QSqlQuery q;
    TableSchema* tbl = dbDefn->table(table);
 
+   // If a write is still queued, the db doesn't have it yet
+   pendingWritesMutex.lock();
+   QHash<QString,PendingWrite>::const_iterator pending = pendingWrites.constFind( pendingWriteKey(table, key, col_name) );
+   if ( pending != pendingWrites.constEnd() ) {
+      QVariant queued = pending.value().value;
+      pendingWritesMutex.unlock();
+      return queued;
+   }
+   pendingWritesMutex.unlock();
+
    QString index = QString("%1_%2").arg(tbl->tableName()).arg(col_name);
 
    if ( ! selectSome.contains(index) ) {
@@ -3340,8 +4989,12 @@ int Database::newInventory(TableSchema* schema) {
    // inventory row for this element. So doesn't this just need an insert?
    // insert into hop_in_inventory DEFAULT VALUES
    QString queryString = QString("INSERT INTO %1 DEFAULT VALUES").arg(inv->tableName());
-   QSqlQuery q( queryString, sqlDatabase() );
+   QSqlQuery q = preparedQuery( queryString );
+   if ( ! q.exec() ) {
+      throw QString("Could not insert into %1: %2").arg(inv->tableName()).arg(q.lastError().text());
+   }
    newKey = q.lastInsertId().toInt();
+   q.finish();
 
    return newKey;
 }
@@ -3405,7 +5058,7 @@ Equipment* Database::addToRecipe( Recipe* rec, Equipment* e, bool noCopy, bool t
       return nullptr;
 
    if ( transact )
-      sqlDatabase().transaction();
+      beginTransaction();
 
    try {
       // Make a copy of equipment.
@@ -3421,14 +5074,14 @@ Equipment* Database::addToRecipe( Recipe* rec, Equipment* e, bool noCopy, bool t
    }
    catch (QString e ) {
       if ( transact )
-         sqlDatabase().rollback();
+         rollbackTransaction();
       throw;
    }
 
    // This is likely illadvised. But if you are telling me to not transact it,
    // it is up to you to commit the changes
    if ( transact ) {
-      sqlDatabase().commit();
+      commitTransaction();
    }
    // NOTE: need to disconnect the recipe's old equipment?
    connect( newEquip, &NamedEntity::changed, rec, &Recipe::acceptEquipChange );
@@ -3484,7 +5137,7 @@ QList<Fermentable*> Database::addToRecipe( Recipe* rec, QList<Fermentable*>ferms
       return rets;
 
    if ( transact ) {
-      sqlDatabase().transaction();
+      beginTransaction();
    }
 
    try {
@@ -3497,13 +5150,13 @@ QList<Fermentable*> Database::addToRecipe( Recipe* rec, QList<Fermentable*>ferms
    }
    catch ( QString e  ) {
       if ( transact ) {
-         sqlDatabase().rollback();
+         rollbackTransaction();
       }
       throw;
    }
 
    if ( transact ) {
-      sqlDatabase().commit();
+      commitTransaction();
       rec->recalcAll();
    }
    return rets;
@@ -3537,7 +5190,7 @@ Hop * Database::addToRecipe( Recipe* rec, Hop* hop, bool noCopy, bool transact )
       // it's slightly dirty pool to put this all in the try block. Sue me.
       connect( newHop, SIGNAL(changed(QMetaProperty,QVariant)), spawn, SLOT(acceptHopChange(QMetaProperty,QVariant)));
       if ( transact ) {
-         spawn->recalcIBU();
+         spawn->recalc(Recipe::RecalcIBU);
       }
       return newHop;
    }
@@ -3562,7 +5215,7 @@ QList<Hop*> Database::addToRecipe( Recipe* rec, QList<Hop*>hops, bool transact )
 
    Recipe *spawn = breed(rec);
    if ( transact ) {
-      sqlDatabase().transaction();
+      beginTransaction();
    }
 
    try {
@@ -3575,14 +5228,14 @@ QList<Hop*> Database::addToRecipe( Recipe* rec, QList<Hop*>hops, bool transact )
    catch (QString e) {
       qCritical() << QString("%1 %2").arg(Q_FUNC_INFO).arg(e);
       if ( transact ) {
-         sqlDatabase().rollback();
+         rollbackTransaction();
       }
       throw;
    }
 
    if ( transact ) {
-      sqlDatabase().commit();
-      rec->recalcIBU();
+      commitTransaction();
+      rec->recalc(Recipe::RecalcIBU);
    }
    return rets;
 }
@@ -3617,7 +5270,7 @@ Mash * Database::addToRecipe( Recipe* rec, Mash* m, bool noCopy, bool transact )
    TableSchema* tbl = dbDefn->table(Brewtarget::RECTABLE);
 
    if ( transact )
-      sqlDatabase().transaction();
+      beginTransaction();
    // Make a copy of mash.
    // Making a copy of the mash isn't enough. We need a copy of the mashsteps
    // too.
@@ -3635,12 +5288,12 @@ Mash * Database::addToRecipe( Recipe* rec, Mash* m, bool noCopy, bool transact )
    catch (QString e) {
       qCritical() << QString("%1 %2").arg(Q_FUNC_INFO).arg(e);
       if ( transact )
-         sqlDatabase().rollback();
+         rollbackTransaction();
       throw;
    }
 
    if ( transact ) {
-      sqlDatabase().commit();
+      commitTransaction();
    }
    connect( newMash, SIGNAL(changed(QMetaProperty,QVariant)), rec, SLOT(acceptMashChange(QMetaProperty,QVariant)));
    emit rec->changed( rec->metaProperty("mash"), NamedEntity::qVariantFromPtr(newMash) );
@@ -3680,7 +5333,7 @@ QList<Misc*> Database::addToRecipe( Recipe* rec, QList<Misc*>miscs, bool transac
       return rets;
 
    if ( transact )
-      sqlDatabase().transaction();
+      beginTransaction();
 
    Recipe* spawn = breed(rec);
    try {
@@ -3691,12 +5344,12 @@ QList<Misc*> Database::addToRecipe( Recipe* rec, QList<Misc*>miscs, bool transac
    catch (QString e) {
       qCritical() << QString("%1 %2").arg(Q_FUNC_INFO).arg(e);
       if ( transact ) {
-         sqlDatabase().rollback();
+         rollbackTransaction();
       }
       abort();
    }
    if ( transact ) {
-      sqlDatabase().commit();
+      commitTransaction();
       spawn->recalcAll();
    }
    return rets;
@@ -3759,7 +5412,7 @@ Style * Database::addToRecipe( Recipe* rec, Style* s, bool noCopy, bool transact
       return nullptr;
 
    if ( transact )
-      sqlDatabase().transaction();
+      beginTransaction();
 
    Recipe* spawn = breed(rec);
    try {
@@ -3773,12 +5426,12 @@ Style * Database::addToRecipe( Recipe* rec, Style* s, bool noCopy, bool transact
    catch (QString e) {
       qCritical() << QString("%1 %2").arg(Q_FUNC_INFO).arg(e);
       if ( transact )
-         sqlDatabase().rollback();
+         rollbackTransaction();
       abort();
    }
 
    if ( transact ) {
-      sqlDatabase().commit();
+      commitTransaction();
    }
    // Emit a changed signal.
    spawn->m_style_id = newStyle->key();
@@ -3797,8 +5450,7 @@ Yeast * Database::addToRecipe( Recipe* rec, Yeast* y, bool noCopy, bool transact
       connect( newYeast, SIGNAL(changed(QMetaProperty,QVariant)), spawn, SLOT(acceptYeastChange(QMetaProperty,QVariant)));
       if ( transact && ! noCopy )
       {
-         spawn->recalcOgFg();
-         spawn->recalcABV_pct();
+         spawn->recalc(Recipe::RecalcOgFg);
       }
       return newYeast;
    }
@@ -3818,7 +5470,7 @@ QList<Yeast*> Database::addToRecipe( Recipe* rec, QList<Yeast*>yeasts, bool tran
       return rets;
 
    if ( transact )
-      sqlDatabase().transaction();
+      beginTransaction();
 
    Recipe* spawn = breed(rec);
    try {
@@ -3832,14 +5484,13 @@ QList<Yeast*> Database::addToRecipe( Recipe* rec, QList<Yeast*>yeasts, bool tran
    catch (QString e) {
       qCritical() << QString("%1 %2").arg(Q_FUNC_INFO).arg(e);
       if ( transact )
-         sqlDatabase().rollback();
+         rollbackTransaction();
       abort();
    }
 
    if ( transact ) {
-      sqlDatabase().commit();
-      spawn->recalcOgFg();
-      spawn->recalcABV_pct();
+      commitTransaction();
+      spawn->recalc(Recipe::RecalcOgFg);
    }
 
    return rets;
@@ -3932,6 +5583,7 @@ template<class T> T* Database::replicant(NamedEntity const* object, QHash<int,T*
 
       newOne = new T(tbl, newRecord, newKey);
       keyHash->insert( newKey, newOne );
+      noteInserted(newOne);
    }
    catch (QString e) {
       qCritical() << QString("%1 %2").arg(Q_FUNC_INFO).arg(e);
@@ -3987,6 +5639,7 @@ template<class T> T* Database::copy( NamedEntity const* object, QHash<int,T*>* k
 
       newOne = new T(tbl, newRecord, newKey);
       keyHash->insert( newKey, newOne );
+      noteInserted(newOne);
    }
    catch (QString e) {
       qCritical() << QString("%1 %2").arg(Q_FUNC_INFO).arg(e);
@@ -4277,6 +5930,19 @@ void Database::updateDatabase(QString const& filename)
 
    QVariant btid, newid, oldid;
 
+   // A SQLite user db can do the whole thing in SQL
+   if ( Brewtarget::dbType() == Brewtarget::SQLITE ) {
+      try {
+         if ( mergeDefaultData(filename) )
+            return;
+      }
+      catch (QString e) {
+         qCritical() << QString("%1 %2").arg(Q_FUNC_INFO).arg(e);
+         abort();
+      }
+      qWarning() << QString("%1 could not attach %2, merging row by row").arg(Q_FUNC_INFO).arg(filename);
+   }
+
    try {
       // connect to the new database
       QString newCon("newSqldbCon");
@@ -4429,6 +6095,121 @@ void Database::updateDatabase(QString const& filename)
    }
 }
 
+bool Database::mergeDefaultData(QString const& filename)
+{
+   QElapsedTimer timer;
+   timer.start();
+
+   QSqlQuery q(sqlDatabase());
+
+   q.prepare("ATTACH DATABASE :file AS newdb");
+   q.bindValue(":file", filename);
+   if ( ! q.exec() ) {
+      qWarning() << QString("%1 %2").arg(Q_FUNC_INFO).arg(q.lastError().text());
+      return false;
+   }
+
+   int merged = 0;
+   beginTransaction();
+   try {
+      foreach ( TableSchema* tbl, dbDefn->baseTables() )
+      {
+         TableSchema* btTbl = dbDefn->btTable(tbl->dbTable());
+         // skip any table that doesn't have a bt_ table
+         if ( btTbl == nullptr ) {
+            continue;
+         }
+
+         QString btKey   = btTbl->keyName(Brewtarget::SQLITE);
+         QString btChild = btTbl->childIndexName(Brewtarget::SQLITE);
+
+         // Every bt row we ship that the user doesn't have yet, numbered from
+         // 1 in bt id order. Joined to the ingredient, so a bt row whose
+         // ingredient is missing doesn't throw the numbering off
+         QStringList sql = QStringList()
+            << "DROP TABLE IF EXISTS temp.merge_map"
+            << "CREATE TEMP TABLE merge_map (seq INTEGER PRIMARY KEY, bt_id INTEGER, new_id INTEGER)"
+            << QString("INSERT INTO temp.merge_map (bt_id, new_id) "
+                       "SELECT n.%1, n.%2 FROM newdb.%3 n JOIN newdb.%4 i ON i.%5 = n.%2 "
+                       "WHERE n.%1 NOT IN (SELECT %1 FROM main.%3) "
+                       "ORDER BY n.%1")
+                  .arg(btKey).arg(btChild).arg(btTbl->tableName())
+                  .arg(tbl->tableName()).arg(tbl->keyName(Brewtarget::SQLITE));
+         foreach( QString stmt, sql ) {
+            if ( ! q.exec(stmt) )
+               throw QString("%1 : %2").arg(stmt).arg(q.lastError().text());
+         }
+
+         QString countMap = "SELECT COUNT(*) FROM temp.merge_map";
+         if ( ! q.exec(countMap) || ! q.next() )
+            throw QString("%1 : %2").arg(countMap).arg(q.lastError().text());
+         int const mapped = q.value(0).toInt();
+         if ( mapped == 0 )
+            continue;
+
+         // Copy the ingredients over in the same order. Same columns
+         // generateInsertProperties() uses; deleted is always false. Both
+         // sides are SQLite, so the booleans don't need spelling out.
+         QStringList columns, values;
+         foreach( QString prop, tbl->allProperties() ) {
+            QString col = tbl->propertyToColumn(prop, Brewtarget::SQLITE);
+            columns.append(col);
+            if ( prop == PropertyNames::NamedEntity::deleted )
+               values.append(Brewtarget::dbFalse());
+            else
+               values.append(QString("n.%1").arg(col));
+         }
+
+         QString insertIngs = QString("INSERT INTO main.%1 (%2) "
+                                      "SELECT %3 FROM newdb.%1 n JOIN temp.merge_map m ON n.%4 = m.new_id "
+                                      "ORDER BY m.seq")
+                                 .arg(tbl->tableName())
+                                 .arg(columns.join(","))
+                                 .arg(values.join(","))
+                                 .arg(tbl->keyName(Brewtarget::SQLITE));
+         if ( ! q.exec(insertIngs) )
+            throw QString("%1 : %2").arg(insertIngs).arg(q.lastError().text());
+
+         // Every merge_map row has to have made exactly one ingredient, or the
+         // links below point at the wrong rows
+         int count = q.numRowsAffected();
+         if ( count != mapped )
+            throw QString("expected %1 new %2 rows, got %3").arg(mapped).arg(tbl->tableName()).arg(count);
+
+         // AUTOINCREMENT hands one INSERT ... SELECT consecutive ids, and
+         // nothing else can write while we hold the transaction. So the
+         // ingredient for merge_map row seq got first + seq - 1.
+         int last = q.lastInsertId().toInt();
+         int first = last - count + 1;
+
+         QString check = QString("SELECT COUNT(*) FROM main.%1 WHERE %2 BETWEEN %3 AND %4")
+                            .arg(tbl->tableName()).arg(tbl->keyName(Brewtarget::SQLITE)).arg(first).arg(last);
+         if ( ! q.exec(check) || ! q.next() || q.value(0).toInt() != count )
+            throw QString("ids for the new %1 rows are not consecutive").arg(tbl->tableName());
+
+         QString insertBt = QString("INSERT INTO main.%1 (%2,%3) SELECT bt_id, %4 + seq - 1 FROM temp.merge_map")
+                               .arg(btTbl->tableName()).arg(btKey).arg(btChild).arg(first);
+         if ( ! q.exec(insertBt) )
+            throw QString("%1 : %2").arg(insertBt).arg(q.lastError().text());
+
+         qDebug() << Q_FUNC_INFO << "merged" << count << "into" << tbl->tableName();
+         merged += count;
+      }
+
+      q.exec("DROP TABLE IF EXISTS temp.merge_map");
+      commitTransaction();
+   }
+   catch (QString e) {
+      rollbackTransaction();
+      q.exec("DETACH DATABASE newdb");
+      throw;
+   }
+
+   q.exec("DETACH DATABASE newdb");
+   qInfo() << QString("%1 merged %2 rows from %3 in %4 ms").arg(Q_FUNC_INFO).arg(merged).arg(filename).arg(timer.elapsed());
+   return true;
+}
+
 // updateDatabase is ugly enough. This takes 20-ish lines out of it that do
 // not really enhance understanding
 void Database::bindForUpdateDatabase(TableSchema* tbl, QSqlQuery qry, QSqlRecord rec)
@@ -4625,75 +6406,237 @@ QVariant Database::convertValue(Brewtarget::DBTypes newType, QSqlField field)
 void Database::copyDatabase( Brewtarget::DBTypes oldType, Brewtarget::DBTypes newType, QSqlDatabase newDb)
 {
    QSqlDatabase oldDb = sqlDatabase();
-   QSqlQuery readOld(oldDb);
+   QVector<TableSchema*> tables = dbDefn->allTables(true);
+
+   // Copy in waves: a table goes in the wave after the last table it has a
+   // foreign key to. Everything in a wave can be copied at once, and a wave
+   // is committed before the next one starts. Pointing at yourself (recipe
+   // ancestors) doesn't count; those rows go in id order, as they always did.
+   QHash<Brewtarget::DBTable,int> wave;
+   foreach( TableSchema* table, tables ) {
+      wave.insert(table->dbTable(), 0);
+   }
+   for( int pass = 0; pass < tables.size(); ++pass ) {
+      bool moved = false;
+      foreach( TableSchema* table, tables ) {
+         foreach( QString fkey, table->allForeignKeys() ) {
+            Brewtarget::DBTable parent = table->foreignTable(fkey, newType);
+            if ( parent == table->dbTable() || ! wave.contains(parent) )
+               continue;
+            if ( wave.value(table->dbTable()) <= wave.value(parent) ) {
+               wave[table->dbTable()] = wave.value(parent) + 1;
+               moved = true;
+            }
+         }
+      }
+      if ( ! moved )
+         break;
+   }
 
-   // There are a lot of tables to process, and we need to make
-   // sure the inventory tables go first
-   foreach( TableSchema* table, dbDefn->allTables(true) ) {
-      QString tname = table->tableName();
-      QSqlField field;
-      bool mustPrepare = true;
-      int maxid = -1;
-
-      // select * from [table] order by id asc
-      QString findAllQuery = QString("SELECT * FROM %1 order by %2 asc")
-                                 .arg(tname)
-                                 .arg(table->keyName(oldType)); // make sure we specify the right db type
-      qDebug() << Q_FUNC_INFO << "FIND ALL:" << findAllQuery;
-      try {
-         if (! readOld.exec(findAllQuery) ) {
-            throw QString("Could not execute %1 : %2")
-               .arg(readOld.lastQuery())
-               .arg(readOld.lastError().text());
+   QMap< int, QList<TableSchema*> > waves;
+   foreach( TableSchema* table, tables ) {
+      waves[wave.value(table->dbTable())].append(table);
+   }
+
+   // The writers each open their own connection to the new db
+   DbParams params;
+   params.driver   = newDb.driverName();
+   params.hostname = newDb.hostName();
+   params.dbName   = newDb.databaseName();
+   params.username = newDb.userName();
+   params.password = newDb.password();
+   params.port     = newDb.port();
+
+   QThreadPool pool;
+   // SQLite only takes one writer at a time, so more threads just wait on each other
+   pool.setMaxThreadCount( newType == Brewtarget::PGSQL ? qMax(2, QThread::idealThreadCount()) : 1 );
+
+   QElapsedTimer total;
+   total.start();
+
+   foreach( QList<TableSchema*> const& thisWave, waves ) {
+      // Every table in the wave gets a writer, fed through its own queue.
+      // The pool runs them in the order they are started, and the reads go
+      // in that order too, so a reader waiting on a full queue is always
+      // waiting on a writer that is running
+      QVector< QSharedPointer<CopyQueue> > queues;
+      QVector<QString> errors(thisWave.size());
+      for( int i = 0; i < thisWave.size(); ++i ) {
+         TableSchema* table = thisWave.at(i);
+         QSharedPointer<CopyQueue> queue(new CopyQueue(copyQueueBatches));
+         queues.append(queue);
+         pool.start(new FetchRunnable([this, table, newType, params, queue]() {
+                                         try {
+                                            writeRowsForCopy(table, newType, params, *queue);
+                                         }
+                                         catch (QString e) {
+                                            queue->abandon();
+                                            throw;
+                                         }
+                                      },
+                                      &errors[i]));
+      }
+
+      // The reads stay here, on the connection the old db was opened with
+      for( int i = 0; i < thisWave.size(); ++i ) {
+         try {
+            readRowsForCopy(thisWave.at(i), oldType, newType, oldDb, *queues.at(i));
+         }
+         catch (QString e) {
+            qCritical() << QString("%1 %2").arg(Q_FUNC_INFO).arg(e);
+            abort();
          }
+         queues.at(i)->close();
+      }
+      pool.waitForDone();
 
-         newDb.transaction();
+      for( int i = 0; i < thisWave.size(); ++i ) {
+         if ( ! errors.at(i).isEmpty() ) {
+            qCritical() << QString("%1 %2").arg(Q_FUNC_INFO).arg(errors.at(i));
+            abort();
+         }
+      }
+   }
+
+   qInfo() << QString("%1 copied %2 tables in %3 ms").arg(Q_FUNC_INFO).arg(tables.size()).arg(total.elapsed());
+}
+
+void Database::readRowsForCopy( TableSchema* table, Brewtarget::DBTypes oldType, Brewtarget::DBTypes newType,
+                                QSqlDatabase oldDb, CopyQueue& queue )
+{
+   QSqlQuery readOld(oldDb);
+   readOld.setForwardOnly(true);
+
+   // select * from [table] order by id asc
+   QString findAllQuery = QString("SELECT * FROM %1 order by %2 asc")
+                              .arg(table->tableName())
+                              .arg(table->keyName(oldType)); // make sure we specify the right db type
+   qDebug() << Q_FUNC_INFO << "FIND ALL:" << findAllQuery;
+   if (! readOld.exec(findAllQuery) ) {
+      throw QString("Could not execute %1 : %2")
+         .arg(readOld.lastQuery())
+         .arg(readOld.lastError().text());
+   }
+
+   // Work out once where each of the new columns lives in the old rows. The
+   // column lists come out of the schema in the same order for either db
+   QStringList oldColumns = table->insertColumnNames(oldType);
+   QVector<int> oldIndex(oldColumns.size());
+   QSqlRecord layout = readOld.record();
+   for( int i = 0; i < oldColumns.size(); ++i ) {
+      oldIndex[i] = layout.indexOf(oldColumns.at(i));
+   }
+
+   QVector<QVariantList> rows;
+   rows.reserve(copyBatchRows);
+
+   while( readOld.next() ) {
+      QSqlRecord here = readOld.record();
+      QVariantList values;
+      values.reserve(oldIndex.size());
+
+      foreach( int idx, oldIndex ) {
+         if ( idx == -1 ) {
+            values.append(QVariant());
+         }
+         else if ( table->dbTable() == Brewtarget::BREWNOTETABLE
+                   && here.fieldName(idx) == PropertyNames::BrewNote::brewDate ) {
+            values.append(QVariant(here.field(idx).value().toString()));
+         }
+         else {
+            values.append(convertValue(newType, here.field(idx)));
+         }
+      }
+      rows.append(values);
 
-         QSqlQuery upsertNew(newDb); // we will prepare this in a bit
+      if ( rows.size() >= copyBatchRows ) {
+         // The writer failed. It has the error to report
+         if ( ! queue.put(rows) )
+            return;
+         rows.clear();
+      }
+   }
 
-         // Start reading the records from the old db
-         while(readOld.next()) {
-            int idx;
-            QSqlRecord here = readOld.record();
-            QString upsertQuery;
+   if ( ! rows.isEmpty() )
+      queue.put(rows);
+}
 
-            idx = here.indexOf(table->keyName(oldType));
+void Database::writeRowsForCopy( TableSchema* table, Brewtarget::DBTypes newType, DbParams const& params,
+                                 CopyQueue& queue )
+{
+   int copied = 0;
+   QElapsedTimer timer;
+   timer.start();
 
-            // We are going to need this for resetting the indexes later. We only
-            // need it for copying to postgresql, but .. meh, not worth the extra
-            // work
-            if ( idx != -1 && here.value(idx).toInt() > maxid ) {
-               maxid = here.value(idx).toInt();
-            }
+   QString conName = QString("copy_%1").arg(table->tableName());
+   {
+      QSqlDatabase newDb = QSqlDatabase::addDatabase(params.driver, conName);
+      newDb.setHostName(params.hostname);
+      newDb.setDatabaseName(params.dbName);
+      newDb.setUserName(params.username);
+      newDb.setPassword(params.password);
+      newDb.setPort(params.port);
 
-            // Prepare the insert for this table if required
-            if ( mustPrepare ) {
-               upsertQuery = table->generateInsertRow(newType);
-               upsertNew.prepare(upsertQuery);
-               // but do it only once for this table
-               mustPrepare = false;
-            }
+      try {
+         if ( ! newDb.open() ) {
+            throw QString("Could not open %1 : %2").arg(params.dbName).arg(newDb.lastError().text());
+         }
 
-            qDebug() << Q_FUNC_INFO << "INSERT:" << upsertQuery;
-            // All that's left is to bind
-            for(int i = 0; i < here.count(); ++i) {
-               if ( table->dbTable() == Brewtarget::BREWNOTETABLE
-                    && here.fieldName(i) == PropertyNames::BrewNote::brewDate ) {
-                  QVariant helpme(here.field(i).value().toString());
-                  upsertNew.bindValue(":brewdate",helpme);
+         newDb.transaction();
+         QSqlQuery upsertNew(newDb);
+
+         // One INSERT carries many rows. Stay well inside the bound parameter
+         // limits: 65535 for postgres, 999 for older sqlite
+         int const columns = table->insertColumnNames(newType).size();
+         int const maxBindings = newType == Brewtarget::PGSQL ? 65535 : 999;
+         int const batchRows = qMax(1, qMin(500, maxBindings / qMax(1,columns)));
+
+         auto insertRows = [&](QSqlQuery& insert, QVector<QVariantList> const& rows, int first, int count) {
+            for( int r = first; r < first + count; ++r ) {
+               foreach( QVariant const& value, rows.at(r) ) {
+                  insert.addBindValue(value);
                }
-               else {
-                  upsertNew.bindValue(QString(":%1").arg(here.fieldName(i)),
-                                      convertValue(newType, here.field(i)));
+            }
+
+            if ( ! insert.exec() ) {
+               throw QString("Could not insert new rows %1 : %2")
+                  .arg(insert.lastQuery())
+                  .arg(insert.lastError().text());
+            }
+         };
+
+         // Prepared once for full batches, and once more at the end for
+         // whatever is left over
+         QSqlQuery fullBatch(newDb);
+         bool fullBatchPrepared = false;
+         QVector<QVariantList> pending;
+         QVector<QVariantList> batch;
+
+         while ( queue.take(batch) ) {
+            copied += batch.size();
+            pending += batch;
+
+            int first = 0;
+            for( ; pending.size() - first >= batchRows; first += batchRows ) {
+               if ( ! fullBatchPrepared ) {
+                  if ( ! fullBatch.prepare(table->generateInsertRows(batchRows, newType)) ) {
+                     throw QString("Could not prepare insert for %1 : %2").arg(table->tableName()).arg(fullBatch.lastError().text());
+                  }
+                  fullBatchPrepared = true;
                }
+               insertRows(fullBatch, pending, first, batchRows);
             }
-            // and execute
-            if ( ! upsertNew.exec() ) {
-               throw QString("Could not insert new row %1 : %2")
-                  .arg(upsertNew.lastQuery())
-                  .arg(upsertNew.lastError().text());
+            pending.remove(0, first);
+         }
+
+         if ( ! pending.isEmpty() ) {
+            QSqlQuery tail(newDb);
+            if ( ! tail.prepare(table->generateInsertRows(pending.size(), newType)) ) {
+               throw QString("Could not prepare insert for %1 : %2").arg(table->tableName()).arg(tail.lastError().text());
             }
+            insertRows(tail, pending, 0, pending.size());
          }
+
          // We need to create the increment and decrement things for the
          // instructions_in_recipe table. This seems a little weird to do this
          // here, but it makes sense to wait until after we've inserted all
@@ -4733,14 +6676,29 @@ void Database::copyDatabase( Brewtarget::DBTypes oldType, Brewtarget::DBTypes ne
                throw QString("Could not reset the sequences: %1 %2")
                   .arg(seq).arg(upsertNew.lastError().text());
          }
+
+         if ( ! newDb.commit() ) {
+            throw QString("Could not commit %1 : %2").arg(table->tableName()).arg(newDb.lastError().text());
+         }
       }
       catch (QString e) {
-         qCritical() << QString("%1 %2").arg(Q_FUNC_INFO).arg(e);
          newDb.rollback();
-         abort();
+         newDb.close();
+         newDb = QSqlDatabase();
+         QSqlDatabase::removeDatabase(conName);
+         throw;
       }
 
-      newDb.commit();
+      newDb.close();
    }
+   QSqlDatabase::removeDatabase(conName);
+
+   qint64 ms = qMax<qint64>(1, timer.elapsed());
+   qInfo() << QString("%1 copied %2 rows of %3 in %4 ms (%5 rows/s)")
+              .arg(Q_FUNC_INFO)
+              .arg(copied)
+              .arg(table->tableName())
+              .arg(ms)
+              .arg(copied * 1000 / ms);
 }
 
@@ -47,6 +47,13 @@ class Database;
 #include <QDebug>
 #include <QRegExp>
 #include <QMap>
+#include <QSet>
+#include <QPointer>
+#include <QVector>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QSemaphore>
+#include <QThreadStorage>
 #include "model/NamedEntity.h"
 #include "brewtarget.h"
 #include "model/Recipe.h"
@@ -69,6 +76,8 @@ class Style;
 class Water;
 class Yeast;
 class QThread;
+class QTimer;
+class DatabaseBackup;
 
 /*!
  * \class Database
@@ -95,9 +104,36 @@ class Database : public QObject
    Q_OBJECT
 
    friend class BeerXML;
+   friend class DatabaseBackup;
 
 public:
 
+   /*!
+    * \brief Checks out a database connection for the calling thread and
+    * gives it back when it goes out of scope.
+    *
+    * Put one of these around any database work done off the GUI thread.
+    * They nest, and a thread gets the same connection however deep it goes.
+    * No more than maxWorkerConnections() worker connections are open at
+    * once; past that, the constructor waits for one to come back and throws
+    * a QString if none does. On the GUI thread this does nothing.
+    */
+   class ConnectionLease
+   {
+   public:
+      ConnectionLease();
+      ~ConnectionLease();
+
+      ConnectionLease(ConnectionLease const&) = delete;
+      ConnectionLease& operator=(ConnectionLease const&) = delete;
+
+      //! \brief The leased connection
+      QSqlDatabase database() const;
+   };
+
+   //! \brief How many connections the threads other than the GUI thread may have open at once
+   static int maxWorkerConnections();
+
    //! This should be the ONLY way you get an instance.
    static Database& instance();
    //! Call this to delete the internal instance.
@@ -113,6 +149,16 @@ public:
    //! backs up database to chosen file
    static bool backupToFile(QString newDbFileName);
 
+   /*!
+    * \brief Starts an online backup to \c target, and returns without
+    * waiting for it.
+    *
+    * Watch the returned object's progress() and finished() signals. It
+    * belongs to the Database, so don't delete it; it deletes itself when it
+    * is done. Returns nullptr if the backup could not be started.
+    */
+   DatabaseBackup* startBackup(QString const& target, bool compress = false);
+
    //! backs up database to 'dir' in chosen directory
    static bool backupToDir(QString dir, QString filename="");
 
@@ -138,6 +184,30 @@ public:
 
    QVariant get( TableSchema* tbl, int key, QString col_name );
 
+   /*!
+    * \brief Puts everything up to endBulkImport() into one transaction.
+    *
+    * Without this, importing a big BeerXML file commits (and syncs) after
+    * every ingredient. While a bulk import is running, the transactions the
+    * insert and addToRecipe methods start for themselves are folded into
+    * the bulk one, and each table's insert statement is prepared only once.
+    */
+   void beginBulkImport();
+   /*!
+    * \brief Ends the bulk import started by beginBulkImport()
+    *
+    * \param success false to roll the whole import back. We also roll back
+    *        if anything inside the import asked for a rollback.
+    * \returns true if the import was committed
+    */
+   bool endBulkImport(bool success);
+   bool isBulkImport() const;
+
+   //! \brief How often preparedQuery() found the statement already prepared
+   int preparedQueryHits() const;
+   //! \brief How often preparedQuery() had to prepare the statement
+   int preparedQueryMisses() const;
+
    //! Get a table view.
    QTableView* createView( Brewtarget::DBTable table );
 
@@ -311,6 +381,13 @@ public:
    QList<Misc*> addToRecipe(Recipe *rec, QList<Misc*> miscs, Misc* exclude, bool transact = true );
    QList<Yeast*> addToRecipe(Recipe *rec, QList<Yeast*> yeasts, Yeast* exclude, bool transact = true );
 
+   /*!
+    * \brief Puts a shared ingredient back into \c rec without copying it, eg
+    * when undoing its removal while an older version still has it. Throws a
+    * QString on failure
+    */
+   NamedEntity* relinkToRecipe( Recipe* rec, NamedEntity* ing );
+
    /**
    * \brief  This function is intended to be called by an ingredient that has not already cached its parent's key
    * \return Key of parent ingredient if there is one, 0 otherwise
@@ -411,6 +488,18 @@ public:
    void swapInstructionOrder(Instruction* in1, Instruction* in2);
    //! Insert an instruction (already in a recipe) into position \b pos.
    void insertInstruction(Instruction* in, int pos);
+   /*!
+    * \brief Makes \c generated the instructions of \c rec, in one transaction.
+    *
+    * \c generated are cache-only instructions, in order. They are lined up
+    * with the existing ones by name and directions first, and by position
+    * only between two matches (see alignInstructions()). A match is kept,
+    * and stays completed if it was; a positional pair is rewritten in place.
+    * Existing instructions left over are removed, and generated ones left
+    * over are added with one multi-row INSERT. Added instructions are taken
+    * over by the database; the rest of \c generated are deleted.
+    */
+   void replaceInstructions(Recipe* rec, QList<Instruction*> generated);
    //! \brief The instruction number of an instruction.
    int instructionNumber(Instruction const* in);
 
@@ -497,6 +586,13 @@ public:
     * database file.
     */
    void updateDatabase(QString const& filename);
+   /*!
+    * \brief updateDatabase() for a SQLite user db: ATTACHes \c filename and
+    * merges each table with one INSERT ... SELECT, all in one transaction.
+    * Returns false if \c filename could not be attached, in which case
+    * nothing was changed. Throws a QString if the merge itself fails.
+    */
+   bool mergeDefaultData(QString const& filename);
    //!brief convenience method for use by updateDatabase
    void bindForUpdateDatabase(TableSchema* tbl, QSqlQuery qry, QSqlRecord rec);
    void convertFromXml();
@@ -504,6 +600,13 @@ public:
    bool isConverted();
    bool wantsVersion(Recipe* rec);
    void setAncestor(Recipe* descendant, Recipe* ancestor, bool transact = true);
+   /*!
+    * \brief Gives \c rec its own copy of every ingredient it shares with a
+    * newer version. Edits to a shared ingredient go to the newest version,
+    * so an older one has to stop sharing before it can be edited. Throws a
+    * QString on failure
+    */
+   void unshareIngredients(Recipe* rec);
 
    Recipe* breed(Recipe* parent);
    Recipe* copyRecipeExcept(Recipe *other, NamedEntity* except);
@@ -519,6 +622,18 @@ public:
 
    BeerXML* getBeerXml() { return m_beerxml; }
 
+public slots:
+   /*!
+    * \brief Writes everything updateEntry() has queued, in one transaction.
+    *
+    * Runs on a short timer after the first queued write, from unload(), and
+    * from sqlDatabase() before anything else on the GUI thread touches the
+    * db. Call it yourself after a burst of changes (eg scaling a recipe) so
+    * they go out as one commit. Throws a QString on failure; the writes that
+    * failed are dropped.
+    */
+   void flushPendingWrites();
+
 signals:
    void changed(QMetaProperty prop, QVariant value);
 
@@ -560,6 +675,8 @@ signals:
 private slots:
    //! Load database from file.
    bool load();
+   //! flushPendingWrites() for flushTimer, which can't catch
+   void flushOnTimer();
 
 private:
    static Database* dbInstance; // The singleton object
@@ -582,9 +699,46 @@ private:
    static QString dbUsername;
    static QString dbPassword;
 
-   // Each thread should have its own connection to QSqlDatabase.
-   static QHash< QThread*, QString > _threadToConnection;
-   static QMutex _threadToConnectionMutex;
+   /*!
+    * \brief One worker thread's connection.
+    *
+    * Qt won't let a connection be used from any thread but the one that
+    * opened it, so the pool hands out slots rather than connections: each
+    * worker opens its own, and closes it when the last lease ends or, if it
+    * never took a lease, when the thread exits.
+    */
+   struct WorkerConnection {
+      QString name;
+      QSqlDatabase db;
+      int leases;
+      //! Which pool the slot came from. A slot from before the last unload() isn't handed back
+      int poolGeneration;
+
+      ~WorkerConnection();
+   };
+
+   // The GUI thread does nearly all the work. Its connection is opened by
+   // load() and handed out without any locking
+   static QThread* guiThread;
+   static QSqlDatabase guiConnection;
+
+   // Everybody else goes through the pool. workerConnections deletes each
+   // thread's WorkerConnection on that thread as it exits
+   static QThreadStorage<WorkerConnection*> workerConnections;
+   static QSemaphore workerConnectionSlots;
+   static QAtomicInt workerConnectionSerial;
+   static QAtomicInt workerPoolGeneration;
+   //! Names of the open worker connections, so unload() can find any left behind
+   static QSet<QString> openWorkerConnections;
+   static QMutex openWorkerConnectionsMutex;
+   static int const workerConnectionWaitMs = 30000;
+
+   //! Opens a new connection called \c conName with the current settings. Throws a QString on failure
+   static QSqlDatabase openConnection(QString const& conName);
+   //! The calling thread's WorkerConnection, opening it if need be. Throws a QString on failure
+   static WorkerConnection* workerConnection();
+   //! Closes \c conName and drops its prepared queries
+   static void closeConnection(QString const& conName);
 
    // Instance variables.
    bool loadWasSuccessful;
@@ -612,15 +766,204 @@ private:
    QHash< int, Yeast* > allYeasts;
    QHash<QString,QSqlQuery> selectSome;
 
-   //! Get the right database connection for the calling thread.
+   // Bulk import state. See beginBulkImport()
+   bool bulkImport;
+   bool bulkImportFailed;
+   //! An entity made during the bulk import. The key and table outlive the entity if somebody else deletes it
+   struct BulkInsert {
+      QPointer<NamedEntity> entity;
+      Brewtarget::DBTable table;
+      int key;
+   };
+   //! Everything insertElement(), copy() or replicant() made during the bulk import, in case it has to be rolled back
+   QList<BulkInsert> bulkInserted;
+
+   /*!
+    * Prepared statements for the writes, keyed by connection name and then
+    * by the SQL. See preparedQuery()
+    */
+   QHash< QString, QHash<QString,QSqlQuery> > preparedQueries;
+   QMutex preparedQueriesMutex;
+   QAtomicInt preparedQueryHitCount;
+   QAtomicInt preparedQueryMissCount;
+
+   //! A write updateEntry() has queued but not done yet. See flushPendingWrites()
+   struct PendingWrite {
+      Brewtarget::DBTable table;
+      int key;
+      QString column;
+      QVariant value;
+   };
+   //! Keyed by pendingWriteKey(), so repeated writes to one column just replace each other
+   QHash< QString, PendingWrite > pendingWrites;
+   QMutex pendingWritesMutex;
+   QTimer* flushTimer;
+   static int const flushIntervalMs = 250;
+   //! How many of our own transactions are open. Writes inside one aren't queued
+   int transactionDepth;
+   //! True while flushPendingWrites() runs, so sqlDatabase() doesn't call it again
+   bool flushingWrites;
+   //! See afterCommit() and onRollback()
+   QList< std::function<void()> > commitHooks;
+   QList< std::function<void()> > rollbackHooks;
+
+   /*!
+    * In-memory copy of the *_in_recipe tables, keyed by the _in_recipe table
+    * and then by recipe key. Each value holds the ingredient keys in the order
+    * they were added. Instructions are not in here, because their order is
+    * maintained by the database triggers.
+    */
+   QMap< Brewtarget::DBTable, QHash< int, QList<int> > > inRecipeIndex;
+
+   /*!
+    * \brief Each recipe's ancestor_id, so ancestoralIds() can walk a chain of
+    * versions in memory. Filled from the recipe rows by load(), kept up by
+    * setAncestor() and topped up from the db by ancestorIdOf() for recipes
+    * made since.
+    */
+   QHash<int,int> ancestorOf;
+
+   /*!
+    * \brief The brewnote keys of each recipe, oldest first, so brewNotes()
+    * can find them without asking the db. Filled from the brewnote rows by
+    * load() and kept up by newBrewNote() and insertBrewNote().
+    */
+   QHash< int, QList<int> > brewNotesOf;
+
+   /*!
+    * \brief Lazy loading.
+    *
+    * Rows that are soft deleted or hidden are rarely looked at again, but
+    * they pile up: every ingredient ever removed from a recipe is still in
+    * the db, and every ingredient in a recipe is a hidden copy. When lazyLoad
+    * is on, load() only notes their keys in \c lazyKeys, and materialize()
+    * makes the entity the first time somebody asks for it, and connects it
+    * the way load() would have.
+    *
+    * Entities made that way are kept in \c lazyLru, most recently used
+    * first. Once there are more than lazyCacheSize of them, the least recently
+    * used are evicted and go back to being a key in \c lazyKeys. Anything
+    * that gets written to, or that something is still connected to, is
+    * pinned: it is taken out of \c lazyLru and stays in memory like
+    * everything else.
+    */
+   bool lazyLoad;
+   QMap< Brewtarget::DBTable, QSet<int> > lazyKeys;
+   QList< QPointer<NamedEntity> > lazyLru;
+   static int const lazyCacheSize = 100;
+   //! How many lazy rows materializeAll() asks for in one query
+   static int const materializeBatchSize = 500;
+   bool evictionScheduled;
+
+   /*!
+    * \brief Get the right database connection for the calling thread.
+    *
+    * Off the GUI thread this takes a pool slot that is only given back when
+    * the thread exits. Hold a ConnectionLease instead where you can. Throws
+    * a QString if the database isn't loaded.
+    */
    static QSqlDatabase sqlDatabase();
 
+   /*!
+    * \brief Gets a prepared query for \c sql on the calling thread's
+    * connection, preparing it only the first time it is asked for.
+    *
+    * \c sql should only vary by table and column. Anything that changes from
+    * call to call (keys, values) has to be a bound parameter, or the cache
+    * will just fill up. Call finish() on the query when you are done with it.
+    */
+   QSqlQuery preparedQuery(QString const& sql);
+
+   //! \brief Does the actual UPDATE for updateEntry() and flushPendingWrites(). Throws a QString on failure
+   void writeEntry( TableSchema* schema, int key, QString const& colName, QVariant const& value );
+   static QString pendingWriteKey( Brewtarget::DBTable table, int key, QString const& colName );
+   /*!
+    * \brief For each of \c generated, the index of the existing instruction
+    * that becomes it, or -1 for a new one. The longest run of steps with the
+    * same name and directions, in order, is matched first. What is left
+    * between two matches is paired up by position.
+    */
+   static QVector<int> alignInstructions( QList<Instruction*> const& existing, QList<Instruction*> const& generated );
+
+   //! \brief Use these instead of sqlDatabase().transaction() etc, so a bulk import can swallow them
+   void beginTransaction();
+   void commitTransaction();
+   void rollbackTransaction();
+   /*!
+    * \brief Runs \c f once the transaction we are in commits, or now if we
+    * aren't in one. Dropped if it rolls back instead.
+    */
+   void afterCommit(std::function<void()> f);
+   /*!
+    * \brief Runs \c undo if the transaction we are in rolls back. Use it for
+    * in-memory state that has to be right before the commit
+    */
+   void onRollback(std::function<void()> undo);
+   //! \brief Runs or drops the hooks once the outermost transaction is done
+   void finishTransactionHooks(bool committed);
+   //! \brief Notes \c ing, if it was made during a bulk import, so endBulkImport() can undo it
+   void noteInserted(NamedEntity* ing);
+   //! \brief Removes an entity whose insert was rolled back from the all* hashes, and deletes it
+   void forgetInserted(BulkInsert const& ins);
+
+   //! Links \c ing to \c rec without copying it, so versions can share what they didn't change. Throws a QString on failure
+   void linkToRecipe( Recipe* rec, NamedEntity* ing );
+   //! Drops the link between \c ing and \c rec, and leaves \c ing alone. Throws a QString on failure
+   void unlinkFromRecipe( Recipe* rec, NamedEntity* ing );
+   //! True if more than one recipe (ie, more than one version) uses \c ing
+   bool isShared( NamedEntity const* ing );
+
    //! Helper to populate all* hashes. T should be a NamedEntity subclass.
    template <class T> void populateElements( QHash<int,T*>& hash, Brewtarget::DBTable table );
+   //! Reads every row of \c table into \c records. Safe to call from any thread. Throws a QString on failure
+   void fetchRecords( Brewtarget::DBTable table, QVector<QSqlRecord>& records );
+   //! Makes the entities for rows read by fetchRecords(). Must be called on the thread that owns the db
+   template <class T> void buildElements( QHash<int,T*>& hash, Brewtarget::DBTable table,
+                                          QVector<QSqlRecord> const& records );
+   //! Reads all the tables in parallel, fills the all* hashes and connects the children to their parents
+   void populateAllElements();
+
+   /*!
+    * \brief Looks \c key up in \c hash, making the entity from the db if it
+    * was left out by a lazy load. Returns nullptr if there is no such row.
+    */
+   template <class T> T* materialize( QHash<int,T*>& hash, int key );
+   //! The ancestor_id of recipe \c key, from ancestorOf if we have it and the db if we don't
+   int ancestorIdOf(int key);
+   //! Adds a brewnote to brewNotesOf, and takes it out again if the transaction rolls back
+   void indexBrewNote( int recKey, int noteKey );
+   //! materialize() for every lazy entity in \c keys, a batch at a time instead of a row at a time
+   template <class T> void materializeAll( QHash<int,T*>& hash, QList<int> const& keys );
+   //! Runs evictLazy() from the event loop, once whoever asked has had a chance to connect
+   void scheduleEviction();
+   //! Evicts the least recently used lazy entities until there are no more than lazyCacheSize
+   void evictLazy();
+   //! Keeps \c ing in memory for good. Called before anything writes to it
+   void pinLazy( NamedEntity const* ing );
+   //! Connects a fermentable, hop or yeast to the recipe that uses it
+   void connectIngredient( NamedEntity* ing, Recipe* rec );
+   //! Connects \c rec to its equipment, mash and ingredients, where they are in memory. \c row is its row
+   void connectRecipe( Recipe* rec, QSqlRecord const& row );
+   //! Connects \c step to its mash, if that is in memory. \c row is its row
+   void connectMashStep( MashStep* step, QSqlRecord const& row );
+   //! Connects a materialized entity to whatever in memory load() would have connected it to
+   void connectToOwners( NamedEntity* ing, QSqlRecord const& row );
+   //! The keys of the rows in \c table where \c column is \c value. Throws a QString on failure
+   QList<int> keysWhere( Brewtarget::DBTable table, QString const& column, int value );
+
+   //! Reads the *_in_recipe tables into inRecipeIndex. Done once, from load()
+   void populateInRecipeIndex();
+   //! Adds/removes one link in inRecipeIndex, and puts it back if the transaction rolls back
+   void indexLink( Brewtarget::DBTable inRecTable, int recKey, int ingKey );
+   void indexUnlink( Brewtarget::DBTable inRecTable, int recKey, int ingKey );
+
+   //! Helper to get the ingredients of a recipe from inRecipeIndex instead of the db
+   template <class T> QList<T*> getIndexedElements( Brewtarget::DBTable inRecTable, Recipe const* parent,
+                                                    QHash<int,T*>& allElements );
 
    //! we search by name enough that this is actually not a bad idea
    // Although this is private, it needs to be defined in the header as it's called from BeerXML
-   template <class T> bool getElementsByName( QList<T*>& list, Brewtarget::DBTable table, QString name, QHash<int,T*> allElements, QString id=QString("") )
+   template <class T> bool getElementsByName( QList<T*>& list, Brewtarget::DBTable table, QString name, QHash<int,T*>& allElements, QString id=QString("") )
    {
       QSqlQuery q(sqlDatabase());
       TableSchema* tbl = dbDefn->table( table );
@@ -652,8 +995,9 @@ private:
       while( q.next() )
       {
          int key = q.record().value("id").toInt();
-         if( allElements.contains(key) )
-            list.append( allElements[key] );
+         T* e = materialize(allElements, key);
+         if( e != nullptr )
+            list.append( e );
       }
 
       q.finish();
@@ -662,7 +1006,7 @@ private:
 
    //! Helper to populate the list using the given filter.
    template <class T> bool getElements( QList<T*>& list, QString filter, Brewtarget::DBTable table,
-                                        QHash<int,T*> allElements, QString id=QString() );
+                                        QHash<int,T*>& allElements, QString id=QString() );
 
 
    //! Hidden constructor.
@@ -767,7 +1111,35 @@ private:
 
    //! \brief does the heavy lifting to copy the contents from one db to the next
    void copyDatabase( Brewtarget::DBTypes oldType, Brewtarget::DBTypes newType, QSqlDatabase oldDb);
+
+   //! \brief What a copyDatabase() writer needs to open its own connection to the new db
+   struct DbParams {
+      QString driver;
+      QString hostname;
+      QString dbName;
+      QString username;
+      QString password;
+      int port;
+   };
+   //! \brief Bounded queue of row batches between the copyDatabase() reader and one writer
+   class CopyQueue;
+   //! How many rows the copyDatabase() reader hands over at a time
+   static int const copyBatchRows = 500;
+   //! How many batches can wait for one writer before the reader stops reading
+   static int const copyQueueBatches = 4;
+   /*!
+    * \brief Reads \c table from \c oldDb, converted and in
+    * insertColumnNames() order, and puts it on \c queue in batches.
+    * Doesn't close \c queue. Throws a QString on failure
+    */
+   void readRowsForCopy( TableSchema* table, Brewtarget::DBTypes oldType, Brewtarget::DBTypes newType,
+                         QSqlDatabase oldDb, CopyQueue& queue );
+   //! \brief Writes what comes off \c queue to \c table in the new db with multi-row INSERTs. Safe on any thread. Throws a QString on failure
+   void writeRowsForCopy( TableSchema* table, Brewtarget::DBTypes newType, DbParams const& params,
+                          CopyQueue& queue );
    void automaticBackup();
+   //! The last backup startBackup() handed out, if it is still going. unload() waits for it
+   QPointer<DatabaseBackup> runningBackup;
 
 };
 
@@ -33,6 +33,7 @@
 #include "xml/BeerXml.h"
 #include "brewtarget.h"
 #include "database.h"
+#include "OptionStore.h"
 
 void importFromXml(const QString & filename);
 void createBlankDb(const QString & filename);
@@ -119,16 +120,31 @@ int main(int argc, char **argv)
     * from QSettings.
     */
    const QCommandLineOption userDirectoryOption("user-dir", "Overwrite the directory used by the application with <directory>", "directory", QString());
+   /*!
+    * \brief Recalculates every recipe without starting the GUI, and reports
+    *        the OG, FG, IBU, SRM and ABV of each as CSV on stdout.
+    */
+   const QCommandLineOption recalcAllOption("recalc-all", "Recalculates every recipe and writes a CSV summary to stdout");
+   //! \brief Same as --recalc-all, but writes to <file>. A .json suffix gets JSON.
+   const QCommandLineOption reportOption("report", "Recalculates every recipe and writes a summary to <file> (CSV, or JSON if <file> ends in .json)", "file");
 
    parser.addOption(importFromXmlOption);
    parser.addOption(createBlankDBOption);
    parser.addOption(userDirectoryOption);
+   parser.addOption(recalcAllOption);
+   parser.addOption(reportOption);
 
    parser.process(app);
 
    if (parser.isSet(importFromXmlOption)) importFromXml(parser.value(importFromXmlOption));
    if (parser.isSet(createBlankDBOption)) createBlankDb(parser.value(createBlankDBOption));
 
+   if (parser.isSet(recalcAllOption) || parser.isSet(reportOption)) {
+      auto reportReturnValue = Brewtarget::runReport(parser.value(userDirectoryOption), parser.value(reportOption));
+      xercesc::XMLPlatformUtils::Terminate();
+      return reportReturnValue;
+   }
+
    try
    {
       auto mainAppReturnValue = Brewtarget::run(parser.value(userDirectoryOption));
@@ -180,6 +196,8 @@ void importFromXml(const QString & filename) {
    }
     Database::dropInstance();
     Brewtarget::setOption("converted", QDate().currentDate().toString());
+    // exit() doesn't give the options a chance to be written back
+    OptionStore::dropInstance();
     exit(0);
 }
 
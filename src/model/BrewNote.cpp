@@ -122,36 +122,36 @@ BrewNote::BrewNote(TableSchema* table, QSqlRecord rec, int t_key)
      loading(false),
      m_cacheOnly(false)
 {
-     m_brewDate = QDateTime::fromString( rec.value( table->propertyToColumn( PropertyNames::BrewNote::brewDate )).toString(), Qt::ISODate);
-     m_fermentDate = QDateTime::fromString(rec.value( table->propertyToColumn(PropertyNames::BrewNote::fermentDate)).toString(), Qt::ISODate);
-     m_notes = rec.value( table->propertyToColumn(PropertyNames::BrewNote::notes)).toString();
-     m_sg = rec.value( table->propertyToColumn(PropertyNames::BrewNote::sg)).toDouble();
-     m_abv = rec.value( table->propertyToColumn(PropertyNames::BrewNote::abv)).toDouble();
-     m_effIntoBK_pct = rec.value( table->propertyToColumn(PropertyNames::BrewNote::effIntoBK_pct)).toDouble();
-     m_brewhouseEff_pct = rec.value( table->propertyToColumn(PropertyNames::BrewNote::brewhouseEff_pct)).toDouble();
-     m_volumeIntoBK_l = rec.value( table->propertyToColumn(PropertyNames::BrewNote::volumeIntoBK_l)).toDouble();
-     m_strikeTemp_c = rec.value( table->propertyToColumn(PropertyNames::BrewNote::strikeTemp_c)).toDouble();
-     m_mashFinTemp_c = rec.value( table->propertyToColumn(PropertyNames::BrewNote::mashFinTemp_c)).toDouble();
-     m_og = rec.value( table->propertyToColumn(PropertyNames::BrewNote::og)).toDouble();
-     m_postBoilVolume_l = rec.value( table->propertyToColumn(PropertyNames::BrewNote::postBoilVolume_l)).toDouble();
-     m_volumeIntoFerm_l = rec.value( table->propertyToColumn(PropertyNames::BrewNote::volumeIntoFerm_l)).toDouble();
-     m_pitchTemp_c = rec.value( table->propertyToColumn(PropertyNames::BrewNote::pitchTemp_c)).toDouble();
-     m_fg = rec.value( table->propertyToColumn(PropertyNames::BrewNote::fg)).toDouble();
-     m_attenuation = rec.value( table->propertyToColumn(PropertyNames::BrewNote::attenuation)).toDouble();
-     m_finalVolume_l = rec.value( table->propertyToColumn(PropertyNames::BrewNote::finalVolume_l)).toDouble();
-     m_boilOff_l = rec.value( table->propertyToColumn(PropertyNames::BrewNote::boilOff_l)).toDouble();
-     m_projBoilGrav = rec.value( table->propertyToColumn(PropertyNames::BrewNote::projBoilGrav)).toDouble();
-     m_projVolIntoBK_l = rec.value( table->propertyToColumn(PropertyNames::BrewNote::projVolIntoBK_l)).toDouble();
-     m_projStrikeTemp_c = rec.value( table->propertyToColumn(PropertyNames::BrewNote::projStrikeTemp_c)).toDouble();
-     m_projMashFinTemp_c = rec.value( table->propertyToColumn(PropertyNames::BrewNote::projMashFinTemp_c)).toDouble();
-     m_projOg = rec.value( table->propertyToColumn(PropertyNames::BrewNote::projOg)).toDouble();
-     m_projVolIntoFerm_l = rec.value( table->propertyToColumn(PropertyNames::BrewNote::projVolIntoFerm_l)).toDouble();
-     m_projFg = rec.value( table->propertyToColumn(PropertyNames::BrewNote::projFg)).toDouble();
-     m_projEff_pct = rec.value( table->propertyToColumn(PropertyNames::BrewNote::projEff_pct)).toDouble();
-     m_projABV_pct = rec.value( table->propertyToColumn(PropertyNames::BrewNote::projABV_pct)).toDouble();
-     m_projPoints = rec.value( table->propertyToColumn(PropertyNames::BrewNote::projPoints)).toDouble();
-     m_projFermPoints = rec.value( table->propertyToColumn(PropertyNames::BrewNote::projFermPoints)).toDouble();
-     m_projAtten = rec.value( table->propertyToColumn(PropertyNames::BrewNote::projAtten)).toDouble();
+     m_brewDate = QDateTime::fromString( table->value(rec, PropertyNames::BrewNote::brewDate).toString(), Qt::ISODate);
+     m_fermentDate = QDateTime::fromString(table->value(rec, PropertyNames::BrewNote::fermentDate).toString(), Qt::ISODate);
+     m_notes = table->value(rec, PropertyNames::BrewNote::notes).toString();
+     m_sg = table->value(rec, PropertyNames::BrewNote::sg).toDouble();
+     m_abv = table->value(rec, PropertyNames::BrewNote::abv).toDouble();
+     m_effIntoBK_pct = table->value(rec, PropertyNames::BrewNote::effIntoBK_pct).toDouble();
+     m_brewhouseEff_pct = table->value(rec, PropertyNames::BrewNote::brewhouseEff_pct).toDouble();
+     m_volumeIntoBK_l = table->value(rec, PropertyNames::BrewNote::volumeIntoBK_l).toDouble();
+     m_strikeTemp_c = table->value(rec, PropertyNames::BrewNote::strikeTemp_c).toDouble();
+     m_mashFinTemp_c = table->value(rec, PropertyNames::BrewNote::mashFinTemp_c).toDouble();
+     m_og = table->value(rec, PropertyNames::BrewNote::og).toDouble();
+     m_postBoilVolume_l = table->value(rec, PropertyNames::BrewNote::postBoilVolume_l).toDouble();
+     m_volumeIntoFerm_l = table->value(rec, PropertyNames::BrewNote::volumeIntoFerm_l).toDouble();
+     m_pitchTemp_c = table->value(rec, PropertyNames::BrewNote::pitchTemp_c).toDouble();
+     m_fg = table->value(rec, PropertyNames::BrewNote::fg).toDouble();
+     m_attenuation = table->value(rec, PropertyNames::BrewNote::attenuation).toDouble();
+     m_finalVolume_l = table->value(rec, PropertyNames::BrewNote::finalVolume_l).toDouble();
+     m_boilOff_l = table->value(rec, PropertyNames::BrewNote::boilOff_l).toDouble();
+     m_projBoilGrav = table->value(rec, PropertyNames::BrewNote::projBoilGrav).toDouble();
+     m_projVolIntoBK_l = table->value(rec, PropertyNames::BrewNote::projVolIntoBK_l).toDouble();
+     m_projStrikeTemp_c = table->value(rec, PropertyNames::BrewNote::projStrikeTemp_c).toDouble();
+     m_projMashFinTemp_c = table->value(rec, PropertyNames::BrewNote::projMashFinTemp_c).toDouble();
+     m_projOg = table->value(rec, PropertyNames::BrewNote::projOg).toDouble();
+     m_projVolIntoFerm_l = table->value(rec, PropertyNames::BrewNote::projVolIntoFerm_l).toDouble();
+     m_projFg = table->value(rec, PropertyNames::BrewNote::projFg).toDouble();
+     m_projEff_pct = table->value(rec, PropertyNames::BrewNote::projEff_pct).toDouble();
+     m_projABV_pct = table->value(rec, PropertyNames::BrewNote::projABV_pct).toDouble();
+     m_projPoints = table->value(rec, PropertyNames::BrewNote::projPoints).toDouble();
+     m_projFermPoints = table->value(rec, PropertyNames::BrewNote::projFermPoints).toDouble();
+     m_projAtten = table->value(rec, PropertyNames::BrewNote::projAtten).toDouble();
 }
 
 void BrewNote::populateNote(Recipe* parent)
@@ -82,23 +82,23 @@ Equipment::Equipment(TableSchema* table, QSqlRecord rec, int t_key)
    : NamedEntity(table, rec, t_key ),
    m_cacheOnly(false)
 {
-   m_boilSize_l = rec.value( table->propertyToColumn( PropertyNames::Equipment::boilSize_l)).toDouble();
-   m_batchSize_l = rec.value( table->propertyToColumn( PropertyNames::Equipment::batchSize_l)).toDouble();
-   m_tunVolume_l = rec.value( table->propertyToColumn( PropertyNames::Equipment::tunVolume_l)).toDouble();
-   m_tunWeight_kg = rec.value( table->propertyToColumn( PropertyNames::Equipment::tunWeight_kg)).toDouble();
-   m_tunSpecificHeat_calGC = rec.value( table->propertyToColumn( PropertyNames::Equipment::tunSpecificHeat_calGC)).toDouble();
-   m_topUpWater_l = rec.value( table->propertyToColumn( PropertyNames::Equipment::topUpWater_l)).toDouble();
-   m_trubChillerLoss_l = rec.value( table->propertyToColumn( PropertyNames::Equipment::trubChillerLoss_l)).toDouble();
-   m_evapRate_pctHr = rec.value( table->propertyToColumn( PropertyNames::Equipment::evapRate_pctHr)).toDouble();
-   m_evapRate_lHr = rec.value( table->propertyToColumn( PropertyNames::Equipment::evapRate_lHr)).toDouble();
-   m_boilTime_min = rec.value( table->propertyToColumn( PropertyNames::Equipment::boilTime_min)).toDouble();
-   m_calcBoilVolume = rec.value( table->propertyToColumn( PropertyNames::Equipment::calcBoilVolume)).toBool();
-   m_lauterDeadspace_l = rec.value( table->propertyToColumn( PropertyNames::Equipment::lauterDeadspace_l)).toDouble();
-   m_topUpKettle_l = rec.value( table->propertyToColumn( PropertyNames::Equipment::topUpKettle_l)).toDouble();
-   m_hopUtilization_pct = rec.value( table->propertyToColumn( PropertyNames::Equipment::hopUtilization_pct)).toDouble();
-   m_notes = rec.value( table->propertyToColumn(PropertyNames::Equipment::notes)).toString();
-   m_grainAbsorption_LKg = rec.value( table->propertyToColumn( PropertyNames::Equipment::grainAbsorption_LKg)).toDouble();
-   m_boilingPoint_c = rec.value( table->propertyToColumn( PropertyNames::Equipment::boilingPoint_c)).toDouble();
+   m_boilSize_l = table->value(rec, PropertyNames::Equipment::boilSize_l).toDouble();
+   m_batchSize_l = table->value(rec, PropertyNames::Equipment::batchSize_l).toDouble();
+   m_tunVolume_l = table->value(rec, PropertyNames::Equipment::tunVolume_l).toDouble();
+   m_tunWeight_kg = table->value(rec, PropertyNames::Equipment::tunWeight_kg).toDouble();
+   m_tunSpecificHeat_calGC = table->value(rec, PropertyNames::Equipment::tunSpecificHeat_calGC).toDouble();
+   m_topUpWater_l = table->value(rec, PropertyNames::Equipment::topUpWater_l).toDouble();
+   m_trubChillerLoss_l = table->value(rec, PropertyNames::Equipment::trubChillerLoss_l).toDouble();
+   m_evapRate_pctHr = table->value(rec, PropertyNames::Equipment::evapRate_pctHr).toDouble();
+   m_evapRate_lHr = table->value(rec, PropertyNames::Equipment::evapRate_lHr).toDouble();
+   m_boilTime_min = table->value(rec, PropertyNames::Equipment::boilTime_min).toDouble();
+   m_calcBoilVolume = table->value(rec, PropertyNames::Equipment::calcBoilVolume).toBool();
+   m_lauterDeadspace_l = table->value(rec, PropertyNames::Equipment::lauterDeadspace_l).toDouble();
+   m_topUpKettle_l = table->value(rec, PropertyNames::Equipment::topUpKettle_l).toDouble();
+   m_hopUtilization_pct = table->value(rec, PropertyNames::Equipment::hopUtilization_pct).toDouble();
+   m_notes = table->value(rec, PropertyNames::Equipment::notes).toString();
+   m_grainAbsorption_LKg = table->value(rec, PropertyNames::Equipment::grainAbsorption_LKg).toDouble();
+   m_boilingPoint_c = table->value(rec, PropertyNames::Equipment::boilingPoint_c).toDouble();
 
 }
 
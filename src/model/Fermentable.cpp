@@ -92,25 +92,25 @@ Fermentable::Fermentable(TableSchema* table, QSqlRecord rec, int t_key)
      m_inventory(-1.0),
      m_cacheOnly(false)
 {
-     m_typeStr = rec.value( table->propertyToColumn( PropertyNames::Fermentable::type)).toString();
-     m_amountKg = rec.value( table->propertyToColumn( PropertyNames::Fermentable::amount_kg)).toDouble();
-     m_yieldPct = rec.value( table->propertyToColumn( PropertyNames::Fermentable::yield_pct)).toDouble();
-     m_colorSrm = rec.value( table->propertyToColumn( PropertyNames::Fermentable::color_srm)).toDouble();
-     m_isAfterBoil = rec.value( table->propertyToColumn( PropertyNames::Fermentable::addAfterBoil)).toBool();
-     m_origin = rec.value( table->propertyToColumn( PropertyNames::Fermentable::origin)).toString();
-     m_supplier = rec.value( table->propertyToColumn( PropertyNames::Fermentable::supplier)).toString();
-     m_notes = rec.value(table->propertyToColumn( PropertyNames::Fermentable::notes)).toString();
-     m_coarseFineDiff = rec.value( table->propertyToColumn( PropertyNames::Fermentable::coarseFineDiff_pct)).toDouble();
-     m_moisturePct = rec.value( table->propertyToColumn( PropertyNames::Fermentable::moisture_pct)).toDouble();
-     m_diastaticPower = rec.value( table->propertyToColumn( PropertyNames::Fermentable::diastaticPower_lintner)).toDouble();
-     m_proteinPct = rec.value( table->propertyToColumn( PropertyNames::Fermentable::protein_pct)).toDouble();
-     m_maxInBatchPct = rec.value( table->propertyToColumn( PropertyNames::Fermentable::maxInBatch_pct)).toDouble();
-     m_recommendMash = rec.value( table->propertyToColumn( PropertyNames::Fermentable::recommendMash)).toBool();
-     m_ibuGalPerLb = rec.value( table->propertyToColumn( PropertyNames::Fermentable::ibuGalPerLb)).toDouble();
-     m_isMashed = rec.value( table->propertyToColumn( PropertyNames::Fermentable::isMashed)).toBool();
+     m_typeStr = table->value(rec, PropertyNames::Fermentable::type).toString();
+     m_amountKg = table->value(rec, PropertyNames::Fermentable::amount_kg).toDouble();
+     m_yieldPct = table->value(rec, PropertyNames::Fermentable::yield_pct).toDouble();
+     m_colorSrm = table->value(rec, PropertyNames::Fermentable::color_srm).toDouble();
+     m_isAfterBoil = table->value(rec, PropertyNames::Fermentable::addAfterBoil).toBool();
+     m_origin = table->value(rec, PropertyNames::Fermentable::origin).toString();
+     m_supplier = table->value(rec, PropertyNames::Fermentable::supplier).toString();
+     m_notes = table->value(rec, PropertyNames::Fermentable::notes).toString();
+     m_coarseFineDiff = table->value(rec, PropertyNames::Fermentable::coarseFineDiff_pct).toDouble();
+     m_moisturePct = table->value(rec, PropertyNames::Fermentable::moisture_pct).toDouble();
+     m_diastaticPower = table->value(rec, PropertyNames::Fermentable::diastaticPower_lintner).toDouble();
+     m_proteinPct = table->value(rec, PropertyNames::Fermentable::protein_pct).toDouble();
+     m_maxInBatchPct = table->value(rec, PropertyNames::Fermentable::maxInBatch_pct).toDouble();
+     m_recommendMash = table->value(rec, PropertyNames::Fermentable::recommendMash).toBool();
+     m_ibuGalPerLb = table->value(rec, PropertyNames::Fermentable::ibuGalPerLb).toDouble();
+     m_isMashed = table->value(rec, PropertyNames::Fermentable::isMashed).toBool();
 
      // keys is different critters
-     m_inventory_id = rec.value( table->foreignKeyToColumn(PropertyNames::Fermentable::inventory_id)).toInt();
+     m_inventory_id = table->foreignKeyValue(rec, PropertyNames::Fermentable::inventory_id).toInt();
 
      // calculated, not retrieved from the db
      m_type = static_cast<Fermentable::Type>(types.indexOf(m_typeStr));
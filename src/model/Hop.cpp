@@ -107,24 +107,24 @@ Hop::Hop(TableSchema* table, QSqlRecord rec, int t_key)
      m_inventory(-1.0),
      m_cacheOnly(false)
 {
-     m_useStr = rec.value(table->propertyToColumn(PropertyNames::Hop::use)).toString();
-     m_typeStr = rec.value(table->propertyToColumn(PropertyNames::Hop::type)).toString();
-     m_formStr = rec.value(table->propertyToColumn(PropertyNames::Hop::form)).toString();
-     m_alpha_pct = rec.value(table->propertyToColumn(PropertyNames::Hop::alpha_pct)).toDouble();
-     m_amount_kg = rec.value(table->propertyToColumn(PropertyNames::Hop::amount_kg)).toDouble();
-     m_time_min = rec.value(table->propertyToColumn(PropertyNames::Hop::time_min)).toDouble();
-     m_notes = rec.value(table->propertyToColumn(PropertyNames::Hop::notes)).toString();
-     m_beta_pct = rec.value(table->propertyToColumn(PropertyNames::Hop::beta_pct)).toDouble();
-     m_hsi_pct = rec.value(table->propertyToColumn(PropertyNames::Hop::hsi_pct)).toDouble();
-     m_origin = rec.value(table->propertyToColumn(PropertyNames::Hop::origin)).toString();
-     m_substitutes = rec.value(table->propertyToColumn(PropertyNames::Hop::substitutes)).toString();
-     m_humulene_pct = rec.value(table->propertyToColumn(PropertyNames::Hop::humulene_pct)).toDouble();
-     m_caryophyllene_pct = rec.value(table->propertyToColumn(PropertyNames::Hop::caryophyllene_pct)).toDouble();
-     m_cohumulone_pct = rec.value(table->propertyToColumn(PropertyNames::Hop::cohumulone_pct)).toDouble();
-     m_myrcene_pct = rec.value(table->propertyToColumn(PropertyNames::Hop::myrcene_pct)).toDouble();
+     m_useStr = table->value(rec, PropertyNames::Hop::use).toString();
+     m_typeStr = table->value(rec, PropertyNames::Hop::type).toString();
+     m_formStr = table->value(rec, PropertyNames::Hop::form).toString();
+     m_alpha_pct = table->value(rec, PropertyNames::Hop::alpha_pct).toDouble();
+     m_amount_kg = table->value(rec, PropertyNames::Hop::amount_kg).toDouble();
+     m_time_min = table->value(rec, PropertyNames::Hop::time_min).toDouble();
+     m_notes = table->value(rec, PropertyNames::Hop::notes).toString();
+     m_beta_pct = table->value(rec, PropertyNames::Hop::beta_pct).toDouble();
+     m_hsi_pct = table->value(rec, PropertyNames::Hop::hsi_pct).toDouble();
+     m_origin = table->value(rec, PropertyNames::Hop::origin).toString();
+     m_substitutes = table->value(rec, PropertyNames::Hop::substitutes).toString();
+     m_humulene_pct = table->value(rec, PropertyNames::Hop::humulene_pct).toDouble();
+     m_caryophyllene_pct = table->value(rec, PropertyNames::Hop::caryophyllene_pct).toDouble();
+     m_cohumulone_pct = table->value(rec, PropertyNames::Hop::cohumulone_pct).toDouble();
+     m_myrcene_pct = table->value(rec, PropertyNames::Hop::myrcene_pct).toDouble();
 
      // keys need special handling
-     m_inventory_id = rec.value(table->foreignKeyToColumn(PropertyNames::Hop::inventory_id)).toInt();
+     m_inventory_id = table->foreignKeyValue(rec, PropertyNames::Hop::inventory_id).toInt();
 
      // these are not taken directly from the SQL record
      m_use  = static_cast<Hop::Use>(uses.indexOf(m_useStr));
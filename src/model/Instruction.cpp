@@ -59,11 +59,11 @@ Instruction::Instruction(TableSchema* table, QSqlRecord rec, int t_key)
      m_cacheOnly(false),
      m_recipe   (nullptr)
 {
-     m_directions = rec.value( table->propertyToColumn( PropertyNames::Instruction::directions)).toString();
-     m_hasTimer   = rec.value( table->propertyToColumn( PropertyNames::Instruction::hasTimer)).toBool();
-     m_timerValue = rec.value( table->propertyToColumn( PropertyNames::Instruction::timerValue)).toString();
-     m_completed  = rec.value( table->propertyToColumn( PropertyNames::Instruction::completed)).toBool();
-     m_interval   = rec.value( table->propertyToColumn( PropertyNames::Instruction::interval)).toDouble();
+     m_directions = table->value(rec, PropertyNames::Instruction::directions).toString();
+     m_hasTimer   = table->value(rec, PropertyNames::Instruction::hasTimer).toBool();
+     m_timerValue = table->value(rec, PropertyNames::Instruction::timerValue).toString();
+     m_completed  = table->value(rec, PropertyNames::Instruction::completed).toBool();
+     m_interval   = table->value(rec, PropertyNames::Instruction::interval).toDouble();
 }
 
 // Setters ====================================================================
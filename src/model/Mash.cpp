@@ -73,14 +73,14 @@ Mash::Mash(TableSchema* table, QSqlRecord rec, int t_key)
    : NamedEntity(table, rec, t_key),
      m_cacheOnly(false)
 {
-     m_grainTemp_c = rec.value( table->propertyToColumn(PropertyNames::Mash::grainTemp_c)).toDouble();
-     m_notes = rec.value( table->propertyToColumn(PropertyNames::Mash::notes)).toString();
-     m_tunTemp_c = rec.value( table->propertyToColumn(PropertyNames::Mash::tunTemp_c)).toDouble();
-     m_spargeTemp_c = rec.value( table->propertyToColumn(PropertyNames::Mash::spargeTemp_c)).toDouble();
-     m_ph = rec.value( table->propertyToColumn(PropertyNames::Mash::ph)).toDouble();
-     m_tunWeight_kg = rec.value( table->propertyToColumn(PropertyNames::Mash::tunWeight_kg)).toDouble();
-     m_tunSpecificHeat_calGC = rec.value( table->propertyToColumn(PropertyNames::Mash::tunSpecificHeat_calGC)).toDouble();
-     m_equipAdjust = rec.value( table->propertyToColumn(PropertyNames::Mash::equipAdjust)).toBool();
+     m_grainTemp_c = table->value(rec, PropertyNames::Mash::grainTemp_c).toDouble();
+     m_notes = table->value(rec, PropertyNames::Mash::notes).toString();
+     m_tunTemp_c = table->value(rec, PropertyNames::Mash::tunTemp_c).toDouble();
+     m_spargeTemp_c = table->value(rec, PropertyNames::Mash::spargeTemp_c).toDouble();
+     m_ph = table->value(rec, PropertyNames::Mash::ph).toDouble();
+     m_tunWeight_kg = table->value(rec, PropertyNames::Mash::tunWeight_kg).toDouble();
+     m_tunSpecificHeat_calGC = table->value(rec, PropertyNames::Mash::tunSpecificHeat_calGC).toDouble();
+     m_equipAdjust = table->value(rec, PropertyNames::Mash::equipAdjust).toBool();
 
 }
 
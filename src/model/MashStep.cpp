@@ -77,15 +77,15 @@ MashStep::MashStep(TableSchema* table, QSqlRecord rec, int t_key)
    : NamedEntity(table, rec, t_key),
      m_cacheOnly(false)
 {
-     m_typeStr = rec.value( table->propertyToColumn( PropertyNames::MashStep::type)).toString();
-     m_infuseAmount_l = rec.value( table->propertyToColumn( PropertyNames::MashStep::infuseAmount_l)).toDouble();
-     m_stepTemp_c = rec.value( table->propertyToColumn( PropertyNames::MashStep::stepTemp_c)).toDouble();
-     m_stepTime_min = rec.value( table->propertyToColumn( PropertyNames::MashStep::stepTime_min)).toDouble();
-     m_rampTime_min = rec.value( table->propertyToColumn( PropertyNames::MashStep::rampTime_min)).toDouble();
-     m_endTemp_c = rec.value( table->propertyToColumn( PropertyNames::MashStep::endTemp_c)).toDouble();
-     m_infuseTemp_c = rec.value( table->propertyToColumn( PropertyNames::MashStep::infuseTemp_c)).toDouble();
-     m_decoctionAmount_l = rec.value( table->propertyToColumn( PropertyNames::MashStep::decoctionAmount_l)).toDouble();
-     m_stepNumber = rec.value( table->propertyToColumn( PropertyNames::MashStep::stepNumber)).toInt();
+     m_typeStr = table->value(rec, PropertyNames::MashStep::type).toString();
+     m_infuseAmount_l = table->value(rec, PropertyNames::MashStep::infuseAmount_l).toDouble();
+     m_stepTemp_c = table->value(rec, PropertyNames::MashStep::stepTemp_c).toDouble();
+     m_stepTime_min = table->value(rec, PropertyNames::MashStep::stepTime_min).toDouble();
+     m_rampTime_min = table->value(rec, PropertyNames::MashStep::rampTime_min).toDouble();
+     m_endTemp_c = table->value(rec, PropertyNames::MashStep::endTemp_c).toDouble();
+     m_infuseTemp_c = table->value(rec, PropertyNames::MashStep::infuseTemp_c).toDouble();
+     m_decoctionAmount_l = table->value(rec, PropertyNames::MashStep::decoctionAmount_l).toDouble();
+     m_stepNumber = table->value(rec, PropertyNames::MashStep::stepNumber).toInt();
 
      m_type = static_cast<MashStep::Type>(types.indexOf(m_typeStr));
 }
@@ -62,16 +62,16 @@ Misc::Misc(TableSchema* table, QSqlRecord rec, int t_key)
    m_inventory(-1.0),
    m_cacheOnly(false)
 {
-   m_typeString = rec.value( table->propertyToColumn( PropertyNames::Misc::type)).toString();
-   m_useString = rec.value( table->propertyToColumn( PropertyNames::Misc::use)).toString();
-   m_time = rec.value( table->propertyToColumn( PropertyNames::Misc::time)).toDouble();
-   m_amount = rec.value( table->propertyToColumn( PropertyNames::Misc::amount)).toDouble();
-   m_amountIsWeight = rec.value( table->propertyToColumn( PropertyNames::Misc::amountIsWeight)).toBool();
-   m_useFor = rec.value( table->propertyToColumn( PropertyNames::Misc::useFor)).toString();
-   m_notes = rec.value( table->propertyToColumn( PropertyNames::Misc::notes)).toString();
+   m_typeString = table->value(rec, PropertyNames::Misc::type).toString();
+   m_useString = table->value(rec, PropertyNames::Misc::use).toString();
+   m_time = table->value(rec, PropertyNames::Misc::time).toDouble();
+   m_amount = table->value(rec, PropertyNames::Misc::amount).toDouble();
+   m_amountIsWeight = table->value(rec, PropertyNames::Misc::amountIsWeight).toBool();
+   m_useFor = table->value(rec, PropertyNames::Misc::useFor).toString();
+   m_notes = table->value(rec, PropertyNames::Misc::notes).toString();
 
    // handle foreign keys properly
-   m_inventory_id = rec.value( table->foreignKeyToColumn( PropertyNames::Misc::inventory_id)).toInt();
+   m_inventory_id = table->foreignKeyValue(rec, PropertyNames::Misc::inventory_id).toInt();
    // not read from the db
    m_type = static_cast<Misc::Type>(types.indexOf(m_typeString));
    m_use = static_cast<Misc::Use>(uses.indexOf(m_useString));
@@ -60,9 +60,9 @@ NamedEntity::NamedEntity(TableSchema* table, QSqlRecord rec, int t_key )
       m_key = t_key;
    }
       
-   m_folder  = rec.value( table->propertyToColumn(PropertyNames::NamedEntity::folder)  ).toString();
-   m_name    = rec.value( table->propertyToColumn(PropertyNames::NamedEntity::name)    ).toString();
-   m_display = rec.value( table->propertyToColumn(PropertyNames::NamedEntity::display) ).toBool();
+   m_folder  = table->value(rec, PropertyNames::NamedEntity::folder).toString();
+   m_name    = table->value(rec, PropertyNames::NamedEntity::name).toString();
+   m_display = table->value(rec, PropertyNames::NamedEntity::display).toBool();
    m_table   = table->dbTable();
 }
 
@@ -32,10 +32,8 @@
 
 #include "Algorithms.h"
 #include "brewtarget.h"
-#include "ColorMethods.h"
 #include "database.h"
 #include "HeatCalculations.h"
-#include "IbuMethods.h"
 #include "model/Equipment.h"
 #include "model/Fermentable.h"
 #include "model/Hop.h"
@@ -50,6 +48,7 @@
 #include "PhysicalConstants.h"
 #include "PreInstruction.h"
 #include "QueuedMethod.h"
+#include "RecipeMath.h"
 #include "RecipeSchema.h"
 #include "TableSchemaConst.h"
 
@@ -67,6 +66,17 @@ static const QHash<QString, Recipe::Type> RECIPE_TYPE_STRING_TO_TYPE {
    {"All Grain",    Recipe::AllGrain}
 };
 
+// What RecipeMath needs from the fermentables
+static QVector<RecipeMath::FermentableSnapshot> fermentableSnapshots(QList<Fermentable*> const& ferms)
+{
+   QVector<RecipeMath::FermentableSnapshot> ret;
+   ret.reserve(ferms.size());
+   foreach( Fermentable* f, ferms ) {
+      ret.append( RecipeMath::snapshot(f) );
+   }
+   return ret;
+}
+
 
 bool Recipe::isEqualTo(NamedEntity const & other) const {
    // Base class (NamedEntity) will have ensured this cast is valid
@@ -110,6 +120,21 @@ QString Recipe::classNameStr()
    return name;
 }
 
+// Each calculation, what it reads and how to run it. Keep this in dependency
+// order, since markDirty() and recalcDirty() both walk it front to back.
+QVector<Recipe::RecalcGraphNode> const Recipe::recalcGraph = {
+   { RecalcGrainsInMash, 0,                        &Recipe::recalcGrainsInMash_kg },
+   { RecalcGrains,       0,                        &Recipe::recalcGrains_kg },
+   { RecalcVolumes,      RecalcGrainsInMash,       &Recipe::recalcVolumeEstimates },
+   { RecalcColor,        RecalcVolumes,            &Recipe::recalcColor_srm },
+   { RecalcSRMColor,     RecalcColor,              &Recipe::recalcSRMColor },
+   { RecalcOgFg,         RecalcVolumes,            &Recipe::recalcOgFg },
+   { RecalcABV,          RecalcOgFg,               &Recipe::recalcABV_pct },
+   { RecalcBoilGrav,     0,                        &Recipe::recalcBoilGrav },
+   { RecalcIBU,          RecalcVolumes|RecalcOgFg, &Recipe::recalcIBU },
+   { RecalcCalories,     RecalcOgFg,               &Recipe::recalcCalories }
+};
+
 Recipe::Recipe(QString name, bool cache)
    : NamedEntity(Brewtarget::RECTABLE, name, true),
    m_type(QString("All Grain")),
@@ -143,6 +168,8 @@ Recipe::Recipe(QString name, bool cache)
    m_fg(1.0),
    m_cacheOnly(cache),
    m_locked(false),
+   m_dirtyCalcs(RecalcAllNodes),
+   m_coalesceChanges(false),
    m_hasDescendants(false)
 {
 }
@@ -150,39 +177,41 @@ Recipe::Recipe(QString name, bool cache)
 Recipe::Recipe(TableSchema* table, QSqlRecord rec, int t_key)
    : NamedEntity(table, rec, t_key),
    m_cacheOnly(false),
+   m_dirtyCalcs(RecalcAllNodes),
+   m_coalesceChanges(false),
    m_hasDescendants(false)
 {
-   m_type = rec.value( table->propertyToColumn( PropertyNames::Recipe::type)).toString();
-   m_brewer = rec.value( table->propertyToColumn( PropertyNames::Recipe::brewer)).toString();
-   m_asstBrewer = rec.value( table->propertyToColumn( PropertyNames::Recipe::asstBrewer)).toString();
-   m_batchSize_l = rec.value( table->propertyToColumn( PropertyNames::Recipe::batchSize_l)).toDouble();
-   m_boilSize_l = rec.value( table->propertyToColumn( PropertyNames::Recipe::boilSize_l)).toDouble();
-   m_boilTime_min = rec.value( table->propertyToColumn( PropertyNames::Recipe::boilTime_min)).toDouble();
-   m_efficiency_pct = rec.value( table->propertyToColumn( PropertyNames::Recipe::efficiency_pct)).toDouble();
-   m_fermentationStages = rec.value( table->propertyToColumn( PropertyNames::Recipe::fermentationStages)).toInt();
-   m_primaryAge_days = rec.value( table->propertyToColumn( PropertyNames::Recipe::primaryAge_days)).toDouble();
-   m_primaryTemp_c = rec.value( table->propertyToColumn( PropertyNames::Recipe::primaryTemp_c)).toDouble();
-   m_secondaryAge_days = rec.value( table->propertyToColumn( PropertyNames::Recipe::secondaryAge_days)).toDouble();
-   m_secondaryTemp_c = rec.value( table->propertyToColumn( PropertyNames::Recipe::secondaryTemp_c)).toDouble();
-   m_tertiaryAge_days = rec.value( table->propertyToColumn( PropertyNames::Recipe::tertiaryAge_days)).toDouble();
-   m_tertiaryTemp_c = rec.value( table->propertyToColumn( PropertyNames::Recipe::tertiaryTemp_c)).toDouble();
-   m_age = rec.value( table->propertyToColumn( PropertyNames::Recipe::age)).toDouble();
-   m_ageTemp_c = rec.value( table->propertyToColumn( PropertyNames::Recipe::ageTemp_c)).toDouble();
-   m_date = QDate::fromString(rec.value( table->propertyToColumn( PropertyNames::Recipe::date)).toString(), Qt::ISODate);
-   m_carbonation_vols = rec.value( table->propertyToColumn( PropertyNames::Recipe::carbonation_vols)).toDouble();
-   m_forcedCarbonation = rec.value( table->propertyToColumn( PropertyNames::Recipe::forcedCarbonation)).toBool();
-   m_primingSugarName = rec.value( table->propertyToColumn( PropertyNames::Recipe::primingSugarName)).toString();
-   m_carbonationTemp_c = rec.value( table->propertyToColumn( PropertyNames::Recipe::carbonationTemp_c)).toDouble();
-   m_primingSugarEquiv = rec.value( table->propertyToColumn( PropertyNames::Recipe::primingSugarEquiv)).toDouble();
-   m_kegPrimingFactor = rec.value( table->propertyToColumn( PropertyNames::Recipe::kegPrimingFactor)).toDouble();
-   m_notes = rec.value( table->propertyToColumn(PropertyNames::Recipe::notes) ).toString();
-   m_tasteNotes = rec.value( table->propertyToColumn( PropertyNames::Recipe::tasteNotes)).toString();
-   m_tasteRating = rec.value( table->propertyToColumn( PropertyNames::Recipe::tasteRating)).toDouble();
-   m_style_id = rec.value( table->propertyToColumn( PropertyNames::Recipe::style_id)).toInt();
-   m_og = rec.value( table->propertyToColumn( PropertyNames::Recipe::og)).toDouble();
-   m_fg = rec.value( table->propertyToColumn( PropertyNames::Recipe::fg)).toDouble();
-
-   m_locked = rec.value( table->propertyToColumn( PropertyNames::Recipe::locked)).toBool();
+   m_type = table->value(rec, PropertyNames::Recipe::type).toString();
+   m_brewer = table->value(rec, PropertyNames::Recipe::brewer).toString();
+   m_asstBrewer = table->value(rec, PropertyNames::Recipe::asstBrewer).toString();
+   m_batchSize_l = table->value(rec, PropertyNames::Recipe::batchSize_l).toDouble();
+   m_boilSize_l = table->value(rec, PropertyNames::Recipe::boilSize_l).toDouble();
+   m_boilTime_min = table->value(rec, PropertyNames::Recipe::boilTime_min).toDouble();
+   m_efficiency_pct = table->value(rec, PropertyNames::Recipe::efficiency_pct).toDouble();
+   m_fermentationStages = table->value(rec, PropertyNames::Recipe::fermentationStages).toInt();
+   m_primaryAge_days = table->value(rec, PropertyNames::Recipe::primaryAge_days).toDouble();
+   m_primaryTemp_c = table->value(rec, PropertyNames::Recipe::primaryTemp_c).toDouble();
+   m_secondaryAge_days = table->value(rec, PropertyNames::Recipe::secondaryAge_days).toDouble();
+   m_secondaryTemp_c = table->value(rec, PropertyNames::Recipe::secondaryTemp_c).toDouble();
+   m_tertiaryAge_days = table->value(rec, PropertyNames::Recipe::tertiaryAge_days).toDouble();
+   m_tertiaryTemp_c = table->value(rec, PropertyNames::Recipe::tertiaryTemp_c).toDouble();
+   m_age = table->value(rec, PropertyNames::Recipe::age).toDouble();
+   m_ageTemp_c = table->value(rec, PropertyNames::Recipe::ageTemp_c).toDouble();
+   m_date = QDate::fromString(table->value(rec, PropertyNames::Recipe::date).toString(), Qt::ISODate);
+   m_carbonation_vols = table->value(rec, PropertyNames::Recipe::carbonation_vols).toDouble();
+   m_forcedCarbonation = table->value(rec, PropertyNames::Recipe::forcedCarbonation).toBool();
+   m_primingSugarName = table->value(rec, PropertyNames::Recipe::primingSugarName).toString();
+   m_carbonationTemp_c = table->value(rec, PropertyNames::Recipe::carbonationTemp_c).toDouble();
+   m_primingSugarEquiv = table->value(rec, PropertyNames::Recipe::primingSugarEquiv).toDouble();
+   m_kegPrimingFactor = table->value(rec, PropertyNames::Recipe::kegPrimingFactor).toDouble();
+   m_notes = table->value(rec, PropertyNames::Recipe::notes).toString();
+   m_tasteNotes = table->value(rec, PropertyNames::Recipe::tasteNotes).toString();
+   m_tasteRating = table->value(rec, PropertyNames::Recipe::tasteRating).toDouble();
+   m_style_id = table->value(rec, PropertyNames::Recipe::style_id).toInt();
+   m_og = table->value(rec, PropertyNames::Recipe::og).toDouble();
+   m_fg = table->value(rec, PropertyNames::Recipe::fg).toDouble();
+
+   m_locked = table->value(rec, PropertyNames::Recipe::locked).toBool();
 }
 
 Recipe::Recipe( Recipe const& other ) : NamedEntity(other),
@@ -217,6 +246,8 @@ Recipe::Recipe( Recipe const& other ) : NamedEntity(other),
    m_fg(other.m_fg),
    m_cacheOnly(other.m_cacheOnly),
    m_locked(other.m_locked),
+   m_dirtyCalcs(RecalcAllNodes),
+   m_coalesceChanges(false),
    m_hasDescendants(false)
 {
    setObjectName("Recipe");
@@ -260,8 +291,7 @@ Instruction* Recipe::mashFermentableIns()
    int i;
 
    /*** Add grains ***/
-   ins = Database::instance().newInstruction(this);
-   ins->setName(tr("Add grains"));
+   ins = new Instruction(tr("Add grains"));
    str = tr("Add ");
    QList<QString> reagents = getReagents(fermentables());
 
@@ -289,9 +319,8 @@ Instruction* Recipe::saltWater(Salt::WhenToAdd when)
    if ( reagents.size() == 0 )
       return nullptr;
 
-   ins = Database::instance().newInstruction(this);
    tmp = when == Salt::MASH ? tr("mash") : tr("sparge");
-   ins->setName(tr("Modify %1 water").arg( tmp ));
+   ins = new Instruction(tr("Modify %1 water").arg( tmp ));
    str = tr("Dissolve ");
 
    for( i = 0; i < reagents.size(); ++i )
@@ -311,8 +340,7 @@ Instruction* Recipe::mashWaterIns()
    if( mash() == nullptr )
       return nullptr;
 
-   ins = Database::instance().newInstruction(this);
-   ins->setName(tr("Heat water"));
+   ins = new Instruction(tr("Heat water"));
    str = tr("Bring ");
    QList<QString> reagents = getReagents(mash()->mashSteps());
    for( i = 0; i < reagents.size(); ++i )
@@ -466,8 +494,7 @@ Instruction* Recipe::firstWortHopsIns()
          str += reagents.at(i);
 
       str += ".";
-      ins = Database::instance().newInstruction(this);
-      ins->setName(tr("First wort hopping"));
+      ins = new Instruction(tr("First wort hopping"));
       ins->setDirections(str);
       return ins;
    }
@@ -495,8 +522,7 @@ Instruction* Recipe::topOffIns()
 
          str += tmp;
 
-         ins = Database::instance().newInstruction(this);
-         ins->setName(tr("Pre-boil"));
+         ins = new Instruction(tr("Pre-boil"));
          ins->setDirections(str);
          ins->addReagent(tmp);
          return ins;
@@ -616,8 +642,7 @@ Instruction* Recipe::postboilFermentablesIns()
 
    if( hasFerms )
    {
-      ins = Database::instance().newInstruction(this);
-      ins->setName(tr("Knockout additions"));
+      ins = new Instruction(tr("Knockout additions"));
       ins->setDirections(str);
       ins->addReagent(tmp);
       return ins;
@@ -655,8 +680,7 @@ Instruction* Recipe::postboilIns()
       str += tr("\nThe final volume in the primary is %1.")
              .arg(Brewtarget::displayAmount(wort_l, kTabRecipeSection, PropertyNames::Recipe::batchSize_l,  &Units::liters));
 
-      ins = Database::instance().newInstruction(this);
-      ins->setName(tr("Post boil"));
+      ins = new Instruction(tr("Post boil"));
       ins->setDirections(str);
       return ins;
    }
@@ -666,20 +690,19 @@ Instruction* Recipe::postboilIns()
    }
 }
 
-void Recipe::addPreinstructions( QVector<PreInstruction> preins )
+void Recipe::addPreinstructions( QVector<PreInstruction> preins, QList<Instruction*>& ins )
 {
    unsigned int i;
-   Instruction* ins;
 
     // Add instructions in descending mash time order.
     std::sort( preins.begin(), preins.end(), std::greater<PreInstruction>() );
     for( i=0; static_cast<int>(i) < preins.size(); ++i )
     {
        PreInstruction pi = preins[static_cast<int>(i)];
-       ins = Database::instance().newInstruction(this);
-       ins->setName(pi.getTitle());
-       ins->setDirections(pi.getText());
-       ins->setInterval(pi.getTime());
+       Instruction* tmp = new Instruction(pi.getTitle());
+       tmp->setDirections(pi.getText());
+       tmp->setInterval(pi.getTime());
+       ins.append(tmp);
     }
 }
 
@@ -691,8 +714,9 @@ void Recipe::generateInstructions()
    double timeRemaining;
    double totalWaterAdded_l = 0.0;
 
-   if ( ! instructions().empty() )
-      clearInstructions();
+   // Everything is built in memory first, then stored in one go
+   QList<Instruction*> generated;
+   auto append = [&generated](Instruction* ins) { if ( ins ) generated.append(ins); };
 
    QVector<PreInstruction> preinstructions;
 
@@ -702,14 +726,14 @@ void Recipe::generateInstructions()
    if( size > 0 )
    {
      /*** prepare mashed fermentables ***/
-     mashFermentableIns();
+     append(mashFermentableIns());
 
      /*** salt the water ***/
-     saltWater(Salt::MASH);
-     saltWater(Salt::SPARGE);
+     append(saltWater(Salt::MASH));
+     append(saltWater(Salt::SPARGE));
 
      /*** Prepare water additions ***/
-     mashWaterIns();
+     append(mashWaterIns());
 
      timeRemaining = mash()->totalTime();
 
@@ -723,15 +747,15 @@ void Recipe::generateInstructions()
      preinstructions += miscSteps(Misc::Mash);
 
      /*** Add the preinstructions into the instructions ***/
-     addPreinstructions(preinstructions);
+     addPreinstructions(preinstructions, generated);
 
    } // END mash instructions.
 
    // First wort hopping
-   firstWortHopsIns();
+   append(firstWortHopsIns());
 
    // Need to top up the kettle before boil?
-   topOffIns();
+   append(topOffIns());
 
    // Boil instructions
    preinstructions.clear();
@@ -748,10 +772,10 @@ void Recipe::generateInstructions()
    }
 
    str = tr("Bring the wort to a boil and hold for %1.").arg(Brewtarget::displayAmount( timeRemaining, "tab_recipe", "boilTime_min", &Units::minutes));
-   ins = Database::instance().newInstruction(this);
-   ins->setName(tr("Start boil"));
+   ins = new Instruction(tr("Start boil"));
    ins->setInterval(timeRemaining);
    ins->setDirections(str);
+   append(ins);
 
    /*** Get fermentables unless we haven't added yet ***/
    if ( hasBoilFermentable() )
@@ -770,26 +794,26 @@ void Recipe::generateInstructions()
    // END boil instructions.
 
    // Add instructions in descending mash time order.
-   addPreinstructions(preinstructions);
+   addPreinstructions(preinstructions, generated);
 
    // FLAMEOUT
-   ins = Database::instance().newInstruction(this);
-   ins->setName(tr("Flameout"));
+   ins = new Instruction(tr("Flameout"));
    ins->setDirections(tr("Stop boiling the wort."));
+   append(ins);
 
    // Steeped aroma hops
    preinstructions.clear();
    preinstructions += hopSteps(Hop::UseAroma);
-   addPreinstructions(preinstructions);
+   addPreinstructions(preinstructions, generated);
 
    // Fermentation instructions
    preinstructions.clear();
 
    /*** Fermentables added after boil ***/
-   postboilFermentablesIns();
+   append(postboilFermentablesIns());
 
    /*** post boil ***/
-   postboilIns();
+   append(postboilIns());
 
    /*** Primary yeast ***/
    str = tr("Cool wort and pitch ");
@@ -801,33 +825,35 @@ void Recipe::generateInstructions()
          str += tr("%1 %2 yeast, ").arg(yeast->name()).arg(yeast->typeStringTr());
    }
    str += tr("to the primary.");
-   ins = Database::instance().newInstruction(this);
-   ins->setName(tr("Pitch yeast"));
+   ins = new Instruction(tr("Pitch yeast"));
    ins->setDirections(str);
+   append(ins);
    /*** End primary yeast ***/
 
    /*** Primary misc ***/
-   addPreinstructions(miscSteps(Misc::Primary));
+   addPreinstructions(miscSteps(Misc::Primary), generated);
 
    str = tr("Let ferment until FG is %1.")
          .arg(Brewtarget::displayAmount(fg(), "tab_recipe", "fg", &Units::sp_grav, 3));
-   ins = Database::instance().newInstruction(this);
-   ins->setName(tr("Ferment"));
+   ins = new Instruction(tr("Ferment"));
    ins->setDirections(str);
+   append(ins);
 
    str = tr("Transfer beer to secondary.");
-   ins = Database::instance().newInstruction(this);
-   ins->setName(tr("Transfer to secondary"));
+   ins = new Instruction(tr("Transfer to secondary"));
    ins->setDirections(str);
+   append(ins);
 
    /*** Secondary misc ***/
-   addPreinstructions(miscSteps(Misc::Secondary));
+   addPreinstructions(miscSteps(Misc::Secondary), generated);
 
    /*** Dry hopping ***/
-   addPreinstructions(hopSteps(Hop::Dry_Hop));
+   addPreinstructions(hopSteps(Hop::Dry_Hop), generated);
 
-   // END fermentation instructions. Let everybody know that now is the time
-   // to update instructions
+   // END fermentation instructions. Store the lot, keeping whatever hasn't
+   // changed, and let everybody know that now is the time to update
+   // instructions
+   Database::instance().replaceInstructions(this, generated);
    emit changed( metaProperty("instructions"), instructions().size() );
 }
 
@@ -908,6 +934,12 @@ template<class T> T * Recipe::add(T * var) {
          return Database::instance().addToRecipe(this, var, true);
       }
 
+      // An older version still has it, which is what undoing the removal of a
+      // shared ingredient looks like. Share it again instead of copying it.
+      if (usedIn != this && this->isMyAncestor(usedIn)) {
+         return static_cast<T *>(Database::instance().relinkToRecipe(this, var));
+      }
+
       // The parameter is already used in a recipe, so we need to add a copy of its parent
       return Database::instance().addToRecipe(this, parentOfVar, false);
    }
@@ -1001,10 +1033,10 @@ void Recipe::setBatchSize_l( double var )
       setEasy(PropertyNames::Recipe::batchSize_l, tmp );
    }
 
-   // NOTE: this is bad, but we have to call recalcAll(), because the estimated
-   // boil/batch volumes depend on the target volumes when there are no mash
-   // steps to actually provide an estimate for the volumes.
-   recalcAll();
+   // The estimated boil/batch volumes depend on the target volumes when there
+   // are no mash steps to actually provide an estimate for the volumes. The
+   // IBUs read the batch size directly.
+   recalc(RecalcVolumes | RecalcIBU);
 }
 
 void Recipe::setBoilSize_l( double var )
@@ -1025,10 +1057,10 @@ void Recipe::setBoilSize_l( double var )
       setEasy(PropertyNames::Recipe::boilSize_l, tmp );
    }
 
-   // NOTE: this is bad, but we have to call recalcAll(), because the estimated
-   // boil/batch volumes depend on the target volumes when there are no mash
-   // steps to actually provide an estimate for the volumes.
-   recalcAll();
+   // The estimated boil volume falls back on the boil size when there are no
+   // mash steps to actually provide an estimate, and the boil gravity reads
+   // it directly.
+   recalc(RecalcVolumes | RecalcBoilGrav);
 }
 
 void Recipe::setBoilTime_min( double var )
@@ -1068,10 +1100,10 @@ void Recipe::setEfficiency_pct( double var )
       setEasy(PropertyNames::Recipe::efficiency_pct, tmp );
    }
 
-   // If you change the efficency, you really should recalc. And I'm afraid it
-   // means recalc all, since og and fg will change, which means your ratios
-   // change
-   recalcAll();
+   // If you change the efficency, you really should recalc. og and fg will
+   // change, which means your ratios change, and so does everything
+   // downstream of them
+   recalc(RecalcOgFg | RecalcBoilGrav);
 }
 
 void Recipe::setAsstBrewer( const QString &var )
@@ -1377,6 +1409,11 @@ void Recipe::setLocked(bool isLocked )
    m_locked = isLocked;
    if ( ! m_cacheOnly ) {
       setEasy(PropertyNames::Recipe::locked, isLocked);
+      // Unlocked means editable, and modifyEntry() sends edits to shared
+      // ingredients to the newest version that uses them
+      if ( ! isLocked ) {
+         Database::instance().unshareIngredients(this);
+      }
    }
 }
 
@@ -1663,6 +1700,24 @@ double Recipe::batchSizeNoLosses_l()
 //==============================Recalculators==================================
 
 void Recipe::recalcAll()
+{
+   recalc(RecalcAllNodes);
+}
+
+void Recipe::markDirty(unsigned int nodes)
+{
+   m_dirtyCalcs |= nodes;
+
+   // The graph is in dependency order, so one pass catches everything
+   // downstream
+   for ( RecalcGraphNode const& n : recalcGraph ) {
+      if ( n.inputs & m_dirtyCalcs ) {
+         m_dirtyCalcs |= n.node;
+      }
+   }
+}
+
+void Recipe::recalcDirty()
 {
    // WARNING
    // Infinite recursion possible, since these methods will emit changed(),
@@ -1670,26 +1725,60 @@ void Recipe::recalcAll()
    // cause another call to recalcAll() and so on.
    //
    // GSG: Now only emit when _uninitializedCalcs is true, which helps some.
+   // maf: The signals are now held until the end of the pass, so listeners
+   //      see every calculated value settled and only hear about it once.
 
-   // Someone has already called this function back in the call stack, so return to avoid recursion.
+   // Someone has already called this function back in the call stack, so
+   // return to avoid recursion. Whatever got marked stays dirty for the next
+   // pass.
    if( ! m_recalcMutex.tryLock() )
       return;
 
-   // Times are in seconds, and are cumulative.
-   recalcGrainsInMash_kg(); // 0.01
-   recalcGrains_kg(); // 0.03
-   recalcVolumeEstimates(); // 0.06
-   recalcColor_srm(); // 0.08
-   recalcSRMColor(); // 0.08
-   recalcOgFg(); // 0.11
-   recalcABV_pct(); // 0.12
-   recalcBoilGrav(); // 0.14
-   recalcIBU(); // 0.15
-   recalcCalories();
+   // Nothing has been calculated yet, so a partial recalc makes no sense
+   if ( m_uninitializedCalcs ) {
+      m_dirtyCalcs = RecalcAllNodes;
+   }
 
+   m_coalesceChanges = true;
+   for ( RecalcGraphNode const& n : recalcGraph ) {
+      if ( m_dirtyCalcs & n.node ) {
+         m_dirtyCalcs &= ~n.node;
+         (this->*n.recalc)();
+      }
+   }
+   m_coalesceChanges = false;
    m_uninitializedCalcs = false;
 
+   QMap<QString,QVariant> pending = m_pendingChanges;
+   m_pendingChanges.clear();
+
    m_recalcMutex.unlock();
+
+   // Emit outside the lock, so anybody listening can ask for another recalc
+   QMap<QString,QVariant>::const_iterator i;
+   for( i = pending.constBegin(); i != pending.constEnd(); ++i ) {
+      emit changed( metaProperty(i.key()), i.value() );
+   }
+}
+
+void Recipe::recalc(unsigned int nodes)
+{
+   markDirty(nodes);
+   recalcDirty();
+}
+
+void Recipe::emitCalcChanged(char const* prop, QVariant val)
+{
+   if ( m_uninitializedCalcs ) {
+      return;
+   }
+
+   if ( m_coalesceChanges ) {
+      m_pendingChanges.insert(prop, val);
+   }
+   else {
+      emit changed( metaProperty(prop), val );
+   }
 }
 
 void Recipe::recalcABV_pct() {
@@ -1697,36 +1786,17 @@ void Recipe::recalcABV_pct() {
 
    if ( ! qFuzzyCompare(ret,m_ABV_pct ) ) {
       m_ABV_pct = ret;
-      if (!m_uninitializedCalcs)
-      {
-        emit changed( metaProperty(PropertyNames::Recipe::ABV_pct), m_ABV_pct );
-      }
+      emitCalcChanged( PropertyNames::Recipe::ABV_pct, m_ABV_pct );
    }
 }
 
 void Recipe::recalcColor_srm()
 {
-   Fermentable *ferm;
-   double mcu = 0.0;
-   double ret;
-   int i;
-
-   QList<Fermentable*> ferms = fermentables();
-   for( i = 0; static_cast<int>(i) < ferms.size(); ++i )
-   {
-      ferm = ferms[i];
-      // Conversion factor for lb/gal to kg/l = 8.34538.
-      mcu += ferm->color_srm()*8.34538 * ferm->amount_kg()/ m_finalVolumeNoLosses_l;
-   }
-
-   ret = ColorMethods::mcuToSrm(mcu);
+   double ret = RecipeMath::color_srm( fermentableSnapshots(fermentables()), m_finalVolumeNoLosses_l );
 
    if ( ! qFuzzyCompare(m_color_srm, ret ) ) {
       m_color_srm = ret;
-      if (!m_uninitializedCalcs)
-      {
-        emit changed( metaProperty(PropertyNames::Recipe::color_srm), m_color_srm );
-      }
+      emitCalcChanged( PropertyNames::Recipe::color_srm, m_color_srm );
    }
 
 }
@@ -1747,20 +1817,11 @@ void Recipe::recalcIBU()
    }
 
    // Bitterness due to hopped extracts...
-   QList<Fermentable*> ferms = fermentables();
-   for( i = 0; static_cast<int>(i) < ferms.size(); ++i ) {
-      // Conversion factor for lb/gal to kg/l = 8.34538.
-      ibus +=
-              ferms[i]->ibuGalPerLb() *
-              (ferms[i]->amount_kg() / batchSize_l()) / 8.34538;
-   }
+   ibus += RecipeMath::ibuFromFermentables( fermentableSnapshots(fermentables()), batchSize_l() );
 
    if ( ! qFuzzyCompare(ibus, m_IBU ) ) {
       m_IBU = ibus;
-      if (!m_uninitializedCalcs)
-      {
-        emit changed( metaProperty(PropertyNames::Recipe::IBU), m_IBU );
-      }
+      emitCalcChanged( PropertyNames::Recipe::IBU, m_IBU );
    }
 }
 
@@ -1841,56 +1902,32 @@ void Recipe::recalcVolumeEstimates()
 
    if ( ! qFuzzyCompare(tmp_wfm, m_wortFromMash_l ) ) {
       m_wortFromMash_l = tmp_wfm;
-      if (!m_uninitializedCalcs) {
-        emit changed( metaProperty(PropertyNames::Recipe::wortFromMash_l), m_wortFromMash_l );
-      }
+      emitCalcChanged( PropertyNames::Recipe::wortFromMash_l, m_wortFromMash_l );
    }
 
    if ( ! qFuzzyCompare(tmp_bv, m_boilVolume_l ) ) {
         m_boilVolume_l = tmp_bv;
-      if (!m_uninitializedCalcs) {
-        emit changed( metaProperty(PropertyNames::Recipe::boilVolume_l), m_boilVolume_l );
-      }
+      emitCalcChanged( PropertyNames::Recipe::boilVolume_l, m_boilVolume_l );
    }
 
    if ( ! qFuzzyCompare(tmp_fv, m_finalVolume_l ) ) {
        m_finalVolume_l = tmp_fv;
-      if (!m_uninitializedCalcs) {
-        emit changed( metaProperty(PropertyNames::Recipe::finalVolume_l), m_finalVolume_l );
-      }
+      emitCalcChanged( PropertyNames::Recipe::finalVolume_l, m_finalVolume_l );
    }
 
    if ( ! qFuzzyCompare(tmp_pbv, m_postBoilVolume_l ) ) {
       m_postBoilVolume_l = tmp_pbv;
-      if (!m_uninitializedCalcs) {
-        emit changed( metaProperty(PropertyNames::Recipe::postBoilVolume_l), m_postBoilVolume_l );
-      }
+      emitCalcChanged( PropertyNames::Recipe::postBoilVolume_l, m_postBoilVolume_l );
    }
 }
 
 void Recipe::recalcGrainsInMash_kg()
 {
-   int i, size;
-   double ret = 0.0;
-   Fermentable* ferm;
-
-   QList<Fermentable*> ferms = fermentables();
-   size = ferms.size();
-   for( i = 0; i < size; ++i )
-   {
-      ferm = ferms[i];
-
-      if( ferm->type() == Fermentable::Grain && ferm->isMashed() )
-      {
-         ret += ferm->amount_kg();
-      }
-   }
+   double ret = RecipeMath::grainsInMash_kg( fermentableSnapshots(fermentables()) );
 
    if ( ! qFuzzyCompare(ret, m_grainsInMash_kg )  ) {
       m_grainsInMash_kg = ret;
-      if (!m_uninitializedCalcs) {
-        emit changed( metaProperty(PropertyNames::Recipe::grainsInMash_kg), m_grainsInMash_kg );
-      }
+      emitCalcChanged( PropertyNames::Recipe::grainsInMash_kg, m_grainsInMash_kg );
    }
 }
 
@@ -1906,9 +1943,7 @@ void Recipe::recalcGrains_kg()
 
    if ( ! qFuzzyCompare(ret, m_grains_kg ) ) {
       m_grains_kg = ret;
-      if (!m_uninitializedCalcs) {
-        emit changed( metaProperty(PropertyNames::Recipe::grains_kg), m_grains_kg );
-      }
+      emitCalcChanged( PropertyNames::Recipe::grains_kg, m_grains_kg );
    }
 }
 
@@ -1919,10 +1954,7 @@ void Recipe::recalcSRMColor()
    if ( tmp != m_SRMColor )
    {
       m_SRMColor = tmp;
-      if (!m_uninitializedCalcs)
-      {
-        emit changed( metaProperty(PropertyNames::Recipe::SRMColor), m_SRMColor );
-      }
+      emitCalcChanged( PropertyNames::Recipe::SRMColor, m_SRMColor );
    }
 }
 
@@ -1958,9 +1990,7 @@ void Recipe::recalcCalories()
 
    if ( ! qFuzzyCompare(tmp, m_calories ) ) {
       m_calories = tmp;
-      if (!m_uninitializedCalcs) {
-        emit changed( metaProperty(PropertyNames::Recipe::calories), m_calories );
-      }
+      emitCalcChanged( PropertyNames::Recipe::calories, m_calories );
    }
 }
 
@@ -1969,47 +1999,14 @@ void Recipe::recalcCalories()
 // split that calcuation out of recalcOgFg();
 QHash<QString,double> Recipe::calcTotalPoints()
 {
-   int i;
-   double sugar_kg_ignoreEfficiency = 0.0;
-   double sugar_kg                  = 0.0;
-   double nonFermentableSugars_kg    = 0.0;
-   double lateAddition_kg           = 0.0;
-   double lateAddition_kg_ignoreEff = 0.0;
-
-   Fermentable* ferm;
-
-   QList<Fermentable*> ferms = fermentables();
+   RecipeMath::Sugars sugars = RecipeMath::totalPoints( fermentableSnapshots(fermentables()) );
    QHash<QString,double> ret;
 
-   for( i = 0; static_cast<int>(i) < ferms.size(); ++i )
-   {
-      ferm = ferms[i];
-
-      // If we have some sort of non-grain, we have to ignore efficiency.
-      if( ferm->isSugar() || ferm->isExtract() )
-      {
-         sugar_kg_ignoreEfficiency += ferm->equivSucrose_kg();
-
-         if (ferm->addAfterBoil())
-            lateAddition_kg_ignoreEff += ferm->equivSucrose_kg();
-
-         if ( !isFermentableSugar(ferm) )
-           nonFermentableSugars_kg += ferm->equivSucrose_kg();
-      }
-      else
-      {
-         sugar_kg += ferm->equivSucrose_kg();
-
-         if (ferm->addAfterBoil())
-            lateAddition_kg += ferm->equivSucrose_kg();
-      }
-   }
-
-   ret.insert("sugar_kg", sugar_kg);
-   ret.insert("nonFermentableSugars_kg", nonFermentableSugars_kg);
-   ret.insert("sugar_kg_ignoreEfficiency", sugar_kg_ignoreEfficiency);
-   ret.insert("lateAddition_kg", lateAddition_kg);
-   ret.insert("lateAddition_kg_ignoreEff", lateAddition_kg_ignoreEff);
+   ret.insert("sugar_kg", sugars.sugar_kg);
+   ret.insert("nonFermentableSugars_kg", sugars.nonFermentableSugars_kg);
+   ret.insert("sugar_kg_ignoreEfficiency", sugars.sugar_kg_ignoreEfficiency);
+   ret.insert("lateAddition_kg", sugars.lateAddition_kg);
+   ret.insert("lateAddition_kg_ignoreEff", sugars.lateAddition_kg_ignoreEff);
 
    return ret;
 
@@ -2038,30 +2035,13 @@ void Recipe::recalcBoilGrav()
 
    if ( ! qFuzzyCompare(ret, m_boilGrav ) ) {
       m_boilGrav = ret;
-      if (!m_uninitializedCalcs)
-      {
-        emit changed( metaProperty(PropertyNames::Recipe::boilGrav), m_boilGrav );
-      }
+      emitCalcChanged( PropertyNames::Recipe::boilGrav, m_boilGrav );
    }
 }
 
 void Recipe::recalcOgFg()
 {
-   int i;
-   double plato;
-   double sugar_kg = 0;
-   double sugar_kg_ignoreEfficiency = 0.0;
-   double nonFermentableSugars_kg = 0.0;
-   double kettleWort_l = 0.0;
-   double postBoilWort_l = 0.0;
-   double ratio = 0.0;
-   double ferm_kg = 0.0;
-   double attenuation_pct = 0.0;
-   double tmp_og, tmp_fg, tmp_pnts, tmp_ferm_pnts, tmp_nonferm_pnts;
-   Yeast* yeast;
-   QHash<QString,double> sugars;
-
-   m_og_fermentable = m_fg_fermentable = 0.0;
+   double ratio = 1.0;
 
    // The first time through really has to get the _og and _fg from the
    // database, not use the initialized values of 1. I (maf) tried putting
@@ -2077,79 +2057,26 @@ void Recipe::recalcOgFg()
       m_fg = Brewtarget::toDouble(this, PropertyNames::Recipe::fg, "Recipe::recalcOgFg()");
    }
 
-   // Find out how much sugar we have.
-   sugars = calcTotalPoints();
-   sugar_kg                  = sugars.value("sugar_kg");  // Mass of sugar that *is* affected by mash efficiency
-   sugar_kg_ignoreEfficiency = sugars.value("sugar_kg_ignoreEfficiency");  // Mass of sugar that *is not* affected by mash efficiency
-   nonFermentableSugars_kg    = sugars.value("nonFermentableSugars_kg");  // Mass of sugar that is not fermentable (also counted in sugar_kg_ignoreEfficiency)
-
    // We might lose some sugar in the form of Trub/Chiller loss and lauter deadspace.
    if( equipment() != nullptr ) {
-
-      kettleWort_l = (m_wortFromMash_l - equipment()->lauterDeadspace_l()) + equipment()->topUpKettle_l();
-      postBoilWort_l = equipment()->wortEndOfBoil_l(kettleWort_l);
-      ratio = (postBoilWort_l - equipment()->trubChillerLoss_l()) / postBoilWort_l;
-      if( ratio > 1.0 ) // Usually happens when we don't have a mash yet.
-         ratio = 1.0;
-      else if( ratio < 0.0 )
-         ratio = 0.0;
-      else if( Algorithms::isNan(ratio) )
-         ratio = 1.0;
-      // Ignore this again since it should be included in efficiency.
-      //sugar_kg *= ratio;
-      sugar_kg_ignoreEfficiency *= ratio;
-      if ( nonFermentableSugars_kg != 0.0 )
-         nonFermentableSugars_kg *= ratio;
-   }
-
-   // Total sugars after accounting for efficiency and mash losses. Implicitly includes non-fermentable sugars
-   sugar_kg = sugar_kg * efficiency_pct()/100.0 + sugar_kg_ignoreEfficiency;
-   plato = Algorithms::getPlato( sugar_kg, m_finalVolumeNoLosses_l);
-
-   tmp_og = Algorithms::PlatoToSG_20C20C( plato );  // og from all sugars
-   tmp_pnts = (tmp_og-1)*1000.0;  // points from all sugars
-   if ( nonFermentableSugars_kg != 0.0 )
-   {
-      ferm_kg = sugar_kg - nonFermentableSugars_kg;  // Mass of only fermentable sugars
-      plato = Algorithms::getPlato( ferm_kg, m_finalVolumeNoLosses_l);  // Plato from fermentable sugars
-      m_og_fermentable = Algorithms::PlatoToSG_20C20C( plato );  // og from only fermentable sugars
-      plato = Algorithms::getPlato( nonFermentableSugars_kg, m_finalVolumeNoLosses_l);  // Plate from non-fermentable sugars
-      tmp_nonferm_pnts = ((Algorithms::PlatoToSG_20C20C( plato ))-1)*1000.0;  // og points from non-fermentable sugars
-   }
-   else
-   {
-      m_og_fermentable = tmp_og;
-      tmp_nonferm_pnts = 0;
+      double kettleWort_l = (m_wortFromMash_l - equipment()->lauterDeadspace_l()) + equipment()->topUpKettle_l();
+      ratio = RecipeMath::lossRatio( equipment()->wortEndOfBoil_l(kettleWort_l), equipment()->trubChillerLoss_l() );
    }
 
-   // Calculage FG
-   QList<Yeast*> yeasties = yeasts();
-   for( i = 0; static_cast<int>(i) < yeasties.size(); ++i )
-   {
-      yeast = yeasties[i];
-      // Get the yeast with the greatest attenuation.
-      if( yeast->attenuation_pct() > attenuation_pct )
-         attenuation_pct = yeast->attenuation_pct();
-   }
-   // This means we have yeast, but they neglected to provide attenuation percentages.
-   if( yeasties.size() > 0 && attenuation_pct <= 0.0 )  {
-      attenuation_pct = 75.0; // 75% is an average attenuation.
+   QVector<double> attenuations;
+   foreach( Yeast* yeast, yeasts() ) {
+      attenuations.append( yeast->attenuation_pct() );
    }
 
-   if ( nonFermentableSugars_kg != 0.0 )
-   {
-      tmp_ferm_pnts = (tmp_pnts-tmp_nonferm_pnts) * (1.0 - attenuation_pct/100.0);  // fg points from fermentable sugars
-      tmp_pnts = tmp_ferm_pnts + tmp_nonferm_pnts;  // FG points from both fermentable and non-fermentable sugars
-      //tmp_pnts *= (1.0 - attenuation_pct/100.0);  // WTF, this completely ignores all the calculations about non-fermentable sugars and just converts everything!
-      tmp_fg =  1 + tmp_pnts/1000.0;  // new FG value
-      m_fg_fermentable =  1 + tmp_ferm_pnts/1000.0;  // FG from fermentables only
-   }
-   else
-   {
-      tmp_pnts *= (1.0 - attenuation_pct/100.0);
-      tmp_fg =  1 + tmp_pnts/1000.0;
-      m_fg_fermentable = tmp_fg;
-   }
+   RecipeMath::Gravities grav = RecipeMath::ogFg( RecipeMath::totalPoints( fermentableSnapshots(fermentables()) ),
+                                                  efficiency_pct(),
+                                                  ratio,
+                                                  m_finalVolumeNoLosses_l,
+                                                  RecipeMath::attenuation_pct(attenuations) );
+   double tmp_og = grav.og;
+   double tmp_fg = grav.fg;
+   m_og_fermentable = grav.og_fermentable;
+   m_fg_fermentable = grav.fg_fermentable;
 
    if ( ! qFuzzyCompare(m_og, tmp_og ) ) {
       m_og     = tmp_og;
@@ -2164,9 +2091,9 @@ void Recipe::recalcOgFg()
       if (!m_uninitializedCalcs)
       {
         setEasy(PropertyNames::Recipe::og, m_og, false );
-        emit changed( metaProperty(PropertyNames::Recipe::og), m_og );
-        emit changed( metaProperty(PropertyNames::Recipe::points), (m_og-1.0)*1e3 );
       }
+      emitCalcChanged( PropertyNames::Recipe::og, m_og );
+      emitCalcChanged( PropertyNames::Recipe::points, (m_og-1.0)*1e3 );
    }
 
    if ( ! qFuzzyCompare(tmp_fg, m_fg ) ) {
@@ -2174,8 +2101,8 @@ void Recipe::recalcOgFg()
       if (!m_uninitializedCalcs)
       {
         setEasy(PropertyNames::Recipe::fg, m_fg, false );
-        emit changed( metaProperty(PropertyNames::Recipe::fg), m_fg );
       }
+      emitCalcChanged( PropertyNames::Recipe::fg, m_fg );
    }
 }
 
@@ -2184,61 +2111,20 @@ void Recipe::recalcOgFg()
 double Recipe::ibuFromHop(Hop const* hop)
 {
    Equipment* equip = equipment();
-   double ibus = 0.0;
    double fwhAdjust = Brewtarget::toDouble(Brewtarget::option("firstWortHopAdjustment", 1.1).toString(), "Recipe::ibmFromHop()");
    double mashHopAdjust = Brewtarget::toDouble(Brewtarget::option("mashHopAdjustment", 0).toString(), "Recipe::ibmFromHop()");
 
    if( hop == nullptr )
       return 0.0;
 
-   double AArating = hop->alpha_pct()/100.0;
-   double grams = hop->amount_kg()*1000.0;
-   double minutes = hop->time_min();
-   // Assume 100% utilization until further notice
-   double hopUtilization = 1.0;
-   // Assume 60 min boil until further notice
-   int boilTime = 60;
-
-   // NOTE: we used to carefully calculate the average boil gravity and use it in the
-   // IBU calculations. However, due to John Palmer
-   // (http://homebrew.stackexchange.com/questions/7343/does-wort-gravity-affect-hop-utilization),
-   // it seems more appropriate to just use the OG directly, since it is the total
-   // amount of break material that truly affects the IBUs.
-
-   if( equip ) {
-      hopUtilization = equip->hopUtilization_pct() / 100.0;
-      boilTime = static_cast<int>(equip->boilTime_min());
-   }
-
-   if( hop->use() == Hop::Boil)
-      ibus = IbuMethods::getIbus( AArating, grams, m_finalVolumeNoLosses_l, m_og, minutes );
-   else if( hop->use() == Hop::First_Wort )
-      ibus = fwhAdjust * IbuMethods::getIbus( AArating, grams, m_finalVolumeNoLosses_l, m_og, boilTime );
-   else if( hop->use() == Hop::Mash && mashHopAdjust > 0.0 )
-      ibus = mashHopAdjust * IbuMethods::getIbus( AArating, grams, m_finalVolumeNoLosses_l, m_og, boilTime );
-
-   // Adjust for hop form. Tinseth's table was created from whole cone data,
-   // and it seems other formulae are optimized that way as well. So, the
-   // utilization is considered unadjusted for whole cones, and adjusted
-   // up for plugs and pellets.
-   //
-   // - http://www.realbeer.com/hops/FAQ.html
-   // - https://groups.google.com/forum/#!topic/brewtarget-help/mv2qvWBC4sU
-   switch( hop->form() ) {
-      case Hop::Plug:
-         hopUtilization *= 1.02;
-         break;
-      case Hop::Pellet:
-         hopUtilization *= 1.10;
-         break;
-      default:
-         break;
-   }
-
-   // Adjust for hop utilization.
-   ibus *= hopUtilization;
-
-   return ibus;
+   // Assume 100% utilization and a 60 min boil until further notice
+   return RecipeMath::ibuFromHop( RecipeMath::snapshot(hop),
+                                  m_finalVolumeNoLosses_l,
+                                  m_og,
+                                  equip ? equip->hopUtilization_pct() : 100.0,
+                                  equip ? static_cast<int>(equip->boilTime_min()) : 60,
+                                  fwhAdjust,
+                                  mashHopAdjust );
 }
 
 // this was fixed, but not with an at
@@ -2366,39 +2252,49 @@ QStringList Recipe::getReagents( QList<Salt*> salts, Salt::WhenToAdd wanted)
 //==========================Accept changes from ingredients====================
 
 void Recipe::acceptEquipChange(QMetaProperty prop, QVariant val) {
-   recalcAll();
+   // The equipment feeds the volumes, and everything else follows from there
+   recalc(RecalcVolumes);
 }
 
 void Recipe::acceptFermChange(QMetaProperty prop, QVariant val)
 {
-   recalcAll();
+   // A couple of properties only feed one calculation. Anything else could
+   // move the gravities, so everything that reads the fermentables goes.
+   QString propName = prop.name();
+   if ( propName == PropertyNames::Fermentable::color_srm ) {
+      recalc(RecalcColor);
+   }
+   else if ( propName == PropertyNames::Fermentable::ibuGalPerLb ) {
+      recalc(RecalcIBU);
+   }
+   else {
+      recalc(RecalcFermentableInputs);
+   }
 }
 
 void Recipe::onFermentableChanged()
 {
-   recalcAll();
+   recalc(RecalcFermentableInputs);
 }
 
 void Recipe::acceptHopChange(QMetaProperty prop, QVariant val)
 {
-   recalcIBU();
+   recalc(RecalcIBU);
 }
 
 void Recipe::acceptHopChange(Hop* hop)
 {
-   recalcIBU();
+   recalc(RecalcIBU);
 }
 
 void Recipe::acceptYeastChange(QMetaProperty prop, QVariant val)
 {
-   recalcOgFg();
-   recalcABV_pct();
+   recalc(RecalcOgFg);
 }
 
 void Recipe::acceptYeastChange(Yeast* yeast)
 {
-   recalcOgFg();
-   recalcABV_pct();
+   recalc(RecalcOgFg);
 }
 
 void Recipe::acceptMashChange(QMetaProperty prop, QVariant val)
@@ -2408,13 +2304,13 @@ void Recipe::acceptMashChange(QMetaProperty prop, QVariant val)
    if ( mashSend == nullptr )
       return;
 
-   recalcAll();
+   recalc(RecalcVolumes);
 }
 
 void Recipe::acceptMashChange(Mash* newMash)
 {
    if ( newMash == mash() )
-      recalcAll();
+      recalc(RecalcVolumes);
 }
 
 double Recipe::targetCollectedWortVol_l()
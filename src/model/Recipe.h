@@ -28,6 +28,7 @@
 #include <QDomDocument>
 #include <QDomNode>
 #include <QList>
+#include <QMap>
 #include <QMutex>
 #include <QString>
 #include <QVariant>
@@ -572,6 +573,45 @@ private:
    QMutex m_uninitializedCalcsMutex;
    QMutex m_recalcMutex;
 
+   /*!
+    * The calculated properties, as nodes in the recalculation graph. Each
+    * node is one of the recalc*() methods below. Callers mark the nodes whose
+    * inputs they changed, and recalcDirty() only runs those and the nodes
+    * downstream of them.
+    */
+   enum RecalcNode {
+      RecalcGrainsInMash = 0x001,
+      RecalcGrains       = 0x002,
+      RecalcVolumes      = 0x004,
+      RecalcColor        = 0x008,
+      RecalcSRMColor     = 0x010,
+      RecalcOgFg         = 0x020,
+      RecalcABV          = 0x040,
+      RecalcBoilGrav     = 0x080,
+      RecalcIBU          = 0x100,
+      RecalcCalories     = 0x200,
+      RecalcAllNodes     = 0x3ff,
+      //! Everything that reads the fermentables directly
+      RecalcFermentableInputs = RecalcGrainsInMash | RecalcGrains | RecalcVolumes | RecalcColor |
+                                RecalcOgFg | RecalcBoilGrav | RecalcIBU
+   };
+
+   //! One node of the graph: which nodes it reads, and how to recalculate it
+   struct RecalcGraphNode {
+      RecalcNode node;
+      unsigned int inputs;
+      void (Recipe::*recalc)();
+   };
+   //! The whole graph, in an order where every node comes after its inputs
+   static QVector<RecalcGraphNode> const recalcGraph;
+
+   //! The nodes that need to be recalculated
+   unsigned int m_dirtyCalcs;
+   //! True while recalcDirty() is running, so changed() signals get queued
+   bool m_coalesceChanges;
+   //! The queued changed() signals, one per property no matter how often it moved
+   QMap<QString,QVariant> m_pendingChanges;
+
    // version things
    QList<Recipe*> m_ancestors;
    bool m_hasDescendants;
@@ -592,6 +632,17 @@ private:
     * WARNING: this call took 0.15s in rev 916!
     */
    void recalcAll();
+   //! Marks \c nodes, and everything downstream of them, as needing a recalc
+   void markDirty(unsigned int nodes);
+   /*!
+    * Runs the dirty recalculators in dependency order, then emits one
+    * changed() for each calculated property that actually moved.
+    */
+   void recalcDirty();
+   //! Convenience for markDirty() followed by recalcDirty()
+   void recalc(unsigned int nodes);
+   //! Emits changed() for a calculated property, or queues it if we are in recalcDirty()
+   void emitCalcChanged(char const* prop, QVariant val);
    // Emits changed(ABV_pct). Depends on: _og, _fg
    Q_INVOKABLE void recalcABV_pct();
    // Emits changed(color_srm). Depends on: _finalVolume_l
@@ -613,7 +664,8 @@ private:
    // Emits changed(og), changed(fg). Depends on: _wortFromMash_l, _finalVolume_l
    Q_INVOKABLE void recalcOgFg();
 
-   // Adds instructions to the recipe.
+   // Make instructions for generateInstructions(). They are cache-only
+   // until Database::replaceInstructions() stores them.
    Instruction* postboilFermentablesIns();
    Instruction* postboilIns();
    Instruction* mashFermentableIns();
@@ -623,7 +675,8 @@ private:
    Instruction* saltWater(Salt::WhenToAdd when);
 
    //void setDefaults();
-   void addPreinstructions( QVector<PreInstruction> preins );
+   //! \brief Appends \c preins to \c ins, in descending time order
+   void addPreinstructions( QVector<PreInstruction> preins, QList<Instruction*>& ins );
    bool isValidType( const QString &str );
 };
 /*
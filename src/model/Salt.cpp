@@ -83,15 +83,15 @@ Salt::Salt(TableSchema* table, QSqlRecord rec, int t_key)
    : NamedEntity(table, rec, t_key),
    m_cacheOnly(false)
 {
-   m_amount = rec.value(table->propertyToColumn( PropertyNames::Salt::amount)).toDouble();
-   m_amount_is_weight = rec.value( table->propertyToColumn( PropertyNames::Salt::amountIsWeight)).toBool();
-   m_percent_acid = rec.value( table->propertyToColumn( PropertyNames::Salt::percentAcid)).toDouble();
-   m_is_acid = rec.value( table->propertyToColumn( PropertyNames::Salt::isAcid)).toBool();
+   m_amount = table->value(rec, PropertyNames::Salt::amount).toDouble();
+   m_amount_is_weight = table->value(rec, PropertyNames::Salt::amountIsWeight).toBool();
+   m_percent_acid = table->value(rec, PropertyNames::Salt::percentAcid).toDouble();
+   m_is_acid = table->value(rec, PropertyNames::Salt::isAcid).toBool();
    // foreign keys suck
-   m_misc_id = rec.value(table->foreignKeyToColumn( PropertyNames::Salt::misc_id)).toInt();
+   m_misc_id = table->foreignKeyValue(rec, PropertyNames::Salt::misc_id).toInt();
 
-   m_add_to = static_cast<Salt::WhenToAdd>(rec.value( table->propertyToColumn( PropertyNames::Salt::addTo)).toInt());
-   m_type = static_cast<Salt::Types>(rec.value( table->propertyToColumn( PropertyNames::Salt::type)).toInt());
+   m_add_to = static_cast<Salt::WhenToAdd>(table->value(rec, PropertyNames::Salt::addTo).toInt());
+   m_type = static_cast<Salt::Types>(table->value(rec, PropertyNames::Salt::type).toInt());
 }
 
 //================================"SET" METHODS=================================
@@ -84,27 +84,27 @@ Style::Style(TableSchema* table, QSqlRecord rec, int t_key)
    : NamedEntity(table, rec, t_key),
      m_cacheOnly(false)
 {
-     m_category = rec.value( table->propertyToColumn( PropertyNames::Style::category)).toString();
-     m_categoryNumber = rec.value( table->propertyToColumn( PropertyNames::Style::categoryNumber)).toString();
-     m_styleLetter = rec.value( table->propertyToColumn( PropertyNames::Style::styleLetter)).toString();
-     m_styleGuide = rec.value( table->propertyToColumn( PropertyNames::Style::styleGuide)).toString();
-     m_typeStr = rec.value( table->propertyToColumn( PropertyNames::Style::type)).toString();
-     m_ogMin = rec.value( table->propertyToColumn( PropertyNames::Style::ogMin)).toDouble();
-     m_ogMax = rec.value( table->propertyToColumn( PropertyNames::Style::ogMax)).toDouble();
-     m_fgMin = rec.value( table->propertyToColumn( PropertyNames::Style::fgMin)).toDouble();
-     m_fgMax = rec.value( table->propertyToColumn( PropertyNames::Style::fgMax)).toDouble();
-     m_ibuMin = rec.value( table->propertyToColumn( PropertyNames::Style::ibuMin)).toDouble();
-     m_ibuMax = rec.value( table->propertyToColumn( PropertyNames::Style::ibuMax)).toDouble();
-     m_colorMin_srm = rec.value( table->propertyToColumn( PropertyNames::Style::colorMin_srm)).toDouble();
-     m_colorMax_srm = rec.value( table->propertyToColumn( PropertyNames::Style::colorMax_srm)).toDouble();
-     m_carbMin_vol = rec.value( table->propertyToColumn( PropertyNames::Style::carbMin_vol)).toDouble();
-     m_carbMax_vol = rec.value( table->propertyToColumn( PropertyNames::Style::carbMax_vol)).toDouble();
-     m_abvMin_pct = rec.value( table->propertyToColumn( PropertyNames::Style::abvMin_pct)).toDouble();
-     m_abvMax_pct = rec.value( table->propertyToColumn( PropertyNames::Style::abvMax_pct)).toDouble();
-     m_notes = rec.value( table->propertyToColumn( PropertyNames::Style::notes)).toString();
-     m_profile = rec.value( table->propertyToColumn( PropertyNames::Style::profile)).toString();
-     m_ingredients = rec.value( table->propertyToColumn( PropertyNames::Style::ingredients)).toString();
-     m_examples = rec.value( table->propertyToColumn( PropertyNames::Style::examples)).toString();
+     m_category = table->value(rec, PropertyNames::Style::category).toString();
+     m_categoryNumber = table->value(rec, PropertyNames::Style::categoryNumber).toString();
+     m_styleLetter = table->value(rec, PropertyNames::Style::styleLetter).toString();
+     m_styleGuide = table->value(rec, PropertyNames::Style::styleGuide).toString();
+     m_typeStr = table->value(rec, PropertyNames::Style::type).toString();
+     m_ogMin = table->value(rec, PropertyNames::Style::ogMin).toDouble();
+     m_ogMax = table->value(rec, PropertyNames::Style::ogMax).toDouble();
+     m_fgMin = table->value(rec, PropertyNames::Style::fgMin).toDouble();
+     m_fgMax = table->value(rec, PropertyNames::Style::fgMax).toDouble();
+     m_ibuMin = table->value(rec, PropertyNames::Style::ibuMin).toDouble();
+     m_ibuMax = table->value(rec, PropertyNames::Style::ibuMax).toDouble();
+     m_colorMin_srm = table->value(rec, PropertyNames::Style::colorMin_srm).toDouble();
+     m_colorMax_srm = table->value(rec, PropertyNames::Style::colorMax_srm).toDouble();
+     m_carbMin_vol = table->value(rec, PropertyNames::Style::carbMin_vol).toDouble();
+     m_carbMax_vol = table->value(rec, PropertyNames::Style::carbMax_vol).toDouble();
+     m_abvMin_pct = table->value(rec, PropertyNames::Style::abvMin_pct).toDouble();
+     m_abvMax_pct = table->value(rec, PropertyNames::Style::abvMax_pct).toDouble();
+     m_notes = table->value(rec, PropertyNames::Style::notes).toString();
+     m_profile = table->value(rec, PropertyNames::Style::profile).toString();
+     m_ingredients = table->value(rec, PropertyNames::Style::ingredients).toString();
+     m_examples = table->value(rec, PropertyNames::Style::examples).toString();
 
      m_type = static_cast<Style::Type>(m_types.indexOf(m_typeStr));
 }
@@ -93,21 +93,21 @@ Water::Water(TableSchema* table, QSqlRecord rec, int t_key)
    : NamedEntity(table, rec, t_key),
    m_cacheOnly(false)
 {
-   m_amount = rec.value( table->propertyToColumn( PropertyNames::Water::amount)).toDouble();
-   m_calcium_ppm = rec.value( table->propertyToColumn( PropertyNames::Water::calcium_ppm)).toDouble();
-   m_bicarbonate_ppm = rec.value( table->propertyToColumn( PropertyNames::Water::bicarbonate_ppm)).toDouble();
-   m_sulfate_ppm = rec.value( table->propertyToColumn( PropertyNames::Water::sulfate_ppm)).toDouble();
-   m_chloride_ppm = rec.value( table->propertyToColumn( PropertyNames::Water::chloride_ppm)).toDouble();
-   m_sodium_ppm = rec.value( table->propertyToColumn( PropertyNames::Water::sodium_ppm)).toDouble();
-   m_magnesium_ppm = rec.value( table->propertyToColumn( PropertyNames::Water::magnesium_ppm)).toDouble();
-   m_ph = rec.value( table->propertyToColumn( PropertyNames::Water::ph)).toDouble();
-   m_alkalinity = rec.value( table->propertyToColumn( PropertyNames::Water::alkalinity)).toDouble();
-   m_notes = rec.value( table->propertyToColumn( PropertyNames::Water::notes)).toString();
-   m_type = static_cast<Water::Types>(rec.value( table->propertyToColumn( PropertyNames::Water::type)).toInt());
-   m_mash_ro = rec.value( table->propertyToColumn( PropertyNames::Water::mashRO)).toDouble();
-   m_sparge_ro = rec.value( table->propertyToColumn( PropertyNames::Water::spargeRO)).toDouble();
-
-   m_alkalinity_as_hco3 = rec.value( table->propertyToColumn( PropertyNames::Water::alkalinityAsHCO3)).toBool();
+   m_amount = table->value(rec, PropertyNames::Water::amount).toDouble();
+   m_calcium_ppm = table->value(rec, PropertyNames::Water::calcium_ppm).toDouble();
+   m_bicarbonate_ppm = table->value(rec, PropertyNames::Water::bicarbonate_ppm).toDouble();
+   m_sulfate_ppm = table->value(rec, PropertyNames::Water::sulfate_ppm).toDouble();
+   m_chloride_ppm = table->value(rec, PropertyNames::Water::chloride_ppm).toDouble();
+   m_sodium_ppm = table->value(rec, PropertyNames::Water::sodium_ppm).toDouble();
+   m_magnesium_ppm = table->value(rec, PropertyNames::Water::magnesium_ppm).toDouble();
+   m_ph = table->value(rec, PropertyNames::Water::ph).toDouble();
+   m_alkalinity = table->value(rec, PropertyNames::Water::alkalinity).toDouble();
+   m_notes = table->value(rec, PropertyNames::Water::notes).toString();
+   m_type = static_cast<Water::Types>(table->value(rec, PropertyNames::Water::type).toInt());
+   m_mash_ro = table->value(rec, PropertyNames::Water::mashRO).toDouble();
+   m_sparge_ro = table->value(rec, PropertyNames::Water::spargeRO).toDouble();
+
+   m_alkalinity_as_hco3 = table->value(rec, PropertyNames::Water::alkalinityAsHCO3).toBool();
 
 }
 
@@ -88,24 +88,24 @@ Yeast::Yeast(TableSchema* table, QSqlRecord rec, int t_key)
      m_inventory(-1),
      m_cacheOnly(false)
 {
-     m_typeString = rec.value( table->propertyToColumn( PropertyNames::Yeast::type)).toString();
-     m_formString = rec.value( table->propertyToColumn( PropertyNames::Yeast::form)).toString();
-     m_flocculationString = rec.value( table->propertyToColumn( PropertyNames::Yeast::flocculation)).toString();
-     m_amount = rec.value( table->propertyToColumn( PropertyNames::Yeast::amount)).toDouble();
-     m_amountIsWeight = rec.value( table->propertyToColumn( PropertyNames::Yeast::amountIsWeight)).toBool();
-     m_laboratory = rec.value( table->propertyToColumn( PropertyNames::Yeast::laboratory)).toString();
-     m_productID = rec.value( table->propertyToColumn( PropertyNames::Yeast::productID)).toString();
-     m_minTemperature_c = rec.value( table->propertyToColumn( PropertyNames::Yeast::minTemperature_c)).toDouble();
-     m_maxTemperature_c = rec.value( table->propertyToColumn( PropertyNames::Yeast::maxTemperature_c)).toDouble();
-     m_attenuation_pct = rec.value( table->propertyToColumn( PropertyNames::Yeast::attenuation_pct)).toDouble();
-     m_notes = rec.value( table->propertyToColumn( PropertyNames::Yeast::notes)).toString();
-     m_bestFor = rec.value( table->propertyToColumn( PropertyNames::Yeast::bestFor)).toString();
-     m_timesCultured = rec.value( table->propertyToColumn( PropertyNames::Yeast::timesCultured)).toInt();
-     m_maxReuse = rec.value( table->propertyToColumn( PropertyNames::Yeast::maxReuse)).toInt();
-     m_addToSecondary = rec.value( table->propertyToColumn( PropertyNames::Yeast::addToSecondary)).toBool();
+     m_typeString = table->value(rec, PropertyNames::Yeast::type).toString();
+     m_formString = table->value(rec, PropertyNames::Yeast::form).toString();
+     m_flocculationString = table->value(rec, PropertyNames::Yeast::flocculation).toString();
+     m_amount = table->value(rec, PropertyNames::Yeast::amount).toDouble();
+     m_amountIsWeight = table->value(rec, PropertyNames::Yeast::amountIsWeight).toBool();
+     m_laboratory = table->value(rec, PropertyNames::Yeast::laboratory).toString();
+     m_productID = table->value(rec, PropertyNames::Yeast::productID).toString();
+     m_minTemperature_c = table->value(rec, PropertyNames::Yeast::minTemperature_c).toDouble();
+     m_maxTemperature_c = table->value(rec, PropertyNames::Yeast::maxTemperature_c).toDouble();
+     m_attenuation_pct = table->value(rec, PropertyNames::Yeast::attenuation_pct).toDouble();
+     m_notes = table->value(rec, PropertyNames::Yeast::notes).toString();
+     m_bestFor = table->value(rec, PropertyNames::Yeast::bestFor).toString();
+     m_timesCultured = table->value(rec, PropertyNames::Yeast::timesCultured).toInt();
+     m_maxReuse = table->value(rec, PropertyNames::Yeast::maxReuse).toInt();
+     m_addToSecondary = table->value(rec, PropertyNames::Yeast::addToSecondary).toBool();
 
      // foreign keys blow
-     m_inventory_id = rec.value( table->foreignKeyToColumn( PropertyNames::Yeast::inventory_id)).toInt();
+     m_inventory_id = table->foreignKeyValue(rec, PropertyNames::Yeast::inventory_id).toInt();
 
      m_type = static_cast<Yeast::Type>(types.indexOf(m_typeString));
      m_form = static_cast<Yeast::Form>(forms.indexOf(m_formString));
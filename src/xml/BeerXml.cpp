@@ -19,6 +19,7 @@
  */
 #include "xml/BeerXml.h"
 
+#include <cstring>
 #include <stdexcept>
 
 #include <QList>
@@ -37,8 +38,12 @@
 #include <QThread>
 #include <QDebug>
 #include <QPair>
+#include <QXmlStreamWriter>
+
+#include <zlib.h>
 
 #include "Algorithms.h"
+#include "config.h"
 #include "DatabaseSchema.h"
 #include "model/BrewNote.h"
 #include "model/Equipment.h"
@@ -63,6 +68,75 @@
 //
 namespace {
 
+   /*
+    * Deflates whatever is written to it, with a gzip header, into another
+    * device. Write-only, and only finished when it is closed
+    */
+   class GzipDevice : public QIODevice
+   {
+   public:
+      GzipDevice(QIODevice* target) : target(target), failed(false)
+      {
+         std::memset(&stream, 0, sizeof(stream));
+         // 15 + 16 asks zlib for a gzip header instead of a zlib one
+         failed = deflateInit2(&stream, 6, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK;
+      }
+
+      ~GzipDevice()
+      {
+         close();
+         deflateEnd(&stream);
+      }
+
+      void close() override
+      {
+         if ( isOpen() )
+            deflateChunk(nullptr, 0, Z_FINISH);
+         QIODevice::close();
+      }
+
+      bool hasFailed() const { return failed; }
+
+   protected:
+      qint64 readData(char*, qint64) override { return -1; }
+
+      qint64 writeData(char const* data, qint64 len) override
+      {
+         return deflateChunk(data, len, Z_NO_FLUSH) ? len : -1;
+      }
+
+   private:
+      bool deflateChunk(char const* data, qint64 len, int flush)
+      {
+         char buffer[1 << 14];
+
+         if ( failed )
+            return false;
+
+         stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+         stream.avail_in = static_cast<uInt>(len);
+         do {
+            stream.next_out = reinterpret_cast<Bytef*>(buffer);
+            stream.avail_out = sizeof(buffer);
+            if ( deflate(&stream, flush) == Z_STREAM_ERROR ) {
+               failed = true;
+               return false;
+            }
+            qint64 have = static_cast<qint64>(sizeof(buffer) - stream.avail_out);
+            if ( have > 0 && target->write(buffer, have) != have ) {
+               failed = true;
+               return false;
+            }
+         } while ( stream.avail_out == 0 );
+
+         return true;
+      }
+
+      QIODevice* target;
+      z_stream stream;
+      bool failed;
+   };
+
    ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
    // Top-level field mappings for BeerXML files
    ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -671,7 +745,8 @@ public:
       };
       BtDomErrorHandler domErrorHandler(&errorPatternsToIgnore, 1, 1);
 
-      return this->BeerXml1Coding.validateLoadAndStoreInDb(documentData, fileName, domErrorHandler, userMessage);
+      // The streaming reader validates with SAX and reads in one pass, so it doesn't need a DOM of the whole file
+      return this->BeerXml1Coding.streamLoadAndStoreInDb(documentData, fileName, domErrorHandler, userMessage);
 
    }
 
@@ -708,198 +783,145 @@ QString BeerXML::textFromValue(QVariant value, QString type)
    return retval;
 }
 
-void BeerXML::toXml( BrewNote* a, QDomDocument& doc, QDomNode& parent )
+// Streaming export ===========================================================
+BeerXML::ExportList BeerXML::everything()
 {
-   QDomElement node;
-   QDomElement tmpElement;
-   QDomText tmpText;
-   TableSchema* tbl = m_tables->table(Brewtarget::BREWNOTETABLE);
-
-   node = doc.createElement("BREWNOTE");
-
-   // This sucks. Not quite sure what to do, but hard code it
-   tmpElement = doc.createElement("VERSION");
-   tmpText = doc.createTextNode(NamedEntity::text(a->version()));
-   tmpElement.appendChild(tmpText);
-   node.appendChild(tmpElement);
-
-   foreach (QString element, tbl->allProperties()) {
-      if ( ! tbl->propertyToXml(element).isEmpty() ) {
-         QString prop = tbl->propertyName(element);
-         tmpElement = doc.createElement(tbl->propertyToXml(element));
-         tmpText    = doc.createTextNode(textFromValue(a->property(prop.toUtf8().data()), tbl->propertyColumnType(element)));
-         tmpElement.appendChild(tmpText);
-         node.appendChild(tmpElement);
-      }
-   }
-   parent.appendChild(node);
+   ExportList items;
+   Database& db = Database::instance();
+
+   // Anything not displayed belongs to a recipe, or is an old version of one,
+   // and goes out with its recipe if at all
+   foreach( Recipe* a, db.recipes() )
+      if ( a->display() ) items.recipes.append(a);
+   foreach( Equipment* a, db.equipments() )
+      if ( a->display() ) items.equipments.append(a);
+   foreach( Fermentable* a, db.fermentables() )
+      if ( a->display() ) items.fermentables.append(a);
+   foreach( Hop* a, db.hops() )
+      if ( a->display() ) items.hops.append(a);
+   foreach( Misc* a, db.miscs() )
+      if ( a->display() ) items.miscs.append(a);
+   foreach( Style* a, db.styles() )
+      if ( a->display() ) items.styles.append(a);
+   foreach( Water* a, db.waters() )
+      if ( a->display() ) items.waters.append(a);
+   foreach( Yeast* a, db.yeasts() )
+      if ( a->display() ) items.yeasts.append(a);
+
+   return items;
 }
 
-void BeerXML::toXml( Equipment* a, QDomDocument& doc, QDomNode& parent )
+template<class T> void BeerXML::writeGroup( QString const& groupTag, QList<T*> const& items, QXmlStreamWriter& out )
 {
-   QDomElement node;
-   QDomElement tmpElement;
-   QDomText tmpText;
-   TableSchema* tbl = m_tables->table(Brewtarget::EQUIPTABLE);
-
-   node = doc.createElement("EQUIPMENT");
-
-   // This sucks. Not quite sure what to do, but hard code it
-   tmpElement = doc.createElement("VERSION");
-   tmpText = doc.createTextNode(NamedEntity::text(a->version()));
-   tmpElement.appendChild(tmpText);
-   node.appendChild(tmpElement);
-
-   foreach (QString element, tbl->allProperties()) {
-      if ( ! tbl->propertyToXml(element).isEmpty() ) {
-         QString prop = tbl->propertyName(element);
-         tmpElement = doc.createElement(tbl->propertyToXml(element));
-         tmpText    = doc.createTextNode(textFromValue(a->property(prop.toUtf8().data()), tbl->propertyColumnType(element)));
-         tmpElement.appendChild(tmpText);
-         node.appendChild(tmpElement);
-      }
-   }
-   parent.appendChild(node);
+   out.writeStartElement(groupTag);
+   foreach( T* a, items )
+      toXml(a, out);
+   out.writeEndElement();
 }
 
-void BeerXML::toXml( Fermentable* a, QDomDocument& doc, QDomNode& parent )
+bool BeerXML::exportToXml( ExportList const& items, QIODevice* device, bool compress )
 {
-   QDomElement node;
-   QDomElement tmpElement;
-   QDomText tmpText;
-   TableSchema* tbl = m_tables->table(Brewtarget::FERMTABLE);
-
-   node = doc.createElement("FERMENTABLE");
+   GzipDevice gzip(device);
+   QIODevice* dest = device;
 
-   // This sucks. Not quite sure what to do, but hard code it
-   tmpElement = doc.createElement("VERSION");
-   tmpText = doc.createTextNode(NamedEntity::text(a->version()));
-   tmpElement.appendChild(tmpText);
-   node.appendChild(tmpElement);
-
-   foreach (QString element, tbl->allProperties()) {
-      if ( ! tbl->propertyToXml(element).isEmpty() ) {
-         QString prop = tbl->propertyName(element);
-         tmpElement = doc.createElement(tbl->propertyToXml(element));
-         tmpText    = doc.createTextNode(textFromValue(a->property(prop.toUtf8().data()), tbl->propertyColumnType(element)));
-         tmpElement.appendChild(tmpText);
-         node.appendChild(tmpElement);
+   if ( compress ) {
+      if ( gzip.hasFailed() || ! gzip.open(QIODevice::WriteOnly) ) {
+         qCritical() << QString("%1 could not start compressing").arg(Q_FUNC_INFO);
+         return false;
       }
+      dest = &gzip;
    }
-   parent.appendChild(node);
 
+   QXmlStreamWriter out(dest);
+   out.setAutoFormatting(true);
+   out.setAutoFormattingIndent(1);
+
+   // BeerXML has no root element. Each kind of thing gets its own group at
+   // the top level, which is what the importer expects
+   out.writeStartDocument();
+   out.writeComment(QString(" BeerXML generated by Brewtarget %1 ").arg(VERSIONSTRING));
+   if ( ! items.recipes.isEmpty() )      writeGroup("RECIPES", items.recipes, out);
+   if ( ! items.equipments.isEmpty() )   writeGroup("EQUIPMENTS", items.equipments, out);
+   if ( ! items.fermentables.isEmpty() ) writeGroup("FERMENTABLES", items.fermentables, out);
+   if ( ! items.hops.isEmpty() )         writeGroup("HOPS", items.hops, out);
+   if ( ! items.miscs.isEmpty() )        writeGroup("MISCS", items.miscs, out);
+   if ( ! items.styles.isEmpty() )       writeGroup("STYLES", items.styles, out);
+   if ( ! items.waters.isEmpty() )       writeGroup("WATERS", items.waters, out);
+   if ( ! items.yeasts.isEmpty() )       writeGroup("YEASTS", items.yeasts, out);
+   out.writeEndDocument();
+
+   if ( compress )
+      gzip.close();
+
+   if ( out.hasError() || (compress && gzip.hasFailed()) ) {
+      qCritical() << QString("%1 could not write the export: %2").arg(Q_FUNC_INFO).arg(device->errorString());
+      return false;
+   }
+   return true;
 }
 
-void BeerXML::toXml( Hop* a, QDomDocument& doc, QDomNode& parent )
+void BeerXML::writeProperties( NamedEntity* a, TableSchema* tbl, QXmlStreamWriter& out )
 {
-
-   QDomElement node;
-   QDomElement tmpElement;
-   QDomText tmpText;
-   TableSchema* tbl = m_tables->table(Brewtarget::HOPTABLE);
-
-   node = doc.createElement("HOP");
-
    // This sucks. Not quite sure what to do, but hard code it
-   tmpElement = doc.createElement("VERSION");
-   tmpText = doc.createTextNode(NamedEntity::text(a->version()));
-   tmpElement.appendChild(tmpText);
-   node.appendChild(tmpElement);
+   out.writeTextElement("VERSION", NamedEntity::text(a->version()));
 
    foreach (QString element, tbl->allProperties()) {
       if ( ! tbl->propertyToXml(element).isEmpty() ) {
          QString prop = tbl->propertyName(element);
-         tmpElement = doc.createElement(tbl->propertyToXml(element));
-         tmpText    = doc.createTextNode(textFromValue(a->property(prop.toUtf8().data()), tbl->propertyColumnType(element)));
-         tmpElement.appendChild(tmpText);
-         node.appendChild(tmpElement);
+         out.writeTextElement(tbl->propertyToXml(element), textFromValue(a->property(prop.toUtf8().data()), tbl->propertyColumnType(element)));
       }
    }
-   parent.appendChild(node);
-
 }
 
-void BeerXML::toXml( Instruction* a, QDomDocument& doc, QDomNode& parent )
+void BeerXML::toXml( BrewNote* a, QXmlStreamWriter& out )
 {
-
-   QDomElement node;
-   QDomElement tmpElement;
-   QDomText tmpText;
-   TableSchema* tbl = m_tables->table(Brewtarget::INSTRUCTIONTABLE);
-
-   node = doc.createElement("INSTRUCTION");
-
-   // This sucks. Not quite sure what to do, but hard code it
-   tmpElement = doc.createElement("VERSION");
-   tmpText = doc.createTextNode(NamedEntity::text(a->version()));
-   tmpElement.appendChild(tmpText);
-   node.appendChild(tmpElement);
-
-   foreach (QString element, tbl->allProperties()) {
-      if ( ! tbl->propertyToXml(element).isEmpty() ) {
-         QString prop = tbl->propertyName(element);
-         tmpElement = doc.createElement(tbl->propertyToXml(element));
-         tmpText    = doc.createTextNode(textFromValue(a->property(prop.toUtf8().data()), tbl->propertyColumnType(element)));
-         tmpElement.appendChild(tmpText);
-         node.appendChild(tmpElement);
-      }
-   }
-   parent.appendChild(node);
-
+   out.writeStartElement("BREWNOTE");
+   writeProperties(a, m_tables->table(Brewtarget::BREWNOTETABLE), out);
+   out.writeEndElement();
 }
 
-void BeerXML::toXml( Mash* a, QDomDocument& doc, QDomNode& parent )
+void BeerXML::toXml( Equipment* a, QXmlStreamWriter& out )
 {
+   out.writeStartElement("EQUIPMENT");
+   writeProperties(a, m_tables->table(Brewtarget::EQUIPTABLE), out);
+   out.writeEndElement();
+}
 
-   QDomElement node;
-   QDomElement tmpElement;
-   QDomText tmpText;
-   int i, size;
-   TableSchema* tbl = m_tables->table(Brewtarget::MASHTABLE);
-
-   node = doc.createElement("MASH");
-
-   // This sucks. Not quite sure what to do, but hard code it
-   tmpElement = doc.createElement("VERSION");
-   tmpText = doc.createTextNode(NamedEntity::text(a->version()));
-   tmpElement.appendChild(tmpText);
-   node.appendChild(tmpElement);
-
-   foreach (QString element, tbl->allProperties()) {
-      if ( ! tbl->propertyToXml(element).isEmpty() ) {
-         QString prop = tbl->propertyName(element);
-         tmpElement = doc.createElement(tbl->propertyToXml(element));
-         tmpText    = doc.createTextNode(textFromValue(a->property(prop.toUtf8().data()), tbl->propertyColumnType(element)));
-         tmpElement.appendChild(tmpText);
-         node.appendChild(tmpElement);
-      }
-   }
+void BeerXML::toXml( Fermentable* a, QXmlStreamWriter& out )
+{
+   out.writeStartElement("FERMENTABLE");
+   writeProperties(a, m_tables->table(Brewtarget::FERMTABLE), out);
+   out.writeEndElement();
+}
 
-   tmpElement = doc.createElement("MASH_STEPS");
-   QList<MashStep*> mashSteps = a->mashSteps();
-   size = mashSteps.size();
-   for( i = 0; i < size; ++i )
-      toXml( mashSteps[i], doc, tmpElement);
-   node.appendChild(tmpElement);
+void BeerXML::toXml( Hop* a, QXmlStreamWriter& out )
+{
+   out.writeStartElement("HOP");
+   writeProperties(a, m_tables->table(Brewtarget::HOPTABLE), out);
+   out.writeEndElement();
+}
 
-   parent.appendChild(node);
+void BeerXML::toXml( Instruction* a, QXmlStreamWriter& out )
+{
+   out.writeStartElement("INSTRUCTION");
+   writeProperties(a, m_tables->table(Brewtarget::INSTRUCTIONTABLE), out);
+   out.writeEndElement();
+}
 
+void BeerXML::toXml( Mash* a, QXmlStreamWriter& out )
+{
+   out.writeStartElement("MASH");
+   writeProperties(a, m_tables->table(Brewtarget::MASHTABLE), out);
+   writeGroup("MASH_STEPS", a->mashSteps(), out);
+   out.writeEndElement();
 }
 
-void BeerXML::toXml( MashStep* a, QDomDocument& doc, QDomNode& parent )
+void BeerXML::toXml( MashStep* a, QXmlStreamWriter& out )
 {
-   QDomElement node;
-   QDomElement tmpElement;
-   QDomText tmpText;
    TableSchema* tbl = m_tables->table(Brewtarget::MASHSTEPTABLE);
 
-   node = doc.createElement("MASH_STEP");
-
-   // This sucks. Not quite sure what to do, but hard code it
-   tmpElement = doc.createElement("VERSION");
-   tmpText = doc.createTextNode(NamedEntity::text(a->version()));
-   tmpElement.appendChild(tmpText);
-   node.appendChild(tmpElement);
+   out.writeStartElement("MASH_STEP");
+   out.writeTextElement("VERSION", NamedEntity::text(a->version()));
 
    foreach (QString element, tbl->allProperties()) {
       if ( ! tbl->propertyToXml(element).isEmpty() ) {
@@ -913,205 +935,67 @@ void BeerXML::toXml( MashStep* a, QDomDocument& doc, QDomNode& parent )
          else {
             val = textFromValue(a->property(prop.toUtf8().data()), tbl->propertyColumnType(element));
          }
-         tmpElement = doc.createElement(tbl->propertyToXml(element));
-         tmpText    = doc.createTextNode(val);
-         tmpElement.appendChild(tmpText);
-         node.appendChild(tmpElement);
+         out.writeTextElement(tbl->propertyToXml(element), val);
       }
    }
-   parent.appendChild(node);
-
+   out.writeEndElement();
 }
 
-void BeerXML::toXml( Misc* a, QDomDocument& doc, QDomNode& parent )
+void BeerXML::toXml( Misc* a, QXmlStreamWriter& out )
 {
-   QDomElement node;
-   QDomElement tmpElement;
-   QDomText tmpText;
-   TableSchema* tbl = m_tables->table(Brewtarget::MISCTABLE);
-
-   node = doc.createElement("MISC");
-
-   // This sucks. Not quite sure what to do, but hard code it
-   tmpElement = doc.createElement("VERSION");
-   tmpText = doc.createTextNode(NamedEntity::text(a->version()));
-   tmpElement.appendChild(tmpText);
-   node.appendChild(tmpElement);
-
-   foreach (QString element, tbl->allProperties()) {
-      if ( ! tbl->propertyToXml(element).isEmpty() ) {
-         QString prop = tbl->propertyName(element);
-         tmpElement = doc.createElement(tbl->propertyToXml(element));
-         tmpText    = doc.createTextNode(textFromValue(a->property(prop.toUtf8().data()), tbl->propertyColumnType(element)));
-         tmpElement.appendChild(tmpText);
-         node.appendChild(tmpElement);
-      }
-   }
-   parent.appendChild(node);
+   out.writeStartElement("MISC");
+   writeProperties(a, m_tables->table(Brewtarget::MISCTABLE), out);
+   out.writeEndElement();
 }
 
-void BeerXML::toXml( Recipe* a, QDomDocument& doc, QDomNode& parent )
+void BeerXML::toXml( Recipe* a, QXmlStreamWriter& out )
 {
-   QDomElement node;
-   QDomElement tmpElement;
-   QDomText tmpText;
-   TableSchema* tbl = m_tables->table(Brewtarget::RECTABLE);
-
-   int i;
-
-   node = doc.createElement("RECIPE");
-
-   tmpElement = doc.createElement("VERSION");
-   tmpText = doc.createTextNode(NamedEntity::text(a->version()));
-   tmpElement.appendChild(tmpText);
-   node.appendChild(tmpElement);
-
-   foreach (QString element, tbl->allProperties()) {
-      if ( ! tbl->propertyToXml(element).isEmpty() ) {
-         QString prop = tbl->propertyName(element);
-         tmpElement = doc.createElement(tbl->propertyToXml(element));
-         tmpText    = doc.createTextNode(textFromValue(a->property(prop.toUtf8().data()), tbl->propertyColumnType(element)));
-         tmpElement.appendChild(tmpText);
-         node.appendChild(tmpElement);
-      }
-   }
+   out.writeStartElement("RECIPE");
+   writeProperties(a, m_tables->table(Brewtarget::RECTABLE), out);
 
    Style* style = a->style();
    if( style != nullptr )
-      toXml( style, doc, node);
-
-   tmpElement = doc.createElement("HOPS");
-   QList<Hop*> hops = a->hops();
-   for( i = 0; i < hops.size(); ++i )
-      toXml( hops[i], doc, tmpElement);
-   node.appendChild(tmpElement);
-
-   tmpElement = doc.createElement("FERMENTABLES");
-   QList<Fermentable*> ferms = a->fermentables();
-   for( i = 0; i < ferms.size(); ++i )
-      toXml( ferms[i], doc, tmpElement);
-   node.appendChild(tmpElement);
-
-   tmpElement = doc.createElement("MISCS");
-   QList<Misc*> miscs = a->miscs();
-   for( i = 0; i < miscs.size(); ++i )
-      toXml( miscs[i], doc, tmpElement);
-   node.appendChild(tmpElement);
-
-   tmpElement = doc.createElement("YEASTS");
-   QList<Yeast*> yeasts = a->yeasts();
-   for( i = 0; i < yeasts.size(); ++i )
-      toXml( yeasts[i], doc, tmpElement);
-   node.appendChild(tmpElement);
-
-   tmpElement = doc.createElement("WATERS");
-   QList<Water*> waters = a->waters();
-   for( i = 0; i < waters.size(); ++i )
-      toXml( waters[i], doc, tmpElement);
-   node.appendChild(tmpElement);
+      toXml( style, out);
+
+   writeGroup("HOPS", a->hops(), out);
+   writeGroup("FERMENTABLES", a->fermentables(), out);
+   writeGroup("MISCS", a->miscs(), out);
+   writeGroup("YEASTS", a->yeasts(), out);
+   writeGroup("WATERS", a->waters(), out);
 
    Mash* mash = a->mash();
    if( mash != nullptr )
-      toXml( mash, doc, node);
-
-   tmpElement = doc.createElement("INSTRUCTIONS");
-   QList<Instruction*> instructions = a->instructions();
-   for( i = 0; i < instructions.size(); ++i )
-      toXml( instructions[i], doc, tmpElement);
-   node.appendChild(tmpElement);
+      toXml( mash, out);
 
-   tmpElement = doc.createElement("BREWNOTES");
-   QList<BrewNote*> brewNotes = a->brewNotes();
-   for(i=0; i < brewNotes.size(); ++i)
-      toXml(brewNotes[i], doc, tmpElement);
-   node.appendChild(tmpElement);
+   writeGroup("INSTRUCTIONS", a->instructions(), out);
+   writeGroup("BREWNOTES", a->brewNotes(), out);
 
    Equipment* equip = a->equipment();
    if( equip )
-      toXml( equip, doc, node);
+      toXml( equip, out);
 
-   parent.appendChild(node);
+   out.writeEndElement();
 }
 
-void BeerXML::toXml( Style* a, QDomDocument& doc, QDomNode& parent )
+void BeerXML::toXml( Style* a, QXmlStreamWriter& out )
 {
-   QDomElement node;
-   QDomElement tmpElement;
-   QDomText tmpText;
-   TableSchema* tbl = m_tables->table(Brewtarget::STYLETABLE);
-
-   node = doc.createElement("STYLE");
-
-   tmpElement = doc.createElement("VERSION");
-   tmpText = doc.createTextNode(NamedEntity::text(a->version()));
-   tmpElement.appendChild(tmpText);
-   node.appendChild(tmpElement);
-
-   foreach (QString element, tbl->allProperties()) {
-      if ( ! tbl->propertyToXml(element).isEmpty() ) {
-         QString prop = tbl->propertyName(element);
-         tmpElement = doc.createElement(tbl->propertyToXml(element));
-         tmpText    = doc.createTextNode(textFromValue(a->property(prop.toUtf8().data()), tbl->propertyColumnType(element)));
-         tmpElement.appendChild(tmpText);
-         node.appendChild(tmpElement);
-      }
-   }
-   parent.appendChild(node);
-
+   out.writeStartElement("STYLE");
+   writeProperties(a, m_tables->table(Brewtarget::STYLETABLE), out);
+   out.writeEndElement();
 }
 
-void BeerXML::toXml( Water* a, QDomDocument& doc, QDomNode& parent )
+void BeerXML::toXml( Water* a, QXmlStreamWriter& out )
 {
-   QDomElement node;
-   QDomElement tmpElement;
-   QDomText tmpText;
-   TableSchema* tbl = m_tables->table(Brewtarget::WATERTABLE);
-
-   node = doc.createElement("WATER");
-
-   tmpElement = doc.createElement("VERSION");
-   tmpText = doc.createTextNode(NamedEntity::text(a->version()));
-   tmpElement.appendChild(tmpText);
-   node.appendChild(tmpElement);
-
-   foreach (QString element, tbl->allProperties()) {
-      if ( ! tbl->propertyToXml(element).isEmpty() ) {
-         QString prop = tbl->propertyName(element);
-         tmpElement = doc.createElement(tbl->propertyToXml(element));
-         tmpText    = doc.createTextNode(textFromValue(a->property(prop.toUtf8().data()), tbl->propertyColumnType(element)));
-         tmpElement.appendChild(tmpText);
-         node.appendChild(tmpElement);
-      }
-   }
-   parent.appendChild(node);
-
-
+   out.writeStartElement("WATER");
+   writeProperties(a, m_tables->table(Brewtarget::WATERTABLE), out);
+   out.writeEndElement();
 }
 
-void BeerXML::toXml( Yeast* a, QDomDocument& doc, QDomNode& parent )
+void BeerXML::toXml( Yeast* a, QXmlStreamWriter& out )
 {
-   QDomElement node;
-   QDomElement tmpElement;
-   QDomText tmpText;
-   TableSchema* tbl = m_tables->table(Brewtarget::YEASTTABLE);
-
-   node = doc.createElement("YEAST");
-
-   tmpElement = doc.createElement("VERSION");
-   tmpText = doc.createTextNode(NamedEntity::text(a->version()));
-   tmpElement.appendChild(tmpText);
-   node.appendChild(tmpElement);
-
-   foreach (QString element, tbl->allProperties()) {
-      if ( ! tbl->propertyToXml(element).isEmpty() ) {
-         QString prop = tbl->propertyName(element);
-         tmpElement = doc.createElement(tbl->propertyToXml(element));
-         tmpText    = doc.createTextNode(textFromValue(a->property(prop.toUtf8().data()), tbl->propertyColumnType(element)));
-         tmpElement.appendChild(tmpText);
-         node.appendChild(tmpElement);
-      }
-   }
-   parent.appendChild(node);
+   out.writeStartElement("YEAST");
+   writeProperties(a, m_tables->table(Brewtarget::YEASTTABLE), out);
+   out.writeEndElement();
 }
 
 // fromXml ====================================================================
@@ -29,6 +29,7 @@ class BeerXML;
 #include <QList>
 #include <QHash>
 #include <QFile>
+#include <QIODevice>
 #include <QString>
 #include <QVariant>
 #include <QMetaProperty>
@@ -38,6 +39,7 @@ class BeerXML;
 #include <QDebug>
 #include <QRegExp>
 #include <QMap>
+#include <QXmlStreamWriter>
 
 #include "model/NamedEntity.h"
 #include "brewtarget.h"
@@ -73,19 +75,43 @@ public:
 
    virtual ~BeerXML();
 
-   // Export to BeerXML =======================================================
-   void toXml( BrewNote* a, QDomDocument& doc, QDomNode& parent );
-   void toXml( Equipment* a, QDomDocument& doc, QDomNode& parent );
-   void toXml( Fermentable* a, QDomDocument& doc, QDomNode& parent );
-   void toXml( Hop* a, QDomDocument& doc, QDomNode& parent );
-   void toXml( Instruction* a, QDomDocument& doc, QDomNode& parent );
-   void toXml( Mash* a, QDomDocument& doc, QDomNode& parent );
-   void toXml( MashStep* a, QDomDocument& doc, QDomNode& parent );
-   void toXml( Misc* a, QDomDocument& doc, QDomNode& parent );
-   void toXml( Recipe* a, QDomDocument& doc, QDomNode& parent );
-   void toXml( Style* a, QDomDocument& doc, QDomNode& parent );
-   void toXml( Water* a, QDomDocument& doc, QDomNode& parent );
-   void toXml( Yeast* a, QDomDocument& doc, QDomNode& parent );
+   // Streaming export to BeerXML =============================================
+   //! \brief Everything one exportToXml() writes, a group per list
+   struct ExportList
+   {
+      //! Each takes its style, ingredients, mash, instructions, brew notes and equipment with it
+      QList<Recipe*> recipes;
+      QList<Equipment*> equipments;
+      QList<Fermentable*> fermentables;
+      QList<Hop*> hops;
+      QList<Misc*> miscs;
+      QList<Style*> styles;
+      QList<Water*> waters;
+      QList<Yeast*> yeasts;
+   };
+
+   /*! Writes \b items to \b device as a BeerXML document. Each element is
+    *  written as soon as it is read, so the document is never in memory as a
+    *  whole.
+    * \param compress gzip the document on its way to \b device
+    * \return true if all of it was written
+    */
+   bool exportToXml( ExportList const& items, QIODevice* device, bool compress = false );
+   //! \brief Every recipe and ingredient in the library, brew notes included
+   ExportList everything();
+
+   void toXml( BrewNote* a, QXmlStreamWriter& out );
+   void toXml( Equipment* a, QXmlStreamWriter& out );
+   void toXml( Fermentable* a, QXmlStreamWriter& out );
+   void toXml( Hop* a, QXmlStreamWriter& out );
+   void toXml( Instruction* a, QXmlStreamWriter& out );
+   void toXml( Mash* a, QXmlStreamWriter& out );
+   void toXml( MashStep* a, QXmlStreamWriter& out );
+   void toXml( Misc* a, QXmlStreamWriter& out );
+   void toXml( Recipe* a, QXmlStreamWriter& out );
+   void toXml( Style* a, QXmlStreamWriter& out );
+   void toXml( Water* a, QXmlStreamWriter& out );
+   void toXml( Yeast* a, QXmlStreamWriter& out );
    //++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 
    /*! Populates the \b element with properties. This must be a class that
@@ -123,6 +149,10 @@ private:
    BeerXML& operator=(BeerXML const&) = delete;
 
    QString textFromValue(QVariant value, QString type);
+   //! \brief VERSION and then every property \b tbl maps to XML
+   void writeProperties( NamedEntity* a, TableSchema* tbl, QXmlStreamWriter& out );
+   //! \brief \b items, each written with toXml(), wrapped in \b groupTag
+   template<class T> void writeGroup( QString const& groupTag, QList<T*> const& items, QXmlStreamWriter& out );
 };
 
 #endif
@@ -24,6 +24,7 @@
 
 #include <xercesc/dom/DOMLocator.hpp>
 #include <xercesc/dom/DOMError.hpp>
+#include <xercesc/sax/SAXParseException.hpp>
 
 #include "xml/XQString.h"
 
@@ -49,6 +50,16 @@ public:
     */
    ~impl() = default;
 
+   /**
+    * Common part of the DOM and SAX error handling.  Returns true if the error can be ignored.
+    */
+   bool handleError(BtDomErrorHandler & self,
+                    unsigned int severity,
+                    unsigned int lineNumber,
+                    unsigned int columnNumber,
+                    XQString const & uri,
+                    XQString const & message);
+
    // See https://xerces.apache.org/xerces-c/apiDocs-3/classDOMError.html for possible indexes into this array
    static char const * const XercesErrorSeverities[];
 
@@ -105,7 +116,12 @@ unsigned int BtDomErrorHandler::correctErrorLine(unsigned int lineNumberOfError)
    return lineNumberOfError;
 }
 
-bool BtDomErrorHandler::handleError(xercesc::DOMError const & domError) {
+bool BtDomErrorHandler::impl::handleError(BtDomErrorHandler & self,
+                                          unsigned int severity,
+                                          unsigned int lineNumber,
+                                          unsigned int columnNumber,
+                                          XQString const & uri,
+                                          XQString const & message) {
    //
    // Although they are often reasonably clear and straightforward, there can sometimes be a bit of an art to
    // decrypting Xerces error messages...
@@ -124,23 +140,21 @@ bool BtDomErrorHandler::handleError(xercesc::DOMError const & domError) {
    //
    QString shortErrorMessage;
    QTextStream shortErrorMessageAsTextStream(&shortErrorMessage);
-   xercesc::DOMLocator* location {domError.getLocation()};
-   XQString message{domError.getMessage()};
    shortErrorMessageAsTextStream <<
-      impl::XercesErrorSeverities[domError.getSeverity()] <<
-      " at line " << this->correctErrorLine(location->getLineNumber()) <<
-      ", column " << location->getColumnNumber() <<
+      impl::XercesErrorSeverities[severity] <<
+      " at line " << self.correctErrorLine(lineNumber) <<
+      ", column " << columnNumber <<
       ": " << message;
 
    QString fullErrorMessage;
    QTextStream fullErrorMessageAsTextStream(&fullErrorMessage);
-   fullErrorMessageAsTextStream << XQString(location->getURI()) << ": " << shortErrorMessage;
+   fullErrorMessageAsTextStream << uri << ": " << shortErrorMessage;
 
    //
    // Check whether the error we just hit is one we can actually ignore
    //
-   if (nullptr != this->pimpl->errorPatternsToIgnore) {
-      for (auto ii = this->pimpl->errorPatternsToIgnore->cbegin(); ii != this->pimpl->errorPatternsToIgnore->cend(); ++ii) {
+   if (nullptr != this->errorPatternsToIgnore) {
+      for (auto ii = this->errorPatternsToIgnore->cbegin(); ii != this->errorPatternsToIgnore->cend(); ++ii) {
          QRegExp pattern(ii->regExMatchingErrorMessage);
          if (pattern.indexIn(message) != -1) {
             // We want to force the parse error onto a separate line, as it will be quite long, hence
@@ -156,7 +170,58 @@ bool BtDomErrorHandler::handleError(xercesc::DOMError const & domError) {
    // Other errors get logged as such and cause us to stop processing the document
    //
    qCritical() << fullErrorMessage;
-   this->pimpl->lastError = shortErrorMessage;
-   this->pimpl->couldntHandleError = true;
+   this->lastError = shortErrorMessage;
+   this->couldntHandleError = true;
    return false;
 }
+
+bool BtDomErrorHandler::handleError(xercesc::DOMError const & domError) {
+   xercesc::DOMLocator* location {domError.getLocation()};
+   return this->pimpl->handleError(*this,
+                                   domError.getSeverity(),
+                                   location->getLineNumber(),
+                                   location->getColumnNumber(),
+                                   XQString(location->getURI()),
+                                   XQString(domError.getMessage()));
+}
+
+void BtDomErrorHandler::warning(xercesc::SAXParseException const & exc) {
+   // Same as for DOM: a warning we don't know we can ignore stops the parse
+   if (!this->pimpl->handleError(*this,
+                                 xercesc::DOMError::DOM_SEVERITY_WARNING,
+                                 exc.getLineNumber(),
+                                 exc.getColumnNumber(),
+                                 XQString(exc.getSystemId()),
+                                 XQString(exc.getMessage()))) {
+      throw exc;
+   }
+   return;
+}
+
+void BtDomErrorHandler::error(xercesc::SAXParseException const & exc) {
+   if (!this->pimpl->handleError(*this,
+                                 xercesc::DOMError::DOM_SEVERITY_ERROR,
+                                 exc.getLineNumber(),
+                                 exc.getColumnNumber(),
+                                 XQString(exc.getSystemId()),
+                                 XQString(exc.getMessage()))) {
+      throw exc;
+   }
+   return;
+}
+
+void BtDomErrorHandler::fatalError(xercesc::SAXParseException const & exc) {
+   this->pimpl->handleError(*this,
+                            xercesc::DOMError::DOM_SEVERITY_FATAL_ERROR,
+                            exc.getLineNumber(),
+                            exc.getColumnNumber(),
+                            XQString(exc.getSystemId()),
+                            XQString(exc.getMessage()));
+   // Even if we could ignore it, the parser can't carry on after a fatal error
+   throw exc;
+}
+
+void BtDomErrorHandler::resetErrors() {
+   this->reset();
+   return;
+}
@@ -29,6 +29,7 @@ class QString;
 #include <QVector>
 
 #include <xercesc/dom/DOMErrorHandler.hpp>
+#include <xercesc/sax/ErrorHandler.hpp>
 
 /**
  * Although some Xerces errors generate exceptions, others are handled through a callback to an object you provide
@@ -39,8 +40,11 @@ class QString;
  *    further processing of the document,
  *  - apply any "corrections" needed the location of the error, which are required when we have made temporary
  *    modifications to the document being parsed (see comments elsewhere for why we would want to do this)
+ *
+ * The same rules apply whether we are building a DOM or just validating the document with a SAX parser, so this class
+ * also implements the xercesc::ErrorHandler interface used by the latter.
  */
-class BtDomErrorHandler: public xercesc::DOMErrorHandler {
+class BtDomErrorHandler: public xercesc::DOMErrorHandler, public xercesc::ErrorHandler {
 public:
    struct PatternAndReason {
       QString const regExMatchingErrorMessage;
@@ -89,6 +93,15 @@ public:
     */
    virtual bool handleError(xercesc::DOMError const & domError);
 
+   /**
+    * SAX versions of \b handleError().  SAX has no return value to say "stop", so, for errors we can't ignore, we
+    * rethrow the exception, which the parser passes back up to its caller.
+    */
+   virtual void warning(xercesc::SAXParseException const & exc);
+   virtual void error(xercesc::SAXParseException const & exc);
+   virtual void fatalError(xercesc::SAXParseException const & exc);
+   virtual void resetErrors();
+
 private:
    // Private implementation details - see https://herbsutter.com/gotw/_100/
    class impl;
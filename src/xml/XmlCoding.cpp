@@ -19,6 +19,8 @@
 #include "xml/XmlCoding.h"
 
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QXmlStreamReader>
 
 #include <xercesc/dom/DOMConfiguration.hpp>
 #include <xercesc/dom/DOMDocument.hpp>
@@ -31,6 +33,9 @@
 #include <xercesc/framework/Wrapper4InputSource.hpp>
 #include <xercesc/framework/XMLGrammarPoolImpl.hpp>
 #include <xercesc/sax/SAXException.hpp>
+#include <xercesc/sax/SAXParseException.hpp>
+#include <xercesc/sax2/SAX2XMLReader.hpp>
+#include <xercesc/sax2/XMLReaderFactory.hpp>
 #include <xercesc/util/PlatformUtils.hpp>
 #include <xercesc/util/XMLException.hpp>
 #include <xercesc/util/XMLUniDefs.hpp>
@@ -43,6 +48,7 @@
 #include <xalanc/XercesParserLiaison/XercesDOMSupport.hpp>
 #include <xalanc/XPath/XPathEvaluator.hpp>
 
+#include "database.h"
 #include "xml/BtDomDocumentOwner.h"
 #include "xml/XercesHelpers.h"
 #include "xml/XmlRecordCount.h"
@@ -313,6 +319,32 @@ public:
       // is called for all the DOMDocument objects to be released.
       config->setParameter(xercesc::XMLUni::fgXercesUserAdoptsDOMDocument, true);
 
+      //
+      // For the streaming import path, we also want to be able to validate a document without building a DOM for it.
+      // A SAX parser with no content handler does just that: it checks the document against the schema in a single
+      // forward pass, using memory that doesn't grow with the size of the document.  The feature settings mirror the
+      // DOM ones above (see https://xerces.apache.org/xerces-c/program-sax2-3.html for the SAX names).
+      //
+      this->saxParser.reset(xercesc::XMLReaderFactory::createXMLReader());
+      this->saxParser->setFeature(xercesc::XMLUni::fgSAX2CoreNameSpaces, true);
+      this->saxParser->setFeature(xercesc::XMLUni::fgSAX2CoreValidation, true);
+      this->saxParser->setFeature(xercesc::XMLUni::fgXercesDynamic, false);
+      this->saxParser->setFeature(xercesc::XMLUni::fgXercesSchema, true);
+      this->saxParser->setFeature(xercesc::XMLUni::fgXercesSchemaFullChecking, false);
+      this->saxParser->setFeature(xercesc::XMLUni::fgXercesHandleMultipleImports, true);
+
+      this->saxParser->setErrorHandler(&domErrorHandler);
+      if (!this->saxParser->loadGrammar(schemaAsInputSource, xercesc::Grammar::SchemaGrammarType, true) ||
+          domErrorHandler.failed()) {
+         qCritical() << Q_FUNC_INFO << "Error parsing schema " << schemaFile.fileName() << " for SAX parser";
+         throw std::runtime_error("Error parsing schema -- see log file for more details");
+      }
+      // domErrorHandler is about to go out of scope
+      this->saxParser->setErrorHandler(nullptr);
+
+      this->saxParser->setFeature(xercesc::XMLUni::fgXercesUseCachedGrammarInParse, true);
+      this->saxParser->setFeature(xercesc::XMLUni::fgXercesLoadSchema, false);
+
       return;
    }
 
@@ -498,15 +530,21 @@ public:
 
       std::shared_ptr<XmlRecord> rootRecord = xmlCoding->getNewXmlRecord(rootNodeName);
 
+      // Anything cached about what's already in the DB from a previous import is out of date now
+      XmlRecord::startNewImport();
+
       XmlRecordCount stats;
 
       if (!rootRecord->load(domSupport, rootNode, userMessage)) {
          return false;
       }
 
-      // At the root level, Succeeded and FoundDuplicate are both OK return values.  It's only Failed that indicates an
-      // error (rather than in info) message for the user in userMessage.
-      if (XmlRecord::Failed == rootRecord->normaliseAndStoreInDb(nullptr, userMessage, stats)) {
+      bool const stored = this->storeInOneTransaction(stats, [&]() {
+         // At the root level, Succeeded and FoundDuplicate are both OK return values.  It's only Failed that indicates
+         // an error (rather than in info) message for the user in userMessage.
+         return XmlRecord::Failed != rootRecord->normaliseAndStoreInDb(nullptr, userMessage, stats);
+      });
+      if (!stored) {
          return false;
       }
 
@@ -516,7 +554,131 @@ public:
       return stats.writeToUserMessage(userMessage);
    }
 
+   /**
+    * \brief Streaming alternative to \b validateLoadAndStoreInDb().  See \b XmlCoding::streamLoadAndStoreInDb() for
+    *        details.
+    */
+   bool streamLoadAndStoreInDb(XmlCoding const * xmlCoding,
+                               QByteArray const & documentData,
+                               QString const & fileName,
+                               BtDomErrorHandler & domErrorHandler,
+                               QTextStream & userMessage,
+                               bool validate) {
+      if (validate && !this->validateWithoutDom(documentData, fileName, domErrorHandler, userMessage)) {
+         return false;
+      }
+
+      QXmlStreamReader xmlStreamReader{documentData};
+
+      // The root element is the one BeerXML makes us insert (see xml/BeerXml.cpp)
+      if (!xmlStreamReader.readNextStartElement()) {
+         qCritical() << Q_FUNC_INFO << "Couldn't find any elements in " << fileName;
+         userMessage << xmlCoding->tr("Contents of file were not readable");
+         return false;
+      }
+      QString const rootElementName = xmlStreamReader.name().toString();
+      qDebug() << Q_FUNC_INFO << "Processing root element: " << rootElementName;
+      if (!xmlCoding->isKnownXmlRecordType(rootElementName)) {
+         qCritical() << Q_FUNC_INFO << "First element in document (" << rootElementName << ") was not recognised!";
+         userMessage << xmlCoding->tr("Could not understand file format");
+         return false;
+      }
+
+      std::shared_ptr<XmlRecord> rootRecord = xmlCoding->getNewXmlRecord(rootElementName);
+
+      // Anything cached about what's already in the DB from a previous import is out of date now
+      XmlRecord::startNewImport();
+
+      XmlRecordCount stats;
+
+      bool const stored = this->storeInOneTransaction(stats, [&]() {
+         return rootRecord->loadNormaliseAndStoreChildRecordsInDb(xmlStreamReader, userMessage, stats);
+      });
+
+      if (xmlStreamReader.hasError()) {
+         unsigned int lineNumberOfError = domErrorHandler.correctErrorLine(xmlStreamReader.lineNumber());
+         qCritical() <<
+            Q_FUNC_INFO << "Error reading " << fileName << " at line " << lineNumberOfError << ": " <<
+            xmlStreamReader.errorString();
+         userMessage << "Error at line " << lineNumberOfError << ": " << xmlStreamReader.errorString();
+         return false;
+      }
+      if (!stored) {
+         return false;
+      }
+
+      return stats.writeToUserMessage(userMessage);
+   }
+
 private:
+   /**
+    * \brief Check the document against the schema using the SAX parser, ie without building a DOM
+    *
+    * \return true if the document is valid (including if there were "errors" that we can safely ignore)
+    */
+   bool validateWithoutDom(QByteArray const & documentData,
+                           QString const & fileName,
+                           BtDomErrorHandler & domErrorHandler,
+                           QTextStream & userMessage) {
+      QByteArray fileNameAsCString = fileName.toLocal8Bit();
+      xercesc::MemBufInputSource documentAsInputSource{reinterpret_cast<const XMLByte *>(documentData.constData()),
+                                                       static_cast<XMLSize_t>(documentData.length()),
+                                                       fileNameAsCString.constData()};
+
+      this->saxParser->setErrorHandler(&domErrorHandler);
+      bool parsedOk = false;
+      try {
+         this->saxParser->parse(documentAsInputSource);
+         parsedOk = !domErrorHandler.failed();
+      } catch (const xercesc::SAXParseException & spe) {
+         // BtDomErrorHandler throws these for errors we can't ignore, having already logged them
+         qDebug() << Q_FUNC_INFO << "Parse stopped at line " << domErrorHandler.correctErrorLine(spe.getLineNumber());
+      } catch (const xercesc::XMLException & xe) {
+         unsigned int lineNumberOfError = domErrorHandler.correctErrorLine(xe.getSrcLine());
+         qCritical() <<
+            Q_FUNC_INFO << "Caught xerces::XMLException at line " << lineNumberOfError << ": " <<
+            XQString(xe.getType()) << ": " << XQString(xe.getMessage());
+         userMessage <<
+            "XMLException at line " << lineNumberOfError << ": " << XQString(xe.getType())  << ": " <<
+            XQString(xe.getMessage());
+         this->saxParser->setErrorHandler(nullptr);
+         return false;
+      }
+      this->saxParser->setErrorHandler(nullptr);
+
+      qDebug() << Q_FUNC_INFO << "Validation of input file " << fileName << (parsedOk ? "succeeded" : "FAILED");
+      if (!parsedOk) {
+         userMessage << domErrorHandler.getlastError();
+      }
+      return parsedOk;
+   }
+
+   /**
+    * \brief Run \c store inside a single DB transaction and log how fast it went.  As well as being a lot faster than
+    *        committing every record on its own, it means a failure part way through a document doesn't leave half of
+    *        it behind in the DB.
+    *
+    * \return true if \c store succeeded and everything was committed
+    */
+   template<class StoreFunction>
+   bool storeInOneTransaction(XmlRecordCount const & stats, StoreFunction store) const {
+      QElapsedTimer timer;
+      timer.start();
+      Database::instance().beginBulkImport();
+
+      bool const stored = store();
+      if (!Database::instance().endBulkImport(stored)) {
+         qWarning() << Q_FUNC_INFO << "Import rolled back after" << timer.elapsed() << "ms";
+         return false;
+      }
+
+      qint64 const elapsedMs = timer.elapsed();
+      qInfo() <<
+         Q_FUNC_INFO << "Imported" << stats.total() << "records in" << elapsedMs << "ms (" <<
+         (elapsedMs > 0 ? (1000.0 * stats.total() / elapsedMs) : 0.0) << "records/sec)";
+      return true;
+   }
+
    // XMLGrammarPoolImpl is a bit lacking in documentation, probably because it used to be an "internal" class of
    // Xerces.  However, since Xerces 3.0.0 release, it is now part of the public API -- see
    // https://xerces.apache.org/xerces-c/migrate-archive-3.html#NewAPI300
@@ -524,6 +686,8 @@ private:
 
    xercesc::DOMImplementation * domImplementation;
    xercesc::DOMLSParser * parser;
+   // Only used for validation.  See streamLoadAndStoreInDb()
+   std::unique_ptr<xercesc::SAX2XMLReader> saxParser;
 };
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -563,3 +727,11 @@ bool XmlCoding::validateLoadAndStoreInDb(QByteArray const & documentData,
                                          QTextStream & userMessage) const {
    return this->pimpl->validateLoadAndStoreInDb(this, documentData, fileName, domErrorHandler, userMessage);
 }
+
+bool XmlCoding::streamLoadAndStoreInDb(QByteArray const & documentData,
+                                       QString const & fileName,
+                                       BtDomErrorHandler & domErrorHandler,
+                                       QTextStream & userMessage,
+                                       bool validate) const {
+   return this->pimpl->streamLoadAndStoreInDb(this, documentData, fileName, domErrorHandler, userMessage, validate);
+}
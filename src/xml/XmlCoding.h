@@ -227,6 +227,26 @@ public:
                                  BtDomErrorHandler & domErrorHandler,
                                  QTextStream & userMessage) const;
 
+   /**
+    * \brief Streaming alternative to \b validateLoadAndStoreInDb().
+    *
+    *        Rather than building a DOM and then evaluating an XPath per field per record, this makes a single forward
+    *        pass over the document with \b QXmlStreamReader, dispatching on element names via the same
+    *        \b XmlRecord::FieldDefinitions.  Each top-level record is stored in the DB as soon as it has been read and
+    *        then discarded, so memory use does not grow with the number of records in the document.
+    *
+    * \param documentData, fileName, domErrorHandler, userMessage As for \b validateLoadAndStoreInDb()
+    * \param validate If \b true, the document is first checked against the XSD with a (streaming) SAX parser.  If
+    *                 \b false, we rely on the field parsing to reject anything we can't make sense of.
+    *
+    * \return true if the contents of the file were read and stored OK, false otherwise
+    */
+   bool streamLoadAndStoreInDb(QByteArray const & documentData,
+                               QString const & fileName,
+                               BtDomErrorHandler & domErrorHandler,
+                               QTextStream & userMessage,
+                               bool validate = true) const;
+
 private:
    QString name;
    QHash<QString, XmlRecordDefinition> const entityNameToXmlRecordDefinition;
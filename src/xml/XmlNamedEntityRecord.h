@@ -24,6 +24,8 @@
 
 #include <QHash>
 #include <QMetaType>
+#include <QMultiHash>
+#include <QSet>
 #include <QString>
 #include <QVariant>
 #include <QVector>
@@ -78,14 +80,16 @@ protected:
     */
    virtual bool isDuplicate() {
       auto currentEntity = this->namedEntity;
-      QList<NE *> listOfAllStored = Database::instance().getAll<NE>();
+      // Two objects can only be equal if their names match once any "(n)" on the end is ignored (see
+      // NamedEntity::operator==), so we only need to look at the ones in the same bucket
+      QList<NE *> candidates = storedIndex().byBaseName.values(baseName(currentEntity->name()));
       qDebug() <<
-         Q_FUNC_INFO << "Searching list of " << listOfAllStored.size() << " existing " << this->namedEntityClassName <<
-         " objects for duplicate with the one we are reading in";
-      auto matchingEntity = std::find_if(listOfAllStored.begin(),
-                                                      listOfAllStored.end(),
-                                                      [currentEntity](NE * ne) {return *ne == *currentEntity;});
-      if (matchingEntity != listOfAllStored.end()) {
+         Q_FUNC_INFO << "Searching " << candidates.size() << " existing " << this->namedEntityClassName <<
+         " objects with a similar name for duplicate with the one we are reading in";
+      auto matchingEntity = std::find_if(candidates.begin(),
+                                         candidates.end(),
+                                         [currentEntity](NE * ne) {return *ne == *currentEntity;});
+      if (matchingEntity != candidates.end()) {
          qDebug() << Q_FUNC_INFO << "Found a match for " << this->namedEntity->name();
          // Set our pointer to the Hop/Yeast/Fermentable/etc that we already have stored in the database, so that any
          // containing Recipe etc can refer to it.  The new object we created is still held in
@@ -109,22 +113,15 @@ protected:
     */
    virtual void normaliseName() {
       QString currentName = this->namedEntity->name();
-      QList<NE *> listOfAllStored = Database::instance().getAll<NE>();
-
-      for (auto matchingEntity = std::find_if(listOfAllStored.begin(),
-                                                      listOfAllStored.end(),
-                                                      [currentName](NE * ne) {return ne->name() == currentName;});
-         matchingEntity != listOfAllStored.end();
-         matchingEntity = std::find_if(listOfAllStored.begin(),
-                                       listOfAllStored.end(),
-                                       [currentName](NE * ne) {return ne->name() == currentName;})) {
+      QSet<QString> const & names = storedIndex().names;
 
+      while (names.contains(currentName)) {
          qDebug() << Q_FUNC_INFO << "Found existing " << this->namedEntityClassName << "named" << currentName;
 
          XmlRecord::modifyClashingName(currentName);
 
          //
-         // Now the for loop will search again with the new name
+         // Now the loop will check again with the new name
          //
          qDebug() << Q_FUNC_INFO << "Trying " << currentName;
       }
@@ -134,6 +131,20 @@ protected:
       return;
    }
 
+   /**
+    * \brief Once we've stored a new object, later records in the same file need to be able to see it, both as a
+    *        possible duplicate and as a name that is taken.
+    */
+   virtual void noteStoredInDb() {
+      StoredIndex & index = storedIndex(false);
+      if (index.importNumber == XmlRecord::importNumber) {
+         NE * stored = static_cast<NE *>(this->namedEntity);
+         index.byBaseName.insert(baseName(stored->name()), stored);
+         index.names.insert(stored->name());
+      }
+      return;
+   }
+
    /**
     * \brief Implementation of the general case where the object is independent of its containing entity
     */
@@ -147,6 +158,51 @@ private:
     */
    bool includedInStats() const { return true; }
 
+   /**
+    * \brief What we already have stored of type NE, so that checking each record we read in for duplicates and name
+    *        clashes is a hash look-up rather than a trip to the DB and a walk over everything we hold.
+    */
+   struct StoredIndex {
+      // The import this was built for (see XmlRecord::startNewImport())
+      unsigned int importNumber = 0;
+      // Keyed by name with any trailing "(n)" removed.  That's the only thing all the isEqualTo() implementations have
+      // in common, and it's enough to get each bucket down to a handful of objects.
+      QMultiHash<QString, NE *> byBaseName;
+      // Exact names, for normaliseName()
+      QSet<QString> names;
+   };
+
+   /**
+    * \brief Get the index for NE, building it from the DB the first time it's asked for in each import
+    * \param rebuildIfStale If false, a stale index is returned as-is, which callers need to check for
+    */
+   static StoredIndex & storedIndex(bool rebuildIfStale = true) {
+      static StoredIndex index;
+      if (rebuildIfStale && index.importNumber != XmlRecord::importNumber) {
+         index.byBaseName.clear();
+         index.names.clear();
+         for (NE * ne : Database::instance().getAll<NE>()) {
+            index.byBaseName.insert(baseName(ne->name()), ne);
+            index.names.insert(ne->name());
+         }
+         index.importNumber = XmlRecord::importNumber;
+         qDebug() << Q_FUNC_INFO << "Indexed " << index.names.size() << " existing objects";
+      }
+      return index;
+   }
+
+   /**
+    * \brief The name with any " (n)" that we or the user added to make it unique removed
+    */
+   static QString baseName(QString const & name) {
+      QString ret = name;
+      int positionOfMatch = NamedEntity::getDuplicateNameNumberMatcher().indexIn(ret);
+      if (positionOfMatch > -1) {
+         ret.truncate(positionOfMatch);
+      }
+      return ret;
+   }
+
 };
 
 // Specialisations for cases where duplicates are allowed
@@ -161,6 +217,12 @@ template<> inline void XmlNamedEntityRecord<Mash>::normaliseName() { return; }
 template<> inline void XmlNamedEntityRecord<MashStep>::normaliseName() { return; }
 template<> inline void XmlNamedEntityRecord<BrewNote>::normaliseName() { return; }
 
+// Specialisations for cases where neither of the above look at what's stored, so there's no index to keep up to date
+template<> inline void XmlNamedEntityRecord<Instruction>::noteStoredInDb() { return; }
+template<> inline void XmlNamedEntityRecord<Mash>::noteStoredInDb() { return; }
+template<> inline void XmlNamedEntityRecord<MashStep>::noteStoredInDb() { return; }
+template<> inline void XmlNamedEntityRecord<BrewNote>::noteStoredInDb() { return; }
+
 // Specialisations for cases where object is owned by its containing entity
 template<> inline void XmlNamedEntityRecord<BrewNote>::setContainingEntity(NamedEntity * containingEntity) {
    qDebug() << Q_FUNC_INFO << "BrewNote * " << static_cast<void*>(this->namedEntity) << ", Recipe * " << static_cast<void*>(containingEntity);
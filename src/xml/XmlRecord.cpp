@@ -20,6 +20,8 @@
 
 #include <QDate>
 #include <QDebug>
+#include <QSet>
+#include <QStringList>
 
 #include <xalanc/XalanDOM/XalanNodeList.hpp>
 #include <xalanc/XPath/NodeRefList.hpp>
@@ -149,220 +151,379 @@ bool XmlRecord::load(xalanc::DOMSupport & domSupport,
                XQString value(valueNode->getNodeValue());
                qDebug() << Q_FUNC_INFO << "Value " << value;
 
-               bool parsedValueOk = false;
-               QVariant parsedValue;
-
-               // A field should have a stringToEnum mapping if and only if it's of type Enum
-               // Anything else is a coding error at the caller
-               Q_ASSERT((XmlRecord::Enum == fieldDefinition->fieldType) != (nullptr == fieldDefinition->stringToEnum));
-
-               switch(fieldDefinition->fieldType) {
-
-                  case XmlRecord::Bool:
-                     // Unlike other XML documents, boolean fields in BeerXML are caps, so we have to accommodate that
-                     if (value.toLower() == "true") {
-                        parsedValue.setValue(true);
-                        parsedValueOk = true;
-                     } else if (value.toLower() == "false") {
-                        parsedValue.setValue(true);
-                        parsedValueOk = true;
-                     } else {
-                        // This is almost certainly a coding error, as we should have already validated that the field
-                        // via XSD parsing.
-                        qWarning() <<
-                           Q_FUNC_INFO << "Ignoring " << this->namedEntityClassName << " node " << fieldDefinition->xPath << "=" <<
-                           value << " as could not be parsed as BOOLEAN";
-                     }
-                     break;
-
-                  case XmlRecord::Int:
-                     // QString's toInt method will report success/failure of parsing straight back into our flag
-                     parsedValue.setValue(value.toInt(&parsedValueOk));
-                     if (!parsedValueOk) {
-                        // This is almost certainly a coding error, as we should have already validated the field via XSD
-                        // parsing.
-                        qWarning() <<
-                           Q_FUNC_INFO << "Ignoring " << this->namedEntityClassName << " node " << fieldDefinition->xPath << "=" <<
-                           value << " as could not be parsed as integer";
-                     }
-                     break;
-
-                  case XmlRecord::UInt:
-                     // QString's toUInt method will report success/failure of parsing straight back into our flag
-                     parsedValue.setValue(value.toUInt(&parsedValueOk));
-                     if (!parsedValueOk) {
-                        // This is almost certainly a coding error, as we should have already validated the field via XSD
-                        // parsing.
-                        qWarning() <<
-                           Q_FUNC_INFO << "Ignoring " << this->namedEntityClassName << " node " << fieldDefinition->xPath << "=" <<
-                           value << " as could not be parsed as unsigned integer";
-                     }
-                     break;
-
-                  case XmlRecord::Double:
-                     // QString's toDouble method will report success/failure of parsing straight back into our flag
-                     parsedValue.setValue(value.toDouble(&parsedValueOk));
-                     if (!parsedValueOk) {
-                        // This is almost certainly a coding error, as we should have already validated the field via XSD
-                        // parsing.
-                        qWarning() <<
-                           Q_FUNC_INFO << "Ignoring " << this->namedEntityClassName << " node " << fieldDefinition->xPath << "=" <<
-                           value << " as could not be parsed as decimal number (double)";
-                     }
-                     break;
-
-                  case XmlRecord::Date:
-                     {
-                        //
-                        // Extra braces here as we have a variable (date) that is only used in this case of the switch,
-                        // so we need to restrict its scope, otherwise the compiler will complain about the variable
-                        // initialisation being "jumped over" in the other case labels.
-                        //
-                        // Dates are a bit annoying because, in some cases, fields are not restricted to using the One
-                        // True Date Format™ (aka ISO 8601).  Eg, in the BeerXML 1.0 standard, for the DATE field of a
-                        // Recipe, it merely says 'Date brewed in a easily recognizable format such as “3 Dec 04”', yet
-                        // internally we want to store this as a date rather than just a text field.
-                        //
-                        // So, we make several attempts to parse a date, using various different "standard" encodings.
-                        // There is a risk that certain formats are ambiguous - eg 01/04/2021 is 4 January 2021 in
-                        // the USA, but 1 April 2021 in most of the rest of the world (except the enlightened countries
-                        // that use the One True Date Format) - but there is little we can do about this.
-                        //
-                        // Start by trying ISO 8601, which is the most logical format :-)
-                        //
-                        QDate date = QDate::fromString(value, Qt::ISODate);
-                        parsedValueOk = date.isValid();
-                        if (!parsedValueOk) {
-                           // If not ISO 8601, try RFC 2822 Internet Message Format, which is horrible because it
-                           // assumes everyone speaks English, but (a) widely used and (b) unambiguous
-                           date = QDate::fromString(value, Qt::RFC2822Date);
-                           parsedValueOk = date.isValid();
-                        }
-                        if (!parsedValueOk) {
-                           // Next we'll try Qt's "default" date format, which is good for display but not for file
-                           // interchange, as it's locale-specific
-                           date = QDate::fromString(value, Qt::TextDate);
-                           parsedValueOk = date.isValid();
-                        }
-                        if (!parsedValueOk) {
-                           // Now we're rolling our own formats.  See https://doc.qt.io/qt-5/qdate.html for details of
-                           // the codes in the format strings.
-                           //
-                           // Try USA / Philippines numeric format next, though NB this could mis-parse some
-                           // non-USA-format dates per example above.  (Historically we assumed USA format dates before
-                           // non-USA-format ones, so we're retaining existing behaviour by trying things in this order.)
-                           date = QDate::fromString(value, "M/d/yyyy");
-                           parsedValueOk = date.isValid();
-                        }
-                        if (!parsedValueOk) {
-                           // Now try the numeric version that is widely used outside the USA & the Philippines
-                           date = QDate::fromString(value, "d/M/yyyy");
-                           parsedValueOk = date.isValid();
-                        }
-                        if (!parsedValueOk) {
-                           // Now try the numeric version that is widely used outside the USA & the Philippines
-                           date = QDate::fromString(value, "d/M/yyyy");
-                           parsedValueOk = date.isValid();
-                        }
-                        if (!parsedValueOk) {
-                           // Now try the example "easily recognizable" format from the BeerXML 1.0 standard.
-                           //
-                           // Of course, this is a horrible format because it is not Y2K compliant.  So the actual date
-                           // we store may be out by 100 years.  Hopefully the user will notice and correct this, and
-                           // then if we export we can use a non-ambiguous format.
-                           date = QDate::fromString(value, "d MMM yy");
-                           parsedValueOk = date.isValid();
-                        }
-                        // .:TBD:. Maybe we could try some more formats here
-
-                        parsedValue.setValue(date);
-                     }
-                     if (!parsedValueOk) {
-                        // This is almost certainly a coding error, as we should have already validated the field via XSD
-                        // parsing.
-                        qWarning() <<
-                           Q_FUNC_INFO << "Ignoring " << this->namedEntityClassName << " node " << fieldDefinition->xPath << "=" <<
-                           value << " as could not be parsed as ISO 8601 date";
-                     }
-                     break;
-
-                  case XmlRecord::Enum:
-                     // It's definitely a coding error if there is no stringToEnum mapping for a field declared as Enum!
-                     Q_ASSERT(nullptr != fieldDefinition->stringToEnum);
-                     if (!fieldDefinition->stringToEnum->contains(value)) {
-                        // This is probably a coding error as the XSD parsing should already have verified that the
-                        // contents of the node are one of the expected values.
-                        qWarning() <<
-                           Q_FUNC_INFO << "Ignoring " << this->namedEntityClassName << " node " << fieldDefinition->xPath << "=" <<
-                           value << " as value not recognised";
-                     } else {
-                        parsedValue.setValue(fieldDefinition->stringToEnum->value(value));
-                        parsedValueOk = true;
-                     }
-                     break;
-
-                  // By default we assume it's a string
-                  case XmlRecord::String:
-                  default:
-                     if (fieldDefinition->fieldType != XmlRecord::String) {
-                        // This is almost certainly a coding error in this class as we should be able to parse all the
-                        // types callers need us to.
-                        qWarning() <<
-                           Q_FUNC_INFO << "Treating " << this->namedEntityClassName << " node " << fieldDefinition->xPath << "=" <<
-                           value << " as string because did not recognise requested parse type " << fieldDefinition->fieldType;
-                     }
-                     parsedValue.setValue(static_cast<QString>(value));
-                     parsedValueOk = true;
-                     break;
-               }
-
-               //
-               // What we do if we couldn't parse the value depends.  If it was a value that we didn't need to set on the
-               // supplied Hop/Yeast/Recipe/Etc object, then we can just ignore the problem and carry on processing.  But,
-               // if this was a field we were expecting to use, then it's a problem that we couldn't parse it and we should
-               // bail.
-               //
-               if (!parsedValueOk && nullptr != fieldDefinition->propertyName) {
-                  userMessage <<
-                     "Could not parse " << this->namedEntityClassName << " node " << fieldDefinition->xPath << "=" << value << " into " <<
-                     fieldDefinition->propertyName;
+               if (!this->parseAndStoreField(&(*fieldDefinition), value, userMessage)) {
                   return false;
                }
+            }
+         }
+      }
+   }
+   return true;
+}
 
+
+bool XmlRecord::parseAndStoreField(FieldDefinition const * fieldDefinition,
+                                   QString const & value,
+                                   QTextStream & userMessage) {
+   bool parsedValueOk = false;
+   QVariant parsedValue;
+
+   // A field should have a stringToEnum mapping if and only if it's of type Enum
+   // Anything else is a coding error at the caller
+   Q_ASSERT((XmlRecord::Enum == fieldDefinition->fieldType) != (nullptr == fieldDefinition->stringToEnum));
+
+   switch(fieldDefinition->fieldType) {
+
+      case XmlRecord::Bool:
+         // Unlike other XML documents, boolean fields in BeerXML are caps, so we have to accommodate that
+         if (value.toLower() == "true") {
+            parsedValue.setValue(true);
+            parsedValueOk = true;
+         } else if (value.toLower() == "false") {
+            parsedValue.setValue(true);
+            parsedValueOk = true;
+         } else {
+            // This is almost certainly a coding error, as we should have already validated that the field
+            // via XSD parsing.
+            qWarning() <<
+               Q_FUNC_INFO << "Ignoring " << this->namedEntityClassName << " node " << fieldDefinition->xPath << "=" <<
+               value << " as could not be parsed as BOOLEAN";
+         }
+         break;
+
+      case XmlRecord::Int:
+         // QString's toInt method will report success/failure of parsing straight back into our flag
+         parsedValue.setValue(value.toInt(&parsedValueOk));
+         if (!parsedValueOk) {
+            // This is almost certainly a coding error, as we should have already validated the field via XSD
+            // parsing.
+            qWarning() <<
+               Q_FUNC_INFO << "Ignoring " << this->namedEntityClassName << " node " << fieldDefinition->xPath << "=" <<
+               value << " as could not be parsed as integer";
+         }
+         break;
+
+      case XmlRecord::UInt:
+         // QString's toUInt method will report success/failure of parsing straight back into our flag
+         parsedValue.setValue(value.toUInt(&parsedValueOk));
+         if (!parsedValueOk) {
+            // This is almost certainly a coding error, as we should have already validated the field via XSD
+            // parsing.
+            qWarning() <<
+               Q_FUNC_INFO << "Ignoring " << this->namedEntityClassName << " node " << fieldDefinition->xPath << "=" <<
+               value << " as could not be parsed as unsigned integer";
+         }
+         break;
+
+      case XmlRecord::Double:
+         // QString's toDouble method will report success/failure of parsing straight back into our flag
+         parsedValue.setValue(value.toDouble(&parsedValueOk));
+         if (!parsedValueOk) {
+            // This is almost certainly a coding error, as we should have already validated the field via XSD
+            // parsing.
+            qWarning() <<
+               Q_FUNC_INFO << "Ignoring " << this->namedEntityClassName << " node " << fieldDefinition->xPath << "=" <<
+               value << " as could not be parsed as decimal number (double)";
+         }
+         break;
+
+      case XmlRecord::Date:
+         {
+            //
+            // Extra braces here as we have a variable (date) that is only used in this case of the switch,
+            // so we need to restrict its scope, otherwise the compiler will complain about the variable
+            // initialisation being "jumped over" in the other case labels.
+            //
+            // Dates are a bit annoying because, in some cases, fields are not restricted to using the One
+            // True Date Format™ (aka ISO 8601).  Eg, in the BeerXML 1.0 standard, for the DATE field of a
+            // Recipe, it merely says 'Date brewed in a easily recognizable format such as “3 Dec 04”', yet
+            // internally we want to store this as a date rather than just a text field.
+            //
+            // So, we make several attempts to parse a date, using various different "standard" encodings.
+            // There is a risk that certain formats are ambiguous - eg 01/04/2021 is 4 January 2021 in
+            // the USA, but 1 April 2021 in most of the rest of the world (except the enlightened countries
+            // that use the One True Date Format) - but there is little we can do about this.
+            //
+            // Start by trying ISO 8601, which is the most logical format :-)
+            //
+            QDate date = QDate::fromString(value, Qt::ISODate);
+            parsedValueOk = date.isValid();
+            if (!parsedValueOk) {
+               // If not ISO 8601, try RFC 2822 Internet Message Format, which is horrible because it
+               // assumes everyone speaks English, but (a) widely used and (b) unambiguous
+               date = QDate::fromString(value, Qt::RFC2822Date);
+               parsedValueOk = date.isValid();
+            }
+            if (!parsedValueOk) {
+               // Next we'll try Qt's "default" date format, which is good for display but not for file
+               // interchange, as it's locale-specific
+               date = QDate::fromString(value, Qt::TextDate);
+               parsedValueOk = date.isValid();
+            }
+            if (!parsedValueOk) {
+               // Now we're rolling our own formats.  See https://doc.qt.io/qt-5/qdate.html for details of
+               // the codes in the format strings.
                //
-               // So we've either parsed the value OK or we don't need it (or both)
-               //
-               // If we do need it, we now store the value
+               // Try USA / Philippines numeric format next, though NB this could mis-parse some
+               // non-USA-format dates per example above.  (Historically we assumed USA format dates before
+               // non-USA-format ones, so we're retaining existing behaviour by trying things in this order.)
+               date = QDate::fromString(value, "M/d/yyyy");
+               parsedValueOk = date.isValid();
+            }
+            if (!parsedValueOk) {
+               // Now try the numeric version that is widely used outside the USA & the Philippines
+               date = QDate::fromString(value, "d/M/yyyy");
+               parsedValueOk = date.isValid();
+            }
+            if (!parsedValueOk) {
+               // Now try the numeric version that is widely used outside the USA & the Philippines
+               date = QDate::fromString(value, "d/M/yyyy");
+               parsedValueOk = date.isValid();
+            }
+            if (!parsedValueOk) {
+               // Now try the example "easily recognizable" format from the BeerXML 1.0 standard.
                //
-               if (nullptr != fieldDefinition->propertyName) {
-                  this->namedParameterBundle.insert(fieldDefinition->propertyName, parsedValue);
-
-                  //
-                  // It's a coding error if we're trying to store a simple field without somewhere to store it.  It
-                  // should only be the root record that doesn't have a NamedEntity to populate, and, equally, the root
-                  // record should not be configured to parse anything other than contained records.
-                  //
-                  Q_ASSERT(nullptr != this->namedEntity && "Trying to parse simple field on root record");
-                  if (!this->namedEntity->setProperty(fieldDefinition->propertyName, parsedValue)) {
-                     //
-                     // It's also a coding error if we are trying to read and store a field that does not exist on the
-                     // object we are loading (because we only try to store fields we (a) recognise and (b) are
-                     // interested in).  Nonetheless, if asserts are disabled, we may be able to continue past this
-                     // coding error by ignoring the current field.
-                     //
-                     Q_ASSERT(false && "Trying to update undeclared property");
-                     qCritical() <<
-                        Q_FUNC_INFO << "Trying to update undeclared property " << fieldDefinition->propertyName << " of " <<
-                        this->namedEntity->metaObject()->className();
-                  }
-               }
+               // Of course, this is a horrible format because it is not Y2K compliant.  So the actual date
+               // we store may be out by 100 years.  Hopefully the user will notice and correct this, and
+               // then if we export we can use a non-ambiguous format.
+               date = QDate::fromString(value, "d MMM yy");
+               parsedValueOk = date.isValid();
             }
+            // .:TBD:. Maybe we could try some more formats here
+
+            parsedValue.setValue(date);
+         }
+         if (!parsedValueOk) {
+            // This is almost certainly a coding error, as we should have already validated the field via XSD
+            // parsing.
+            qWarning() <<
+               Q_FUNC_INFO << "Ignoring " << this->namedEntityClassName << " node " << fieldDefinition->xPath << "=" <<
+               value << " as could not be parsed as ISO 8601 date";
          }
+         break;
+
+      case XmlRecord::Enum:
+         // It's definitely a coding error if there is no stringToEnum mapping for a field declared as Enum!
+         Q_ASSERT(nullptr != fieldDefinition->stringToEnum);
+         if (!fieldDefinition->stringToEnum->contains(value)) {
+            // This is probably a coding error as the XSD parsing should already have verified that the
+            // contents of the node are one of the expected values.
+            qWarning() <<
+               Q_FUNC_INFO << "Ignoring " << this->namedEntityClassName << " node " << fieldDefinition->xPath << "=" <<
+               value << " as value not recognised";
+         } else {
+            parsedValue.setValue(fieldDefinition->stringToEnum->value(value));
+            parsedValueOk = true;
+         }
+         break;
+
+      // By default we assume it's a string
+      case XmlRecord::String:
+      default:
+         if (fieldDefinition->fieldType != XmlRecord::String) {
+            // This is almost certainly a coding error in this class as we should be able to parse all the
+            // types callers need us to.
+            qWarning() <<
+               Q_FUNC_INFO << "Treating " << this->namedEntityClassName << " node " << fieldDefinition->xPath << "=" <<
+               value << " as string because did not recognise requested parse type " << fieldDefinition->fieldType;
+         }
+         parsedValue.setValue(static_cast<QString>(value));
+         parsedValueOk = true;
+         break;
+   }
+
+   //
+   // What we do if we couldn't parse the value depends.  If it was a value that we didn't need to set on the
+   // supplied Hop/Yeast/Recipe/Etc object, then we can just ignore the problem and carry on processing.  But,
+   // if this was a field we were expecting to use, then it's a problem that we couldn't parse it and we should
+   // bail.
+   //
+   if (!parsedValueOk && nullptr != fieldDefinition->propertyName) {
+      userMessage <<
+         "Could not parse " << this->namedEntityClassName << " node " << fieldDefinition->xPath << "=" << value << " into " <<
+         fieldDefinition->propertyName;
+      return false;
+   }
+
+   //
+   // So we've either parsed the value OK or we don't need it (or both)
+   //
+   // If we do need it, we now store the value
+   //
+   if (nullptr != fieldDefinition->propertyName) {
+      this->namedParameterBundle.insert(fieldDefinition->propertyName, parsedValue);
+
+      //
+      // It's a coding error if we're trying to store a simple field without somewhere to store it.  It
+      // should only be the root record that doesn't have a NamedEntity to populate, and, equally, the root
+      // record should not be configured to parse anything other than contained records.
+      //
+      Q_ASSERT(nullptr != this->namedEntity && "Trying to parse simple field on root record");
+      if (!this->namedEntity->setProperty(fieldDefinition->propertyName, parsedValue)) {
+         //
+         // It's also a coding error if we are trying to read and store a field that does not exist on the
+         // object we are loading (because we only try to store fields we (a) recognise and (b) are
+         // interested in).  Nonetheless, if asserts are disabled, we may be able to continue past this
+         // coding error by ignoring the current field.
+         //
+         Q_ASSERT(false && "Trying to update undeclared property");
+         qCritical() <<
+            Q_FUNC_INFO << "Trying to update undeclared property " << fieldDefinition->propertyName << " of " <<
+            this->namedEntity->metaObject()->className();
       }
    }
    return true;
 }
 
+bool XmlRecord::load(QXmlStreamReader & xmlStreamReader,
+                     QTextStream & userMessage) {
+   return this->loadFromStream(xmlStreamReader, userMessage, nullptr);
+}
+
+
+bool XmlRecord::loadNormaliseAndStoreChildRecordsInDb(QXmlStreamReader & xmlStreamReader,
+                                                      QTextStream & userMessage,
+                                                      XmlRecordCount & stats) {
+   return this->loadFromStream(xmlStreamReader, userMessage, &stats);
+}
+
+
+XmlRecord::StreamIndex const & XmlRecord::streamIndex(FieldDefinitions const & fieldDefinitions) {
+   //
+   // Each type of record has a fixed list of field definitions (they are static data in, eg, xml/BeerXml.cpp), so we
+   // only need to build the look-up for each list once, rather than once per record read in.  We only read XML on the
+   // GUI thread, so there's no locking here.
+   //
+   static QHash<FieldDefinitions const *, StreamIndex> indexes;
+   auto ii = indexes.find(&fieldDefinitions);
+   if (ii == indexes.end()) {
+      StreamIndex index;
+      for (auto fieldDefinition = fieldDefinitions.cbegin(); fieldDefinition < fieldDefinitions.cend(); ++fieldDefinition) {
+         index.fields.insert(fieldDefinition->xPath, &(*fieldDefinition));
+         // Eg for "HOPS/HOP" we need to know that it's worth looking inside a HOPS element
+         QStringList steps = fieldDefinition->xPath.split('/');
+         for (steps.removeLast(); !steps.isEmpty(); steps.removeLast()) {
+            index.containers.insert(steps.join('/'));
+         }
+      }
+      ii = indexes.insert(&fieldDefinitions, index);
+   }
+   return ii.value();
+}
+
+
+bool XmlRecord::loadFromStream(QXmlStreamReader & xmlStreamReader,
+                               QTextStream & userMessage,
+                               XmlRecordCount * storeChildRecordsAsWeGo) {
+   qDebug() << Q_FUNC_INFO;
+
+   //
+   // We get here with the reader positioned on our own start element.  Everything up to the matching end element is
+   // ours.  Rather than searching the record for each field definition in turn, as the DOM version does, we make a
+   // single pass through the elements and look each one up by its path relative to the start of the record.  Anything
+   // we don't have a definition for (and that doesn't contain anything we have a definition for) gets skipped in one
+   // go.
+   //
+   StreamIndex const & index = XmlRecord::streamIndex(this->fieldDefinitions);
+   QStringList currentPath;
+   QSet<FieldDefinition const *> fieldsRead;
+
+   while (!xmlStreamReader.atEnd()) {
+      QXmlStreamReader::TokenType token = xmlStreamReader.readNext();
+
+      if (QXmlStreamReader::EndElement == token) {
+         if (currentPath.isEmpty()) {
+            // This is the end of our record
+            return true;
+         }
+         currentPath.removeLast();
+         continue;
+      }
+
+      if (QXmlStreamReader::StartElement != token) {
+         // Whitespace, comments, etc
+         continue;
+      }
+
+      QString const elementName = xmlStreamReader.name().toString();
+      currentPath.append(elementName);
+      QString const path = currentPath.join('/');
+
+      FieldDefinition const * fieldDefinition = index.fields.value(path, nullptr);
+      if (nullptr == fieldDefinition) {
+         if (!index.containers.contains(path)) {
+            // Either an extension tag we don't know about or something we don't care about.  Either way, ignore it and
+            // everything inside it.
+            xmlStreamReader.skipCurrentElement();
+            currentPath.removeLast();
+         }
+         continue;
+      }
+
+      if (XmlRecord::Record == fieldDefinition->fieldType) {
+         // Same coding error check as in loadChildRecords()
+         Q_ASSERT(this->xmlCoding.isKnownXmlRecordType(elementName));
+
+         std::shared_ptr<XmlRecord> xmlRecord = this->xmlCoding.getNewXmlRecord(elementName);
+         if (!xmlRecord->load(xmlStreamReader, userMessage)) {
+            return false;
+         }
+         currentPath.removeLast();
+
+         if (nullptr == storeChildRecordsAsWeGo) {
+            this->childRecords.insert(xmlRecord->namedEntityClassName,
+                                      XmlRecord::ChildRecord(fieldDefinition->propertyName, xmlRecord));
+         } else {
+            //
+            // Nothing else in the document refers to a top-level record once it's been read, so we can store it now
+            // and let it go, rather than holding the whole document in memory until the end.
+            //
+            if (XmlRecord::Failed == xmlRecord->normaliseAndStoreInDb(this->namedEntity,
+                                                                      userMessage,
+                                                                      *storeChildRecordsAsWeGo)) {
+               return false;
+            }
+         }
+         continue;
+      }
+
+      //
+      // It's a simple field.  As with the DOM version, if there are several of them, we only take the first.
+      //
+      QString value = xmlStreamReader.readElementText(QXmlStreamReader::SkipChildElements);
+      currentPath.removeLast();
+      if (fieldsRead.contains(fieldDefinition)) {
+         qWarning() <<
+            Q_FUNC_INFO << "More than one node found with path " << fieldDefinition->xPath << ".  Taking value only "
+            "of the first one.";
+         continue;
+      }
+      fieldsRead.insert(fieldDefinition);
+
+      if (value.isEmpty()) {
+         qDebug() << Q_FUNC_INFO << "Empty!";
+         continue;
+      }
+      // Xerces gives us text with the whitespace already normalised for anything that isn't a string in the XSD
+      if (XmlRecord::String != fieldDefinition->fieldType) {
+         value = value.trimmed();
+      }
+      qDebug() << Q_FUNC_INFO << "Value " << value;
+
+      if (!this->parseAndStoreField(fieldDefinition, value, userMessage)) {
+         return false;
+      }
+   }
+
+   //
+   // If we ran out of document before we found our end element, the document is broken.  The caller will report the
+   // details from xmlStreamReader.
+   //
+   qWarning() << Q_FUNC_INFO << "Reached end of document inside " << this->namedEntityClassName << " record";
+   return false;
+}
+
+
 XmlRecord::ProcessingResult XmlRecord::normaliseAndStoreInDb(NamedEntity * containingEntity,
                                                              QTextStream & userMessage,
                                                              XmlRecordCount & stats) {
@@ -404,6 +565,9 @@ XmlRecord::ProcessingResult XmlRecord::normaliseAndStoreInDb(NamedEntity * conta
 
    // Finally orchestrate storing any contained records
    if (this->normaliseAndStoreChildRecordsInDb(userMessage, stats)) {
+      if (nullptr != this->namedEntity) {
+         this->noteStoredInDb();
+      }
       return XmlRecord::Succeeded;
    }
 
@@ -530,6 +694,17 @@ void XmlRecord::setContainingEntity(NamedEntity * containingEntity) {
 }
 
 
+void XmlRecord::noteStoredInDb() {
+   return;
+}
+
+unsigned int XmlRecord::importNumber = 0;
+
+void XmlRecord::startNewImport() {
+   ++XmlRecord::importNumber;
+   return;
+}
+
 void XmlRecord::modifyClashingName(QString & candidateName) {
    //
    // First, see whether there's already a (n) (ie "(1)", "(2)" etc) at the end of the name (with or without
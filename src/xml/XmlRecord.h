@@ -22,7 +22,10 @@
 
 #include <memory>
 
+#include <QHash>
+#include <QSet>
 #include <QTextStream>
+#include <QXmlStreamReader>
 
 #include <xalanc/DOMSupport/DOMSupport.hpp>
 #include <xalanc/XalanDOM/XalanNode.hpp>
@@ -142,6 +145,34 @@ public:
              xalanc::XalanNode * rootNodeOfRecord,
              QTextStream & userMessage);
 
+   /**
+    * \brief Streaming alternative to the DOM-based \b load() above.  Reads this record, including any other records
+    *        nested inside it, in a single forward pass over the document.
+    *
+    * \param xmlStreamReader Should be positioned on the start element of this record.  On successful return it is
+    *                        positioned on the matching end element.
+    * \param userMessage Where to append any error messages that we want the user to see on the screen
+    *
+    * \return \b true if load succeeded, \b false if there was an error
+    */
+   bool load(QXmlStreamReader & xmlStreamReader,
+             QTextStream & userMessage);
+
+   /**
+    * \brief For the root record when streaming.  As \b load(QXmlStreamReader &, QTextStream &), except that each child
+    *        record is normalised and stored in the DB as soon as it has been read, and then discarded.  This means we
+    *        only ever hold one top-level record (eg one Recipe and its contents) in memory, however big the document.
+    *
+    * \param xmlStreamReader Should be positioned on the start element of the root record
+    * \param userMessage Where to append any error messages that we want the user to see on the screen
+    * \param stats This object keeps tally of how many records (of each type) we skipped or stored
+    *
+    * \return \b true if everything was read and stored, \b false if there was an error
+    */
+   bool loadNormaliseAndStoreChildRecordsInDb(QXmlStreamReader & xmlStreamReader,
+                                              QTextStream & userMessage,
+                                              XmlRecordCount & stats);
+
    /**
     * \brief Once the record (including all its sub-records) is loaded into memory, we this function does any final
     *        validation and data correction before then storing the object(s) in the database.  Most validation should
@@ -164,7 +195,47 @@ public:
                                                   QTextStream & userMessage,
                                                   XmlRecordCount & stats);
 
+   /**
+    * \brief Called once at the start of reading in each document.  Anything that caches what is already stored in the
+    *        DB for the duration of an import (see \b XmlNamedEntityRecord::storedIndex()) uses this to know when its
+    *        cache is stale.
+    */
+   static void startNewImport();
+
 private:
+   /**
+    * \brief What \b loadFromStream() needs to know about a list of field definitions, keyed by XPath
+    */
+   struct StreamIndex {
+      // The simple XPaths (eg "NAME", "HOPS/HOP") we have field definitions for
+      QHash<QString, FieldDefinition const *> fields;
+      // Partial XPaths we need to look inside to find those fields (eg "HOPS")
+      QSet<QString> containers;
+   };
+
+   /**
+    * \brief Returns the (cached) \b StreamIndex for \c fieldDefinitions
+    */
+   static StreamIndex const & streamIndex(FieldDefinitions const & fieldDefinitions);
+
+   /**
+    * \brief Does the work for both streaming versions of \b load().  If \c storeChildRecordsAsWeGo is not null, child
+    *        records are stored in the DB as soon as they are read instead of being added to \b childRecords.
+    */
+   bool loadFromStream(QXmlStreamReader & xmlStreamReader,
+                       QTextStream & userMessage,
+                       XmlRecordCount * storeChildRecordsAsWeGo);
+
+   /**
+    * \brief Parse the text of a simple (ie non-record) field and, if there is a property for it, set it on
+    *        \b namedEntity.  This is common to the DOM and streaming versions of \b load().
+    *
+    * \return \b false if the value could not be parsed and we needed it, \b true otherwise
+    */
+   bool parseAndStoreField(FieldDefinition const * fieldDefinition,
+                           QString const & value,
+                           QTextStream & userMessage);
+
    /**
     * \brief Load in child records.  It is for derived classes to determine whether and when they have child records to
     *        process (eg Hop records inside a Recipe).  But the algorithm for processing is generic, so we implement it
@@ -200,6 +271,18 @@ protected:
     */
    virtual void setContainingEntity(NamedEntity * containingEntity);
 
+   /**
+    * \brief Called after the \b NamedEntity for this record (and everything it contains) has been successfully stored
+    *        in the DB, so that subclasses can keep any look-ups of stored objects up to date.  Default is a no-op.
+    */
+   virtual void noteStoredInDb();
+
+   /**
+    * \brief Incremented by \b startNewImport().  A cache built with a different number than this one was built for a
+    *        previous import and needs to be rebuilt.
+    */
+   static unsigned int importNumber;
+
    /**
     * \brief Given a name that is a duplicate of an existing one, modify it to a potential alternative.
     *        Callers should call this function as many times as necessary to find a non-clashing name.
@@ -86,3 +86,14 @@ bool XmlRecordCount::writeToUserMessage(QTextStream & userMessage) {
 
    return true;
 }
+
+int XmlRecordCount::total() const {
+   int count = 0;
+   for (auto ii : this->skips) {
+      count += ii;
+   }
+   for (auto ii : this->oks) {
+      count += ii;
+   }
+   return count;
+}
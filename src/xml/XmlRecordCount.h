@@ -63,6 +63,11 @@ public:
     */
    bool writeToUserMessage(QTextStream & userMessage);
 
+   /**
+    * \brief How many records we have seen in total, skipped or processed, of all types
+    */
+   int total() const;
+
 private:
    QMap<QString, int> skips;
    QMap<QString, int> oks;